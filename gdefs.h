@@ -56,6 +56,7 @@
 #define DEF_PREC_METRIC_PAR 12
 #define DEF_PREC_BOOST 6
 #define DEF_PREC_JACOBI 6
+#define DEF_PREC_COLORMAP 6
 
 #define DEF_ZOOM_STEP 0.5
 
@@ -65,6 +66,9 @@
 #define DEF_3D_FILE_ENDING ".3d.png"
 #define DEF_IMG_FILE_FILTER "*.png"
 #define DEF_IMG_FILE_ENDING ".png"
+#define DEF_VEC_FILE_FILTER "*.svg *.pdf"
+#define DEF_SVG_FILE_ENDING ".svg"
+#define DEF_PDF_FILE_ENDING ".pdf"
 
 // -----------------------------------
 //   camera draw style
@@ -74,6 +78,43 @@ enum enum_draw_style { enum_draw_points = 0, enum_draw_lines };
 const QStringList stl_draw_styles = QStringList() << "points"
                                                   << "lines";
 
+// -----------------------------------
+//   geodesic line mode (3d)
+// -----------------------------------
+enum enum_line_mode { enum_line_mode_gl = 0, enum_line_mode_thick, enum_line_mode_tube };
+
+const QStringList stl_line_modes = QStringList() << "GL lines"
+                                                 << "thick lines"
+                                                 << "tubes";
+
+// -----------------------------------
+//   geodesic colormapping (3d)
+// -----------------------------------
+enum enum_geod_scalar {
+    enum_geod_scalar_none = 0,
+    enum_geod_scalar_lambda,
+    enum_geod_scalar_time,
+    enum_geod_scalar_constraint,
+    enum_geod_scalar_stepsize,
+    enum_geod_scalar_radius,
+    enum_geod_scalar_freqshift
+};
+
+const QStringList stl_geod_scalars = QStringList() << "single color"
+                                                   << "affine parameter"
+                                                   << "coordinate time"
+                                                   << "constraint error"
+                                                   << "step size"
+                                                   << "radius"
+                                                   << "frequency shift";
+
+enum enum_colormap { enum_colormap_rainbow = 0, enum_colormap_viridis, enum_colormap_coolwarm, enum_colormap_gray };
+
+const QStringList stl_colormaps = QStringList() << "rainbow"
+                                                << "viridis"
+                                                << "cool-warm"
+                                                << "gray";
+
 // -----------------------------------
 //   camera projection
 // -----------------------------------
@@ -160,6 +201,16 @@ enum enum_draw_coord_num {
     enum_draw_coord_dx3
 };
 
+// number of channels per vertex of 2D coordinate plots, in the order of enum_draw_coord_num
+#define DEF_DRAW_COORD_NUM 9
+
+// one panel of the small-multiples grid of the 2D view
+typedef struct _struct_plot_panel {
+    enum_draw_coord_num abscissa;
+    enum_draw_coord_num ordinate;
+    QString title;
+} struct_plot_panel;
+
 // -----------------------------------
 //   valuestep_model
 // -----------------------------------
@@ -175,6 +226,29 @@ enum enum_draw_coord_num {
 
 #define DEF_MAX_NUM_POINTS 3000
 
+// minimum number of points per thread for batch transformations
+#define DEF_BATCH_TRANSFORM_CHUNK 65536
+
+// memory budget for cached projections of the geodesic per view
+#define DEF_PROJECTION_CACHE_MAX_BYTES (64 * 1024 * 1024)
+
+// undo/redo history: number of states, states with trajectory, and memory budget for trajectories
+#define DEF_HISTORY_MAX_STATES 100
+#define DEF_HISTORY_NUM_TRAJECTORIES 16
+#define DEF_HISTORY_MAX_BYTES (256 * 1024 * 1024)
+
+// effective potential: samples per view width, refinement depth and relative tolerance, extra range per side,
+// factor by which the grid may be coarser than the view needs before it is resampled
+#define DEF_EFFPOT_NUM_SAMPLES 128
+#define DEF_EFFPOT_MAX_DEPTH 6
+#define DEF_EFFPOT_TOLERANCE 1.0e-3
+#define DEF_EFFPOT_MARGIN 0.5
+#define DEF_EFFPOT_RESAMPLE 4.0
+
+// embedding diagrams: memory budget for cached meshes, index that separates quad strips
+#define DEF_EMB_CACHE_MAX_BYTES (64 * 1024 * 1024)
+#define DEF_EMB_RESTART_INDEX 0xFFFFFFFFu
+
 #ifndef SIGNUM
 #define SIGNUM(x) (x >= 0 ? 1.0 : -1.0)
 #endif
@@ -193,6 +267,9 @@ enum enum_draw_coord_num {
 #define DEF_OBJECT_FILE_ENDING ".obj"
 #define DEF_OBJECT_FILE_ENDING_PATTERN "*.obj"
 
+#define DEF_CAMPATH_FILE_ENDING ".cam"
+#define DEF_CAMPATH_FILE_ENDING_PATTERN "*.cam"
+
 #define DEF_REPORT_FILE_ENDING ".rep"
 #define DEF_REPORT_FILE_ENDING_PATTERN "*.rep"
 
@@ -213,7 +290,12 @@ enum enum_draw_coord_num {
 #define DEF_OPENGL_FOG_DENSITY_INIT 0.05
 
 #define DEF_OPENGL_LINE_COLOR 255, 255, 0
-#define DEF_OPENGL_LINE_WIDTH 1 // range: 1-5
+#define DEF_OPENGL_LINE_WIDTH 1 // range: 1-DEF_OPENGL_MAX_LINE_WIDTH
+#define DEF_OPENGL_MAX_LINE_WIDTH 20
+#define DEF_OPENGL_TUBE_RADIUS 0.05
+#define DEF_OPENGL_TUBE_SEGMENTS 8
+#define DEF_OPENGL_IMG_MAX_SIZE 32768
+#define DEF_OPENGL_EXPORT_TILE_SIZE 1024
 #define DEF_OPENGL_BG_COLOR 0, 0, 0
 
 #define DEF_OPENGL_LEG1_COL1 255, 255, 0
@@ -229,6 +311,19 @@ enum enum_draw_coord_num {
 #define DEF_OPENGL_ANIM_ROT_Y_INIT 0.0
 #define DEF_OPENGL_ANIM_ROT_Z_INIT 0.0
 
+// Animation export: default length and frame rate, pixel-pack buffers in flight, frames queued for encoding
+#define DEF_ANIM_EXPORT_FRAMES 300
+#define DEF_ANIM_EXPORT_FPS 30
+#define DEF_ANIM_EXPORT_PBO_RING 3
+#define DEF_ANIM_EXPORT_QUEUE 8
+
+// Camera path: default time between keyframes in seconds, playback timer interval in msec
+#define DEF_CAMPATH_KEY_DT 2.0
+#define DEF_CAMPATH_PLAY_INTERVAL 15
+
+// Geodesic colormapping: number of texels per colormap
+#define DEF_GEOD_COLORMAP_SIZE 256
+
 #define DEF_DOUBLE_EDIT_COLOR 200, 240, 255
 
 #define DEF_DRAW2D_BG_COLOR 88, 94, 85
@@ -241,6 +336,41 @@ enum enum_draw_coord_num {
 
 #define DEF_DRAW2D_ZOOM_COLOR 35, 35, 35
 
+// Tiled views: number of additional 2D coordinate plots, margin around fitted plots
+#define DEF_TILED_NUM_PLOTS 2
+#define DEF_TILED_PLOT_MARGIN 0.05
+
+// Small multiples: maximum rows and columns, gap between panels in pixels, margin around fitted panels,
+// desired distance between lattice lines and tick length in pixels
+#define DEF_DRAW2D_MULTIPLES_MAX 4
+#define DEF_DRAW2D_MULTIPLES_GAP 2
+#define DEF_DRAW2D_MULTIPLES_MARGIN 0.05
+#define DEF_DRAW2D_MULTIPLES_TICK_DIST 80
+#define DEF_DRAW2D_MULTIPLES_TICK_SIZE 5
+
+// Vector export of the 2d view: simplification tolerance in pixels, font size of the tick labels
+#define DEF_VECTOR_EXPORT_TOLERANCE 0.25
+#define DEF_VECTOR_EXPORT_FONT_SIZE 12
+
+// Point picking: search radius in pixels, marker size in pixels, marker color
+#define DEF_PICK_RADIUS 8
+#define DEF_PICK_MARKER_SIZE 9
+#define DEF_PICK_MARKER_COLOR 255, 0, 255
+
+// geodesic trails: shown by default, maximum number, GPU memory per view and its upper limit in MB, alpha ramp
+#define DEF_TRAILS_NUM 10
+#define DEF_TRAILS_MAX_NUM 100
+#define DEF_TRAILS_MAX_BYTES (32 * 1024 * 1024)
+#define DEF_TRAILS_MAX_MBYTES 1024
+#define DEF_TRAILS_MIN_ALPHA 0.05
+#define DEF_TRAILS_MAX_ALPHA 0.8
+#define DEF_TRAILS_RAMP_SIZE 256
+
+// GPU pass timer: timestamps per frame, frames kept for the log, smoothing of the overlay values
+#define DEF_PASS_TIMER_MAX_SAMPLES 64
+#define DEF_PASS_TIMER_LOG_FRAMES 10000
+#define DEF_PASS_TIMER_SMOOTHING 0.1
+
 // Parameter configuration
 typedef struct _struct_params {
     std::string filename;
@@ -275,6 +405,15 @@ typedef struct _struct_params {
     QColor opengl_bg_color;
     int opengl_line_width;
     int opengl_line_smooth;
+    int opengl_line_mode;
+    double opengl_tube_radius;
+    int opengl_cmap_scalar;
+    int opengl_cmap_type;
+    int opengl_cmap_auto;
+    double opengl_cmap_min;
+    double opengl_cmap_max;
+    int opengl_img_width;
+    int opengl_img_height;
 
     int opengl_stereo_use;
     enum_stereo_glasses opengl_stereo_glasses;
@@ -322,6 +461,10 @@ typedef struct _struct_params {
     int draw2d_abscissa;
     int draw2d_ordinate;
 
+    int trails_use;
+    int trails_num;
+    int trails_max_mbytes;
+
 } struct_params;
 
 // -----------------------------------
@@ -336,6 +479,9 @@ typedef struct _struct_params {
 #define DEF_GLU_CYLINDER_SLICES 20.0
 #define DEF_GLU_CYLINDER_STACKS 20.0
 
+// Upper limit of slices and stacks of the shared object meshes
+#define DEF_OBJECT_MESH_MAX_RES 512
+
 enum enum_object_type {
     enum_object_undefined = 0,
     enum_object_sphere2d,
@@ -61,25 +61,59 @@ MODEL_SOURCES = \
     $$MODEL_DIR/opengl2d_model.cpp
 
 UTILS_HEADERS = \
+    $$UTILS_DIR/batch_transform.h \
     $$UTILS_DIR/camera.h \
+    $$UTILS_DIR/camera_path.h \
     $$UTILS_DIR/quaternions.h \
     $$UTILS_DIR/doubleedit_util.h \
+    $$UTILS_DIR/effpot_curve.h \
+    $$UTILS_DIR/embedding_mesh.h \
+    $$UTILS_DIR/frame_exporter.h \
+    $$UTILS_DIR/geodesic_colormap.h \
+    $$UTILS_DIR/geodesic_trails.h \
+    $$UTILS_DIR/gpu_pass_timer.h \
     $$UTILS_DIR/greek.h \
+    $$UTILS_DIR/layer_cache.h \
     $$UTILS_DIR/mathutils.h \
     $$UTILS_DIR/myobject.h \
+    $$UTILS_DIR/object_meshes.h \
+    $$UTILS_DIR/plot_lattice.h \
+    $$UTILS_DIR/png_stream_writer.h \
+    $$UTILS_DIR/point_index.h \
+    $$UTILS_DIR/projection_cache.h \
     $$UTILS_DIR/rendertext.h \
+    $$UTILS_DIR/session_history.h \
+    $$UTILS_DIR/soft_renderer.h \
     $$UTILS_DIR/utilities.h \
+    $$UTILS_DIR/vector_exporter.h \
     $$UTILS_DIR/gramschmidt.h
 
 UTILS_SOURCES = \
+    $$UTILS_DIR/batch_transform.cpp \
     $$UTILS_DIR/camera.cpp \
+    $$UTILS_DIR/camera_path.cpp \
     $$UTILS_DIR/quaternions.cpp \
     $$UTILS_DIR/doubleedit_util.cpp \
+    $$UTILS_DIR/effpot_curve.cpp \
+    $$UTILS_DIR/embedding_mesh.cpp \
+    $$UTILS_DIR/frame_exporter.cpp \
+    $$UTILS_DIR/geodesic_colormap.cpp \
+    $$UTILS_DIR/geodesic_trails.cpp \
+    $$UTILS_DIR/gpu_pass_timer.cpp \
     $$UTILS_DIR/greek.cpp \
+    $$UTILS_DIR/layer_cache.cpp \
     $$UTILS_DIR/mathutils.cpp \
     $$UTILS_DIR/myobject.cpp \
+    $$UTILS_DIR/object_meshes.cpp \
+    $$UTILS_DIR/plot_lattice.cpp \
+    $$UTILS_DIR/png_stream_writer.cpp \
+    $$UTILS_DIR/point_index.cpp \
+    $$UTILS_DIR/projection_cache.cpp \
     $$UTILS_DIR/rendertext.cpp \
+    $$UTILS_DIR/session_history.cpp \
+    $$UTILS_DIR/soft_renderer.cpp \
     $$UTILS_DIR/utilities.cpp \
+    $$UTILS_DIR/vector_exporter.cpp \
     $$UTILS_DIR/gramschmidt.cpp
 
 include($$M4D_DIR/m4d_sources.pri)
@@ -29,11 +29,18 @@
 #include <extra/m4dObject.h>
 #include <geodesic_view.h>
 #include <utils/myobject.h>
+#include <utils/projection_cache.h>
 #include <utils/utilities.h>
 #include <view/mapplication.h>
 
 m4d::Object mObject;
 
+// Incremented whenever mObject holds a newly integrated trajectory.
+unsigned int mObjectRevision = 0;
+
+// Projections of the trajectory, shared by all views of the shared GL context group.
+ProjectionCache mProjCache;
+
 /**
  * @brief main
  * @param argc
@@ -48,6 +55,8 @@ int main(int argc, char* argv[])
     GetExePath(exePath);
 
     QApplication::setAttribute(Qt::AA_DisableHighDpiScaling);
+    // All GL views share buffers and textures.
+    QApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
 
     MApplication app(argc, argv, exePath);
     if (exePath != nullptr) {
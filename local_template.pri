@@ -22,3 +22,8 @@ GSL_LIB_DIR = $$GSL_DIR/lib
 # INCLUDEPATH += $$FREETYPE_DIR/include/freetype2
 # LIBS += -L$$FREETYPE_LIB_DIR -lfreetyped
 
+## ------------------------------------------------
+##  libpng (optional, large images are streamed to file)
+## ------------------------------------------------
+# DEFINES += HAVE_LIBPNG
+# LIBS += -lpng
@@ -6,15 +6,29 @@
  */
 #include "opengl2d_model.h"
 #include "math/TransCoordinates.h"
+#include "utils/batch_transform.h"
 #include "utils/utilities.h"
 #include <QApplication>
 #include <QDesktopWidget>
+#include <algorithm>
+#include <cmath>
 #include <fstream>
+#include <limits>
 
 extern m4d::Object mObject;
+extern unsigned int mObjectRevision;
+extern ProjectionCache mProjCache;
 
 OpenGL2dModel::OpenGL2dModel(struct_params* par, QWidget* parent)
     : QOpenGLWidget(parent)
+    , mTrails(2)
+    , mPassTimer(QStringList() << "ticks"
+                               << "lattice"
+                               << "objects"
+                               << "geodesic"
+                               << "effpot"
+                               << "labels")
+    , mStaticCache(false)
 {
     mParams = par;
 
@@ -32,11 +46,27 @@ OpenGL2dModel::OpenGL2dModel(struct_params* par, QWidget* parent)
     mDrawStyle = enum_draw_lines;
     mLineSmooth = 1;
 
-    // Vertices for the geodesic.
+    // Vertices for the geodesic, shared with the other views.
+    mProjCache.attach();
     mVerts = nullptr;
+    mDim = 2;
     mNumVerts = 0;
     mShowNumVerts = 0;
     mDrawType = m4d::enum_draw_pseudocart;
+    mDrawParam = 0.0;
+    mDrawRevision = 0;
+    mEffPot.setReceiver(this);
+    mPickIndexValid = false;
+    mPickedVertex = -1;
+    mPlotShader = nullptr;
+    mPlotVertsValid = false;
+    mPanelGrid[0] = mPanelGrid[1] = 0;
+    mChannelRangeValid = false;
+
+    // Trails of previous geodesics.
+    mUseTrails = (mParams->trails_use == 1);
+    mTrails.setMaxTrails(mParams->trails_num);
+    mTrails.setMaxBytes(static_cast<size_t>(mParams->trails_max_mbytes) * 1024 * 1024);
 
     mXmin = mParams->draw2d_xMin;
     mXmax = mParams->draw2d_xMax;
@@ -61,26 +91,56 @@ OpenGL2dModel::OpenGL2dModel(struct_params* par, QWidget* parent)
     if (!mObjects.empty()) {
         mObjects.clear();
     }
+    mObjectsRevision = 0;
 
     mAbscissa = enum_draw_coord_x0;
     mOrdinate = enum_draw_coord_x3;
 
     mTicksFont = QFont("Helvetica", 9);
+#ifdef HAVE_FREETYPE
+    renderText = nullptr;
+#endif // HAVE_FREETYPE
 
     setMouseTracking(true);
 }
 
-OpenGL2dModel::~OpenGL2dModel() {}
+OpenGL2dModel::~OpenGL2dModel()
+{
+    makeCurrent();
+    mProjCache.unpin(mVerts);
+    if (mProjCache.detach() == 0) {
+        mProjCache.clear();
+    }
+    mProjCache.releaseBuffers();
+    mEffPot.clear();
+    mEffPot.releaseBuffer();
+    mTrails.releaseBuffer();
+    mStaticCache.release();
+    mLattice.release();
+    mPassTimer.release();
+    delete mPlotShader;
+    mPlotShader = nullptr;
+#ifdef HAVE_FREETYPE
+    delete renderText;
+    renderText = nullptr;
+#endif // HAVE_FREETYPE
+    doneCurrent();
+}
 
 void OpenGL2dModel::setPoints(m4d::enum_draw_type dtype, bool needUpdate)
 {
-    SafeDelete<GLfloat>(mVerts);
+    GLfloat* prevVerts = mVerts;
+    mVerts = nullptr;
 
     mNumVerts = 0;
     mShowNumVerts = 0;
     mDrawType = dtype;
+    mPickIndexValid = false;
+    mPlotVertsValid = false;
+    mChannelRangeValid = false;
 
     if (dtype == m4d::enum_draw_effpoti) {
+        mProjCache.unpin(prevVerts);
         if (needUpdate) {
             update();
         }
@@ -88,71 +148,36 @@ void OpenGL2dModel::setPoints(m4d::enum_draw_type dtype, bool needUpdate)
     }
 
     mNumVerts = mObject.points.size();
-    mVerts = new GLfloat[mNumVerts * 2];
 
-    GLfloat* vptr = mVerts;
-
-    m4d::vec4 tp;
-    for (size_t i = 0; i < mNumVerts; i++) {
-        switch (dtype) {
-            case m4d::enum_draw_pseudocart: {
-                mObject.currMetric->transToPseudoCart(mObject.points[i], tp);
-                // fprintf(stderr, "%4d %f %f %f\n", i, mObject.points[i][1], tp[1], tp[2]);
-                *(vptr++) = GLfloat(tp[1]);
-                *(vptr++) = GLfloat(tp[2]);
-                break;
+    // Projections of the current trajectory are cached per draw type. A coordinate plot stores all
+    // channels, so any column selection is drawn from the same buffer; only trails depend on the selection.
+    mDim = (dtype == m4d::enum_draw_coordinates ? DEF_DRAW_COORD_NUM : 2);
+    mDrawParam = (dtype == m4d::enum_draw_coordinates ? static_cast<double>(mAbscissa * 16 + mOrdinate) : 0.0);
+    if (mDrawRevision != mObjectRevision) {
+        mPickedVertex = -1;
+    }
+    mDrawRevision = mObjectRevision;
+
+    size_t numFloats = 0;
+    mVerts = mProjCache.find(mObjectRevision, dtype, 0.0, mDim, numFloats);
+    if (mVerts == nullptr) {
+        numFloats = mNumVerts * static_cast<size_t>(mDim);
+        mVerts = mProjCache.insert(mObjectRevision, dtype, 0.0, mDim, numFloats);
+        if (dtype != m4d::enum_draw_coordinates) {
+            if (!transformPoints(mObject.currMetric, dtype, mObject.points, mVerts, 2)) {
+                memset(mVerts, 0, sizeof(GLfloat) * numFloats);
             }
-            case m4d::enum_draw_coordinates: {
-                switch (mAbscissa) {
-                    case enum_draw_coord_x0:
-                    case enum_draw_coord_x1:
-                    case enum_draw_coord_x2:
-                    case enum_draw_coord_x3:
-                        *(vptr++) = GLfloat(mObject.points[i].x(static_cast<int>(mAbscissa)));
-                        break;
-                    case enum_draw_lambda:
-                        *(vptr++) = GLfloat(mObject.lambda[i]);
-                        break;
-                    case enum_draw_coord_dx0:
-                    case enum_draw_coord_dx1:
-                    case enum_draw_coord_dx2:
-                    case enum_draw_coord_dx3:
-                        *(vptr++) = GLfloat(mObject.dirs[i].x(static_cast<int>(mAbscissa) - 5));
-                        break;
-                }
-                switch (mOrdinate) {
-                    case enum_draw_coord_x0:
-                    case enum_draw_coord_x1:
-                    case enum_draw_coord_x2:
-                    case enum_draw_coord_x3:
-                        *(vptr++) = GLfloat(mObject.points[i].x(static_cast<int>(mOrdinate)));
-                        break;
-                    case enum_draw_lambda:
-                        *(vptr++) = GLfloat(mObject.lambda[i]);
-                        break;
-                    case enum_draw_coord_dx0:
-                    case enum_draw_coord_dx1:
-                    case enum_draw_coord_dx2:
-                    case enum_draw_coord_dx3:
-                        *(vptr++) = GLfloat(mObject.dirs[i].x(static_cast<int>(mOrdinate) - 5));
-                        break;
+        }
+        else {
+            GLfloat* vptr = mVerts;
+            for (size_t i = 0; i < mNumVerts; i++) {
+                for (int c = 0; c < DEF_DRAW_COORD_NUM; c++) {
+                    *(vptr++) = GLfloat(getCoordValue(static_cast<enum_draw_coord_num>(c), i));
                 }
-                break;
-            }
-            case m4d::enum_draw_embedding:
-                break;
-            case m4d::enum_draw_twoplusone:
-                break;
-            case m4d::enum_draw_effpoti:
-                break;
-            case m4d::enum_draw_custom: {
-                mObject.currMetric->transToCustom(mObject.points[i], tp);
-                *(vptr++) = GLfloat(tp[1]);
-                *(vptr++) = GLfloat(tp[2]);
-                break;
             }
         }
     }
+    mProjCache.unpin(prevVerts);
 
     mShowNumVerts = mNumVerts;
     if (needUpdate) {
@@ -162,17 +187,273 @@ void OpenGL2dModel::setPoints(m4d::enum_draw_type dtype, bool needUpdate)
 
 void OpenGL2dModel::clearPoints()
 {
-    SafeDelete<GLfloat>(mVerts);
+    mProjCache.unpin(mVerts);
+    mVerts = nullptr;
+    mPickIndex.clear();
+    mPickIndexValid = false;
+    mPickedVertex = -1;
+    mChannelRangeValid = false;
 
     mNumVerts = 0;
     mShowNumVerts = 0;
     update();
 }
 
+double OpenGL2dModel::getCoordValue(enum_draw_coord_num num, size_t idx)
+{
+    switch (num) {
+        case enum_draw_coord_x0:
+        case enum_draw_coord_x1:
+        case enum_draw_coord_x2:
+        case enum_draw_coord_x3:
+            return mObject.points[idx].x(static_cast<int>(num));
+        case enum_draw_lambda:
+            return mObject.lambda[idx];
+        case enum_draw_coord_dx0:
+        case enum_draw_coord_dx1:
+        case enum_draw_coord_dx2:
+        case enum_draw_coord_dx3:
+            return mObject.dirs[idx].x(static_cast<int>(num) - 5);
+    }
+    return 0.0;
+}
+
 void OpenGL2dModel::setAbsOrd(enum_draw_coord_num absNum, enum_draw_coord_num ordNum)
 {
+    if (absNum == mAbscissa && ordNum == mOrdinate) {
+        return;
+    }
     mAbscissa = absNum;
     mOrdinate = ordNum;
+
+    // The channels stay where they are; only the selection changes.
+    if (mDrawType == m4d::enum_draw_coordinates) {
+        mDrawParam = static_cast<double>(mAbscissa * 16 + mOrdinate);
+        mPickIndexValid = false;
+        mPlotVertsValid = false;
+        update();
+    }
+}
+
+void OpenGL2dModel::setMultiples(int rows, int cols, const std::vector<struct_plot_panel>& panels)
+{
+    mPanelGrid[0] = std::max(0, std::min(rows, DEF_DRAW2D_MULTIPLES_MAX));
+    mPanelGrid[1] = std::max(0, std::min(cols, DEF_DRAW2D_MULTIPLES_MAX));
+    size_t numPanels = static_cast<size_t>(mPanelGrid[0] * mPanelGrid[1]);
+    mPanels.clear();
+    for (size_t i = 0; i < panels.size() && i < numPanels; i++) {
+        mPanels.push_back(panels[i]);
+    }
+    update();
+}
+
+void OpenGL2dModel::getVertex(size_t idx, GLfloat& x, GLfloat& y)
+{
+    const GLfloat* v = mVerts + idx * static_cast<size_t>(mDim);
+    if (mDim == 2) {
+        x = v[0];
+        y = v[1];
+    }
+    else {
+        x = v[mAbscissa];
+        y = v[mOrdinate];
+    }
+}
+
+const GLfloat* OpenGL2dModel::getPlotVerts()
+{
+    if (mVerts == nullptr || mDim == 2) {
+        return mVerts;
+    }
+    if (!mPlotVertsValid) {
+        mPlotVerts.resize(mNumVerts * 2);
+        for (size_t i = 0; i < mNumVerts; i++) {
+            getVertex(i, mPlotVerts[2 * i], mPlotVerts[2 * i + 1]);
+        }
+        mPlotVertsValid = true;
+    }
+    return mPlotVerts.data();
+}
+
+bool OpenGL2dModel::bindChannels()
+{
+    if (mDim != DEF_DRAW_COORD_NUM || mVerts == nullptr || mPlotShader == nullptr) {
+        return false;
+    }
+    QOpenGLBuffer* vbo = mProjCache.getBuffer(mVerts);
+    if (vbo == nullptr) {
+        return false;
+    }
+
+    int stride = static_cast<int>(sizeof(GLfloat)) * DEF_DRAW_COORD_NUM;
+    mPlotShader->bind();
+    vbo->bind();
+    mPlotShader->setAttributeBuffer(0, GL_FLOAT, 0, 4, stride);
+    mPlotShader->setAttributeBuffer(1, GL_FLOAT, static_cast<int>(sizeof(GLfloat)) * enum_draw_lambda, 1, stride);
+    mPlotShader->setAttributeBuffer(2, GL_FLOAT, static_cast<int>(sizeof(GLfloat)) * enum_draw_coord_dx0, 4, stride);
+    for (int i = 0; i < 3; i++) {
+        mPlotShader->enableAttributeArray(i);
+    }
+    vbo->release();
+    return true;
+}
+
+void OpenGL2dModel::releaseChannels()
+{
+    for (int i = 0; i < 3; i++) {
+        mPlotShader->disableAttributeArray(i);
+    }
+    mPlotShader->release();
+}
+
+bool OpenGL2dModel::drawChannels(GLenum mode)
+{
+    if (!bindChannels()) {
+        return false;
+    }
+    mPlotShader->setUniformValue("absCol", static_cast<int>(mAbscissa));
+    mPlotShader->setUniformValue("ordCol", static_cast<int>(mOrdinate));
+    glDrawArrays(mode, 0, static_cast<GLsizei>(mShowNumVerts));
+    releaseChannels();
+    return true;
+}
+
+bool OpenGL2dModel::isMultiples()
+{
+    return (!mPanels.empty() && mDrawType == m4d::enum_draw_coordinates);
+}
+
+void OpenGL2dModel::getChannelRanges()
+{
+    if (mChannelRangeValid) {
+        return;
+    }
+
+    // One pass over the shared buffer gives the ranges of all channels, whichever panels show them.
+    bool first[DEF_DRAW_COORD_NUM];
+    for (int c = 0; c < DEF_DRAW_COORD_NUM; c++) {
+        first[c] = true;
+        mChannelRange[c][0] = -1.0;
+        mChannelRange[c][1] = 1.0;
+    }
+    if (mVerts != nullptr && mDim == DEF_DRAW_COORD_NUM) {
+        const GLfloat* v = mVerts;
+        for (size_t i = 0; i < mNumVerts; i++, v += DEF_DRAW_COORD_NUM) {
+            for (int c = 0; c < DEF_DRAW_COORD_NUM; c++) {
+                if (!std::isfinite(v[c])) {
+                    continue;
+                }
+                mChannelRange[c][0] = (first[c] ? v[c] : std::min(mChannelRange[c][0], static_cast<double>(v[c])));
+                mChannelRange[c][1] = (first[c] ? v[c] : std::max(mChannelRange[c][1], static_cast<double>(v[c])));
+                first[c] = false;
+            }
+        }
+    }
+
+    for (int c = 0; c < DEF_DRAW_COORD_NUM; c++) {
+        double d = mChannelRange[c][1] - mChannelRange[c][0];
+        if (d > 0.0) {
+            mChannelRange[c][0] -= DEF_DRAW2D_MULTIPLES_MARGIN * d;
+            mChannelRange[c][1] += DEF_DRAW2D_MULTIPLES_MARGIN * d;
+        }
+        else {
+            mChannelRange[c][0] -= 0.5;
+            mChannelRange[c][1] += 0.5;
+        }
+    }
+    mChannelRangeValid = true;
+}
+
+void OpenGL2dModel::getPanelRect(int idx, int* rect)
+{
+    int row = idx / mPanelGrid[1];
+    int col = idx % mPanelGrid[1];
+    int w = mWinSize[0] / mPanelGrid[1];
+    int h = mWinSize[1] / mPanelGrid[0];
+
+    // Rows are counted from the top, viewports from the bottom.
+    rect[0] = col * w + DEF_DRAW2D_MULTIPLES_GAP;
+    rect[1] = mWinSize[1] - (row + 1) * h + DEF_DRAW2D_MULTIPLES_GAP;
+    rect[2] = std::max(w - 2 * DEF_DRAW2D_MULTIPLES_GAP, 1);
+    rect[3] = std::max(h - 2 * DEF_DRAW2D_MULTIPLES_GAP, 1);
+}
+
+void OpenGL2dModel::getPanelRange(int idx, double* range)
+{
+    getChannelRanges();
+    range[0] = mChannelRange[mPanels[idx].abscissa][0];
+    range[1] = mChannelRange[mPanels[idx].abscissa][1];
+    range[2] = mChannelRange[mPanels[idx].ordinate][0];
+    range[3] = mChannelRange[mPanels[idx].ordinate][1];
+}
+
+double OpenGL2dModel::getPanelStep(double width, int pixels)
+{
+    // Closest step of the list, as in getTightLattice.
+    double pStep = width * DEF_DRAW2D_MULTIPLES_TICK_DIST / static_cast<double>(std::max(pixels, 1));
+    double step = mStepList[0];
+    double dist, minDist = 1e32;
+    for (int i = 0; i < mStepList.size(); i++) {
+        dist = fabs(pStep - mStepList[i]);
+        if (dist < minDist) {
+            minDist = dist;
+            step = mStepList[i];
+        }
+    }
+    return step;
+}
+
+const GLfloat* OpenGL2dModel::getPanelVerts(int idx)
+{
+    if (mVerts == nullptr || mDim != DEF_DRAW_COORD_NUM) {
+        return nullptr;
+    }
+    mPanelVerts.resize(mShowNumVerts * 2);
+    const GLfloat* v = mVerts;
+    for (size_t i = 0; i < mShowNumVerts; i++, v += DEF_DRAW_COORD_NUM) {
+        mPanelVerts[2 * i] = v[mPanels[idx].abscissa];
+        mPanelVerts[2 * i + 1] = v[mPanels[idx].ordinate];
+    }
+    return mPanelVerts.data();
+}
+
+void OpenGL2dModel::drawPanelLattice(const int* rect, const double* range, const double* step)
+{
+    // Visible lattice indices as in setLattice.
+    int xs = static_cast<int>(floor(range[0] / step[0])) + 1;
+    int xe = static_cast<int>(floor(range[1] / step[0])) + 1;
+    int ys = static_cast<int>(floor(range[2] / step[1])) + 1;
+    int ye = static_cast<int>(floor(range[3] / step[1])) + 1;
+
+    glLineStipple(1, 0x1111);
+    glEnable(GL_LINE_STIPPLE);
+    glColor3d(mGridColor.redF(), mGridColor.greenF(), mGridColor.blueF());
+    glBegin(GL_LINES);
+    for (int x = xs; x < xe; x++) {
+        glVertex2f(static_cast<float>(x * step[0]), static_cast<float>(range[2]));
+        glVertex2f(static_cast<float>(x * step[0]), static_cast<float>(range[3]));
+    }
+    for (int y = ys; y < ye; y++) {
+        glVertex2f(static_cast<float>(range[0]), static_cast<float>(y * step[1]));
+        glVertex2f(static_cast<float>(range[1]), static_cast<float>(y * step[1]));
+    }
+    glEnd();
+    glDisable(GL_LINE_STIPPLE);
+
+    // Ticks point from the lower and the left edge into the panel.
+    double tx = DEF_DRAW2D_MULTIPLES_TICK_SIZE * (range[1] - range[0]) / rect[2];
+    double ty = DEF_DRAW2D_MULTIPLES_TICK_SIZE * (range[3] - range[2]) / rect[3];
+    glColor3f(1, 1, 1);
+    glBegin(GL_LINES);
+    for (int x = xs; x < xe; x++) {
+        glVertex2f(static_cast<float>(x * step[0]), static_cast<float>(range[2]));
+        glVertex2f(static_cast<float>(x * step[0]), static_cast<float>(range[2] + ty));
+    }
+    for (int y = ys; y < ye; y++) {
+        glVertex2f(static_cast<float>(range[0]), static_cast<float>(y * step[1]));
+        glVertex2f(static_cast<float>(range[0] + tx), static_cast<float>(y * step[1]));
+    }
+    glEnd();
 }
 
 void OpenGL2dModel::setScaling(double xMin, double xMax, double yMin, double yMax)
@@ -220,6 +501,41 @@ void OpenGL2dModel::makeUniform()
     setScaling(mXmin, mXmax, mYmin, mYmax);
 }
 
+void OpenGL2dModel::fitPoints(double margin)
+{
+    if (mVerts == nullptr || mNumVerts == 0) {
+        return;
+    }
+
+    double xMin = 0.0, xMax = 0.0, yMin = 0.0, yMax = 0.0;
+    bool first = true;
+    for (size_t i = 0; i < mNumVerts; i++) {
+        GLfloat x, y;
+        getVertex(i, x, y);
+        if (!std::isfinite(x) || !std::isfinite(y)) {
+            continue;
+        }
+        xMin = (first ? x : std::min(xMin, static_cast<double>(x)));
+        xMax = (first ? x : std::max(xMax, static_cast<double>(x)));
+        yMin = (first ? y : std::min(yMin, static_cast<double>(y)));
+        yMax = (first ? y : std::max(yMax, static_cast<double>(y)));
+        first = false;
+    }
+
+    double dx = (xMax > xMin ? xMax - xMin : 1.0);
+    double dy = (yMax > yMin ? yMax - yMin : 1.0);
+    mXmin = xMin - margin * dx;
+    mXmax = xMin + (1.0 + margin) * dx;
+    mYmin = yMin - margin * dy;
+    mYmax = yMin + (1.0 + margin) * dy;
+    mAspect = (mXmax - mXmin) / (mYmax - mYmin);
+
+    adjust();
+    getTightLattice();
+    setLattice();
+    update();
+}
+
 void OpenGL2dModel::setStepIdx(int xidx, int yidx)
 {
     mXstepIdx = xidx;
@@ -241,6 +557,7 @@ void OpenGL2dModel::clearAllObjects()
     if (!mObjects.empty()) {
         mObjects.clear();
     }
+    mObjectsRevision++;
     update();
 }
 
@@ -249,6 +566,7 @@ void OpenGL2dModel::insertObject(MyObject* obj)
     makeCurrent();
     MyObject* no = new MyObject(*obj);
     mObjects.push_back(no);
+    mObjectsRevision++;
     update();
 }
 
@@ -295,6 +613,17 @@ void OpenGL2dModel::setStyle(enum_draw_style style)
     mDrawStyle = style;
 }
 
+void OpenGL2dModel::setTrails(int use, int num, int maxMBytes)
+{
+    mUseTrails = (use == 1);
+    mTrails.setMaxTrails(num);
+    mTrails.setMaxBytes(static_cast<size_t>(maxMBytes) * 1024 * 1024);
+    if (!mUseTrails) {
+        mTrails.clear();
+    }
+    update();
+}
+
 void OpenGL2dModel::showNumVerts(int num)
 {
     mShowNumVerts = static_cast<size_t>(std::max(0, std::min(num, static_cast<int>(mNumVerts))));
@@ -333,6 +662,62 @@ bool OpenGL2dModel::saveRGBimage(QString filename)
     return true;
 }
 
+void OpenGL2dModel::getSoftJob(struct_soft_job& job)
+{
+    job.view = enum_soft_view_2d;
+    job.width = mWinSize[0];
+    job.height = mWinSize[1];
+
+    job.params = *mParams;
+    job.params.draw2d_xMin = mXmin;
+    job.params.draw2d_xMax = mXmax;
+    job.params.draw2d_yMin = mYmin;
+    job.params.draw2d_yMax = mYmax;
+    job.params.draw2d_bg_color = mBGcolor;
+    job.params.draw2d_line_color = mFGcolor;
+    job.params.draw2d_grid_color = mGridColor;
+    job.params.draw2d_line_width = mLineWidth;
+
+    job.style = mDrawStyle;
+    job.verts.clear();
+    const GLfloat* plotVerts = getPlotVerts();
+    if (plotVerts != nullptr) {
+        job.verts.assign(plotVerts, plotVerts + mShowNumVerts * 2);
+    }
+    job.embMesh.reset();
+
+    job.objects.clear();
+    for (size_t i = 0; i < mObjects.size(); i++) {
+        struct_obj obj;
+        mObjects[i]->getObject(obj);
+        job.objects.push_back(obj);
+    }
+
+    // The effective potential is exported with the samples that are currently drawn.
+    job.effPot.clear();
+    job.effPotEnergy = std::numeric_limits<double>::quiet_NaN();
+    if (mDrawType == m4d::enum_draw_effpoti && mObject.currMetric != nullptr) {
+        mEffPot.getVerts(job.effPot);
+        double k;
+        if (mObject.currMetric->totEnergy(mObject.startPos, mObject.coordDir, 0.0, k)) {
+            job.effPotEnergy = k;
+        }
+    }
+    job.wiredObjs = false;
+    job.ok = false;
+}
+
+void OpenGL2dModel::showPassTimes(bool show)
+{
+    mPassTimer.setEnabled(show);
+    update();
+}
+
+bool OpenGL2dModel::savePassTimes(QString filename)
+{
+    return mPassTimer.saveLog(filename);
+}
+
 void OpenGL2dModel::updateParams()
 {
     mLineWidth = mParams->draw2d_line_width;
@@ -341,8 +726,9 @@ void OpenGL2dModel::updateParams()
     mFGcolor = mParams->draw2d_line_color;
     mGridColor = mParams->draw2d_grid_color;
 
-    mAbscissa = static_cast<enum_draw_coord_num>(mParams->draw2d_abscissa);
-    mOrdinate = static_cast<enum_draw_coord_num>(mParams->draw2d_ordinate);
+    setAbsOrd(static_cast<enum_draw_coord_num>(mParams->draw2d_abscissa),
+        static_cast<enum_draw_coord_num>(mParams->draw2d_ordinate));
+    setTrails(mParams->trails_use, mParams->trails_num, mParams->trails_max_mbytes);
 
     adjust();
     getTightLattice();
@@ -373,20 +759,74 @@ void OpenGL2dModel::initializeGL()
     mDPIFactor[0] = QApplication::desktop()->devicePixelRatioF();
     mDPIFactor[1] = QApplication::desktop()->devicePixelRatioF();
 
+    if (QOpenGLShaderProgram::hasOpenGLShaderPrograms()) {
+        mPlotShader = new QOpenGLShaderProgram();
+        mPlotShader->addShaderFromSourceCode(QOpenGLShader::Vertex, getPlotVertexShaderCode());
+        mPlotShader->addShaderFromSourceCode(QOpenGLShader::Fragment, getPlotFragmentShaderCode());
+        mPlotShader->bindAttributeLocation("position", 0);
+        mPlotShader->bindAttributeLocation("lambda", 1);
+        mPlotShader->bindAttributeLocation("direction", 2);
+        if (!mPlotShader->link()) {
+            fprintf(stderr, "Cannot link plot shader!\n");
+            delete mPlotShader;
+            mPlotShader = nullptr;
+        }
+    }
+
 #ifdef HAVE_FREETYPE
     renderText = new RenderText("resources/DroidSansMono.ttf", 12);
 #endif // HAVE_FREETYPE
 }
 
 void OpenGL2dModel::paintGL()
+{
+    mProjCache.releaseBuffers();
+
+    // The current geodesic becomes a trail as soon as a new one is shown.
+    if (mUseTrails && mVerts != nullptr) {
+        mTrails.push(mDrawRevision, mDrawType, mDrawParam, getPlotVerts(), mNumVerts);
+    }
+    mPassTimer.beginFrame();
+
+    if (isMultiples()) {
+        paintGL_multiples();
+    }
+    else {
+        // Ticks, lattice, objects, and labels are only drawn again when the scaling or the scene changed.
+        std::vector<double> key;
+        getStaticKey(key);
+        enum_layer_cache state = mStaticCache.check(key, mWinSize[0], mWinSize[1]);
+        if (state == enum_layer_cache_build) {
+            mStaticCache.begin();
+            paintGL_static();
+            mStaticCache.end();
+        }
+        if (state == enum_layer_cache_direct || !mStaticCache.blit()) {
+            paintGL_static();
+        }
+        paintGL_dynamic();
+    }
+
+    mPassTimer.endFrame();
+
+    mPassTimer.drawOverlay(
+        this, (mBGcolor.value() > 127 ? QColor(Qt::black) : QColor(Qt::white)), DEF_DRAW2D_LEFT_BORDER);
+}
+
+void OpenGL2dModel::paintGL_static()
 {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     // -----------------------
     //   draw ticks
     // -----------------------
+    mPassTimer.begin(enum_timed_pass_ticks);
     glColor3f(1, 1, 1);
 
+    // Lattice and ticks come from one buffer that is only rebuilt when the steps change
+    // or the view leaves its covered range.
+    mLattice.update(mXmin, mXmax, mYmin, mYmax, mXstep, mYstep);
+
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
 
@@ -394,35 +834,20 @@ void OpenGL2dModel::paintGL()
     glLoadIdentity();
     gluOrtho2D(mXmin, mXmax, 0, 1);
     glViewport(DEF_DRAW2D_LEFT_BORDER, 0, mWinSize[0] - DEF_DRAW2D_LEFT_BORDER, DEF_DRAW2D_BOTTOM_BORDER);
-    for (int x = xStart; x < xEnd; x++) {
-        glBegin(GL_LINES);
-        glVertex2f(static_cast<float>(x * mXstep), 0.6f);
-        glVertex2f(static_cast<float>(x * mXstep), 1.0f);
-        glEnd();
-    }
+    mLattice.drawXTicks();
 
     glLoadIdentity();
     gluOrtho2D(0, 1, mYmin, mYmax);
     glViewport(0, DEF_DRAW2D_BOTTOM_BORDER, DEF_DRAW2D_LEFT_BORDER, mWinSize[1] - DEF_DRAW2D_BOTTOM_BORDER);
-    for (int y = yStart; y < yEnd; y++) {
-        glBegin(GL_LINES);
-        glVertex2f(0.6f, static_cast<float>(y * mYstep));
-        glVertex2f(1.0f, static_cast<float>(y * mYstep));
-        glEnd();
-    }
+    mLattice.drawYTicks();
+    mPassTimer.end(enum_timed_pass_ticks);
 
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    gluOrtho2D(mXmin, mXmax, mYmin, mYmax);
-    glViewport(DEF_DRAW2D_LEFT_BORDER, DEF_DRAW2D_BOTTOM_BORDER, mWinSize[0] - DEF_DRAW2D_LEFT_BORDER,
-        mWinSize[1] - DEF_DRAW2D_BOTTOM_BORDER);
+    setPlotView();
 
     // -----------------------
     //   draw background
     // -----------------------
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
-
+    mPassTimer.begin(enum_timed_pass_lattice);
     glColor3d(mBGcolor.redF(), mBGcolor.greenF(), mBGcolor.blueF());
     glBegin(GL_QUADS);
     glVertex2f(static_cast<float>(mXmin), static_cast<float>(mYmin));
@@ -435,10 +860,12 @@ void OpenGL2dModel::paintGL()
     //   draw lattice
     // -----------------------
     drawLattice();
+    mPassTimer.end(enum_timed_pass_lattice);
 
     // -----------------------
     //   draw objects
     // -----------------------
+    mPassTimer.begin(enum_timed_pass_objects);
     for (unsigned int i = 0; i < mObjects.size(); i++) {
         if (mObjects[i]->getObjectDim() == enum_object_dim_2d) {
             if (!mObjects[i]->drawObject(false)) {
@@ -452,10 +879,43 @@ void OpenGL2dModel::paintGL()
             }
         }
     }
+    mPassTimer.end(enum_timed_pass_objects);
+
+    // -----------------------
+    //   draw tick labels
+    // -----------------------
+    mPassTimer.begin(enum_timed_pass_labels);
+#ifdef HAVE_FREETYPE
+    if (renderText != nullptr) {
+        // All labels are collected in window pixels and drawn with one call.
+        double xScale = (mWinSize[0] - DEF_DRAW2D_LEFT_BORDER) / (mXmax - mXmin);
+        double yScale = (mWinSize[1] - DEF_DRAW2D_BOTTOM_BORDER) / (mYmax - mYmin);
+        renderText->BeginBatch();
+        for (int x = xStart; x < xEnd; x++) {
+            int xpos = DEF_DRAW2D_LEFT_BORDER + static_cast<int>((x * mXstep - mXmin) * xScale);
+            renderText->AddToBatch(xpos, 2, QString::number(x * mXstep).toStdString().c_str(), ALIGN_HCENTER);
+        }
+        for (int y = yStart; y < yEnd; y++) {
+            int ypos = DEF_DRAW2D_BOTTOM_BORDER + static_cast<int>((y * mYstep - mYmin) * yScale);
+            renderText->AddToBatch(
+                DEF_DRAW2D_LEFT_BORDER - 3, ypos + 2, QString::number(y * mYstep).toStdString().c_str(), ALIGN_RIGHT);
+        }
+        glViewport(0, 0, mWinSize[0], mWinSize[1]);
+        renderText->SetWindowSize(mWinSize[0], mWinSize[1]);
+        renderText->DrawBatch();
+    }
+#endif // HAVE_FREETYPE
+    mPassTimer.end(enum_timed_pass_labels);
+}
+
+void OpenGL2dModel::paintGL_dynamic()
+{
+    setPlotView();
 
     // -----------------------
     //  draw geodesic
     // -----------------------
+    mPassTimer.begin(enum_timed_pass_geodesic);
     glLineWidth(mLineWidth);
     if (mLineSmooth == 1) {
         glEnable(GL_LINE_SMOOTH);
@@ -463,35 +923,54 @@ void OpenGL2dModel::paintGL()
 
     glColor3d(mFGcolor.redF(), mFGcolor.greenF(), mFGcolor.blueF());
 
-    glPointSize(mLineWidth);
-    glVertexPointer(2, GL_FLOAT, 0, mVerts);
-    glEnableClientState(GL_VERTEX_ARRAY);
-    if (mDrawStyle == enum_draw_lines) {
-        glDrawArrays(GL_LINE_STRIP, 0, static_cast<GLsizei>(mShowNumVerts));
-    }
-    else {
-        glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(mShowNumVerts));
+    if (mUseTrails && mVerts != nullptr) {
+        mTrails.draw(mFGcolor);
     }
 
-    glDisableClientState(GL_VERTEX_ARRAY);
+    glPointSize(mLineWidth);
+    GLenum mode = (mDrawStyle == enum_draw_lines ? GL_LINE_STRIP : GL_POINTS);
+    if (!drawChannels(mode)) {
+        QOpenGLBuffer* vbo = (mDim == 2 && mVerts != nullptr ? mProjCache.getBuffer(mVerts) : nullptr);
+        if (vbo != nullptr) {
+            vbo->bind();
+            glVertexPointer(2, GL_FLOAT, 0, nullptr);
+        }
+        else {
+            glVertexPointer(2, GL_FLOAT, 0, getPlotVerts());
+        }
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glDrawArrays(mode, 0, static_cast<GLsizei>(mShowNumVerts));
+        glDisableClientState(GL_VERTEX_ARRAY);
+        if (vbo != nullptr) {
+            vbo->release();
+        }
+    }
     glLineWidth(1);
     glDisable(GL_LINE_SMOOTH);
 
+    if (mVerts != nullptr && mPickedVertex >= 0 && static_cast<size_t>(mPickedVertex) < mShowNumVerts) {
+        QColor markerCol(DEF_PICK_MARKER_COLOR);
+        glPointSize(DEF_PICK_MARKER_SIZE);
+        glColor3d(markerCol.redF(), markerCol.greenF(), markerCol.blueF());
+        GLfloat x, y;
+        getVertex(static_cast<size_t>(mPickedVertex), x, y);
+        glBegin(GL_POINTS);
+        glVertex2f(x, y);
+        glEnd();
+        glPointSize(1);
+    }
+    mPassTimer.end(enum_timed_pass_geodesic);
+
     // -----------------------
     //   draw effective
     // -----------------------
+    mPassTimer.begin(enum_timed_pass_effpot);
     if (mDrawType == m4d::enum_draw_effpoti) {
         if (mObject.currMetric != nullptr) {
-            double xstep = (mXmax - mXmin) / static_cast<double>(mWinSize[0]);
+            mEffPot.update(mObjectRevision, mObject.currMetric, mObject.startPos, mObject.coordDir, mObject.type,
+                mXmin, mXmax);
             glColor3f(1, 0, 0);
-            glBegin(GL_LINE_STRIP);
-            for (double x = mXmin; x < mXmax; x += xstep) {
-                double val;
-                if (mObject.currMetric->effPotentialValue(mObject.startPos, mObject.coordDir, mObject.type, x, val)) {
-                    glVertex2f(static_cast<float>(x), static_cast<float>(val));
-                }
-            }
-            glEnd();
+            mEffPot.draw();
 
             double k;
             if (mObject.currMetric->totEnergy(mObject.startPos, mObject.coordDir, 0.0, k)) {
@@ -503,6 +982,7 @@ void OpenGL2dModel::paintGL()
             }
         }
     }
+    mPassTimer.end(enum_timed_pass_effpot);
 
     // -----------------------
     //   draw zoom quad
@@ -516,30 +996,195 @@ void OpenGL2dModel::paintGL()
         glVertex2f(static_cast<float>(mZoomXul), static_cast<float>(mZoomYul));
         glEnd();
     }
+}
+
+void OpenGL2dModel::paintGL_multiples()
+{
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+
+    // Each panel gets its own lattice steps from its range and size.
+    int numPanels = static_cast<int>(mPanels.size());
+    std::vector<double> steps(static_cast<size_t>(2 * numPanels));
+    for (int i = 0; i < numPanels; i++) {
+        int rect[4];
+        double range[4];
+        getPanelRect(i, rect);
+        getPanelRange(i, range);
+        steps[2 * i] = getPanelStep(range[1] - range[0], rect[2]);
+        steps[2 * i + 1] = getPanelStep(range[3] - range[2], rect[3]);
+    }
 
     // -----------------------
-    //   draw tick labels
+    //  draw lattice and ticks
     // -----------------------
-#ifdef HAVE_FREETYPE
-    if (renderText != nullptr) {
-        double xScale = 1.0 / (mXmax - mXmin) * mWinSize[0];
-        glViewport(DEF_DRAW2D_LEFT_BORDER, 0, mWinSize[0] - DEF_DRAW2D_LEFT_BORDER, DEF_DRAW2D_BOTTOM_BORDER);
-        renderText->SetWindowSize(mWinSize[0], DEF_DRAW2D_BOTTOM_BORDER);
-        for (int x = xStart; x < xEnd; x++) {
-            int xpos = static_cast<int>((x * mXstep - mXmin) * xScale);
-            renderText->Print(xpos, 2, QString::number(x * mXstep).toStdString().c_str(), ALIGN_HCENTER);
+    mPassTimer.begin(enum_timed_pass_lattice);
+    glEnable(GL_SCISSOR_TEST);
+    glClearColor(static_cast<GLfloat>(mBGcolor.redF()), static_cast<GLfloat>(mBGcolor.greenF()),
+        static_cast<GLfloat>(mBGcolor.blueF()), 1.0f);
+    for (int i = 0; i < numPanels; i++) {
+        int rect[4];
+        getPanelRect(i, rect);
+        glViewport(rect[0], rect[1], rect[2], rect[3]);
+        glScissor(rect[0], rect[1], rect[2], rect[3]);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        double range[4];
+        getPanelRange(i, range);
+        glMatrixMode(GL_PROJECTION);
+        glLoadIdentity();
+        gluOrtho2D(range[0], range[1], range[2], range[3]);
+        drawPanelLattice(rect, range, &steps[2 * i]);
+    }
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    mPassTimer.end(enum_timed_pass_lattice);
+
+    // -----------------------
+    //  draw panels
+    // -----------------------
+    mPassTimer.begin(enum_timed_pass_geodesic);
+    glLineWidth(mLineWidth);
+    if (mLineSmooth == 1) {
+        glEnable(GL_LINE_SMOOTH);
+    }
+    glPointSize(mLineWidth);
+    GLenum mode = (mDrawStyle == enum_draw_lines ? GL_LINE_STRIP : GL_POINTS);
+    bool showMarker = (mPickedVertex >= 0 && static_cast<size_t>(mPickedVertex) < mShowNumVerts);
+    QColor markerCol(DEF_PICK_MARKER_COLOR);
+
+    // The channel buffer is bound once; panels only differ in viewport, projection, and selected columns.
+    // Without plot shader, the columns of each panel are gathered in client memory.
+    bool haveChannels = bindChannels();
+    for (int i = 0; i < numPanels; i++) {
+        int rect[4];
+        getPanelRect(i, rect);
+        glViewport(rect[0], rect[1], rect[2], rect[3]);
+        glScissor(rect[0], rect[1], rect[2], rect[3]);
+
+        double range[4];
+        getPanelRange(i, range);
+        glMatrixMode(GL_PROJECTION);
+        glLoadIdentity();
+        gluOrtho2D(range[0], range[1], range[2], range[3]);
+
+        if (haveChannels) {
+            mPlotShader->setUniformValue("absCol", static_cast<int>(mPanels[i].abscissa));
+            mPlotShader->setUniformValue("ordCol", static_cast<int>(mPanels[i].ordinate));
+
+            glColor3d(mFGcolor.redF(), mFGcolor.greenF(), mFGcolor.blueF());
+            glDrawArrays(mode, 0, static_cast<GLsizei>(mShowNumVerts));
+            if (showMarker) {
+                glPointSize(DEF_PICK_MARKER_SIZE);
+                glColor3d(markerCol.redF(), markerCol.greenF(), markerCol.blueF());
+                glDrawArrays(GL_POINTS, mPickedVertex, 1);
+                glPointSize(mLineWidth);
+            }
+            continue;
         }
 
-        double yScale = 1.0 / (mYmax - mYmin) * mWinSize[1];
-        glViewport(0, DEF_DRAW2D_BOTTOM_BORDER, DEF_DRAW2D_LEFT_BORDER, mWinSize[1] - DEF_DRAW2D_BOTTOM_BORDER);
-        renderText->SetWindowSize(DEF_DRAW2D_LEFT_BORDER, mWinSize[1]);
-        for (int y = yStart; y < yEnd; y++) {
-            int ypos = static_cast<int>((y * mYstep - mYmin) * yScale);
-            renderText->Print(
-                DEF_DRAW2D_LEFT_BORDER - 3, ypos + 2, QString::number(y * mYstep).toStdString().c_str(), ALIGN_RIGHT);
+        const GLfloat* verts = getPanelVerts(i);
+        if (verts == nullptr) {
+            continue;
+        }
+        glColor3d(mFGcolor.redF(), mFGcolor.greenF(), mFGcolor.blueF());
+        glVertexPointer(2, GL_FLOAT, 0, verts);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glDrawArrays(mode, 0, static_cast<GLsizei>(mShowNumVerts));
+        glDisableClientState(GL_VERTEX_ARRAY);
+        if (showMarker) {
+            glPointSize(DEF_PICK_MARKER_SIZE);
+            glColor3d(markerCol.redF(), markerCol.greenF(), markerCol.blueF());
+            glBegin(GL_POINTS);
+            glVertex2f(verts[2 * mPickedVertex], verts[2 * mPickedVertex + 1]);
+            glEnd();
+            glPointSize(mLineWidth);
         }
     }
+    glDisable(GL_SCISSOR_TEST);
+    if (haveChannels) {
+        releaseChannels();
+    }
+    glPointSize(1);
+    glLineWidth(1);
+    glDisable(GL_LINE_SMOOTH);
+    mPassTimer.end(enum_timed_pass_geodesic);
+
+    // -----------------------
+    //   draw panel titles and tick labels
+    // -----------------------
+    mPassTimer.begin(enum_timed_pass_labels);
+#ifdef HAVE_FREETYPE
+    if (renderText != nullptr) {
+        // Labels next to the lower left corner and below the title are left out, they would overlap.
+        renderText->BeginBatch();
+        for (int i = 0; i < numPanels; i++) {
+            int rect[4];
+            double range[4];
+            getPanelRect(i, rect);
+            getPanelRange(i, range);
+            renderText->AddToBatch(
+                rect[0] + 4, rect[1] + rect[3] - 4, mPanels[i].title.toStdString().c_str(), ALIGN_LEFT | ALIGN_TOP);
+
+            const double* step = &steps[2 * i];
+            double xScale = rect[2] / (range[1] - range[0]);
+            double yScale = rect[3] / (range[3] - range[2]);
+            int xs = static_cast<int>(floor(range[0] / step[0])) + 1;
+            int xe = static_cast<int>(floor(range[1] / step[0])) + 1;
+            int ys = static_cast<int>(floor(range[2] / step[1])) + 1;
+            int ye = static_cast<int>(floor(range[3] / step[1])) + 1;
+            for (int x = xs; x < xe; x++) {
+                int xpos = rect[0] + static_cast<int>((x * step[0] - range[0]) * xScale);
+                if (xpos - rect[0] < DEF_DRAW2D_LEFT_BORDER) {
+                    continue;
+                }
+                renderText->AddToBatch(xpos, rect[1] + DEF_DRAW2D_MULTIPLES_TICK_SIZE + 2,
+                    QString::number(x * step[0]).toStdString().c_str(), ALIGN_HCENTER);
+            }
+            for (int y = ys; y < ye; y++) {
+                int ypos = rect[1] + static_cast<int>((y * step[1] - range[2]) * yScale);
+                if (ypos - rect[1] < DEF_DRAW2D_BOTTOM_BORDER || rect[1] + rect[3] - ypos < DEF_DRAW2D_BOTTOM_BORDER) {
+                    continue;
+                }
+                renderText->AddToBatch(rect[0] + DEF_DRAW2D_MULTIPLES_TICK_SIZE + 2, ypos + 2,
+                    QString::number(y * step[1]).toStdString().c_str(), ALIGN_LEFT);
+            }
+        }
+        glViewport(0, 0, mWinSize[0], mWinSize[1]);
+        renderText->SetWindowSize(mWinSize[0], mWinSize[1]);
+        renderText->DrawBatch();
+    }
 #endif // HAVE_FREETYPE
+    mPassTimer.end(enum_timed_pass_labels);
+}
+
+void OpenGL2dModel::setPlotView()
+{
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    gluOrtho2D(mXmin, mXmax, mYmin, mYmax);
+    glViewport(DEF_DRAW2D_LEFT_BORDER, DEF_DRAW2D_BOTTOM_BORDER, mWinSize[0] - DEF_DRAW2D_LEFT_BORDER,
+        mWinSize[1] - DEF_DRAW2D_BOTTOM_BORDER);
+
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+}
+
+void OpenGL2dModel::getStaticKey(std::vector<double>& key)
+{
+    key.clear();
+    key.push_back(mXmin);
+    key.push_back(mXmax);
+    key.push_back(mYmin);
+    key.push_back(mYmax);
+    key.push_back(mXstep);
+    key.push_back(mYstep);
+    key.push_back(mWinSize[0]);
+    key.push_back(mWinSize[1]);
+    key.push_back(mBGcolor.rgba());
+    key.push_back(mGridColor.rgba());
+    key.push_back(mObjectsRevision);
 }
 
 void OpenGL2dModel::resizeGL(int width, int height)
@@ -569,30 +1214,11 @@ void OpenGL2dModel::drawLattice()
     glEnable(GL_LINE_STIPPLE);
 
     glColor3d(mGridColor.redF(), mGridColor.greenF(), mGridColor.blueF());
-    for (int x = xStart; x < xEnd; x++) {
-        glBegin(GL_LINES);
-        glVertex2f(static_cast<float>(x * mXstep), static_cast<float>(mYmin));
-        glVertex2f(static_cast<float>(x * mXstep), static_cast<float>(mYmax));
-        glEnd();
-    }
-    for (int y = yStart; y < yEnd; y++) {
-        glBegin(GL_LINES);
-        glVertex2f(static_cast<float>(mXmin), static_cast<float>(y * mYstep));
-        glVertex2f(static_cast<float>(mXmax), static_cast<float>(y * mYstep));
-        glEnd();
-    }
+    mLattice.drawLattice();
     glDisable(GL_LINE_STIPPLE);
 
     // 'origin' cross
-    glBegin(GL_LINES);
-    glVertex2f(0.0f, static_cast<float>(mYmin));
-    glVertex2f(0.0f, static_cast<float>(mYmax));
-    glEnd();
-
-    glBegin(GL_LINES);
-    glVertex2f(static_cast<float>(mXmin), 0.0f);
-    glVertex2f(static_cast<float>(mXmax), 0.0f);
-    glEnd();
+    mLattice.drawOrigin();
 }
 
 void OpenGL2dModel::keyPressEvent(QKeyEvent* event)
@@ -629,6 +1255,9 @@ void OpenGL2dModel::keyPressEvent(QKeyEvent* event)
         adjust();
         setLattice();
     }
+    else {
+        return;
+    }
     update();
 }
 
@@ -646,12 +1275,25 @@ void OpenGL2dModel::mousePressEvent(QMouseEvent* event)
     mLastPos.setX(static_cast<int>(mLastPos.x() * mDPIFactor[0]));
     mLastPos.setY(static_cast<int>(mLastPos.y() * mDPIFactor[1]));
 
+    // Panels of the grid are fitted to the data; picking is all they take.
+    if (isMultiples() && !(mButtonPressed == Qt::LeftButton && event->modifiers() == Qt::ShiftModifier)) {
+        mButtonPressed = Qt::NoButton;
+        return;
+    }
+
     if (mButtonPressed == Qt::LeftButton && mModifiers == Qt::ControlModifier) {
         getXY(mLastPos, mZoomXul, mZoomYul);
         mZoomXlr = mZoomXul;
         mZoomYlr = mZoomYul;
         mShowZoom = true;
     }
+    else if (mButtonPressed == Qt::LeftButton && event->modifiers() == Qt::ShiftModifier) {
+        mButtonPressed = Qt::NoButton;
+        int idx = pickVertex(mLastPos);
+        if (idx >= 0) {
+            emit vertexPicked(idx);
+        }
+    }
 }
 
 void OpenGL2dModel::mouseReleaseEvent(QMouseEvent* event)
@@ -737,6 +1379,87 @@ void OpenGL2dModel::mouseMoveEvent(QMouseEvent* event)
     mParams->draw2d_yMin = mYmin;
     mParams->draw2d_yMax = mYmax;
     emit scalingChanged();
+
+    // Mouse tracking only updates the cursor position; the plot stays the same.
+    if (mButtonPressed != Qt::NoButton) {
+        update();
+    }
+}
+
+int OpenGL2dModel::pickVertex(QPoint pos)
+{
+    if (mVerts == nullptr || mShowNumVerts == 0) {
+        return -1;
+    }
+    if (isMultiples()) {
+        return pickPanelVertex(pos);
+    }
+    if (mFactorX <= 0.0 || mFactorY <= 0.0) {
+        return -1;
+    }
+    if (!mPickIndexValid) {
+        if (mDim == 2) {
+            mPickIndex.build(mVerts, mNumVerts);
+        }
+        else {
+            mPickIndex.build(mVerts, mNumVerts, mDim, mAbscissa, mOrdinate);
+        }
+        mPickIndexValid = true;
+    }
+
+    // Distances are measured in pixels, independent of the scaling of both axes.
+    double x, y;
+    getXY(pos, x, y);
+    return mPickIndex.nearest(x, y, 1.0 / mFactorX, 1.0 / mFactorY, DEF_PICK_RADIUS * mDPIFactor[0], mShowNumVerts);
+}
+
+int OpenGL2dModel::pickPanelVertex(QPoint pos)
+{
+    if (mDim != DEF_DRAW_COORD_NUM) {
+        return -1;
+    }
+
+    int px = pos.x();
+    int py = mWinSize[1] - pos.y();
+    for (int i = 0; i < static_cast<int>(mPanels.size()); i++) {
+        int rect[4];
+        getPanelRect(i, rect);
+        if (px < rect[0] || px >= rect[0] + rect[2] || py < rect[1] || py >= rect[1] + rect[3]) {
+            continue;
+        }
+
+        double range[4];
+        getPanelRange(i, range);
+        double wx = rect[2] / (range[1] - range[0]);
+        double wy = rect[3] / (range[3] - range[2]);
+        double x = range[0] + (px - rect[0]) / wx;
+        double y = range[2] + (py - rect[1]) / wy;
+
+        // Every panel selects other columns; a linear search is cheaper than a spatial index per click.
+        double maxDist = DEF_PICK_RADIUS * mDPIFactor[0];
+        double bestDist2 = maxDist * maxDist;
+        int best = -1;
+        const GLfloat* v = mVerts;
+        for (size_t n = 0; n < mShowNumVerts; n++, v += DEF_DRAW_COORD_NUM) {
+            double dx = (v[mPanels[i].abscissa] - x) * wx;
+            double dy = (v[mPanels[i].ordinate] - y) * wy;
+            double dist2 = dx * dx + dy * dy;
+            if (dist2 < bestDist2) {
+                bestDist2 = dist2;
+                best = static_cast<int>(n);
+            }
+        }
+        return best;
+    }
+    return -1;
+}
+
+void OpenGL2dModel::setPickedVertex(int idx)
+{
+    if (idx == mPickedVertex) {
+        return;
+    }
+    mPickedVertex = idx;
     update();
 }
 
@@ -816,3 +1539,42 @@ void OpenGL2dModel::setLattice()
     yStart = static_cast<int>(floor(mYmin / mYstep)) + 1;
     yEnd = static_cast<int>(floor(mYmax / mYstep)) + 1;
 }
+
+QString OpenGL2dModel::getPlotVertexShaderCode()
+{
+    // Channels in the order of enum_draw_coord_num: x0..x3, lambda, dx0..dx3.
+    QString vert;
+    vert += "attribute vec4  position;\n";
+    vert += "attribute float lambda;\n";
+    vert += "attribute vec4  direction;\n";
+    vert += "uniform int absCol;\n";
+    vert += "uniform int ordCol;\n";
+
+    vert += "float channel(int c)\n";
+    vert += "{\n";
+    vert += "   if (c<4)\n";
+    vert += "     return (c==0 ? position.x : (c==1 ? position.y : (c==2 ? position.z : position.w)));\n";
+    vert += "   if (c==4)\n";
+    vert += "     return lambda;\n";
+    vert += "   return (c==5 ? direction.x : (c==6 ? direction.y : (c==7 ? direction.z : direction.w)));\n";
+    vert += "}\n";
+
+    vert += "void main()\n";
+    vert += "{\n";
+    vert += "   gl_FrontColor = gl_Color;\n";
+    vert += "   gl_Position = gl_ModelViewProjectionMatrix * vec4(channel(absCol),channel(ordCol),0.0,1.0);\n";
+    vert += "}\n";
+
+    return vert;
+}
+
+QString OpenGL2dModel::getPlotFragmentShaderCode()
+{
+    QString frag;
+    frag += "void main()\n";
+    frag += "{\n";
+    frag += "gl_FragColor = gl_Color;\n";
+    frag += "}\n";
+
+    return frag;
+}
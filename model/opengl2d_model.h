@@ -10,10 +10,19 @@
 #define OPENGL2D_MODEL_H
 
 #include <QMouseEvent>
+#include <QOpenGLShaderProgram>
 #include <QOpenGLWidget>
 
+#include "utils/effpot_curve.h"
+#include "utils/geodesic_trails.h"
+#include "utils/gpu_pass_timer.h"
+#include "utils/layer_cache.h"
 #include "utils/myobject.h"
+#include "utils/plot_lattice.h"
+#include "utils/point_index.h"
+#include "utils/projection_cache.h"
 #include "utils/rendertext.h"
+#include "utils/soft_renderer.h"
 #include "utils/utilities.h"
 #include <gdefs.h>
 
@@ -37,6 +46,17 @@ public:
     void clearPoints();
     void setAbsOrd(enum_draw_coord_num absNum, enum_draw_coord_num ordNum);
 
+    /**
+     * @brief Show a grid of coordinate plots instead of the single view.
+     *
+     * Only used with the coordinates draw type. Every panel is fitted to the
+     * range of its channels and drawn from the same vertex buffer.
+     * @param rows    Number of panel rows; the grid is removed if zero.
+     * @param cols    Number of panel columns.
+     * @param panels  Panels filled row by row; surplus entries are ignored.
+     */
+    void setMultiples(int rows, int cols, const std::vector<struct_plot_panel>& panels);
+
     void setScaling(double xMin, double xMax, double yMin, double yMax);
     void getScaling(double& xMin, double& xMax, double& yMin, double& yMax);
 
@@ -54,8 +74,28 @@ public:
     void setLineWidth(int width);
     void setLineSmooth(int smooth);
     void setStyle(enum_draw_style style);
+    void setTrails(int use, int num, int maxMBytes);
 
     bool saveRGBimage(QString filename);
+
+    /**
+     * @brief Describe current view for the CPU renderer.
+     * @param job  Job without file name.
+     */
+    void getSoftJob(struct_soft_job& job);
+
+    /**
+     * @brief Show GPU time per render pass as overlay.
+     * @param show
+     */
+    void showPassTimes(bool show);
+
+    /**
+     * @brief Save logged GPU times per render pass.
+     * @param filename  Name of log file.
+     * @return true if file could be written.
+     */
+    bool savePassTimes(QString filename);
     void updateParams();
 
     void getCurrPos(double& x, double& y);
@@ -68,13 +108,36 @@ public:
     void reset();
     void makeUniform();
 
+    /**
+     * @brief Scale to the bounding box of the shown projection.
+     * @param margin  Relative margin around the bounding box.
+     */
+    void fitPoints(double margin);
+
+    /**
+     * @brief Find the shown vertex next to a window position.
+     * @param pos  Position in physical pixels.
+     * @return vertex index, or -1 if there is none within the pick radius.
+     */
+    int pickVertex(QPoint pos);
+
+    /**
+     * @brief Mark picked vertex.
+     * @param idx  Vertex index, or -1 to remove the marker.
+     */
+    void setPickedVertex(int idx);
+
 signals:
     void scalingChanged();
     void scalingReset();
+    void vertexPicked(int idx);
 
 protected:
     virtual void initializeGL();
     virtual void paintGL();
+    virtual void paintGL_static();
+    virtual void paintGL_dynamic();
+    virtual void paintGL_multiples();
     virtual void resizeGL(int width, int height);
     virtual void drawLattice();
 
@@ -86,9 +149,40 @@ protected:
     virtual void mouseMoveEvent(QMouseEvent* event);
 
     void getXY(QPoint pos, double& x, double& y);
+    double getCoordValue(enum_draw_coord_num num, size_t idx);
+    void getVertex(size_t idx, GLfloat& x, GLfloat& y);
+    const GLfloat* getPlotVerts();
+    bool bindChannels();
+    void releaseChannels();
+    bool drawChannels(GLenum mode);
+    bool isMultiples();
+    void getChannelRanges();
+    void getPanelRect(int idx, int* rect);
+    void getPanelRange(int idx, double* range);
+    double getPanelStep(double width, int pixels);
+    const GLfloat* getPanelVerts(int idx);
+    void drawPanelLattice(const int* rect, const double* range, const double* step);
+    int pickPanelVertex(QPoint pos);
     void adjust();
     void getTightLattice();
     void setLattice();
+    void setPlotView();
+    void getStaticKey(std::vector<double>& key);
+
+    QString getPlotVertexShaderCode();
+    QString getPlotFragmentShaderCode();
+
+    /**
+     * @brief Render passes measured by the GPU pass timer.
+     */
+    enum enum_timed_pass {
+        enum_timed_pass_ticks = 0,
+        enum_timed_pass_lattice,
+        enum_timed_pass_objects,
+        enum_timed_pass_geodesic,
+        enum_timed_pass_effpot,
+        enum_timed_pass_labels
+    };
 
 private:
     struct_params* mParams;
@@ -108,15 +202,43 @@ private:
     QColor mBGcolor;
     QColor mGridColor;
 
-    GLfloat* mVerts;
+    GLfloat* mVerts; //!< pinned entry of the shared projection cache
+    int mDim; //!< floats per vertex: two, or all channels of a coordinate plot
     size_t mNumVerts;
     size_t mShowNumVerts;
     int mLineWidth;
     int mLineSmooth;
 
     m4d::enum_draw_type mDrawType;
+    double mDrawParam;
+    unsigned int mDrawRevision;
+    EffPotCurve mEffPot;
+
+    PointIndex mPickIndex; //!< built on the first pick after a projection changed
+    bool mPickIndexValid;
+    int mPickedVertex;
+
+    // A coordinate plot keeps all channels on the GPU and selects abscissa and ordinate in the shader.
+    QOpenGLShaderProgram* mPlotShader;
+    std::vector<GLfloat> mPlotVerts; //!< selected columns, only for trails and the CPU renderer
+    bool mPlotVertsValid;
+
+    // Small multiples: all panels select their columns from the same channel buffer.
+    std::vector<struct_plot_panel> mPanels;
+    int mPanelGrid[2]; //!< rows, columns
+    double mChannelRange[DEF_DRAW_COORD_NUM][2];
+    bool mChannelRangeValid;
+    std::vector<GLfloat> mPanelVerts; //!< selected columns of one panel, only without plot shader
+
+    GeodesicTrails mTrails;
+    bool mUseTrails;
 
     std::vector<MyObject*> mObjects;
+    unsigned int mObjectsRevision;
+
+    GpuPassTimer mPassTimer;
+    LayerCache mStaticCache; //!< ticks, lattice, objects, and labels
+    PlotLattice mLattice;
 
     int xStart, xEnd;
     int yStart, yEnd;
@@ -6,23 +6,171 @@
  */
 #include "opengl3d_model.h"
 #include "math/TransCoordinates.h"
+#include "utils/batch_transform.h"
+#include "utils/png_stream_writer.h"
 #include "utils/utilities.h"
 
 #include <QApplication>
 #include <QDesktopWidget>
+#include <QOpenGLExtraFunctions>
+#include <QProgressDialog>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <limits>
+#include <vector>
 
 extern m4d::Object mObject;
+extern unsigned int mObjectRevision;
+extern ProjectionCache mProjCache;
+
+static const int SACHS_NUM_COMPS = 11;
+
+/**
+ * @brief Extension of both Sachs legs in negative (a) and positive (b) direction.
+ */
+static void getSachsLegFactors(enum_sachs_legs legs, double& l1a, double& l1b, double& l2a, double& l2b)
+{
+    l1a = l1b = l2a = l2b = 0.0;
+    switch (legs) {
+        case enum_sachs_legs_right_up:
+            l1b = 1.0;
+            l2b = 1.0;
+            break;
+        case enum_sachs_legs_up_left:
+            l1a = 1.0;
+            l2b = 1.0;
+            break;
+        case enum_sachs_legs_left_down:
+            l1a = 1.0;
+            l2a = 1.0;
+            break;
+        case enum_sachs_legs_down_right:
+            l1b = 1.0;
+            l2a = 1.0;
+            break;
+        case enum_sachs_legs_all:
+            l1a = l1b = l2a = l2b = 1.0;
+            break;
+    }
+}
+
+/**
+ * @brief Append triangles of a truncated cone along the z-axis with interleaved position and normal.
+ */
+static void addArrowMantle(std::vector<GLfloat>& verts, double r0, double r1, double z0, double z1)
+{
+    const int numSlices = 32;
+    double len = sqrt((r0 - r1) * (r0 - r1) + (z1 - z0) * (z1 - z0));
+    double nr = (z1 - z0) / len;
+    double nz = (r0 - r1) / len;
+
+    for (int i = 0; i < numSlices; i++) {
+        double phi[2] = { 2.0 * M_PI * i / numSlices, 2.0 * M_PI * (i + 1) / numSlices };
+        int order[6][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 0 }, { 1, 1 }, { 0, 1 } };
+        for (int k = 0; k < 6; k++) {
+            double c = cos(phi[order[k][0]]);
+            double s = sin(phi[order[k][0]]);
+            double r = (order[k][1] == 0 ? r0 : r1);
+            verts.push_back(static_cast<GLfloat>(r * c));
+            verts.push_back(static_cast<GLfloat>(r * s));
+            verts.push_back(static_cast<GLfloat>(order[k][1] == 0 ? z0 : z1));
+            verts.push_back(static_cast<GLfloat>(nr * c));
+            verts.push_back(static_cast<GLfloat>(nr * s));
+            verts.push_back(static_cast<GLfloat>(nz));
+        }
+    }
+}
+
+/**
+ * @brief Append triangles of a disk facing the negative z-axis.
+ */
+static void addArrowDisk(std::vector<GLfloat>& verts, double r, double z)
+{
+    const int numSlices = 32;
+    for (int i = 0; i < numSlices; i++) {
+        double phi[3] = { 0.0, 2.0 * M_PI * (i + 1) / numSlices, 2.0 * M_PI * i / numSlices };
+        for (int k = 0; k < 3; k++) {
+            double rk = (k == 0 ? 0.0 : r);
+            verts.push_back(static_cast<GLfloat>(rk * cos(phi[k])));
+            verts.push_back(static_cast<GLfloat>(rk * sin(phi[k])));
+            verts.push_back(static_cast<GLfloat>(z));
+            verts.push_back(0.0f);
+            verts.push_back(0.0f);
+            verts.push_back(-1.0f);
+        }
+    }
+}
+
+/**
+ * @brief Prologue of the line and Sachs shaders.
+ *
+ * The stereo variant transforms each vertex with the matrices of eye gl_InstanceID
+ * and squeezes it into the left or right half of the side-by-side target.
+ */
+static QString getStereoPrologue(bool stereo, bool vertexStage)
+{
+    QString code;
+    if (!stereo) {
+        if (vertexStage) {
+            code += "#define MODELVIEW    gl_ModelViewMatrix\n";
+            code += "#define PROJECTION   gl_ProjectionMatrix\n";
+            code += "#define NORMALMATRIX gl_NormalMatrix\n";
+            code += "vec4 stereoClip(vec4 c) { return c; }\n";
+        }
+        return code;
+    }
+
+    code += "#version 150 compatibility\n";
+    if (vertexStage) {
+        code += "uniform mat4 eyeMV[2];\n";
+        code += "uniform mat4 eyeProj[2];\n";
+        code += "#define MODELVIEW    eyeMV[gl_InstanceID]\n";
+        code += "#define PROJECTION   eyeProj[gl_InstanceID]\n";
+        code += "#define NORMALMATRIX mat3(eyeMV[gl_InstanceID])\n";
+        code += "vec4 stereoClip(vec4 c)\n";
+        code += "{\n";
+        code += "   float s = (gl_InstanceID==0 ? -1.0 : 1.0);\n";
+        code += "   vec4  h = vec4(0.5*c.x + 0.5*s*c.w, c.yzw);\n";
+        code += "   gl_ClipDistance[0] = s*h.x;\n";
+        code += "   return h;\n";
+        code += "}\n";
+    }
+    return code;
+}
 
 OpenGL3dModel::OpenGL3dModel(struct_params* par, QWidget* parent)
     : QOpenGLWidget(parent)
+    , mStaticCache(true)
+    , mGeodIBO(QOpenGLBuffer::IndexBuffer)
+    , mTrails(3)
+    , mSachsVBO(QOpenGLBuffer::VertexBuffer)
+    , mEmbVBO(QOpenGLBuffer::VertexBuffer)
+    , mEmbIBO(QOpenGLBuffer::IndexBuffer)
+    , mAxesVBO(QOpenGLBuffer::VertexBuffer)
+    , mPassTimer(QStringList() << "embedding"
+                               << "geodesic"
+                               << "sachs"
+                               << "objects"
+                               << "axes")
 {
     mParams = par;
     mDPIFactor[0] = mDPIFactor[1] = 1.0;
     mLineSmooth = 0;
-    mEmbNumElems = 0;
     mGLSLsupported = false;
     shader = nullptr;
+    mLineShader = nullptr;
+    mTubeShader = nullptr;
+    mTubeSupported = false;
+    mSachsShaderStereo = nullptr;
+    mLineShaderStereo = nullptr;
+    mTubeShaderStereo = nullptr;
+    mAnaglyphShader = nullptr;
+    mPickShader = nullptr;
+    mPickFBO = nullptr;
+    mPickedVertex = -1;
 
     mCamera.setSize(DEF_OPENGL_WIDTH, DEF_OPENGL_HEIGHT);
     mCamera.setEyePos(m4d::vec3(&mParams->opengl_eye_pos[0]));
@@ -39,33 +187,53 @@ OpenGL3dModel::OpenGL3dModel(struct_params* par, QWidget* parent)
     mFGcolor = mParams->opengl_line_color;
 
     mLineWidth = mParams->opengl_line_width;
+    mLineMode = static_cast<enum_line_mode>(mParams->opengl_line_mode);
+    mTubeRadius = mParams->opengl_tube_radius;
+    mGeodIBONumVerts = 0;
+
+    mCmapScalar = static_cast<enum_geod_scalar>(mParams->opengl_cmap_scalar);
+    mCmapType = static_cast<enum_colormap>(mParams->opengl_cmap_type);
+    mCmapAuto = (mParams->opengl_cmap_auto == 1);
+    mCmapMin = mParams->opengl_cmap_min;
+    mCmapMax = mParams->opengl_cmap_max;
 
     mProjection = static_cast<enum_projection>(mParams->opengl_projection);
     mDrawStyle = enum_draw_lines;
 
-    // Vertices for the geodesic.
+    // Vertices for the geodesic, shared with the other views.
+    mProjCache.attach();
     mVerts = nullptr;
-    mLambda = nullptr;
     mNumVerts = 0;
     mShowNumVerts = 0;
+    mDrawType = m4d::enum_draw_pseudocart;
+    mDrawParam = 0.0;
+    mDrawRevision = 0;
+
+    // Trails of previous geodesics.
+    mUseTrails = (mParams->trails_use == 1);
+    mTrails.setMaxTrails(mParams->trails_num);
+    mTrails.setMaxBytes(static_cast<size_t>(mParams->trails_max_mbytes) * 1024 * 1024);
 
-    mSachsLegs = mParams->opengl_sachs_legs;
-    mSachsScale = mParams->opengl_sachs_scale;
-    mSachsVerts1 = nullptr;
-    mSachsVerts2 = nullptr;
-    mNumSachsVerts1 = 0;
-    mNumSachsVerts2 = 0;
+    // Sachs legs are expanded on the GPU.
+    mSachsData = nullptr;
+    mNumSachsPoints = 0;
+    mSachsRevision = 0;
+    mSachsNeedUpload = false;
 
     // Data structures for an embedding diagram.
-    mEmbVerts = nullptr;
-    mEmbNumVerts = 0;
-    mEmbIndices = nullptr;
-    mEmbCounter = 0;
-    mCount = nullptr;
+    mEmbMesh.setReceiver(this);
+    mPrimRestart = false;
+    mAxesNumVerts = 0;
 
     mScaleX = mScaleY = mScaleZ = 1.0;
 
     mStereo = (mParams->opengl_stereo_use == 1);
+    mStereoSupported = false;
+    mStereoPass = enum_stereo_pass_none;
+    mStereoFBO = nullptr;
+    mTileScale = 1.0;
+    mLayerPass = enum_layer_pass_all;
+    mPathPreview = false;
     mUseFog = (mParams->opengl_fog_use == 1);
     mFogDensity = mParams->opengl_fog_init; // DEF_OPENGL_FOG_DENSITY_INIT;
     // QGLFormat f = format();
@@ -78,79 +246,96 @@ OpenGL3dModel::OpenGL3dModel(struct_params* par, QWidget* parent)
     if (!mObjects.empty()) {
         mObjects.clear();
     }
+    mObjectsRevision = 0;
     mWiredObjs = false;
 
-    mQuadricAxis = gluNewQuadric();
-    gluQuadricNormals(mQuadricAxis, GLU_SMOOTH);
-    gluQuadricDrawStyle(mQuadricAxis, GLU_FILL);
-    gluQuadricTexture(mQuadricAxis, GL_FALSE);
-    mQuadricDisk = gluNewQuadric();
-    gluQuadricNormals(mQuadricDisk, GLU_SMOOTH);
-    gluQuadricDrawStyle(mQuadricDisk, GLU_FILL);
-    gluQuadricTexture(mQuadricDisk, GL_FALSE);
-    redLight[1] = redLight[2] = greenLight[0] = greenLight[2] = blueLight[0] = blueLight[1] = 0.0f;
-    redLight[0] = greenLight[1] = blueLight[2] = 1.0f;
-
     mNameOfZaxis = QString("z");
+#ifdef HAVE_FREETYPE
+    renderText = nullptr;
+    mObjectLabelsRevision = 0;
+    mObjectLabelsScale = 0.0;
+#endif // HAVE_FREETYPE
 }
 
 OpenGL3dModel::~OpenGL3dModel()
 {
-    if (mQuadricAxis != nullptr) {
-        gluDeleteQuadric(mQuadricAxis);
+    makeCurrent();
+    mProjCache.unpin(mVerts);
+    if (mProjCache.detach() == 0) {
+        mProjCache.clear();
     }
-    mQuadricAxis = nullptr;
-    if (mQuadricDisk != nullptr) {
-        gluDeleteQuadric(mQuadricDisk);
+    mProjCache.releaseBuffers();
+    mTrails.releaseBuffer();
+    mColormap.release();
+    mEmbVAO.destroy();
+    mEmbVBO.destroy();
+    mEmbIBO.destroy();
+    mAxesVAO.destroy();
+    mAxesVBO.destroy();
+    mSachsVBO.destroy();
+    mGeodIBO.destroy();
+    if (mLineShader != nullptr) {
+        delete mLineShader;
+        mLineShader = nullptr;
     }
-    mQuadricDisk = nullptr;
+    if (mTubeShader != nullptr) {
+        delete mTubeShader;
+        mTubeShader = nullptr;
+    }
+    delete mSachsShaderStereo;
+    delete mLineShaderStereo;
+    delete mTubeShaderStereo;
+    delete mAnaglyphShader;
+    delete mPickShader;
+    delete mStereoFBO;
+    delete mPickFBO;
+    mSachsShaderStereo = mLineShaderStereo = mTubeShaderStereo = mAnaglyphShader = mPickShader = nullptr;
+    mStereoFBO = mPickFBO = nullptr;
+    mStaticCache.release();
+    mObjMeshes.release();
+    mPassTimer.release();
+#ifdef HAVE_FREETYPE
+    delete renderText;
+    renderText = nullptr;
+#endif // HAVE_FREETYPE
+    doneCurrent();
+
+    SafeDelete<GLfloat>(mSachsData);
 }
 
 void OpenGL3dModel::setPoints(m4d::enum_draw_type dtype, bool needUpdate)
 {
-    SafeDelete<GLfloat>(mVerts);
-    SafeDelete<GLfloat>(mLambda);
-
     mNumVerts = static_cast<int>(mObject.points.size());
-    mVerts = new GLfloat[static_cast<size_t>(mNumVerts * 3)];
-    mLambda = new GLfloat[static_cast<size_t>(mNumVerts)];
-
-    GLfloat* vptr = mVerts;
-    GLfloat* lptr = mLambda;
 
     mNameOfZaxis = QString("z");
+    if (dtype == m4d::enum_draw_twoplusone) {
+        mNameOfZaxis = QString("t");
+    }
 
-    m4d::vec4 tp;
-    for (int i = 0; i < mNumVerts; i++) {
-        size_t idx = static_cast<size_t>(i);
-        switch (dtype) {
-            case m4d::enum_draw_pseudocart:
-                mObject.currMetric->transToPseudoCart(mObject.points[idx], tp);
-                break;
-            case m4d::enum_draw_coordinates:
-                break;
-            case m4d::enum_draw_embedding:
-                mObject.currMetric->transToEmbedding(mObject.points[idx], tp);
-                tp[3] += mParams->opengl_emb_offset;
-                break;
-            case m4d::enum_draw_twoplusone:
-                mObject.currMetric->transToTwoPlusOne(mObject.points[idx], tp);
-                mNameOfZaxis = QString("t");
-                break;
-            case m4d::enum_draw_effpoti:
-                break;
-            case m4d::enum_draw_custom:
-                mObject.currMetric->transToCustom(mObject.points[idx], tp);
-                break;
+    // Projections of the current trajectory are cached per draw type.
+    double param = (dtype == m4d::enum_draw_embedding ? mParams->opengl_emb_offset : 0.0);
+    mDrawType = dtype;
+    mDrawParam = param;
+    if (mDrawRevision != mObjectRevision) {
+        mPickedVertex = -1;
+    }
+    mDrawRevision = mObjectRevision;
+    size_t numFloats = 0;
+    GLfloat* prevVerts = mVerts;
+    mVerts = mProjCache.find(mObjectRevision, dtype, param, 3, numFloats);
+    if (mVerts == nullptr) {
+        numFloats = static_cast<size_t>(mNumVerts * 3);
+        mVerts = mProjCache.insert(mObjectRevision, dtype, param, 3, numFloats);
+        if (!transformPoints(mObject.currMetric, dtype, mObject.points, mVerts, 3, param)) {
+            memset(mVerts, 0, sizeof(GLfloat) * numFloats);
         }
-        *(vptr++) = GLfloat(tp[1]);
-        *(vptr++) = GLfloat(tp[2]);
-        *(vptr++) = GLfloat(tp[3]);
-
-        *(lptr++) = GLfloat(mObject.lambda[idx]);
     }
+    mProjCache.unpin(prevVerts);
 
     mShowNumVerts = mNumVerts;
+    if (mCmapScalar != enum_geod_scalar_none) {
+        mColormap.setTrajectory(&mObject, mObjectRevision);
+    }
     if (needUpdate) {
         update();
     }
@@ -158,89 +343,54 @@ void OpenGL3dModel::setPoints(m4d::enum_draw_type dtype, bool needUpdate)
 
 void OpenGL3dModel::setSachsAxes(bool needUpdate)
 {
-    SafeDelete<GLfloat>(mSachsVerts1);
-    SafeDelete<GLfloat>(mSachsVerts2);
-
-    mNumSachsVerts1 = static_cast<int>(mObject.sachs1.size());
-    mNumSachsVerts2 = static_cast<int>(mObject.sachs2.size());
-    int mv = static_cast<int>(mObject.points.size());
+    // Leg selection and scale are uniforms; the data only depend on the trajectory.
+    if (mSachsData != nullptr && mSachsRevision == mObjectRevision) {
+        if (needUpdate) {
+            update();
+        }
+        return;
+    }
 
-    mSachsVerts1 = new GLfloat[static_cast<size_t>(mNumSachsVerts1 * 3 * 2)];
-    mSachsVerts2 = new GLfloat[static_cast<size_t>(mNumSachsVerts2 * 3 * 2)];
+    SafeDelete<GLfloat>(mSachsData);
+    mNumSachsPoints = static_cast<int>(
+        std::min(std::min(mObject.sachs1.size(), mObject.sachs2.size()), mObject.points.size()));
+    mSachsData = new GLfloat[static_cast<size_t>(mNumSachsPoints * 2 * SACHS_NUM_COMPS)];
+    mSachsRevision = mObjectRevision;
 
-    GLfloat* vptr1 = mSachsVerts1;
-    GLfloat* vptr2 = mSachsVerts2;
+    GLfloat* vptr = mSachsData;
 
     m4d::vec4 tp;
     m4d::vec4 d1, d2, s1, s2;
 
-    int n1 = 0, n2 = 0;
-    while (n1 < mNumSachsVerts1 && n2 < mNumSachsVerts2 && n1 < mv) {
-        double f, l1a = 0.0, l1b = 0.0, l2a = 0.0, l2b = 0.0;
-        size_t ni1 = static_cast<size_t>(n1);
-        size_t ni2 = static_cast<size_t>(n2);
+    for (int n = 0; n < mNumSachsPoints; n++) {
+        double f;
+        size_t ni = static_cast<size_t>(n);
 
         // reparametrization
-        f = mObject.sachs1[ni1].x(0) / mObject.dirs[ni1].x(0);
-        s1 = mObject.sachs1[ni1] - f * mObject.dirs[ni1];
-        f = mObject.sachs2[ni2].x(0) / mObject.dirs[ni2].x(0);
-        s2 = mObject.sachs2[ni2] - f * mObject.dirs[ni2];
-
-        m4d::TransCoordinates::toCartesianCoord(mObject.currMetric->getCoordType(), mObject.points[ni1], s1, tp, d1);
-        m4d::TransCoordinates::toCartesianCoord(mObject.currMetric->getCoordType(), mObject.points[ni1], s2, tp, d2);
-
-        d1 *= mParams->opengl_sachs_scale;
-        d2 *= mParams->opengl_sachs_scale;
-
-        switch (mParams->opengl_sachs_legs) {
-            case enum_sachs_legs_right_up:
-                l1a = 0.0;
-                l1b = 1.0;
-                l2a = 0.0;
-                l2b = 1.0;
-                break;
-            case enum_sachs_legs_up_left:
-                l1a = 1.0;
-                l1b = 0.0;
-                l2a = 0.0;
-                l2b = 1.0;
-                break;
-            case enum_sachs_legs_left_down:
-                l1a = 1.0;
-                l1b = 0.0;
-                l2a = 1.0;
-                l2b = 0.0;
-                break;
-            case enum_sachs_legs_down_right:
-                l1a = 0.0;
-                l1b = 1.0;
-                l2a = 1.0;
-                l2b = 0.0;
-                break;
-            case enum_sachs_legs_all:
-                l1a = 1.0;
-                l1b = 1.0;
-                l2a = 1.0;
-                l2b = 1.0;
-                break;
+        f = mObject.sachs1[ni].x(0) / mObject.dirs[ni].x(0);
+        s1 = mObject.sachs1[ni] - f * mObject.dirs[ni];
+        f = mObject.sachs2[ni].x(0) / mObject.dirs[ni].x(0);
+        s2 = mObject.sachs2[ni] - f * mObject.dirs[ni];
+
+        m4d::TransCoordinates::toCartesianCoord(mObject.currMetric->getCoordType(), mObject.points[ni], s1, tp, d1);
+        m4d::TransCoordinates::toCartesianCoord(mObject.currMetric->getCoordType(), mObject.points[ni], s2, tp, d2);
+
+        GLfloat lambda = (ni < mObject.lambda.size() ? static_cast<GLfloat>(mObject.lambda[ni]) : 0.0f);
+        for (int side = 0; side < 2; side++) {
+            for (int k = 1; k < 4; k++) {
+                *(vptr++) = GLfloat(tp[k]);
+            }
+            for (int k = 1; k < 4; k++) {
+                *(vptr++) = GLfloat(d1[k]);
+            }
+            for (int k = 1; k < 4; k++) {
+                *(vptr++) = GLfloat(d2[k]);
+            }
+            *(vptr++) = lambda;
+            *(vptr++) = static_cast<GLfloat>(side);
         }
-
-        *(vptr1++) = GLfloat(tp[1] - l1a * d1[1]);
-        *(vptr1++) = GLfloat(tp[2] - l1a * d1[2]);
-        *(vptr1++) = GLfloat(tp[3] - l1a * d1[3]);
-        *(vptr1++) = GLfloat(tp[1] + l1b * d1[1]);
-        *(vptr1++) = GLfloat(tp[2] + l1b * d1[2]);
-        *(vptr1++) = GLfloat(tp[3] + l1b * d1[3]);
-
-        *(vptr2++) = GLfloat(tp[1] - l2a * d2[1]);
-        *(vptr2++) = GLfloat(tp[2] - l2a * d2[2]);
-        *(vptr2++) = GLfloat(tp[3] - l2a * d2[3]);
-        *(vptr2++) = GLfloat(tp[1] + l2b * d2[1]);
-        *(vptr2++) = GLfloat(tp[2] + l2b * d2[2]);
-        *(vptr2++) = GLfloat(tp[3] + l2b * d2[3]);
-        n1++;
-        n2++;
     }
+    mSachsNeedUpload = true;
 
     if (needUpdate) {
         update();
@@ -249,17 +399,18 @@ void OpenGL3dModel::setSachsAxes(bool needUpdate)
 
 void OpenGL3dModel::clearSachsAxes()
 {
-    SafeDelete<GLfloat>(mSachsVerts1);
-    SafeDelete<GLfloat>(mSachsVerts2);
+    SafeDelete<GLfloat>(mSachsData);
 
-    mNumSachsVerts1 = mNumSachsVerts2 = 0;
+    mNumSachsPoints = 0;
+    mSachsNeedUpload = false;
     update();
 }
 
 void OpenGL3dModel::clearPoints()
 {
-    SafeDelete<GLfloat>(mVerts);
-    SafeDelete<GLfloat>(mLambda);
+    mProjCache.unpin(mVerts);
+    mVerts = nullptr;
+    mPickedVertex = -1;
 
     mNumVerts = 0;
     mShowNumVerts = 0;
@@ -268,64 +419,14 @@ void OpenGL3dModel::clearPoints()
 
 void OpenGL3dModel::genEmbed(m4d::Metric* currMetric)
 {
-    SafeDelete<GLfloat>(mEmbVerts);
-
-    if (mEmbIndices != nullptr) {
-        for (unsigned int j = 0; j < mEmbCounter; j++) {
-            delete[] mEmbIndices[j];
-        }
-        delete[] mEmbIndices;
-        mEmbIndices = nullptr;
-    }
-    mEmbNumElems = mEmbCounter = 0;
-
-    SafeDelete<GLsizei>(mCount);
-
-    unsigned int* indices = nullptr;
-
-    if (currMetric == nullptr) {
-        return;
-    }
-
-    if ((mEmbNumVerts = currMetric->getEmbeddingVertices(mEmbVerts, indices, mEmbNumElems, mEmbCounter)) == 0) {
-        return;
-    }
-
-    mCount = new GLsizei[mEmbCounter];
-    mEmbIndices = new unsigned int*[mEmbCounter];
-    for (unsigned int i = 0; i < mEmbCounter; i++) {
-        mEmbIndices[i] = new unsigned int[mEmbNumElems * 2];
-    }
-
-    // std::cerr << mEmbNumElems << " " << mEmbCounter << std::endl;
-
-    unsigned int k = 0;
-    for (unsigned int i = 0; i < mEmbCounter; i++) {
-        for (unsigned int j = 0; j < mEmbNumElems * 2; j++) {
-            mEmbIndices[i][j] = indices[k++];
-        }
-        mCount[i] = static_cast<GLsizei>(mEmbNumElems * 2);
-    }
-
+    // A cached mesh is shown at once, a new one as soon as the worker has finished.
+    mEmbMesh.request(currMetric);
     update();
 }
 
 void OpenGL3dModel::clearEmbed()
 {
-    SafeDelete<GLfloat>(mEmbVerts);
-    mEmbNumVerts = 0;
-
-    if (mEmbIndices != nullptr) {
-        for (unsigned int j = 0; j < mEmbCounter; j++) {
-            delete[] mEmbIndices[j];
-        }
-        delete[] mEmbIndices;
-        mEmbIndices = nullptr;
-    }
-
-    SafeDelete<GLsizei>(mCount);
-
-    mEmbNumElems = mEmbCounter = 0;
+    mEmbMesh.clear();
     update();
 }
 
@@ -421,6 +522,7 @@ void OpenGL3dModel::clearAllObjects()
     if (!mObjects.empty()) {
         mObjects.clear();
     }
+    mObjectsRevision++;
     update();
 }
 
@@ -429,6 +531,7 @@ void OpenGL3dModel::insertObject(MyObject* obj)
     makeCurrent();
     MyObject* no = new MyObject(*obj);
     mObjects.push_back(no);
+    mObjectsRevision++;
     update();
 }
 
@@ -463,11 +566,49 @@ void OpenGL3dModel::setLineSmooth(int smooth)
     update();
 }
 
+void OpenGL3dModel::setLineMode(int mode, double tubeRadius)
+{
+    mLineMode = static_cast<enum_line_mode>(mode);
+    mTubeRadius = tubeRadius;
+    update();
+}
+
+void OpenGL3dModel::setColormap(int scalar, int cmap, bool autoRange, double min, double max)
+{
+    mCmapScalar = static_cast<enum_geod_scalar>(scalar);
+    mCmapType = static_cast<enum_colormap>(cmap);
+    mCmapAuto = autoRange;
+    mCmapMin = min;
+    mCmapMax = max;
+
+    // The scalars are only computed once a scalar is selected, then only uniforms change.
+    if (mCmapScalar != enum_geod_scalar_none && mVerts != nullptr) {
+        mColormap.setTrajectory(&mObject, mObjectRevision);
+    }
+    update();
+}
+
+void OpenGL3dModel::getColormapRange(double& min, double& max)
+{
+    mColormap.getRange(mCmapScalar, min, max);
+}
+
 void OpenGL3dModel::setStyle(enum_draw_style style)
 {
     mDrawStyle = style;
 }
 
+void OpenGL3dModel::setTrails(int use, int num, int maxMBytes)
+{
+    mUseTrails = (use == 1);
+    mTrails.setMaxTrails(num);
+    mTrails.setMaxBytes(static_cast<size_t>(maxMBytes) * 1024 * 1024);
+    if (!mUseTrails) {
+        mTrails.clear();
+    }
+    update();
+}
+
 void OpenGL3dModel::setScaling(double sx, double sy, double sz)
 {
     mScaleX = sx;
@@ -540,6 +681,10 @@ void OpenGL3dModel::getAnimRotationParams(double& rx, double& ry, double& rz)
 
 void OpenGL3dModel::doAnimRotation(double msec, bool local)
 {
+    if (mAnimRotX == 0.0 && mAnimRotY == 0.0 && mAnimRotZ == 0.0) {
+        return;
+    }
+
     if (local) {
         mCamera.fixRotAroundVup(mAnimRotZ * msec * 1e-3);
         mCamera.fixRotAroundRight(mAnimRotX * msec * 1e-3);
@@ -564,31 +709,293 @@ void OpenGL3dModel::showNumVerts(int num)
 
 bool OpenGL3dModel::saveRGBimage(QString filename)
 {
-    makeCurrent();
-    if (width() == 0 || height() == 0) {
+    int camWidth, camHeight;
+    mCamera.getSize(camWidth, camHeight);
+
+    // A zero image size means window size.
+    int imgWidth = (mParams->opengl_img_width > 0 ? mParams->opengl_img_width : camWidth);
+    int imgHeight = (mParams->opengl_img_height > 0 ? mParams->opengl_img_height : camHeight);
+    if (imgWidth <= 0 || imgHeight <= 0 || camHeight <= 0) {
         fprintf(stderr, "Image size is null!\n");
         return false;
     }
 
-    unsigned char* buf = new unsigned char[static_cast<size_t>(width() * height() * 3)];
+    makeCurrent();
+
+    // The stereo target holds two tiles side by side.
+    GLint maxDims[2];
+    glGetIntegerv(GL_MAX_VIEWPORT_DIMS, maxDims);
+    int tileWidth = std::min(std::min(imgWidth, DEF_OPENGL_EXPORT_TILE_SIZE), static_cast<int>(maxDims[0] / 2));
+    int tileHeight = std::min(std::min(imgHeight, DEF_OPENGL_EXPORT_TILE_SIZE), static_cast<int>(maxDims[1]));
 
-    update();
-    glReadBuffer(GL_BACK);
-    glReadPixels(0, 0, width(), height(), GL_RGB, GL_UNSIGNED_BYTE, buf);
+    QOpenGLFramebufferObject fbo(tileWidth, tileHeight, QOpenGLFramebufferObject::Depth);
+    if (!fbo.isValid()) {
+        fprintf(stderr, "Cannot create framebuffer for image export!\n");
+        doneCurrent();
+        return false;
+    }
+
+    PngStreamWriter writer;
+    if (!writer.open(filename, imgWidth, imgHeight)) {
+        doneCurrent();
+        return false;
+    }
 
-    QImage img(buf, width(), height(), QImage::Format_RGB888);
-    QTransform trans;
-    trans.scale(1.0, -1.0);
-    QImage flippedImage = img.transformed(trans);
-    if (!flippedImage.isNull()) {
-        flippedImage.save(filename);
+    mCamera.setSize(imgWidth, imgHeight);
+    mTileScale = imgHeight / static_cast<double>(camHeight);
+
+    // Png rows run from top to bottom: render bands of tiles starting at the top,
+    // and stream each band as soon as it is complete.
+    std::vector<unsigned char> band(static_cast<size_t>(imgWidth) * static_cast<size_t>(tileHeight * 3));
+    std::vector<unsigned char> tile(static_cast<size_t>(tileWidth * tileHeight * 3));
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    bool ok = true;
+    for (int y1 = imgHeight; y1 > 0 && ok; y1 -= tileHeight) {
+        int y0 = std::max(0, y1 - tileHeight);
+        int bandHeight = y1 - y0;
+
+        for (int x0 = 0; x0 < imgWidth; x0 += tileWidth) {
+            int w = std::min(tileWidth, imgWidth - x0);
+            mCamera.setTile(x0, y0, w, bandHeight);
+            fbo.bind();
+            paintGL();
+            glReadPixels(0, 0, w, bandHeight, GL_RGB, GL_UNSIGNED_BYTE, tile.data());
+
+            for (int r = 0; r < bandHeight; r++) {
+                memcpy(band.data() + (static_cast<size_t>(r) * static_cast<size_t>(imgWidth) + x0) * 3,
+                    tile.data() + static_cast<size_t>(r * w * 3), static_cast<size_t>(w * 3));
+            }
+        }
+
+        for (int r = bandHeight - 1; r >= 0 && ok; r--) {
+            ok = writer.writeRow(band.data() + static_cast<size_t>(r) * static_cast<size_t>(imgWidth * 3));
+        }
     }
+    fbo.release();
 
-    delete[] buf;
+    mCamera.clearTile();
+    mCamera.setSize(camWidth, camHeight);
+    mTileScale = 1.0;
+    doneCurrent();
+    update();
+
+    if (!writer.close() || !ok) {
+        fprintf(stderr, "Cannot write image %s!\n", filename.toLocal8Bit().constData());
+        return false;
+    }
     return true;
 }
 
+bool OpenGL3dModel::exportAnimation(const struct_anim_export& job)
+{
+    int camWidth, camHeight;
+    mCamera.getSize(camWidth, camHeight);
+
+    // A zero image size means window size.
+    int imgWidth = (mParams->opengl_img_width > 0 ? mParams->opengl_img_width : camWidth);
+    int imgHeight = (mParams->opengl_img_height > 0 ? mParams->opengl_img_height : camHeight);
+    if (imgWidth <= 0 || imgHeight <= 0 || camHeight <= 0 || job.numFrames <= 0 || job.fps <= 0) {
+        fprintf(stderr, "Image size or number of frames is null!\n");
+        return false;
+    }
+
+    makeCurrent();
+
+    // Frames are rendered in one piece; the stereo target holds two of them side by side.
+    GLint maxDims[2];
+    glGetIntegerv(GL_MAX_VIEWPORT_DIMS, maxDims);
+    if (imgWidth * 2 > maxDims[0] || imgHeight > maxDims[1]) {
+        fprintf(stderr, "Cannot export animation larger than %dx%d!\n", maxDims[0] / 2, maxDims[1]);
+        doneCurrent();
+        return false;
+    }
+
+    QOpenGLFramebufferObject fbo(imgWidth, imgHeight, QOpenGLFramebufferObject::Depth);
+    if (!fbo.isValid()) {
+        fprintf(stderr, "Cannot create framebuffer for animation export!\n");
+        doneCurrent();
+        return false;
+    }
+
+    FrameExporter exporter(imgWidth, imgHeight);
+    bool ok = (job.command.isEmpty() ? exporter.openImages(job.filename) : exporter.openPipe(job.command, job.fps));
+    if (!ok) {
+        doneCurrent();
+        return false;
+    }
+
+    m4d::vec3 pos = mCamera.getEyePos();
+    m4d::vec3 dir = mCamera.getDir();
+    m4d::vec3 vup = mCamera.getVup();
+    m4d::vec3 poi = mCamera.getPOI();
+    double fovy = mCamera.getFovY();
+    int showNumVerts = mShowNumVerts;
+    bool pathPreview = mPathPreview;
+    mPathPreview = false;
+
+    // The tile covers the whole image; it keeps the overlay and the layer cache out of the frames.
+    mCamera.setSize(imgWidth, imgHeight);
+    mCamera.setTile(0, 0, imgWidth, imgHeight);
+    mTileScale = imgHeight / static_cast<double>(camHeight);
+
+    // The dialog processes events, which may make another context current; ours is restored before each frame.
+    QProgressDialog progress("Exporting animation frames...", "Cancel", 0, job.numFrames, this);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
+    bool canceled = false;
+
+    exporter.begin();
+    for (int i = 0; i < job.numFrames && ok; i++) {
+        progress.setValue(i);
+        if (progress.wasCanceled()) {
+            canceled = true;
+            break;
+        }
+        makeCurrent();
+
+        if (job.firstPoints >= 0) {
+            double t = (job.numFrames > 1 ? i / static_cast<double>(job.numFrames - 1) : 1.0);
+            int num = static_cast<int>(job.firstPoints + t * (job.lastPoints - job.firstPoints) + 0.5);
+            mShowNumVerts = std::max(0, std::min(num, mNumVerts));
+        }
+
+        if (job.cameraPath) {
+            mCamPath.evaluate(i / static_cast<double>(job.fps), mCamera);
+        }
+
+        fbo.bind();
+        paintGL();
+        ok = exporter.readFrame();
+
+        if (job.rotate && !job.cameraPath) {
+            doAnimRotation(1000.0 / job.fps, job.local);
+        }
+    }
+    makeCurrent();
+    ok = exporter.end() && ok && !canceled;
+    fbo.release();
+
+    mCamera.setPOI(poi);
+    mCamera.setEyePos(pos);
+    mCamera.setDir(dir);
+    mCamera.setVup(vup);
+    mCamera.setFovY(fovy);
+    mShowNumVerts = showNumVerts;
+    mPathPreview = pathPreview;
+
+    mCamera.clearTile();
+    mCamera.setSize(camWidth, camHeight);
+    mTileScale = 1.0;
+    doneCurrent();
+    progress.setValue(job.numFrames);
+    update();
+
+    if (!ok && !canceled) {
+        fprintf(stderr, "Cannot export all animation frames!\n");
+    }
+    return ok;
+}
+
+bool OpenGL3dModel::addCameraKey(double dt)
+{
+    double time = (mCamPath.numKeys() > 0 ? mCamPath.duration() + std::max(dt, 1e-3) : 0.0);
+    return mCamPath.addKey(mCamera, time);
+}
+
+void OpenGL3dModel::clearCameraPath()
+{
+    mCamPath.clear();
+}
+
+int OpenGL3dModel::numCameraKeys()
+{
+    return mCamPath.numKeys();
+}
+
+double OpenGL3dModel::getCameraPathDuration()
+{
+    return mCamPath.duration();
+}
+
+void OpenGL3dModel::setCameraPathTime(double t)
+{
+    if (mCamPath.evaluate(t, mCamera)) {
+        mParams->opengl_fov = mCamera.getFovY();
+        update();
+    }
+}
+
+void OpenGL3dModel::setPathPreview(bool preview)
+{
+    mPathPreview = preview;
+    update();
+}
+
+bool OpenGL3dModel::loadCameraPath(QString filename)
+{
+    return mCamPath.load(filename.toStdString());
+}
+
+bool OpenGL3dModel::saveCameraPath(QString filename)
+{
+    return mCamPath.save(filename.toStdString());
+}
+
+void OpenGL3dModel::getSoftJob(struct_soft_job& job)
+{
+    int camWidth, camHeight;
+    mCamera.getSize(camWidth, camHeight);
+    if (camWidth <= 0 || camHeight <= 0) {
+        camWidth = DEF_OPENGL_WIDTH;
+        camHeight = DEF_OPENGL_HEIGHT;
+    }
+
+    job.view = enum_soft_view_3d;
+    job.width = (mParams->opengl_img_width > 0 ? mParams->opengl_img_width : camWidth);
+    job.height = (mParams->opengl_img_height > 0 ? mParams->opengl_img_height : camHeight);
+
+    // The current camera and scaling take precedence over the parameters.
+    job.params = *mParams;
+    getCameraDirs(job.params.opengl_eye_pos, job.params.opengl_eye_poi, job.params.opengl_eye_vup);
+    job.params.opengl_fov = mCamera.getFovY();
+    job.params.opengl_projection = static_cast<int>(mProjection);
+    job.params.opengl_scale_x = mScaleX;
+    job.params.opengl_scale_y = mScaleY;
+    job.params.opengl_scale_z = mScaleZ;
+    job.params.opengl_bg_color = mBGcolor;
+    job.params.opengl_line_color = mFGcolor;
+    job.params.opengl_line_width = mLineWidth;
+
+    job.style = mDrawStyle;
+    job.verts.clear();
+    if (mVerts != nullptr) {
+        job.verts.assign(mVerts, mVerts + static_cast<size_t>(mShowNumVerts * 3));
+    }
+    job.embMesh = mEmbMesh.getMesh();
+
+    job.objects.clear();
+    for (size_t i = 0; i < mObjects.size(); i++) {
+        struct_obj obj;
+        mObjects[i]->getObject(obj);
+        job.objects.push_back(obj);
+    }
+    job.effPot.clear();
+    job.effPotEnergy = std::numeric_limits<double>::quiet_NaN();
+    job.wiredObjs = mWiredObjs;
+    job.ok = false;
+}
+
+void OpenGL3dModel::showPassTimes(bool show)
+{
+    mPassTimer.setEnabled(show);
+    update();
+}
 
+bool OpenGL3dModel::savePassTimes(QString filename)
+{
+    return mPassTimer.saveLog(filename);
+}
 
 void OpenGL3dModel::updateParams()
 {
@@ -598,11 +1005,16 @@ void OpenGL3dModel::updateParams()
     mCamera.setFovY(mParams->opengl_fov);
     mLineWidth = mParams->opengl_line_width;
     mLineSmooth = mParams->opengl_line_smooth;
+    mLineMode = static_cast<enum_line_mode>(mParams->opengl_line_mode);
+    mTubeRadius = mParams->opengl_tube_radius;
+    setColormap(mParams->opengl_cmap_scalar, mParams->opengl_cmap_type, mParams->opengl_cmap_auto == 1,
+        mParams->opengl_cmap_min, mParams->opengl_cmap_max);
 
     mBGcolor = mParams->opengl_bg_color;
     mFGcolor = mParams->opengl_line_color;
 
     mStereo = mParams->opengl_stereo_use;
+    setTrails(mParams->trails_use, mParams->trails_num, mParams->trails_max_mbytes);
     mCamera.setStereoParams(mParams->opengl_stereo_sep, mParams->opengl_stereo_glasses);
     mCamera.setStereoType(mParams->opengl_stereo_type);
 
@@ -654,6 +1066,7 @@ void OpenGL3dModel::initializeGL()
     glLightModeli(GL_LIGHT_MODEL_LOCAL_VIEWER, GL_FALSE);
 
     mGLSLsupported = QOpenGLShaderProgram::hasOpenGLShaderPrograms();
+    mPrimRestart = (context()->format().version() >= qMakePair(3, 1));
 
     fprintf(stderr, "Basic information about graphics board:\n");
     fprintf(stderr, "\tVendor:          %s\n", glGetString(GL_VENDOR));
@@ -665,11 +1078,54 @@ void OpenGL3dModel::initializeGL()
     // shader->addShaderFromSourceFile(QGLShader::Vertex,  "shader/vert.c");
     // shader->addShaderFromSourceFile(QGLShader::Fragment,"shader/frag.c");
 
-    shader->addShaderFromSourceCode(QOpenGLShader::Vertex, getVertexShaderCode());
-    shader->addShaderFromSourceCode(QOpenGLShader::Fragment, getFragmentShaderCode());
+    shader->addShaderFromSourceCode(QOpenGLShader::Vertex, getVertexShaderCode(false));
+    shader->addShaderFromSourceCode(QOpenGLShader::Fragment, getFragmentShaderCode(false));
+    shader->bindAttributeLocation("basePos", 0);
+    shader->bindAttributeLocation("sachs1", 1);
+    shader->bindAttributeLocation("sachs2", 2);
+    shader->bindAttributeLocation("lambdaSide", 3);
     shader->link();
     // std::cerr << "OpenGL frag log: " << shader->isLinked() << std::endl;
 
+    mLineShader = new QOpenGLShaderProgram();
+    mLineShader->addShaderFromSourceCode(QOpenGLShader::Vertex, getLineVertexShaderCode(false));
+    mLineShader->addShaderFromSourceCode(QOpenGLShader::Fragment, getLineFragmentShaderCode(false));
+    mLineShader->bindAttributeLocation("position", 0);
+    mLineShader->bindAttributeLocation("normal", 1);
+    mLineShader->bindAttributeLocation("scalar", 2);
+    if (!mLineShader->link()) {
+        fprintf(stderr, "Cannot link line shader!\n");
+    }
+
+    // Thick lines and tubes are expanded by a geometry shader, if available.
+    if (QOpenGLShader::hasOpenGLShaders(QOpenGLShader::Geometry, context())) {
+        mTubeShader = new QOpenGLShaderProgram();
+        mTubeShader->addShaderFromSourceCode(QOpenGLShader::Vertex, getTubeVertexShaderCode(false));
+        mTubeShader->addShaderFromSourceCode(QOpenGLShader::Geometry, getTubeGeometryShaderCode(false));
+        mTubeShader->addShaderFromSourceCode(QOpenGLShader::Fragment, getTubeFragmentShaderCode());
+        mTubeShader->bindAttributeLocation("position", 0);
+        mTubeShader->bindAttributeLocation("scalar", 1);
+        mTubeSupported = mTubeShader->link();
+        if (!mTubeSupported) {
+            fprintf(stderr, "Cannot link tube shader!\n");
+        }
+    }
+
+    // Anaglyph stereo draws buffered geometry for both eyes with instancing.
+    mStereoSupported = (mGLSLsupported && context()->format().version() >= qMakePair(3, 2));
+    if (mStereoSupported) {
+        initStereoShaders();
+    }
+
+    initBuffers();
+    if (mGLSLsupported) {
+        mObjMeshes.init();
+    }
+
+#ifdef HAVE_FREETYPE
+    renderText = new RenderText("resources/DroidSansMono.ttf", 12);
+#endif // HAVE_FREETYPE
+
     mDPIFactor[0] = QApplication::desktop()->devicePixelRatioF();
     mDPIFactor[1] = QApplication::desktop()->devicePixelRatioF();
 }
@@ -685,10 +1141,24 @@ void OpenGL3dModel::paintGL()
             break;
     }
     mCamera.lookAtModelView();
+    mProjCache.releaseBuffers();
+    uploadEmbed();
+    if (mSachsNeedUpload && mSachsData != nullptr && mSachsVBO.isCreated()) {
+        mSachsVBO.bind();
+        mSachsVBO.allocate(mSachsData, static_cast<int>(sizeof(GLfloat) * mNumSachsPoints * 2 * SACHS_NUM_COMPS));
+        mSachsVBO.release();
+        mSachsNeedUpload = false;
+    }
+
+    // The current geodesic becomes a trail as soon as a new one is shown.
+    if (mUseTrails && mVerts != nullptr) {
+        mTrails.push(mDrawRevision, mDrawType, mDrawParam, mVerts, static_cast<size_t>(mNumVerts));
+    }
 
     glClearColor(static_cast<float>(mBGcolor.redF()), static_cast<float>(mBGcolor.greenF()),
         static_cast<float>(mBGcolor.blueF()), 0.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    mPassTimer.beginFrame();
 
     if (mUseFog) {
         glEnable(GL_FOG);
@@ -709,15 +1179,31 @@ void OpenGL3dModel::paintGL()
         paintGL_stereo();
     }
     else {
-        paintGL_mono();
+        paintGL_cached();
     }
 
     glDisable(GL_FOG);
+    mPassTimer.begin(enum_timed_pass_axes);
     paintGL_axes();
+    mPassTimer.end(enum_timed_pass_axes);
+    mPassTimer.endFrame();
+
+    // The overlay must not go into the framebuffer of a tiled image export.
+    int tileX, tileY, tileWidth, tileHeight;
+    if (!mCamera.getTile(tileX, tileY, tileWidth, tileHeight)) {
+        mPassTimer.drawOverlay(this, (mBGcolor.value() > 127 ? QColor(Qt::black) : QColor(Qt::white)));
+    }
 }
 
 void OpenGL3dModel::paintGL_mono()
 {
+    // In stereo mode, the instanced pass draws all buffered geometry and the
+    // per-eye passes only draw trails and objects.
+    bool bufferedLayer = (mStereoPass != enum_stereo_pass_eye);
+    bool fixedLayer = (mStereoPass != enum_stereo_pass_instanced);
+    bool staticLayer = (mLayerPass != enum_layer_pass_dynamic);
+    bool dynamicLayer = (mLayerPass != enum_layer_pass_static);
+
     glColor3f(1, 1, 1);
     glScalef(GLfloat(mScaleX), GLfloat(mScaleY), GLfloat(mScaleZ));
 
@@ -735,68 +1221,129 @@ void OpenGL3dModel::paintGL_mono()
     // -----------------------
     //   draw embedding
     // -----------------------
+    mPassTimer.begin(enum_timed_pass_embedding);
     glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
-    if (mEmbVerts != nullptr && mEmbIndices != nullptr) {
+    std::shared_ptr<const struct_emb_mesh> embMesh = mEmbMesh.getMesh();
+    if (staticLayer && bufferedLayer && embMesh != nullptr && embMesh->numStrips > 0) {
         glEnable(GL_LINE_SMOOTH);
-        if (mStereo) {
-            glColor3f(1, 1, 1);
+        QOpenGLShaderProgram* prog = bindSceneShader(mLineShader, mLineShaderStereo);
+        setLineShaderParams(prog, mStereo ? QColor(Qt::white) : mParams->opengl_emb_color, false);
+        if (mEmbVAO.isCreated()) {
+            mEmbVAO.bind();
         }
-        else {
-            glColor3f(static_cast<float>(mParams->opengl_emb_color.redF()),
-                static_cast<float>(mParams->opengl_emb_color.greenF()),
-                static_cast<float>(mParams->opengl_emb_color.blueF()));
+        else if (mEmbVBO.isCreated()) {
+            bindEmbedArrays();
         }
-        glPointSize(1.0);
-        glVertexPointer(3, GL_FLOAT, 0, mEmbVerts);
-        glEnableClientState(GL_VERTEX_ARRAY);
-#ifdef _WIN32
-        for (unsigned int i = 0; i < mEmbCounter - 1; i++) {
-            glDrawElements(GL_QUAD_STRIP, mCount[i], GL_UNSIGNED_INT, reinterpret_cast<const void**>(mEmbIndices[i]));
+        else {
+            prog->setAttributeArray(0, embMesh->verts.data(), 3);
+            prog->enableAttributeArray(0);
         }
-#else
+
+        // Offsets into the index buffer, or into the client-side indices as fallback.
+        uintptr_t base = (mEmbIBO.isCreated() ? 0 : reinterpret_cast<uintptr_t>(embMesh->indices.data()));
 #ifdef GL_GLEXT_PROTOTYPES
-        glMultiDrawElements(GL_QUAD_STRIP, mCount, GL_UNSIGNED_INT, (const void**)mEmbIndices, mEmbCounter - 1);
+        if (mPrimRestart) {
+            glEnable(GL_PRIMITIVE_RESTART);
+            glPrimitiveRestartIndex(DEF_EMB_RESTART_INDEX);
+            drawSceneElements(GL_QUAD_STRIP, static_cast<GLsizei>(embMesh->indices.size()),
+                reinterpret_cast<const GLvoid*>(base));
+            glDisable(GL_PRIMITIVE_RESTART);
+        }
+        else {
+            for (GLsizei i = 0; i < embMesh->numStrips; i++) {
+                size_t offset = sizeof(GLuint) * static_cast<size_t>(i * (embMesh->stripLength + 1));
+                drawSceneElements(
+                    GL_QUAD_STRIP, embMesh->stripLength, reinterpret_cast<const GLvoid*>(base + offset));
+            }
+        }
 #else
-        for (unsigned int i = 0; i < mEmbCounter - 1; i++) {
-            glDrawElements(GL_QUAD_STRIP, mCount[i], GL_UNSIGNED_INT, mEmbIndices[i]);
+        for (GLsizei i = 0; i < embMesh->numStrips; i++) {
+            size_t offset = sizeof(GLuint) * static_cast<size_t>(i * (embMesh->stripLength + 1));
+            drawSceneElements(
+                GL_QUAD_STRIP, embMesh->stripLength, reinterpret_cast<const GLvoid*>(base + offset));
         }
 #endif // GL_GLEXT_PROTOTYPES
-#endif
-        glDisableClientState(GL_VERTEX_ARRAY);
+        if (mEmbVAO.isCreated()) {
+            mEmbVAO.release();
+        }
+        else {
+            prog->disableAttributeArray(0);
+            if (mEmbVBO.isCreated()) {
+                mEmbVBO.release();
+                mEmbIBO.release();
+            }
+        }
+        prog->release();
         glDisable(GL_LINE_SMOOTH);
     }
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    mPassTimer.end(enum_timed_pass_embedding);
 
     // -----------------------
     //   draw geodesic
     // -----------------------
-    glLineWidth(mLineWidth);
-    if (mLineSmooth == 1) {
+    mPassTimer.begin(enum_timed_pass_geodesic);
+    // Tiled exports scale widths like the axes and labels, so lines keep their relative thickness.
+    glLineWidth(static_cast<GLfloat>(mLineWidth * mTileScale));
+    if (mLineSmooth == 1 && !mPathPreview) {
         glEnable(GL_LINE_SMOOTH);
     }
 
-    if (mStereo) {
-        glColor3f(1.0f, 1.0f, 1.0f);
-    }
-    else {
-        glColor3f(static_cast<float>(mFGcolor.redF()), static_cast<float>(mFGcolor.greenF()),
-            static_cast<float>(mFGcolor.blueF()));
+    QColor geodCol = (mStereo ? QColor(Qt::white) : mFGcolor);
+    if (dynamicLayer && fixedLayer && mUseTrails && mVerts != nullptr) {
+        mTrails.draw(geodCol);
     }
 
-    glPointSize(mLineWidth);
-    glVertexPointer(3, GL_FLOAT, 0, mVerts);
-    glEnableClientState(GL_VERTEX_ARRAY);
-    if (mDrawStyle == enum_draw_lines) {
-        glDrawArrays(GL_LINE_STRIP, 0, mShowNumVerts);
-    }
-    else {
-        glDrawArrays(GL_POINTS, 0, mShowNumVerts);
+    // The projected vertices stay on the GPU; per frame only uniforms change.
+    glPointSize(static_cast<GLfloat>(mLineWidth * mTileScale));
+    QOpenGLBuffer* vbo = (mVerts != nullptr ? mProjCache.getBuffer(mVerts) : nullptr);
+    // The camera path preview keeps to plain lines.
+    bool expanded = (dynamicLayer && bufferedLayer && mVerts != nullptr && mDrawStyle == enum_draw_lines
+        && mLineMode != enum_line_mode_gl && !mPathPreview && drawExpandedGeodesic(vbo, geodCol));
+    if (dynamicLayer && bufferedLayer && mVerts != nullptr && !expanded) {
+        QOpenGLShaderProgram* prog = bindSceneShader(mLineShader, mLineShaderStereo);
+        setLineShaderParams(prog, geodCol, false);
+        bool mapped = bindColormap(prog, 2);
+        if (vbo != nullptr) {
+            vbo->bind();
+            prog->setAttributeBuffer(0, GL_FLOAT, 0, 3);
+        }
+        else {
+            prog->setAttributeArray(0, mVerts, 3);
+        }
+        prog->enableAttributeArray(0);
+        if (mDrawStyle == enum_draw_lines) {
+            drawSceneArrays(GL_LINE_STRIP, 0, mShowNumVerts);
+        }
+        else {
+            drawSceneArrays(GL_POINTS, 0, mShowNumVerts);
+        }
+        prog->disableAttributeArray(0);
+        if (mapped) {
+            mColormap.unbind(prog, 2);
+        }
+        if (vbo != nullptr) {
+            vbo->release();
+        }
+        prog->release();
     }
-    glDisableClientState(GL_VERTEX_ARRAY);
     glLineWidth(1);
     glDisable(GL_LINE_SMOOTH);
 
+    if (dynamicLayer && bufferedLayer && mVerts != nullptr && mPickedVertex >= 0 && mPickedVertex < mShowNumVerts) {
+        QOpenGLShaderProgram* prog = bindSceneShader(mLineShader, mLineShaderStereo);
+        setLineShaderParams(prog, mStereo ? QColor(Qt::white) : QColor(DEF_PICK_MARKER_COLOR), false);
+        glPointSize(static_cast<GLfloat>(DEF_PICK_MARKER_SIZE * mDPIFactor[0] * mTileScale));
+        prog->setAttributeArray(0, mVerts + 3 * mPickedVertex, 3);
+        prog->enableAttributeArray(0);
+        drawSceneArrays(GL_POINTS, 0, 1);
+        prog->disableAttributeArray(0);
+        prog->release();
+        glPointSize(1);
+    }
+    mPassTimer.end(enum_timed_pass_geodesic);
+
     glDisable(GL_LIGHTING);
 
     glColor3f(1.0, 1.0, 1.0);
@@ -804,76 +1351,88 @@ void OpenGL3dModel::paintGL_mono()
     // -----------------------
     //   draw Sachs
     // -----------------------
-    shader->bind();
-    if (mStereo) {
-        shader->setUniformValue(shader->uniformLocation("colortype"), 0);
-    }
-    else {
-        shader->setUniformValue(shader->uniformLocation("colortype"), 2);
-    }
-
-    shader->setUniformValue("col1", static_cast<float>(mParams->opengl_leg1_col1.redF()),
-        static_cast<float>(mParams->opengl_leg1_col1.greenF()), static_cast<float>(mParams->opengl_leg1_col1.blueF()));
-
-    shader->setUniformValue("col2", static_cast<float>(mParams->opengl_leg1_col2.redF()),
-        static_cast<float>(mParams->opengl_leg1_col2.greenF()), static_cast<float>(mParams->opengl_leg1_col2.blueF()));
-
-    shader->setUniformValue("freq", static_cast<float>(mParams->opengl_leg1_freq));
-    shader->setUniformValue("useFog", static_cast<int>(mUseFog));
-    shader->setUniformValue("fogFactor", static_cast<float>(-mFogDensity * mFogDensity * 1.442695));
-    shader->setUniformValue("eyePos", light_position[0], light_position[1], light_position[2]);
-
-    if (mNumSachsVerts1 > 0) {
-        int num1, num2;
-        glBegin(GL_QUAD_STRIP);
-        for (int i = 0; i < mShowNumVerts; i++) {
-            num1 = 6 * i;
-            num2 = 6 * i + 3;
-            glTexCoord2f(0.0, mLambda[i]);
-            glVertex3f(mSachsVerts1[num1 + 0], mSachsVerts1[num1 + 1], mSachsVerts1[num1 + 2]);
-            glTexCoord2f(1.0, mLambda[i]);
-            glVertex3f(mSachsVerts1[num2 + 0], mSachsVerts1[num2 + 1], mSachsVerts1[num2 + 2]);
+    mPassTimer.begin(enum_timed_pass_sachs);
+    int numSachs = std::min(mShowNumVerts, mNumSachsPoints);
+    if (dynamicLayer && bufferedLayer && mSachsData != nullptr && numSachs > 0) {
+        QOpenGLShaderProgram* prog = bindSceneShader(shader, mSachsShaderStereo);
+        if (mStereo) {
+            prog->setUniformValue(prog->uniformLocation("colortype"), 0);
         }
-        glEnd();
+        else {
+            prog->setUniformValue(prog->uniformLocation("colortype"), 2);
+        }
+
+        prog->setUniformValue("col1", static_cast<float>(mParams->opengl_leg1_col1.redF()),
+            static_cast<float>(mParams->opengl_leg1_col1.greenF()),
+            static_cast<float>(mParams->opengl_leg1_col1.blueF()));
+
+        prog->setUniformValue("col2", static_cast<float>(mParams->opengl_leg1_col2.redF()),
+            static_cast<float>(mParams->opengl_leg1_col2.greenF()),
+            static_cast<float>(mParams->opengl_leg1_col2.blueF()));
+
+        prog->setUniformValue("freq", static_cast<float>(mParams->opengl_leg1_freq));
+        prog->setUniformValue("useFog", static_cast<int>(mUseFog));
+        prog->setUniformValue("fogFactor", static_cast<float>(-mFogDensity * mFogDensity * 1.442695));
+        prog->setUniformValue("eyePos", light_position[0], light_position[1], light_position[2]);
+
+        double l1a, l1b, l2a, l2b;
+        getSachsLegFactors(mParams->opengl_sachs_legs, l1a, l1b, l2a, l2b);
+        prog->setUniformValue("sachsScale", static_cast<float>(mParams->opengl_sachs_scale));
+        bindSachsArrays();
+
+        prog->setUniformValue("legIndex", 0);
+        prog->setUniformValue("legFactors", static_cast<float>(l1a), static_cast<float>(l1b));
+        drawSceneArrays(GL_QUAD_STRIP, 0, 2 * numSachs);
 
         if (mStereo) {
-            shader->setUniformValue("colortype", 1);
+            prog->setUniformValue("colortype", 1);
         }
         else {
-            shader->setUniformValue("colortype", 2);
+            prog->setUniformValue("colortype", 2);
         }
 
-        shader->setUniformValue("col1", static_cast<float>(mParams->opengl_leg2_col1.redF()),
+        prog->setUniformValue("col1", static_cast<float>(mParams->opengl_leg2_col1.redF()),
             static_cast<float>(mParams->opengl_leg2_col1.greenF()),
             static_cast<float>(mParams->opengl_leg2_col1.blueF()));
 
-        shader->setUniformValue("col2", static_cast<float>(mParams->opengl_leg2_col2.redF()),
+        prog->setUniformValue("col2", static_cast<float>(mParams->opengl_leg2_col2.redF()),
             static_cast<float>(mParams->opengl_leg2_col2.greenF()),
             static_cast<float>(mParams->opengl_leg2_col2.blueF()));
 
-        shader->setUniformValue("freq", static_cast<float>(mParams->opengl_leg2_freq));
-        glBegin(GL_QUAD_STRIP);
-        for (int i = 0; i < mShowNumVerts; i++) {
-            num1 = 6 * i;
-            num2 = 6 * i + 3;
-            glTexCoord2f(0.0, mLambda[i]);
-            glVertex3f(mSachsVerts2[num1 + 0], mSachsVerts2[num1 + 1], mSachsVerts2[num1 + 2]);
-            glTexCoord2f(1.0, mLambda[i]);
-            glVertex3f(mSachsVerts2[num2 + 0], mSachsVerts2[num2 + 1], mSachsVerts2[num2 + 2]);
+        prog->setUniformValue("freq", static_cast<float>(mParams->opengl_leg2_freq));
+        prog->setUniformValue("legIndex", 1);
+        prog->setUniformValue("legFactors", static_cast<float>(l2a), static_cast<float>(l2b));
+        drawSceneArrays(GL_QUAD_STRIP, 0, 2 * numSachs);
+
+        for (int i = 0; i < 4; i++) {
+            prog->disableAttributeArray(i);
         }
-        glEnd();
+        if (mSachsVBO.isCreated()) {
+            mSachsVBO.release();
+        }
+        prog->release();
+    }
+    mPassTimer.end(enum_timed_pass_sachs);
+
+    if (!fixedLayer || !staticLayer) {
+        return;
     }
-    shader->release();
 
     // -----------------------
     //   draw objects
     // -----------------------
+    mPassTimer.begin(enum_timed_pass_objects);
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
     if (mWiredObjs) {
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     }
 
+    // Quadrics are drawn instanced per type; the remaining objects one by one.
+    bool instanced = mObjMeshes.draw(mObjects, mObjectsRevision, mStereo, (mUseFog ? mFogDensity : 0.0));
     for (unsigned int i = 0; i < mObjects.size(); i++) {
+        if (instanced && ObjectMeshes::isInstanced(mObjects[i]->getObjectType())) {
+            continue;
+        }
         if (mObjects[i]->withLight(mat_diffuse, mStereo)) {
             // glLightfv(GL_LIGHT0, GL_DIFFUSE, light_ambient);
 
@@ -882,24 +1441,135 @@ void OpenGL3dModel::paintGL_mono()
             glEnable(GL_LIGHTING);
         }
 
-        if (!mObjects[i]->drawObject(mStereo)) {
-            if (mObjects[i]->getObjectType() == enum_object_text3d
-                && mObjects[i]->getObjectDim() == enum_object_dim_3d) {
-                double cx, cy, cz, size;
-                mObjects[i]->getValue(0, cx);
-                mObjects[i]->getValue(1, cy);
-                mObjects[i]->getValue(2, cz);
-                mObjects[i]->getValue(3, size);
-
-                // TODO: render text
-                // this->renderText((double)cx, (double)cy, (double)cz, QString(mObjects[i]->getText().c_str()), font);
-            }
-        }
+        // Text objects are not drawn here, but as labels below.
+        mObjects[i]->drawObject(mStereo);
         glDisable(GL_LIGHTING);
     }
+    drawObjectLabels();
+    mPassTimer.end(enum_timed_pass_objects);
+}
+
+void OpenGL3dModel::paintGL_cached()
+{
+    // A tiled export renders every tile once; caching would not pay off.
+    int tileX, tileY, tileWidth, tileHeight;
+    enum_layer_cache state = enum_layer_cache_direct;
+    if (!mCamera.getTile(tileX, tileY, tileWidth, tileHeight)) {
+        std::vector<double> key;
+        getStaticKey(key);
+        int width, height;
+        mCamera.getViewportSize(width, height);
+        state = mStaticCache.check(key, width, height);
+    }
+
+    if (state == enum_layer_cache_build) {
+        mStaticCache.begin();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        mLayerPass = enum_layer_pass_static;
+        glMatrixMode(GL_MODELVIEW);
+        glPushMatrix();
+        paintGL_mono();
+        glPopMatrix();
+        mStaticCache.end();
+    }
+
+    // The depth of the cached layer still occludes the geodesic.
+    mLayerPass = enum_layer_pass_all;
+    if (state != enum_layer_cache_direct && mStaticCache.blit()) {
+        mLayerPass = enum_layer_pass_dynamic;
+    }
+    paintGL_mono();
+    mLayerPass = enum_layer_pass_all;
 }
 
 void OpenGL3dModel::paintGL_stereo()
+{
+    int width, height;
+    mCamera.getViewportSize(width, height);
+    if (!mStereoSupported || !initStereoTarget(width, height)) {
+        paintGL_stereoMasked();
+        return;
+    }
+
+    // Eye matrices; the buffered geometry additionally needs the scaling of paintGL_mono.
+    QMatrix4x4 eyeView[2];
+    for (int eye = 0; eye < 2; eye++) {
+        if (eye == 0) {
+            mCamera.lookAtMV_Left();
+        }
+        else {
+            mCamera.lookAtMV_Right();
+        }
+        GLfloat m[16];
+        glGetFloatv(GL_MODELVIEW_MATRIX, m);
+        eyeView[eye] = QMatrix4x4(m).transposed();
+        glGetFloatv(GL_PROJECTION_MATRIX, m);
+        mEyeProj[eye] = QMatrix4x4(m).transposed();
+        mEyeMV[eye] = eyeView[eye];
+        mEyeMV[eye].scale(static_cast<float>(mScaleX), static_cast<float>(mScaleY), static_cast<float>(mScaleZ));
+    }
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+    // The anaglyph goes to the framebuffer that is bound, e.g. the one of an image export.
+    GLint targetFBO = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &targetFBO);
+
+    mStereoFBO->bind();
+    glViewport(0, 0, 2 * width, height);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // Embedding, geodesic, and Sachs legs are submitted once for both eyes.
+    mStereoPass = enum_stereo_pass_instanced;
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glEnable(GL_CLIP_DISTANCE0);
+    paintGL_mono();
+    glDisable(GL_CLIP_DISTANCE0);
+    glPopMatrix();
+
+    // Trails and objects use the fixed-function pipeline and are drawn per eye.
+    mStereoPass = enum_stereo_pass_eye;
+    for (int eye = 0; eye < 2; eye++) {
+        glViewport(eye * width, 0, width, height);
+        glMatrixMode(GL_PROJECTION);
+        glLoadMatrixf(mEyeProj[eye].constData());
+        glMatrixMode(GL_MODELVIEW);
+        glLoadMatrixf(eyeView[eye].constData());
+        paintGL_mono();
+    }
+    mStereoPass = enum_stereo_pass_none;
+    context()->functions()->glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(targetFBO));
+
+    // Composite both eyes with the channel masks of the glasses.
+    GLfloat mask[2][3];
+    mCamera.getStereoMasks(mask[0], mask[1]);
+    static const GLfloat corners[8] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+
+    glViewport(0, 0, width, height);
+    glPushAttrib(GL_ENABLE_BIT);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_FOG);
+
+    mAnaglyphShader->bind();
+    glBindTexture(GL_TEXTURE_2D, mStereoFBO->texture());
+    mAnaglyphShader->setUniformValue("stereoTex", 0);
+    mAnaglyphShader->setUniformValue("maskLeft", mask[0][0], mask[0][1], mask[0][2]);
+    mAnaglyphShader->setUniformValue("maskRight", mask[1][0], mask[1][1], mask[1][2]);
+    mAnaglyphShader->setUniformValue("bgColor", static_cast<float>(mBGcolor.redF()),
+        static_cast<float>(mBGcolor.greenF()), static_cast<float>(mBGcolor.blueF()));
+    mAnaglyphShader->setAttributeArray(0, GL_FLOAT, corners, 2);
+    mAnaglyphShader->enableAttributeArray(0);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    mAnaglyphShader->disableAttributeArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    mAnaglyphShader->release();
+
+    glPopAttrib();
+}
+
+void OpenGL3dModel::paintGL_stereoMasked()
 {
     glDrawBuffer(GL_BACK);
     glReadBuffer(GL_BACK);
@@ -917,71 +1587,586 @@ void OpenGL3dModel::paintGL_stereo()
 
 void OpenGL3dModel::paintGL_axes()
 {
+    // In tiled rendering, the axes keep their relative size and position in the image.
+    int tileX, tileY, tileWidth, tileHeight;
+    mCamera.getTile(tileX, tileY, tileWidth, tileHeight);
+    int axesSize = static_cast<int>(100 * mTileScale);
+
     mCamera.perspectiveAxes();
-    glViewport(0, 0, 100, 100);
+    glViewport(-tileX, -tileY, axesSize, axesSize);
     glClear(GL_DEPTH_BUFFER_BIT);
     mCamera.lookAtCenterModelView();
 
-    QColor textColor = Qt::white;
-    if (mBGcolor.value() > 127) {
-        textColor = Qt::black;
+    if (mAxesNumVerts == 0) {
+        return;
     }
 
-    glEnable(GL_LIGHTING);
-
-    GLfloat light_ambient[4] = { 0.0, 0.0, 0.0, 1.0 };
-    GLfloat light_spec[4] = { 1.0, 1.0, 1.0, 1.0 };
-    glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, light_ambient);
-    glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, light_ambient);
-    glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, light_spec);
-    glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, 0.5);
+    mLineShader->bind();
+    mLineShader->setUniformValue("useFog", 0);
+    mLineShader->setUniformValue("useLight", 1);
+    if (mAxesVAO.isCreated()) {
+        mAxesVAO.bind();
+    }
+    else {
+        bindAxesArrays();
+    }
 
     glPushMatrix();
     glRotatef(90.0, 0.0, 1.0, 0.0);
-    // qglColor(textColor);
-    // renderText(0.0, 0.0, 1.2, QString("x"));
-    light_spec[0] = 1.0;
-    light_spec[1] = 0.0;
-    light_spec[2] = 0.0;
-    glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, light_spec);
-    glColor3f(1.0f, 0.0f, 0.0f);
-    gluCylinder(mQuadricAxis, 0.0625, 0.0625, 0.75, 32, 32);
-    gluDisk(mQuadricDisk, 0.0, 0.0625, 32, 32);
-    glTranslatef(0.0, 0.0, 0.75);
-    gluCylinder(mQuadricAxis, 0.125, 0.0, 0.25, 32, 32);
-    gluDisk(mQuadricDisk, 0.0, 0.125, 32, 32);
+    mLineShader->setUniformValue("color", 1.0f, 0.0f, 0.0f, 1.0f);
+    glDrawArrays(GL_TRIANGLES, 0, mAxesNumVerts);
     glPopMatrix();
 
     glPushMatrix();
     glRotatef(-90.0, 1.0, 0.0, 0.0);
-    // qglColor(textColor);
-    // renderText(-0.1, 0.1, 1.2, QString("y"));
-    light_spec[0] = 0.0;
-    light_spec[1] = 1.0;
-    light_spec[2] = 0.0;
-    glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, light_spec);
-    gluCylinder(mQuadricAxis, 0.0625, 0.0625, 0.75, 32, 32);
-    gluDisk(mQuadricDisk, 0.0, 0.0625, 32, 32);
-    glTranslatef(0.0, 0.0, 0.75);
-    gluCylinder(mQuadricAxis, 0.125, 0.0, 0.25, 32, 32);
-    gluDisk(mQuadricDisk, 0.0, 0.125, 32, 32);
+    mLineShader->setUniformValue("color", 0.0f, 1.0f, 0.0f, 1.0f);
+    glDrawArrays(GL_TRIANGLES, 0, mAxesNumVerts);
     glPopMatrix();
 
-    glPushMatrix();
-    // qglColor(textColor);
-    // renderText(-0.1, -0.1, 1.2, mNameOfZaxis);
-    light_spec[0] = 0.0;
-    light_spec[1] = 0.0;
-    light_spec[2] = 1.0;
-    glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, light_spec);
-    gluCylinder(mQuadricAxis, 0.0625, 0.0625, 0.75, 32, 32);
-    gluDisk(mQuadricDisk, 0.0, 0.0625, 32, 32);
-    glTranslatef(0.0, 0.0, 0.75);
-    gluCylinder(mQuadricAxis, 0.125, 0.0, 0.25, 32, 32);
-    gluDisk(mQuadricDisk, 0.0, 0.125, 32, 32);
-    glPopMatrix();
+    mLineShader->setUniformValue("color", 0.0f, 0.0f, 1.0f, 1.0f);
+    glDrawArrays(GL_TRIANGLES, 0, mAxesNumVerts);
 
-    glDisable(GL_LIGHTING);
+    if (mAxesVAO.isCreated()) {
+        mAxesVAO.release();
+    }
+    else {
+        mLineShader->disableAttributeArray(0);
+        mLineShader->disableAttributeArray(1);
+        mAxesVBO.release();
+    }
+    mLineShader->release();
+
+    drawAxesLabels();
+}
+
+void OpenGL3dModel::initBuffers()
+{
+    mEmbVBO.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+    mEmbIBO.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    if (!mEmbVBO.create() || !mEmbIBO.create()) {
+        fprintf(stderr, "Cannot create buffers for embedding diagram!\n");
+        mEmbVBO.destroy();
+        mEmbIBO.destroy();
+    }
+    else if (mEmbVAO.create()) {
+        mEmbVAO.bind();
+        bindEmbedArrays();
+        mEmbVAO.release();
+        mEmbVBO.release();
+        mEmbIBO.release();
+    }
+    mEmbUploaded.reset();
+
+    mGeodIBO.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    if (!mGeodIBO.create()) {
+        fprintf(stderr, "Cannot create index buffer for thick lines!\n");
+    }
+    mGeodIBONumVerts = 0;
+
+    mSachsVBO.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    if (!mSachsVBO.create()) {
+        fprintf(stderr, "Cannot create buffer for Sachs legs!\n");
+    }
+    mSachsNeedUpload = (mSachsData != nullptr);
+
+    // Arrow along the z-axis: shaft, bottom disk, cone, and cone disk.
+    std::vector<GLfloat> verts;
+    addArrowMantle(verts, 0.0625, 0.0625, 0.0, 0.75);
+    addArrowDisk(verts, 0.0625, 0.0);
+    addArrowMantle(verts, 0.125, 0.0, 0.75, 1.0);
+    addArrowDisk(verts, 0.125, 0.75);
+    mAxesNumVerts = static_cast<int>(verts.size() / 6);
+
+    mAxesVBO.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    if (!mAxesVBO.create()) {
+        fprintf(stderr, "Cannot create buffer for coordinate axes!\n");
+        mAxesNumVerts = 0;
+        return;
+    }
+    mAxesVBO.bind();
+    mAxesVBO.allocate(verts.data(), static_cast<int>(verts.size() * sizeof(GLfloat)));
+    mAxesVBO.release();
+
+    if (mAxesVAO.create()) {
+        mAxesVAO.bind();
+        bindAxesArrays();
+        mAxesVAO.release();
+        mAxesVBO.release();
+    }
+}
+
+void OpenGL3dModel::initStereoShaders()
+{
+    mSachsShaderStereo = new QOpenGLShaderProgram();
+    mSachsShaderStereo->addShaderFromSourceCode(QOpenGLShader::Vertex, getVertexShaderCode(true));
+    mSachsShaderStereo->addShaderFromSourceCode(QOpenGLShader::Fragment, getFragmentShaderCode(true));
+    mSachsShaderStereo->bindAttributeLocation("basePos", 0);
+    mSachsShaderStereo->bindAttributeLocation("sachs1", 1);
+    mSachsShaderStereo->bindAttributeLocation("sachs2", 2);
+    mSachsShaderStereo->bindAttributeLocation("lambdaSide", 3);
+
+    mLineShaderStereo = new QOpenGLShaderProgram();
+    mLineShaderStereo->addShaderFromSourceCode(QOpenGLShader::Vertex, getLineVertexShaderCode(true));
+    mLineShaderStereo->addShaderFromSourceCode(QOpenGLShader::Fragment, getLineFragmentShaderCode(true));
+    mLineShaderStereo->bindAttributeLocation("position", 0);
+    mLineShaderStereo->bindAttributeLocation("normal", 1);
+    mLineShaderStereo->bindAttributeLocation("scalar", 2);
+
+    mAnaglyphShader = new QOpenGLShaderProgram();
+    mAnaglyphShader->addShaderFromSourceCode(QOpenGLShader::Vertex, getAnaglyphVertexShaderCode());
+    mAnaglyphShader->addShaderFromSourceCode(QOpenGLShader::Fragment, getAnaglyphFragmentShaderCode());
+    mAnaglyphShader->bindAttributeLocation("corner", 0);
+
+    if (!mSachsShaderStereo->link() || !mLineShaderStereo->link() || !mAnaglyphShader->link()) {
+        fprintf(stderr, "Cannot link stereo shaders! Falling back to color masks.\n");
+        mStereoSupported = false;
+        return;
+    }
+
+    // Without a stereo tube shader, thick lines and tubes fall back to GL lines in stereo mode.
+    if (mTubeSupported) {
+        mTubeShaderStereo = new QOpenGLShaderProgram();
+        mTubeShaderStereo->addShaderFromSourceCode(QOpenGLShader::Vertex, getTubeVertexShaderCode(true));
+        mTubeShaderStereo->addShaderFromSourceCode(QOpenGLShader::Geometry, getTubeGeometryShaderCode(true));
+        mTubeShaderStereo->addShaderFromSourceCode(QOpenGLShader::Fragment, getTubeFragmentShaderCode());
+        mTubeShaderStereo->bindAttributeLocation("position", 0);
+        mTubeShaderStereo->bindAttributeLocation("scalar", 1);
+        if (!mTubeShaderStereo->link()) {
+            fprintf(stderr, "Cannot link stereo tube shader!\n");
+            delete mTubeShaderStereo;
+            mTubeShaderStereo = nullptr;
+        }
+    }
+}
+
+bool OpenGL3dModel::initStereoTarget(int width, int height)
+{
+    QSize size(2 * width, height);
+    if (mStereoFBO != nullptr && mStereoFBO->size() == size) {
+        return true;
+    }
+
+    delete mStereoFBO;
+    mStereoFBO = new QOpenGLFramebufferObject(size, QOpenGLFramebufferObject::Depth);
+    if (!mStereoFBO->isValid()) {
+        fprintf(stderr, "Cannot create framebuffer for stereo rendering! Falling back to color masks.\n");
+        delete mStereoFBO;
+        mStereoFBO = nullptr;
+        mStereoSupported = false;
+        return false;
+    }
+    return true;
+}
+
+void OpenGL3dModel::uploadEmbed()
+{
+    mEmbMesh.poll();
+    std::shared_ptr<const struct_emb_mesh> mesh = mEmbMesh.getMesh();
+    if (mesh == nullptr || mesh == mEmbUploaded || !mEmbVBO.isCreated()) {
+        return;
+    }
+
+    // Meshes of different embedding parameters usually share the topology;
+    // then only the range of vertices that actually moved is re-uploaded.
+    if (mEmbUploaded != nullptr && mEmbUploaded->indices == mesh->indices
+        && mEmbUploaded->verts.size() == mesh->verts.size()) {
+        const std::vector<GLfloat>& oldVerts = mEmbUploaded->verts;
+        size_t first = 0;
+        while (first < oldVerts.size() && oldVerts[first] == mesh->verts[first]) {
+            first++;
+        }
+        size_t last = oldVerts.size();
+        while (last > first && oldVerts[last - 1] == mesh->verts[last - 1]) {
+            last--;
+        }
+        if (first < last) {
+            mEmbVBO.bind();
+            mEmbVBO.write(static_cast<int>(sizeof(GLfloat) * first), mesh->verts.data() + first,
+                static_cast<int>(sizeof(GLfloat) * (last - first)));
+            mEmbVBO.release();
+        }
+    }
+    else {
+        mEmbVBO.bind();
+        mEmbVBO.allocate(mesh->verts.data(), static_cast<int>(sizeof(GLfloat) * mesh->verts.size()));
+        mEmbVBO.release();
+        mEmbIBO.bind();
+        mEmbIBO.allocate(mesh->indices.data(), static_cast<int>(sizeof(GLuint) * mesh->indices.size()));
+        mEmbIBO.release();
+    }
+    mEmbUploaded = mesh;
+}
+
+void OpenGL3dModel::bindEmbedArrays()
+{
+    mEmbVBO.bind();
+    mLineShader->setAttributeBuffer(0, GL_FLOAT, 0, 3);
+    mLineShader->enableAttributeArray(0);
+    mEmbIBO.bind();
+}
+
+void OpenGL3dModel::bindAxesArrays()
+{
+    int stride = static_cast<int>(6 * sizeof(GLfloat));
+    mAxesVBO.bind();
+    mLineShader->setAttributeBuffer(0, GL_FLOAT, 0, 3, stride);
+    mLineShader->setAttributeBuffer(1, GL_FLOAT, static_cast<int>(3 * sizeof(GLfloat)), 3, stride);
+    mLineShader->enableAttributeArray(0);
+    mLineShader->enableAttributeArray(1);
+}
+
+void OpenGL3dModel::bindSachsArrays()
+{
+    int stride = static_cast<int>(SACHS_NUM_COMPS * sizeof(GLfloat));
+    if (mSachsVBO.isCreated()) {
+        mSachsVBO.bind();
+        shader->setAttributeBuffer(0, GL_FLOAT, 0, 3, stride);
+        shader->setAttributeBuffer(1, GL_FLOAT, static_cast<int>(3 * sizeof(GLfloat)), 3, stride);
+        shader->setAttributeBuffer(2, GL_FLOAT, static_cast<int>(6 * sizeof(GLfloat)), 3, stride);
+        shader->setAttributeBuffer(3, GL_FLOAT, static_cast<int>(9 * sizeof(GLfloat)), 2, stride);
+    }
+    else {
+        shader->setAttributeArray(0, GL_FLOAT, mSachsData, 3, stride);
+        shader->setAttributeArray(1, GL_FLOAT, mSachsData + 3, 3, stride);
+        shader->setAttributeArray(2, GL_FLOAT, mSachsData + 6, 3, stride);
+        shader->setAttributeArray(3, GL_FLOAT, mSachsData + 9, 2, stride);
+    }
+    for (int i = 0; i < 4; i++) {
+        shader->enableAttributeArray(i);
+    }
+}
+
+bool OpenGL3dModel::drawExpandedGeodesic(QOpenGLBuffer* vbo, const QColor& col)
+{
+    if (!mTubeSupported || vbo == nullptr || !mGeodIBO.isCreated() || mShowNumVerts < 2) {
+        return false;
+    }
+    if (mStereoPass == enum_stereo_pass_instanced && mTubeShaderStereo == nullptr) {
+        return false;
+    }
+
+    // Adjacency indices 0,0,1,...,n-1,n-1; a prefix of k+2 indices draws the first k points.
+    if (mGeodIBONumVerts != mNumVerts) {
+        std::vector<GLuint> indices(static_cast<size_t>(mNumVerts + 2));
+        indices[0] = 0;
+        for (int i = 0; i < mNumVerts; i++) {
+            indices[static_cast<size_t>(i + 1)] = static_cast<GLuint>(i);
+        }
+        indices[static_cast<size_t>(mNumVerts + 1)] = static_cast<GLuint>(mNumVerts - 1);
+        mGeodIBO.bind();
+        mGeodIBO.allocate(indices.data(), static_cast<int>(indices.size() * sizeof(GLuint)));
+        mGeodIBO.release();
+        mGeodIBONumVerts = mNumVerts;
+    }
+
+    // The side-by-side stereo target holds two viewports of half its width.
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    if (mStereoPass == enum_stereo_pass_instanced) {
+        viewport[2] /= 2;
+    }
+
+    QOpenGLShaderProgram* prog = bindSceneShader(mTubeShader, mTubeShaderStereo);
+    prog->setUniformValue("lineMode", static_cast<int>(mLineMode));
+    prog->setUniformValue("viewport", static_cast<float>(viewport[2]), static_cast<float>(viewport[3]));
+    prog->setUniformValue("lineWidth", static_cast<float>(mLineWidth * mDPIFactor[0] * mTileScale));
+    prog->setUniformValue("tubeRadius", static_cast<float>(mTubeRadius));
+    prog->setUniformValue("color", static_cast<float>(col.redF()), static_cast<float>(col.greenF()),
+        static_cast<float>(col.blueF()), 1.0f);
+    prog->setUniformValue("useFog", static_cast<int>(mUseFog));
+    prog->setUniformValue("fogFactor", static_cast<float>(-mFogDensity * mFogDensity * 1.442695));
+    bool mapped = bindColormap(prog, 1);
+
+    vbo->bind();
+    prog->setAttributeBuffer(0, GL_FLOAT, 0, 3);
+    prog->enableAttributeArray(0);
+    mGeodIBO.bind();
+    drawSceneElements(GL_LINE_STRIP_ADJACENCY, mShowNumVerts + 2, nullptr);
+    mGeodIBO.release();
+    prog->disableAttributeArray(0);
+    if (mapped) {
+        mColormap.unbind(prog, 1);
+    }
+    vbo->release();
+    prog->release();
+    return true;
+}
+
+int OpenGL3dModel::pickVertex(QPoint pos)
+{
+    int camWidth, camHeight;
+    mCamera.getSize(camWidth, camHeight);
+    if (mVerts == nullptr || mShowNumVerts <= 0 || !mGLSLsupported || camWidth <= 0 || camHeight <= 0) {
+        return -1;
+    }
+
+    makeCurrent();
+    if (mPickShader == nullptr) {
+        mPickShader = new QOpenGLShaderProgram();
+        mPickShader->addShaderFromSourceCode(QOpenGLShader::Vertex, getPickVertexShaderCode());
+        mPickShader->addShaderFromSourceCode(QOpenGLShader::Fragment, getPickFragmentShaderCode());
+        mPickShader->bindAttributeLocation("position", 0);
+        if (!mPickShader->link()) {
+            fprintf(stderr, "Cannot link pick shader!\n");
+        }
+    }
+    QOpenGLBuffer* vbo = mProjCache.getBuffer(mVerts);
+    if (!mPickShader->isLinked() || vbo == nullptr) {
+        doneCurrent();
+        return -1;
+    }
+
+    int radius = static_cast<int>(DEF_PICK_RADIUS * mDPIFactor[0]);
+    int size = 2 * radius + 1;
+    if (mPickFBO != nullptr && mPickFBO->width() != size) {
+        delete mPickFBO;
+        mPickFBO = nullptr;
+    }
+    if (mPickFBO == nullptr) {
+        mPickFBO = new QOpenGLFramebufferObject(size, size, QOpenGLFramebufferObject::Depth);
+    }
+    if (!mPickFBO->isValid()) {
+        fprintf(stderr, "Cannot create framebuffer for picking!\n");
+        delete mPickFBO;
+        mPickFBO = nullptr;
+        doneCurrent();
+        return -1;
+    }
+
+    // The frustum is restricted to the window around the position, so only this window is rasterized.
+    // Parts of the window beyond the view are scissored away.
+    int x0 = pos.x() - radius;
+    int y0 = camHeight - 1 - pos.y() - radius;
+    int sx = std::max(0, -x0);
+    int sy = std::max(0, -y0);
+    int sw = std::max(std::min(size, camWidth - x0) - sx, 0);
+    int sh = std::max(std::min(size, camHeight - y0) - sy, 0);
+    mCamera.setTile(x0, y0, size, size);
+
+    mPickFBO->bind();
+    glPushAttrib(GL_ENABLE_BIT | GL_SCISSOR_BIT);
+    glDisable(GL_SCISSOR_TEST);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(sx, sy, sw, sh);
+    glDisable(GL_BLEND);
+    glDisable(GL_LINE_SMOOTH);
+    glDisable(GL_POINT_SMOOTH);
+    glDisable(GL_FOG);
+    glEnable(GL_DEPTH_TEST);
+
+    switch (mProjection) {
+        case enum_proj_perspective:
+            mCamera.perspective();
+            break;
+        case enum_proj_orthographic:
+            mCamera.orthographic();
+            break;
+    }
+    mCamera.lookAtModelView();
+    glScalef(GLfloat(mScaleX), GLfloat(mScaleY), GLfloat(mScaleZ));
+
+    // Vertices are drawn on top of the segments, so that they win when they are visible.
+    mPickShader->bind();
+    vbo->bind();
+    mPickShader->setAttributeBuffer(0, GL_FLOAT, 0, 3);
+    mPickShader->enableAttributeArray(0);
+    glLineWidth(std::max(mLineWidth, 1));
+    glPointSize(std::max(mLineWidth, 3));
+    if (mDrawStyle == enum_draw_lines) {
+        glDrawArrays(GL_LINE_STRIP, 0, mShowNumVerts);
+    }
+    glDrawArrays(GL_POINTS, 0, mShowNumVerts);
+    glLineWidth(1);
+    glPointSize(1);
+    mPickShader->disableAttributeArray(0);
+    vbo->release();
+    mPickShader->release();
+
+    std::vector<unsigned char> ids(static_cast<size_t>(size * size * 4), 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, ids.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glPopAttrib();
+    mPickFBO->release();
+    mCamera.clearTile();
+    doneCurrent();
+
+    // Pixels outside of the view stay zero, as does the background.
+    int idx = -1;
+    int bestDist2 = radius * radius + 1;
+    for (int j = 0; j < size; j++) {
+        for (int i = 0; i < size; i++) {
+            const unsigned char* p = ids.data() + 4 * (j * size + i);
+            uint32_t id = p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+            int dist2 = (i - radius) * (i - radius) + (j - radius) * (j - radius);
+            if (id != 0 && dist2 < bestDist2) {
+                bestDist2 = dist2;
+                idx = static_cast<int>(id - 1);
+            }
+        }
+    }
+    return (idx < mShowNumVerts ? idx : -1);
+}
+
+void OpenGL3dModel::setPickedVertex(int idx)
+{
+    if (idx == mPickedVertex) {
+        return;
+    }
+    mPickedVertex = idx;
+    update();
+}
+
+void OpenGL3dModel::setLineShaderParams(QOpenGLShaderProgram* prog, const QColor& col, bool useLight)
+{
+    prog->setUniformValue("color", static_cast<float>(col.redF()), static_cast<float>(col.greenF()),
+        static_cast<float>(col.blueF()), 1.0f);
+    prog->setUniformValue("useLight", static_cast<int>(useLight));
+    prog->setUniformValue("useColormap", 0);
+    prog->setUniformValue("useFog", static_cast<int>(mUseFog));
+    prog->setUniformValue("fogFactor", static_cast<float>(-mFogDensity * mFogDensity * 1.442695));
+}
+
+bool OpenGL3dModel::bindColormap(QOpenGLShaderProgram* prog, int location)
+{
+    // Anaglyph stereo needs the white geodesic.
+    if (mCmapScalar == enum_geod_scalar_none || mStereo
+        || !mColormap.bind(prog, location, mCmapScalar, mCmapType, mShowNumVerts)) {
+        prog->setUniformValue("useColormap", 0);
+        return false;
+    }
+
+    double min = mCmapMin;
+    double max = mCmapMax;
+    if (mCmapAuto) {
+        mColormap.getRange(mCmapScalar, min, max);
+    }
+    if (max == min) {
+        max = min + 1.0;
+    }
+    prog->setUniformValue("useColormap", 1);
+    prog->setUniformValue("scalarRange", static_cast<float>(min), static_cast<float>(max));
+    return true;
+}
+
+QOpenGLShaderProgram* OpenGL3dModel::bindSceneShader(QOpenGLShaderProgram* mono, QOpenGLShaderProgram* stereo)
+{
+    if (mStereoPass != enum_stereo_pass_instanced) {
+        mono->bind();
+        return mono;
+    }
+    stereo->bind();
+    stereo->setUniformValueArray("eyeMV", mEyeMV, 2);
+    stereo->setUniformValueArray("eyeProj", mEyeProj, 2);
+    return stereo;
+}
+
+void OpenGL3dModel::drawSceneArrays(GLenum mode, GLint first, GLsizei count)
+{
+    if (mStereoPass == enum_stereo_pass_instanced) {
+        context()->extraFunctions()->glDrawArraysInstanced(mode, first, count, 2);
+    }
+    else {
+        glDrawArrays(mode, first, count);
+    }
+}
+
+void OpenGL3dModel::drawSceneElements(GLenum mode, GLsizei count, const GLvoid* indices)
+{
+    if (mStereoPass == enum_stereo_pass_instanced) {
+        context()->extraFunctions()->glDrawElementsInstanced(mode, count, GL_UNSIGNED_INT, indices, 2);
+    }
+    else {
+        glDrawElements(mode, count, GL_UNSIGNED_INT, indices);
+    }
+}
+
+QMatrix4x4 OpenGL3dModel::getModelViewProjection()
+{
+    GLfloat proj[16], mv[16];
+    glGetFloatv(GL_PROJECTION_MATRIX, proj);
+    glGetFloatv(GL_MODELVIEW_MATRIX, mv);
+    return QMatrix4x4(proj).transposed() * QMatrix4x4(mv).transposed();
+}
+
+void OpenGL3dModel::drawObjectLabels()
+{
+#ifdef HAVE_FREETYPE
+    if (renderText == nullptr) {
+        return;
+    }
+
+    // Labels are laid out once per object revision; a frame only draws the label buffer.
+    if (mObjectLabelsRevision != mObjectsRevision || mObjectLabelsScale != mTileScale) {
+        renderText->BeginLabels(enum_label_set_objects);
+        for (unsigned int i = 0; i < mObjects.size(); i++) {
+            if (mObjects[i]->getObjectType() != enum_object_text3d
+                || mObjects[i]->getObjectDim() != enum_object_dim_3d) {
+                continue;
+            }
+            double cx, cy, cz, size;
+            mObjects[i]->getValue(0, cx);
+            mObjects[i]->getValue(1, cy);
+            mObjects[i]->getValue(2, cz);
+            mObjects[i]->getValue(3, size);
+            float red, green, blue;
+            mObjects[i]->getColor(red, green, blue);
+            float scale = static_cast<float>(size * mTileScale / renderText->GetFontSize());
+            renderText->AddLabel(enum_label_set_objects, static_cast<float>(cx), static_cast<float>(cy),
+                static_cast<float>(cz), mObjects[i]->getText().c_str(), QColor::fromRgbF(red, green, blue), scale);
+        }
+        mObjectLabelsRevision = mObjectsRevision;
+        mObjectLabelsScale = mTileScale;
+    }
+    renderText->DrawLabels(enum_label_set_objects, getModelViewProjection());
+#endif // HAVE_FREETYPE
+}
+
+void OpenGL3dModel::drawAxesLabels()
+{
+#ifdef HAVE_FREETYPE
+    if (renderText == nullptr) {
+        return;
+    }
+
+    QColor textColor = Qt::white;
+    if (mBGcolor.value() > 127) {
+        textColor = Qt::black;
+    }
+    QString key = QString("%1 %2 %3").arg(mNameOfZaxis).arg(textColor.rgba()).arg(mTileScale);
+    if (key != mAxesLabelsKey) {
+        float scale = static_cast<float>(mTileScale);
+        int align = ALIGN_HCENTER | ALIGN_VCENTER;
+        renderText->BeginLabels(enum_label_set_axes);
+        renderText->AddLabel(enum_label_set_axes, 1.2f, 0.0f, 0.0f, "x", textColor, scale, align);
+        renderText->AddLabel(enum_label_set_axes, 0.0f, 1.2f, 0.0f, "y", textColor, scale, align);
+        renderText->AddLabel(
+            enum_label_set_axes, 0.0f, 0.0f, 1.2f, mNameOfZaxis.toStdString().c_str(), textColor, scale, align);
+        mAxesLabelsKey = key;
+    }
+    renderText->DrawLabels(enum_label_set_axes, getModelViewProjection());
+#endif // HAVE_FREETYPE
+}
+
+void OpenGL3dModel::getStaticKey(std::vector<double>& key)
+{
+    GLfloat proj[16], mv[16];
+    glGetFloatv(GL_PROJECTION_MATRIX, proj);
+    glGetFloatv(GL_MODELVIEW_MATRIX, mv);
+    key.assign(proj, proj + 16);
+    key.insert(key.end(), mv, mv + 16);
+
+    key.push_back(mScaleX);
+    key.push_back(mScaleY);
+    key.push_back(mScaleZ);
+    key.push_back(static_cast<double>(reinterpret_cast<uintptr_t>(mEmbMesh.getMesh().get())));
+    key.push_back(mParams->opengl_emb_color.rgba());
+    key.push_back(mBGcolor.rgba());
+    key.push_back(mUseFog ? mFogDensity : -1.0);
+    key.push_back(mObjectsRevision);
+    key.push_back(mWiredObjs ? 1.0 : 0.0);
 }
 
 void OpenGL3dModel::resizeGL(int width, int height)
@@ -1066,6 +2251,10 @@ void OpenGL3dModel::keyPressEvent(QKeyEvent* event)
     else if (mKeyPressed == Qt::Key_W) {
         mWiredObjs = !mWiredObjs;
     }
+    else {
+        // Nothing changed, no need for a new frame.
+        return;
+    }
 #if 0
     else if (mKeyPressed == Qt::Key_R) {
         if (shader->isLinked()) {
@@ -1093,6 +2282,14 @@ void OpenGL3dModel::mousePressEvent(QMouseEvent* event)
     cp.setX(static_cast<int>(cp.x() * mDPIFactor[0]));
     cp.setY(static_cast<int>(cp.y() * mDPIFactor[1]));
     mLastPos = cp;
+
+    if (mButtonPressed == Qt::LeftButton && event->modifiers() == Qt::ShiftModifier) {
+        mButtonPressed = Qt::NoButton;
+        int idx = pickVertex(mLastPos);
+        if (idx >= 0) {
+            emit vertexPicked(idx);
+        }
+    }
 }
 
 void OpenGL3dModel::mouseReleaseEvent(QMouseEvent* event)
@@ -1138,31 +2335,43 @@ void OpenGL3dModel::mouseMoveEvent(QMouseEvent* event)
         mCamera.setEyePos(pos);
         emit cameraMoved();
     }
+    else {
+        return;
+    }
 
     update();
 }
 
-QString OpenGL3dModel::getVertexShaderCode()
+QString OpenGL3dModel::getVertexShaderCode(bool stereo)
 {
-    QString vert;
-    vert += "uniform int  useFog;\n";
-    vert += "uniform vec3 eyePos;\n";
+    QString vert = getStereoPrologue(stereo, true);
+    vert += "attribute vec3 basePos;\n";
+    vert += "attribute vec3 sachs1;\n";
+    vert += "attribute vec3 sachs2;\n";
+    vert += "attribute vec2 lambdaSide;\n";
+    vert += "uniform int   useFog;\n";
+    vert += "uniform vec3  eyePos;\n";
+    vert += "uniform float sachsScale;\n";
+    vert += "uniform int   legIndex;\n";
+    vert += "uniform vec2  legFactors;\n";
 
     vert += "void main()\n";
     vert += "{\n";
-    vert += "   gl_Position    = gl_ModelViewProjectionMatrix * gl_Vertex;\n";
-    vert += "   gl_TexCoord[0] = gl_MultiTexCoord0;\n";
+    vert += "   vec3 d   = sachsScale * (legIndex==0 ? sachs1 : sachs2);\n";
+    vert += "   vec3 pos = basePos + (lambdaSide.y < 0.5 ? -legFactors.x : legFactors.y) * d;\n";
+    vert += "   gl_Position    = stereoClip(PROJECTION * (MODELVIEW * vec4(pos,1.0)));\n";
+    vert += "   gl_TexCoord[0] = vec4(lambdaSide.y,lambdaSide.x,0.0,1.0);\n";
 
     vert += "   if (useFog==1)\n";
-    vert += "     gl_FogFragCoord = length(eyePos-gl_Vertex.xyz);\n";
+    vert += "     gl_FogFragCoord = length(eyePos-pos);\n";
     vert += "}\n";
 
     return vert;
 }
 
-QString OpenGL3dModel::getFragmentShaderCode()
+QString OpenGL3dModel::getFragmentShaderCode(bool stereo)
 {
-    QString frag;
+    QString frag = getStereoPrologue(stereo, false);
     frag += "uniform int   useFog;\n";
     frag += "uniform float fogFactor;\n";
     frag += "uniform vec3  col1;\n";
@@ -1195,3 +2404,313 @@ QString OpenGL3dModel::getFragmentShaderCode()
 
     return frag;
 }
+
+QString OpenGL3dModel::getLineVertexShaderCode(bool stereo)
+{
+    QString vert = getStereoPrologue(stereo, true);
+    vert += "attribute vec3 position;\n";
+    vert += "attribute vec3 normal;\n";
+    vert += "attribute float scalar;\n";
+    vert += "uniform int  useFog;\n";
+    vert += "uniform int  useLight;\n";
+    vert += "uniform vec2 scalarRange;\n";
+    vert += "varying float shade;\n";
+    vert += "varying float scalarCoord;\n";
+
+    vert += "void main()\n";
+    vert += "{\n";
+    vert += "   vec4 ePos   = MODELVIEW * vec4(position,1.0);\n";
+    vert += "   gl_Position = stereoClip(PROJECTION * ePos);\n";
+
+    // headlight, two-sided
+    vert += "   shade = 1.0;\n";
+    vert += "   if (useLight==1)\n";
+    vert += "   {\n";
+    vert += "     vec3 n = normalize(NORMALMATRIX * normal);\n";
+    vert += "     shade = 0.2 + 0.8*abs(dot(n,normalize(-ePos.xyz)));\n";
+    vert += "   }\n";
+
+    vert += "   scalarCoord = (scalar-scalarRange.x)/(scalarRange.y-scalarRange.x);\n";
+
+    vert += "   if (useFog==1)\n";
+    vert += "     gl_FogFragCoord = length(ePos.xyz);\n";
+    vert += "}\n";
+
+    return vert;
+}
+
+QString OpenGL3dModel::getLineFragmentShaderCode(bool stereo)
+{
+    QString frag = getStereoPrologue(stereo, false);
+    frag += "uniform int   useFog;\n";
+    frag += "uniform float fogFactor;\n";
+    frag += "uniform vec4  color;\n";
+    frag += "uniform int   useColormap;\n";
+    frag += "uniform sampler1D colormap;\n";
+    frag += "varying float shade;\n";
+    frag += "varying float scalarCoord;\n";
+    frag += "void main()\n";
+    frag += "{\n";
+    frag += "vec3 base = (useColormap==1 ? texture1D(colormap,clamp(scalarCoord,0.0,1.0)).rgb : color.rgb);\n";
+    frag += "vec4 col = vec4(base*shade,color.a);\n";
+
+    frag += "if (useFog==1)\n";
+    frag += "{\n";
+    frag += "  float fog = exp2( gl_FogFragCoord*gl_FogFragCoord*fogFactor );\n";
+    frag += "  fog = clamp(fog,0.0,1.0);\n";
+    frag += "  col = mix(vec4(0.0,0.0,0.0,1.0),col,fog);\n";
+    frag += "}\n";
+    frag += "gl_FragColor = col;\n";
+    frag += "}\n";
+
+    return frag;
+}
+
+QString OpenGL3dModel::getTubeVertexShaderCode(bool stereo)
+{
+    QString vert;
+    vert += "#version 150 compatibility\n";
+    vert += "in vec3 position;\n";
+    vert += "in float scalar;\n";
+    vert += "out float vScalar;\n";
+    if (stereo) {
+        vert += "uniform mat4 eyeMV[2];\n";
+        vert += "flat out int eye;\n";
+    }
+    vert += "void main()\n";
+    vert += "{\n";
+    vert += "   vScalar = scalar;\n";
+    if (stereo) {
+        vert += "   eye = gl_InstanceID;\n";
+        vert += "   gl_Position = eyeMV[gl_InstanceID] * vec4(position,1.0);\n";
+    }
+    else {
+        vert += "   gl_Position = gl_ModelViewMatrix * vec4(position,1.0);\n";
+    }
+    vert += "}\n";
+
+    return vert;
+}
+
+QString OpenGL3dModel::getTubeGeometryShaderCode(bool stereo)
+{
+    // Each segment p1-p2 of the line strip is expanded with its neighbours p0 and p3:
+    // lineMode 1 emits a camera-facing quad with miter joins (width in pixels),
+    // lineMode 2 emits a low-poly tube whose end rings are perpendicular to the
+    // averaged tangents, so adjacent segments share their rings.
+    QString geom;
+    geom += "#version 150 compatibility\n";
+    geom += "layout(lines_adjacency) in;\n";
+    geom += QString("layout(triangle_strip, max_vertices = %1) out;\n").arg(2 * (DEF_OPENGL_TUBE_SEGMENTS + 1));
+    geom += QString("const int numSegments = %1;\n").arg(DEF_OPENGL_TUBE_SEGMENTS);
+    geom += "uniform int   lineMode;\n";
+    geom += "uniform vec2  viewport;\n";
+    geom += "uniform float lineWidth;\n";
+    geom += "uniform float tubeRadius;\n";
+    geom += "uniform vec2  scalarRange;\n";
+    geom += "in float vScalar[];\n";
+    geom += "out float shade;\n";
+    geom += "out float fogDist;\n";
+    geom += "out float scalarCoord;\n";
+    if (stereo) {
+        geom += "uniform mat4 eyeProj[2];\n";
+        geom += "flat in int eye[];\n";
+        geom += "#define PROJECTION eyeProj[eye[0]]\n";
+        geom += "vec4 stereoClip(vec4 c)\n";
+        geom += "{\n";
+        geom += "   float s = (eye[0]==0 ? -1.0 : 1.0);\n";
+        geom += "   vec4  h = vec4(0.5*c.x + 0.5*s*c.w, c.yzw);\n";
+        geom += "   gl_ClipDistance[0] = s*h.x;\n";
+        geom += "   return h;\n";
+        geom += "}\n";
+    }
+    else {
+        geom += "#define PROJECTION gl_ProjectionMatrix\n";
+        geom += "vec4 stereoClip(vec4 c) { return c; }\n";
+    }
+
+    geom += "vec2 toScreen(vec4 c)\n";
+    geom += "{\n";
+    geom += "   return 0.5*viewport*c.xy/c.w;\n";
+    geom += "}\n";
+
+    geom += "vec2 miter(vec2 s0, vec2 s1, vec2 s2, out float len)\n";
+    geom += "{\n";
+    geom += "   vec2 d1 = s1-s0;\n";
+    geom += "   vec2 d2 = s2-s1;\n";
+    geom += "   d2 = (length(d2) > 1e-6 ? normalize(d2) : vec2(1.0,0.0));\n";
+    geom += "   d1 = (length(d1) > 1e-6 ? normalize(d1) : d2);\n";
+    geom += "   vec2 t = d1+d2;\n";
+    geom += "   t = (length(t) > 1e-6 ? normalize(t) : d2);\n";
+    geom += "   vec2 m = vec2(-t.y,t.x);\n";
+    geom += "   len = 0.5*lineWidth/max(dot(m,vec2(-d2.y,d2.x)),0.25);\n";
+    geom += "   return m;\n";
+    geom += "}\n";
+
+    geom += "float toCoord(float s)\n";
+    geom += "{\n";
+    geom += "   return (s-scalarRange.x)/(scalarRange.y-scalarRange.x);\n";
+    geom += "}\n";
+
+    geom += "void emitThick(vec4 ePos, vec2 m, float len, float s)\n";
+    geom += "{\n";
+    geom += "   vec4 c = PROJECTION * ePos;\n";
+    geom += "   scalarCoord = toCoord(s);\n";
+    geom += "   fogDist = length(ePos.xyz);\n";
+    geom += "   shade = 1.0;\n";
+    geom += "   gl_Position = stereoClip(c + vec4(m*len/(0.5*viewport)*c.w,0.0,0.0));\n";
+    geom += "   EmitVertex();\n";
+    geom += "   scalarCoord = toCoord(s);\n";
+    geom += "   gl_Position = stereoClip(c - vec4(m*len/(0.5*viewport)*c.w,0.0,0.0));\n";
+    geom += "   EmitVertex();\n";
+    geom += "}\n";
+
+    geom += "void ringFrame(vec3 t, out vec3 u, out vec3 v)\n";
+    geom += "{\n";
+    geom += "   vec3 r = (abs(t.z) < 0.9 ? vec3(0.0,0.0,1.0) : vec3(1.0,0.0,0.0));\n";
+    geom += "   u = normalize(cross(t,r));\n";
+    geom += "   v = cross(t,u);\n";
+    geom += "}\n";
+
+    geom += "void emitTube(vec3 p, vec3 n, float s)\n";
+    geom += "{\n";
+    geom += "   vec3 ePos = p + tubeRadius*n;\n";
+    geom += "   scalarCoord = toCoord(s);\n";
+    geom += "   fogDist = length(ePos);\n";
+    geom += "   shade = 0.2 + 0.8*abs(dot(n,normalize(-ePos)));\n";
+    geom += "   gl_Position = stereoClip(PROJECTION * vec4(ePos,1.0));\n";
+    geom += "   EmitVertex();\n";
+    geom += "}\n";
+
+    geom += "void main()\n";
+    geom += "{\n";
+    geom += "   vec4 p0 = gl_in[0].gl_Position;\n";
+    geom += "   vec4 p1 = gl_in[1].gl_Position;\n";
+    geom += "   vec4 p2 = gl_in[2].gl_Position;\n";
+    geom += "   vec4 p3 = gl_in[3].gl_Position;\n";
+    geom += "   if (lineMode==1)\n";
+    geom += "   {\n";
+    geom += "     vec2 s0 = toScreen(PROJECTION*p0);\n";
+    geom += "     vec2 s1 = toScreen(PROJECTION*p1);\n";
+    geom += "     vec2 s2 = toScreen(PROJECTION*p2);\n";
+    geom += "     vec2 s3 = toScreen(PROJECTION*p3);\n";
+    geom += "     float len1, len2;\n";
+    geom += "     vec2 m1 = miter(s0,s1,s2,len1);\n";
+    geom += "     vec2 m2 = miter(s1,s2,s3,len2);\n";
+    geom += "     emitThick(p1,m1,len1,vScalar[1]);\n";
+    geom += "     emitThick(p2,m2,len2,vScalar[2]);\n";
+    geom += "     EndPrimitive();\n";
+    geom += "   }\n";
+    geom += "   else\n";
+    geom += "   {\n";
+    geom += "     vec3 t1 = p2.xyz-p0.xyz;\n";
+    geom += "     vec3 t2 = p3.xyz-p1.xyz;\n";
+    geom += "     if (length(t1) < 1e-12 || length(t2) < 1e-12) return;\n";
+    geom += "     vec3 u1, v1, u2, v2;\n";
+    geom += "     ringFrame(normalize(t1),u1,v1);\n";
+    geom += "     ringFrame(normalize(t2),u2,v2);\n";
+    geom += "     for(int i=0; i<=numSegments; i++)\n";
+    geom += "     {\n";
+    geom += "       float phi = 6.2831853*float(i)/float(numSegments);\n";
+    geom += "       emitTube(p1.xyz,cos(phi)*u1+sin(phi)*v1,vScalar[1]);\n";
+    geom += "       emitTube(p2.xyz,cos(phi)*u2+sin(phi)*v2,vScalar[2]);\n";
+    geom += "     }\n";
+    geom += "     EndPrimitive();\n";
+    geom += "   }\n";
+    geom += "}\n";
+
+    return geom;
+}
+
+QString OpenGL3dModel::getTubeFragmentShaderCode()
+{
+    QString frag;
+    frag += "#version 150 compatibility\n";
+    frag += "uniform int   useFog;\n";
+    frag += "uniform float fogFactor;\n";
+    frag += "uniform vec4  color;\n";
+    frag += "uniform int   useColormap;\n";
+    frag += "uniform sampler1D colormap;\n";
+    frag += "in float shade;\n";
+    frag += "in float fogDist;\n";
+    frag += "in float scalarCoord;\n";
+    frag += "void main()\n";
+    frag += "{\n";
+    frag += "vec3 base = (useColormap==1 ? texture(colormap,clamp(scalarCoord,0.0,1.0)).rgb : color.rgb);\n";
+    frag += "vec4 col = vec4(base*shade,color.a);\n";
+
+    frag += "if (useFog==1)\n";
+    frag += "{\n";
+    frag += "  float fog = exp2( fogDist*fogDist*fogFactor );\n";
+    frag += "  fog = clamp(fog,0.0,1.0);\n";
+    frag += "  col = mix(vec4(0.0,0.0,0.0,1.0),col,fog);\n";
+    frag += "}\n";
+    frag += "gl_FragColor = col;\n";
+    frag += "}\n";
+
+    return frag;
+}
+
+QString OpenGL3dModel::getAnaglyphVertexShaderCode()
+{
+    QString vert;
+    vert += "attribute vec2 corner;\n";
+    vert += "varying vec2 tc;\n";
+    vert += "void main()\n";
+    vert += "{\n";
+    vert += "   tc = 0.5*corner + 0.5;\n";
+    vert += "   gl_Position = vec4(corner,0.0,1.0);\n";
+    vert += "}\n";
+
+    return vert;
+}
+
+QString OpenGL3dModel::getAnaglyphFragmentShaderCode()
+{
+    // Channels not seen by either eye keep the background color, as with color masks.
+    QString frag;
+    frag += "uniform sampler2D stereoTex;\n";
+    frag += "uniform vec3 maskLeft;\n";
+    frag += "uniform vec3 maskRight;\n";
+    frag += "uniform vec3 bgColor;\n";
+    frag += "varying vec2 tc;\n";
+    frag += "void main()\n";
+    frag += "{\n";
+    frag += "vec3 left  = texture2D(stereoTex,vec2(0.5*tc.x,tc.y)).rgb;\n";
+    frag += "vec3 right = texture2D(stereoTex,vec2(0.5+0.5*tc.x,tc.y)).rgb;\n";
+    frag += "vec3 col   = maskLeft*left + maskRight*right + (vec3(1.0)-maskLeft-maskRight)*bgColor;\n";
+    frag += "gl_FragColor = vec4(col,1.0);\n";
+    frag += "}\n";
+
+    return frag;
+}
+
+QString OpenGL3dModel::getPickVertexShaderCode()
+{
+    // The vertex id plus one is encoded in the color; zero marks the background.
+    QString vert;
+    vert += "#version 130\n";
+    vert += "in vec3 position;\n";
+    vert += "flat out vec4 idColor;\n";
+    vert += "void main()\n";
+    vert += "{\n";
+    vert += "   int id = gl_VertexID + 1;\n";
+    vert += "   idColor = vec4(id & 255, (id >> 8) & 255, (id >> 16) & 255, (id >> 24) & 255) / 255.0;\n";
+    vert += "   gl_Position = gl_ModelViewProjectionMatrix * vec4(position,1.0);\n";
+    vert += "}\n";
+
+    return vert;
+}
+
+QString OpenGL3dModel::getPickFragmentShaderCode()
+{
+    QString frag;
+    frag += "#version 130\n";
+    frag += "flat in vec4 idColor;\n";
+    frag += "void main()\n";
+    frag += "{\n";
+    frag += "gl_FragColor = idColor;\n";
+    frag += "}\n";
+
+    return frag;
+}
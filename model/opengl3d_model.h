@@ -10,12 +10,27 @@
 #define OPENGL3D_MODEL_H
 
 #include <QMouseEvent>
+#include <QMatrix4x4>
+#include <QOpenGLBuffer>
+#include <QOpenGLFramebufferObject>
 #include <QOpenGLShaderProgram>
+#include <QOpenGLVertexArrayObject>
 #include <QOpenGLWidget>
 
 #include <gdefs.h>
 #include <utils/camera.h>
+#include <utils/camera_path.h>
+#include <utils/embedding_mesh.h>
+#include <utils/frame_exporter.h>
+#include <utils/geodesic_colormap.h>
+#include <utils/geodesic_trails.h>
+#include <utils/gpu_pass_timer.h>
+#include <utils/layer_cache.h>
 #include <utils/myobject.h>
+#include <utils/object_meshes.h>
+#include <utils/projection_cache.h>
+#include <utils/rendertext.h>
+#include <utils/soft_renderer.h>
 #include <utils/utilities.h>
 
 #include <extra/m4dObject.h>
@@ -73,7 +88,25 @@ public:
 
     void setLineWidth(int width);
     void setLineSmooth(int smooth);
+    void setLineMode(int mode, double tubeRadius);
+
+    /**
+     * @brief Color the geodesic by a per-point scalar.
+     * @param scalar     Scalar channel, or none for a single color.
+     * @param cmap       Colormap.
+     * @param autoRange  Map the range of the scalar over the whole trajectory.
+     * @param min        Scalar mapped to the start of the colormap, if not autoRange.
+     * @param max        Scalar mapped to the end of the colormap, if not autoRange.
+     */
+    void setColormap(int scalar, int cmap, bool autoRange, double min, double max);
+
+    /**
+     * @brief Range of the current scalar over the whole trajectory.
+     */
+    void getColormapRange(double& min, double& max);
+
     void setStyle(enum_draw_style style);
+    void setTrails(int use, int num, int maxMBytes);
 
     void setScaling(double sx, double sy, double sz);
     void getScaling(double& sx, double& sy, double& sz);
@@ -94,17 +127,88 @@ public:
 
     bool saveRGBimage(QString filename);
 
+    /**
+     * @brief Render an animation offscreen at the image size and export its frames.
+     *   The camera and the number of shown points are restored afterwards.
+     *   A progress dialog allows to cancel the export.
+     * @param job  Frame count, frame rate, output, and what changes per frame.
+     * @return true if all frames were written, false on error or cancel.
+     */
+    bool exportAnimation(const struct_anim_export& job);
+
+    /**
+     * @brief Append the current camera to the camera path.
+     * @param dt  Time after the last keyframe in seconds; the first keyframe is at zero.
+     * @return false if the camera has no valid viewing direction.
+     */
+    bool addCameraKey(double dt);
+    void clearCameraPath();
+    int numCameraKeys();
+    double getCameraPathDuration();
+
+    /**
+     * @brief Set camera to the camera path at the given time.
+     * @param t  Time in seconds.
+     */
+    void setCameraPathTime(double t);
+
+    /**
+     * @brief Draw geodesics as plain lines while the camera path is previewed.
+     * @param preview
+     */
+    void setPathPreview(bool preview);
+
+    bool loadCameraPath(QString filename);
+    bool saveCameraPath(QString filename);
+
+    /**
+     * @brief Describe current view for the CPU renderer.
+     * @param job  Job without file name.
+     */
+    void getSoftJob(struct_soft_job& job);
+
+    /**
+     * @brief Show GPU time per render pass as overlay.
+     * @param show
+     */
+    void showPassTimes(bool show);
+
+    /**
+     * @brief Save logged GPU times per render pass.
+     * @param filename  Name of log file.
+     * @return true if file could be written.
+     */
+    bool savePassTimes(QString filename);
+
     void updateParams();
     void reset();
 
+    /**
+     * @brief Find the shown vertex next to a window position.
+     *   The geodesic is rendered with vertex ids into a small window around
+     *   the position; the nearest id wins.
+     * @param pos  Position in physical pixels.
+     * @return vertex index, or -1 if there is none within the pick radius.
+     */
+    int pickVertex(QPoint pos);
+
+    /**
+     * @brief Mark picked vertex.
+     * @param idx  Vertex index, or -1 to remove the marker.
+     */
+    void setPickedVertex(int idx);
+
 signals:
     void cameraMoved();
+    void vertexPicked(int idx);
 
 protected:
     virtual void initializeGL();
     virtual void paintGL();
     virtual void paintGL_mono();
+    virtual void paintGL_cached();
     virtual void paintGL_stereo();
+    virtual void paintGL_stereoMasked();
     virtual void paintGL_axes();
     virtual void resizeGL(int width, int height);
 
@@ -115,8 +219,65 @@ protected:
     virtual void mouseReleaseEvent(QMouseEvent* event);
     virtual void mouseMoveEvent(QMouseEvent* event);
 
-    QString getVertexShaderCode();
-    QString getFragmentShaderCode();
+    /**
+     * @brief Passes of the anaglyph stereo rendering.
+     *   Buffered geometry is drawn once for both eyes with instancing,
+     *   trails and objects are still drawn once per eye.
+     */
+    enum enum_stereo_pass { enum_stereo_pass_none = 0, enum_stereo_pass_instanced, enum_stereo_pass_eye };
+
+    /**
+     * @brief Layers of the mono rendering.
+     *   Embedding and objects only depend on camera and scene, and are
+     *   cached as static layer while the camera stands still.
+     */
+    enum enum_layer_pass { enum_layer_pass_all = 0, enum_layer_pass_static, enum_layer_pass_dynamic };
+
+    /**
+     * @brief Label sets of the text renderer.
+     */
+    enum enum_label_set { enum_label_set_objects = 0, enum_label_set_axes };
+
+    /**
+     * @brief Render passes measured by the GPU pass timer.
+     */
+    enum enum_timed_pass {
+        enum_timed_pass_embedding = 0,
+        enum_timed_pass_geodesic,
+        enum_timed_pass_sachs,
+        enum_timed_pass_objects,
+        enum_timed_pass_axes
+    };
+
+    void initBuffers();
+    void initStereoShaders();
+    bool initStereoTarget(int width, int height);
+    void uploadEmbed();
+    void bindEmbedArrays();
+    void bindAxesArrays();
+    void bindSachsArrays();
+    void setLineShaderParams(QOpenGLShaderProgram* prog, const QColor& col, bool useLight);
+    bool bindColormap(QOpenGLShaderProgram* prog, int location);
+    QOpenGLShaderProgram* bindSceneShader(QOpenGLShaderProgram* mono, QOpenGLShaderProgram* stereo);
+    void drawSceneArrays(GLenum mode, GLint first, GLsizei count);
+    void drawSceneElements(GLenum mode, GLsizei count, const GLvoid* indices);
+    void getStaticKey(std::vector<double>& key);
+    QMatrix4x4 getModelViewProjection();
+    void drawObjectLabels();
+    void drawAxesLabels();
+    bool drawExpandedGeodesic(QOpenGLBuffer* vbo, const QColor& col);
+
+    QString getVertexShaderCode(bool stereo);
+    QString getFragmentShaderCode(bool stereo);
+    QString getLineVertexShaderCode(bool stereo);
+    QString getLineFragmentShaderCode(bool stereo);
+    QString getTubeVertexShaderCode(bool stereo);
+    QString getTubeGeometryShaderCode(bool stereo);
+    QString getTubeFragmentShaderCode();
+    QString getAnaglyphVertexShaderCode();
+    QString getAnaglyphFragmentShaderCode();
+    QString getPickVertexShaderCode();
+    QString getPickFragmentShaderCode();
 
 private:
     struct_params* mParams;
@@ -126,6 +287,17 @@ private:
     enum_projection mProjection;
     enum_draw_style mDrawStyle;
     bool mStereo;
+    bool mStereoSupported;
+    enum_stereo_pass mStereoPass;
+    QMatrix4x4 mEyeMV[2]; //!< view and scaling of left and right eye
+    QMatrix4x4 mEyeProj[2];
+    QOpenGLFramebufferObject* mStereoFBO; //!< left and right eye side by side
+    double mTileScale; //!< image height over window height during tiled export
+    enum_layer_pass mLayerPass;
+    LayerCache mStaticCache; //!< embedding and objects
+
+    CameraPath mCamPath;
+    bool mPathPreview;
 
     QPoint mLastPos;
     int mKeyPressed;
@@ -135,28 +307,45 @@ private:
     QColor mFGcolor;
     QColor mBGcolor;
 
-    GLfloat* mVerts;
-    GLfloat* mLambda;
+    GLfloat* mVerts; //!< pinned entry of the shared projection cache
     int mNumVerts;
     int mLineWidth;
     int mLineSmooth;
+    enum_line_mode mLineMode;
+    double mTubeRadius;
+    QOpenGLBuffer mGeodIBO; //!< adjacency indices for thick lines and tubes
+    int mGeodIBONumVerts;
     int mShowNumVerts;
-
-    GLfloat* mSachsVerts1;
-    int mNumSachsVerts1;
-    GLfloat* mSachsVerts2;
-    int mNumSachsVerts2;
-    enum_sachs_legs mSachsLegs;
-    double mSachsScale;
-
-    GLfloat* mEmbVerts;
-    unsigned int mEmbNumVerts;
-    unsigned int mEmbNumElems;
-    unsigned int mEmbCounter;
-    unsigned int** mEmbIndices;
-    GLsizei* mCount;
+    m4d::enum_draw_type mDrawType;
+    double mDrawParam;
+    unsigned int mDrawRevision;
+
+    GeodesicTrails mTrails;
+    bool mUseTrails;
+
+    GeodesicColormap mColormap;
+    enum_geod_scalar mCmapScalar;
+    enum_colormap mCmapType;
+    bool mCmapAuto;
+    double mCmapMin;
+    double mCmapMax;
+
+    GLfloat* mSachsData; //!< per point two vertices: base, sachs1, sachs2, lambda, side
+    int mNumSachsPoints;
+    unsigned int mSachsRevision;
+    bool mSachsNeedUpload;
+    QOpenGLBuffer mSachsVBO;
+
+    EmbeddingMesh mEmbMesh;
+    std::shared_ptr<const struct_emb_mesh> mEmbUploaded; //!< mesh currently held by the buffers
+    QOpenGLBuffer mEmbVBO;
+    QOpenGLBuffer mEmbIBO;
+    QOpenGLVertexArrayObject mEmbVAO;
+    bool mPrimRestart;
 
     std::vector<MyObject*> mObjects;
+    unsigned int mObjectsRevision;
+    ObjectMeshes mObjMeshes; //!< spheres, cylinders, and disks
     bool mWiredObjs;
 
     double mScaleX;
@@ -180,14 +369,30 @@ private:
     double mAnimRotZ;
 
     QString mNameOfZaxis;
-    GLUquadricObj* mQuadricAxis;
-    GLUquadricObj* mQuadricDisk;
-    float redLight[3];
-    float greenLight[3];
-    float blueLight[3];
+#ifdef HAVE_FREETYPE
+    RenderText* renderText;
+    unsigned int mObjectLabelsRevision; //!< object revision the labels were laid out for
+    double mObjectLabelsScale;
+    QString mAxesLabelsKey;
+#endif // HAVE_FREETYPE
+    QOpenGLBuffer mAxesVBO;
+    QOpenGLVertexArrayObject mAxesVAO;
+    int mAxesNumVerts;
 
     bool mGLSLsupported;
     QOpenGLShaderProgram* shader;
+    QOpenGLShaderProgram* mLineShader; //!< geodesic, embedding, and axes
+    QOpenGLShaderProgram* mTubeShader; //!< thick lines and tubes
+    bool mTubeSupported;
+    QOpenGLShaderProgram* mSachsShaderStereo;
+    QOpenGLShaderProgram* mLineShaderStereo;
+    QOpenGLShaderProgram* mTubeShaderStereo;
+    QOpenGLShaderProgram* mAnaglyphShader;
+    QOpenGLShaderProgram* mPickShader; //!< vertex ids, created on the first pick
+    QOpenGLFramebufferObject* mPickFBO; //!< window around the cursor, created on the first pick
+    int mPickedVertex;
+
+    GpuPassTimer mPassTimer;
 };
 
 #endif // OPENGL3D_MODEL_H
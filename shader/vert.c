@@ -4,17 +4,27 @@
 // .DATE     11.12.2009
 // -----------------------------------------------------------------------------
 
-uniform int  useFog;
-uniform vec3 eyePos;
+attribute vec3 basePos;
+attribute vec3 sachs1;
+attribute vec3 sachs2;
+attribute vec2 lambdaSide;   // (affine parameter, ribbon side 0/1)
+
+uniform int   useFog;
+uniform vec3  eyePos;
+uniform float sachsScale;
+uniform int   legIndex;
+uniform vec2  legFactors;    // extension in negative/positive leg direction
 
 // ---------------------------------------------------
 //    m a i n
 // ---------------------------------------------------
 void main()
 {
-   gl_Position    = gl_ModelViewProjectionMatrix * gl_Vertex;
-   gl_TexCoord[0] = gl_MultiTexCoord0;
+   vec3 d   = sachsScale * (legIndex==0 ? sachs1 : sachs2);
+   vec3 pos = basePos + (lambdaSide.y < 0.5 ? -legFactors.x : legFactors.y) * d;
+   gl_Position    = gl_ModelViewProjectionMatrix * vec4(pos,1.0);
+   gl_TexCoord[0] = vec4(lambdaSide.y,lambdaSide.x,0.0,1.0);
 
    if (useFog==1)
-     gl_FogFragCoord = length(eyePos-gl_Vertex.xyz);
+     gl_FogFragCoord = length(eyePos-pos);
 }
@@ -0,0 +1,198 @@
+/**
+ * @file    batch_transform.cpp
+ * @author  Thomas Mueller
+ *
+ * This file is part of GeodesicView.
+ */
+#include "batch_transform.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace {
+
+/**
+ * @brief Closed-form pseudo-cartesian transformation of 'num' points.
+ *   The loop body has no virtual calls and no branches besides the coordinate
+ *   switch, which is hoisted out of the loop.
+ */
+void pseudoCartRange(m4d::enum_coordinate_type ctype, const m4d::vec4* points, GLfloat* verts, size_t num, int numComps)
+{
+    GLfloat* vptr = verts;
+    switch (ctype) {
+        case m4d::enum_coordinate_spherical: {
+            for (size_t i = 0; i < num; i++) {
+                const double r = points[i].x(1);
+                const double st = sin(points[i].x(2));
+                const double ct = cos(points[i].x(2));
+                const double sp = sin(points[i].x(3));
+                const double cp = cos(points[i].x(3));
+                *(vptr++) = GLfloat(r * st * cp);
+                *(vptr++) = GLfloat(r * st * sp);
+                if (numComps == 3) {
+                    *(vptr++) = GLfloat(r * ct);
+                }
+            }
+            break;
+        }
+        case m4d::enum_coordinate_cylinder: {
+            for (size_t i = 0; i < num; i++) {
+                const double r = points[i].x(1);
+                const double sp = sin(points[i].x(2));
+                const double cp = cos(points[i].x(2));
+                *(vptr++) = GLfloat(r * cp);
+                *(vptr++) = GLfloat(r * sp);
+                if (numComps == 3) {
+                    *(vptr++) = GLfloat(points[i].x(3));
+                }
+            }
+            break;
+        }
+        default: {
+            for (size_t i = 0; i < num; i++) {
+                *(vptr++) = GLfloat(points[i].x(1));
+                *(vptr++) = GLfloat(points[i].x(2));
+                if (numComps == 3) {
+                    *(vptr++) = GLfloat(points[i].x(3));
+                }
+            }
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Check whether the closed-form transformation reproduces the metric's own one.
+ *   Metrics may override transToPseudoCart; the closed form is used only if it agrees
+ *   with the metric at the first, middle, and last point.
+ */
+bool hasClosedFormPseudoCart(m4d::Metric* metric, const std::vector<m4d::vec4>& points)
+{
+    m4d::enum_coordinate_type ctype = metric->getCoordType();
+    if (ctype != m4d::enum_coordinate_cartesian && ctype != m4d::enum_coordinate_spherical
+        && ctype != m4d::enum_coordinate_cylinder) {
+        return false;
+    }
+
+    const size_t n = points.size();
+    const size_t samples[3] = { 0, n / 2, n - 1 };
+
+    m4d::vec4 tp;
+    GLfloat cf[3];
+    for (int k = 0; k < 3; k++) {
+        metric->transToPseudoCart(points[samples[k]], tp);
+        pseudoCartRange(ctype, &points[samples[k]], cf, 1, 3);
+        for (int c = 0; c < 3; c++) {
+            double scale = std::max(1.0, fabs(tp[c + 1]));
+            if (fabs(cf[c] - tp[c + 1]) > 1e-5 * scale) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool transformPoints(m4d::Metric* metric, m4d::enum_draw_type dtype, const std::vector<m4d::vec4>& points,
+    GLfloat* verts, int numComps, double zOffset)
+{
+    if (metric == nullptr || verts == nullptr || points.empty()) {
+        return false;
+    }
+
+    const size_t n = points.size();
+
+    // -----------------------------------------
+    //   closed-form pseudo-cartesian fast path
+    // -----------------------------------------
+    if (dtype == m4d::enum_draw_pseudocart && hasClosedFormPseudoCart(metric, points)) {
+        m4d::enum_coordinate_type ctype = metric->getCoordType();
+        size_t numThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        numThreads = std::min(numThreads, n / DEF_BATCH_TRANSFORM_CHUNK);
+
+        if (numThreads <= 1) {
+            pseudoCartRange(ctype, &points[0], verts, n, numComps);
+        }
+        else {
+            std::vector<std::thread> workers;
+            size_t chunk = (n + numThreads - 1) / numThreads;
+            for (size_t t = 1; t < numThreads; t++) {
+                size_t start = t * chunk;
+                size_t end = std::min(n, start + chunk);
+                workers.push_back(std::thread(pseudoCartRange, ctype, &points[start],
+                    verts + start * static_cast<size_t>(numComps), end - start, numComps));
+            }
+            pseudoCartRange(ctype, &points[0], verts, chunk, numComps);
+            for (size_t t = 0; t < workers.size(); t++) {
+                workers[t].join();
+            }
+        }
+        return true;
+    }
+
+    // -----------------------------------------
+    //   generic path via the metric
+    // -----------------------------------------
+    GLfloat* vptr = verts;
+    m4d::vec4 tp;
+    switch (dtype) {
+        case m4d::enum_draw_pseudocart:
+            for (size_t i = 0; i < n; i++) {
+                metric->transToPseudoCart(points[i], tp);
+                *(vptr++) = GLfloat(tp[1]);
+                *(vptr++) = GLfloat(tp[2]);
+                if (numComps == 3) {
+                    *(vptr++) = GLfloat(tp[3]);
+                }
+            }
+            break;
+        case m4d::enum_draw_embedding:
+            for (size_t i = 0; i < n; i++) {
+                metric->transToEmbedding(points[i], tp);
+                *(vptr++) = GLfloat(tp[1]);
+                *(vptr++) = GLfloat(tp[2]);
+                if (numComps == 3) {
+                    *(vptr++) = GLfloat(tp[3] + zOffset);
+                }
+            }
+            break;
+        case m4d::enum_draw_twoplusone:
+            for (size_t i = 0; i < n; i++) {
+                metric->transToTwoPlusOne(points[i], tp);
+                *(vptr++) = GLfloat(tp[1]);
+                *(vptr++) = GLfloat(tp[2]);
+                if (numComps == 3) {
+                    *(vptr++) = GLfloat(tp[3]);
+                }
+            }
+            break;
+        case m4d::enum_draw_custom:
+            for (size_t i = 0; i < n; i++) {
+                metric->transToCustom(points[i], tp);
+                *(vptr++) = GLfloat(tp[1]);
+                *(vptr++) = GLfloat(tp[2]);
+                if (numComps == 3) {
+                    *(vptr++) = GLfloat(tp[3]);
+                }
+            }
+            break;
+        case m4d::enum_draw_coordinates:
+        case m4d::enum_draw_effpoti:
+            return false;
+    }
+    return true;
+}
+
+void copyToFloat(const std::vector<double>& src, GLfloat* dest)
+{
+    if (dest == nullptr) {
+        return;
+    }
+
+    const size_t n = src.size();
+    for (size_t i = 0; i < n; i++) {
+        dest[i] = GLfloat(src[i]);
+    }
+}
@@ -0,0 +1,47 @@
+/**
+ * @file    batch_transform.h
+ * @author  Thomas Mueller
+ *
+ * @brief  Transform whole trajectories into a draw representation.
+ *
+ * The metric offers only per-point virtual transformations. For the common
+ * cartesian, spherical (incl. Boyer-Lindquist), and cylindrical coordinates
+ * the pseudo-cartesian representation is evaluated in closed form in a tight
+ * loop that is split across threads for long geodesics.
+ *
+ * This file is part of GeodesicView.
+ */
+#ifndef BATCH_TRANSFORM_H
+#define BATCH_TRANSFORM_H
+
+#include <vector>
+
+#include <gdefs.h>
+#include <m4dGlobalDefs.h>
+#include <metric/m4dMetric.h>
+
+/**
+ * @brief Transform trajectory points into the given draw representation.
+ *
+ *   For each point, the components tp[1], tp[2] (and tp[3] if numComps==3)
+ *   of the transformed point are stored consecutively in 'verts'.
+ *
+ * @param metric    Pointer to current metric.
+ * @param dtype     Draw type: pseudocart, embedding, twoplusone, or custom.
+ * @param points    Trajectory in metric coordinates.
+ * @param verts     Output array with at least points.size()*numComps entries.
+ * @param numComps  Number of components per vertex (2 or 3).
+ * @param zOffset   Offset added to the third component.
+ * @return true : draw type is supported.
+ */
+bool transformPoints(m4d::Metric* metric, m4d::enum_draw_type dtype, const std::vector<m4d::vec4>& points,
+    GLfloat* verts, int numComps, double zOffset = 0.0);
+
+/**
+ * @brief Narrow double array to float array.
+ * @param src   Source values.
+ * @param dest  Output array with at least src.size() entries.
+ */
+void copyToFloat(const std::vector<double>& src, GLfloat* dest);
+
+#endif // BATCH_TRANSFORM_H
@@ -34,6 +34,7 @@ void Camera::setStandardParams()
 
     mWidth = 100;
     mHeight = 100;
+    clearTile();
 
     mAspect = 1.0;
     mFovY = 90.0;
@@ -178,6 +179,53 @@ void Camera::getSize(int& width, int& height)
     height = mHeight;
 }
 
+void Camera::setTile(int x, int y, int width, int height)
+{
+    mUseTile = true;
+    mTile[0] = x;
+    mTile[1] = y;
+    mTile[2] = width;
+    mTile[3] = height;
+}
+
+bool Camera::getTile(int& x, int& y, int& width, int& height)
+{
+    x = mTile[0];
+    y = mTile[1];
+    width = mTile[2];
+    height = mTile[3];
+    return mUseTile;
+}
+
+void Camera::clearTile()
+{
+    mUseTile = false;
+    mTile[0] = mTile[1] = 0;
+    mTile[2] = mTile[3] = 0;
+}
+
+void Camera::getViewportSize(int& width, int& height)
+{
+    width = (mUseTile ? mTile[2] : mWidth);
+    height = (mUseTile ? mTile[3] : mHeight);
+}
+
+/**
+ * @brief Cut the part of the tile out of the near plane window of the full image.
+ */
+void Camera::tileWindow(double& left, double& right, double& bottom, double& top)
+{
+    if (!mUseTile) {
+        return;
+    }
+    double w = (right - left) / mWidth;
+    double h = (top - bottom) / mHeight;
+    left += w * mTile[0];
+    right = left + w * mTile[2];
+    bottom += h * mTile[1];
+    top = bottom + h * mTile[3];
+}
+
 /*! Rotate camera around vup with fixed point of interest.
  *  \param angle : angle of rotation
  */
@@ -507,28 +555,41 @@ void Camera::getStereoType(enum_stereo_type& type)
     type = mStereoType;
 }
 
-void Camera::lookAtMV_Left()
+void Camera::getStereoMasks(GLfloat* left, GLfloat* right)
 {
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
-
-    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    for (int c = 0; c < 3; c++) {
+        left[c] = right[c] = 0.0f;
+    }
     switch (mStereoGlasses) {
         case enum_stereo_red_blue:
+            left[0] = right[2] = 1.0f;
+            break;
         case enum_stereo_red_green:
+            left[0] = right[1] = 1.0f;
+            break;
         case enum_stereo_red_cyan:
-            glColorMask(GL_TRUE, GL_FALSE, GL_FALSE, GL_TRUE);
+            left[0] = right[1] = right[2] = 1.0f;
             break;
         case enum_stereo_blue_red:
-            glColorMask(GL_FALSE, GL_FALSE, GL_TRUE, GL_TRUE);
+            left[2] = right[0] = 1.0f;
             break;
         case enum_stereo_green_red:
-            glColorMask(GL_FALSE, GL_TRUE, GL_FALSE, GL_TRUE);
+            left[1] = right[0] = 1.0f;
             break;
         case enum_stereo_cyan_red:
-            glColorMask(GL_FALSE, GL_TRUE, GL_TRUE, GL_TRUE);
+            left[1] = left[2] = right[0] = 1.0f;
             break;
     }
+}
+
+void Camera::lookAtMV_Left()
+{
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+
+    GLfloat mask[2][3];
+    getStereoMasks(mask[0], mask[1]);
+    glColorMask(mask[0][0] > 0.0f, mask[0][1] > 0.0f, mask[0][2] > 0.0f, GL_TRUE);
 
     m4d::vec3 eye = mPos - mRight * 0.5 * mEyeSep;
     m4d::vec3 focus = mPOI;
@@ -544,6 +605,7 @@ void Camera::lookAtMV_Left()
             double right = mAspect * wd2 - 0.5 * mEyeSep * ndfl;
             double top = wd2;
             double bottom = -wd2;
+            tileWindow(left, right, bottom, top);
             glFrustum(left, right, bottom, top, mZnear, mZfar);
 
             focus = focus - mRight * 0.5 * mEyeSep + mDir;
@@ -566,23 +628,9 @@ void Camera::lookAtMV_Right()
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
 
-    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-    switch (mStereoGlasses) {
-        case enum_stereo_red_blue:
-            glColorMask(GL_FALSE, GL_FALSE, GL_TRUE, GL_TRUE);
-            break;
-        case enum_stereo_red_green:
-            glColorMask(GL_FALSE, GL_TRUE, GL_FALSE, GL_TRUE);
-            break;
-        case enum_stereo_red_cyan:
-            glColorMask(GL_FALSE, GL_TRUE, GL_TRUE, GL_TRUE);
-            break;
-        case enum_stereo_blue_red:
-        case enum_stereo_green_red:
-        case enum_stereo_cyan_red:
-            glColorMask(GL_TRUE, GL_FALSE, GL_FALSE, GL_TRUE);
-            break;
-    }
+    GLfloat mask[2][3];
+    getStereoMasks(mask[0], mask[1]);
+    glColorMask(mask[1][0] > 0.0f, mask[1][1] > 0.0f, mask[1][2] > 0.0f, GL_TRUE);
 
     m4d::vec3 eye = mPos + mRight * 0.5 * mEyeSep;
     m4d::vec3 focus = mPOI;
@@ -598,6 +646,7 @@ void Camera::lookAtMV_Right()
             double right = mAspect * wd2 + 0.5 * mEyeSep * ndfl;
             double top = wd2;
             double bottom = -wd2;
+            tileWindow(left, right, bottom, top);
             glFrustum(left, right, bottom, top, mZnear, mZfar);
 
             focus = focus + mRight * 0.5 * mEyeSep + mDir;
@@ -619,8 +668,19 @@ void Camera::perspective()
 {
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
-    glViewport(0, 0, mWidth, mHeight);
-    gluPerspective(mFovY, mAspect, mZnear, mZfar);
+    if (!mUseTile) {
+        glViewport(0, 0, mWidth, mHeight);
+        gluPerspective(mFovY, mAspect, mZnear, mZfar);
+        return;
+    }
+
+    glViewport(0, 0, mTile[2], mTile[3]);
+    double top = mZnear * tan(0.5 * mFovY * DEG_TO_RAD);
+    double bottom = -top;
+    double right = top * mAspect;
+    double left = -right;
+    tileWindow(left, right, bottom, top);
+    glFrustum(left, right, bottom, top, mZnear, mZfar);
 }
 
 void Camera::perspectiveAxes()
@@ -635,19 +695,22 @@ void Camera::orthographic()
 {
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
-    glViewport(0, 0, mWidth, mHeight);
+    viewport();
 
     double size = getDistance() * tan(0.5 * mFovY * DEG_TO_RAD);
     double bottom = -size;
     double top = size;
     double left = -size * mAspect;
     double right = size * mAspect;
+    tileWindow(left, right, bottom, top);
     glOrtho(left, right, bottom, top, mZnear, mZfar);
 }
 
 void Camera::viewport()
 {
-    glViewport(0, 0, GLsizei(mWidth), GLsizei(mHeight));
+    int width, height;
+    getViewportSize(width, height);
+    glViewport(0, 0, GLsizei(width), GLsizei(height));
 }
 
 void Camera::print(FILE* ptr)
@@ -61,6 +61,20 @@ public:
     void setSize(int width, int height);
     void getSize(int& width, int& height);
 
+    /*! Restrict the view to a tile of the image for tiled rendering.
+     * \param x : left border of the tile in pixels.
+     * \param y : bottom border of the tile in pixels.
+     * \param width : width of the tile in pixels.
+     * \param height : height of the tile in pixels.
+     */
+    void setTile(int x, int y, int width, int height);
+    bool getTile(int& x, int& y, int& width, int& height);
+    void clearTile();
+
+    /*! Size of the viewport, either the tile or the full image.
+     */
+    void getViewportSize(int& width, int& height);
+
     void fixRotAroundVup(double angle);
     void fixRotAroundRight(double angle);
     void fixRotAroundDir(double angle);
@@ -94,6 +108,12 @@ public:
     void setStereoType(enum_stereo_type type);
     void getStereoType(enum_stereo_type& type);
 
+    /*! Color channels seen by the left and right eye.
+     * \param left : rgb mask (0 or 1) of the left eye.
+     * \param right : rgb mask (0 or 1) of the right eye.
+     */
+    void getStereoMasks(GLfloat* left, GLfloat* right);
+
     void lookAtMV_Left();
     void lookAtMV_Right();
 
@@ -104,6 +124,9 @@ public:
 
     void print(FILE* ptr = stderr);
 
+protected:
+    void tileWindow(double& left, double& right, double& bottom, double& top);
+
 protected:
     m4d::vec3 mPos;
     m4d::vec3 mDir;
@@ -114,6 +137,8 @@ protected:
     GLdouble mAspect;
     int mWidth;
     int mHeight;
+    bool mUseTile;
+    int mTile[4];
     GLdouble mFovY;
 
     double mEyeSep;
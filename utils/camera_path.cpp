@@ -0,0 +1,212 @@
+/**
+ * @file    camera_path.cpp
+ * @author  Thomas Mueller
+ *
+ * This file is part of GeodesicView.
+ */
+#include "camera_path.h"
+#include "utilities.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+Quaternion getKeyRotation(struct_cam_key key)
+{
+    m4d::vec3 dir = (key.poi - key.pos).getNormalized();
+    m4d::vec3 right = (dir ^ key.vup).getNormalized();
+    m4d::vec3 vup = right ^ dir;
+
+    Quaternion q;
+    q.setCamFrame(right, vup, dir);
+    return q;
+}
+
+m4d::vec3 hermite(m4d::vec3 p0, m4d::vec3 m0, m4d::vec3 p1, m4d::vec3 m1, double dt, double s)
+{
+    double s2 = s * s;
+    double s3 = s2 * s;
+    double h00 = 2.0 * s3 - 3.0 * s2 + 1.0;
+    double h10 = s3 - 2.0 * s2 + s;
+    double h01 = -2.0 * s3 + 3.0 * s2;
+    double h11 = s3 - s2;
+    return p0 * h00 + m0 * (h10 * dt) + p1 * h01 + m1 * (h11 * dt);
+}
+
+} // namespace
+
+CameraPath::CameraPath()
+{
+}
+
+CameraPath::~CameraPath()
+{
+}
+
+bool CameraPath::addKey(Camera& camera, double time)
+{
+    if (!mKeys.empty() && time <= mKeys.back().time) {
+        return false;
+    }
+
+    struct_cam_key key;
+    key.time = time;
+    key.pos = camera.getEyePos();
+    key.poi = camera.getPOI();
+    key.vup = camera.getVup();
+    key.fovy = camera.getFovY();
+    if ((key.poi - key.pos).isZero()) {
+        return false;
+    }
+
+    // Neighbouring orientations must lie in the same hemisphere for the short slerp arc.
+    Quaternion q = getKeyRotation(key);
+    if (!mRots.empty()) {
+        const Quaternion& p = mRots.back();
+        if (p.r() * q.r() + p.i() * q.i() + p.j() * q.j() + p.k() * q.k() < 0.0) {
+            q = q * (-1.0);
+        }
+    }
+    mKeys.push_back(key);
+    mRots.push_back(q);
+    return true;
+}
+
+void CameraPath::clear()
+{
+    mKeys.clear();
+    mRots.clear();
+}
+
+int CameraPath::numKeys() const
+{
+    return static_cast<int>(mKeys.size());
+}
+
+double CameraPath::duration() const
+{
+    return (mKeys.empty() ? 0.0 : mKeys.back().time);
+}
+
+bool CameraPath::evaluate(double t, Camera& camera) const
+{
+    if (mKeys.empty()) {
+        return false;
+    }
+
+    struct_cam_key key;
+    Quaternion rot;
+    if (mKeys.size() == 1 || t <= mKeys.front().time) {
+        key = mKeys.front();
+        rot = mRots.front();
+    }
+    else if (t >= mKeys.back().time) {
+        key = mKeys.back();
+        rot = mRots.back();
+    }
+    else {
+        size_t i = 1;
+        while (i < mKeys.size() - 1 && mKeys[i].time < t) {
+            i++;
+        }
+        const struct_cam_key& k0 = mKeys[i - 1];
+        const struct_cam_key& k1 = mKeys[i];
+        double dt = k1.time - k0.time;
+        double s = (t - k0.time) / dt;
+
+        int i0 = static_cast<int>(i) - 1;
+        key.pos = hermite(k0.pos, tangent(i0, false), k1.pos, tangent(i0 + 1, false), dt, s);
+        key.poi = hermite(k0.poi, tangent(i0, true), k1.poi, tangent(i0 + 1, true), dt, s);
+        key.fovy = k0.fovy + s * (k1.fovy - k0.fovy);
+        rot = Quaternion::slerp(mRots[i - 1], mRots[i], s);
+    }
+
+    // The spline fixes the viewing direction; the slerped orientation only contributes the roll.
+    rot.calcMat();
+    m4d::vec3 dir = key.poi - key.pos;
+    if (dir.isZero()) {
+        dir = -rot.getCamDir();
+    }
+    m4d::vec3 vup = rot.getCamVup();
+
+    camera.setPosRFrame(key.pos, dir, vup);
+    camera.setPOI(key.poi);
+    camera.setFovY(key.fovy);
+    return true;
+}
+
+bool CameraPath::load(std::string filename)
+{
+    std::vector<std::vector<std::string>> tokens;
+    if (!tokenizeFile(filename, tokens)) {
+        return false;
+    }
+
+    clear();
+    for (unsigned int i = 0; i < tokens.size(); i++) {
+        if (tokens[i].size() < 12 || tokens[i][0].compare("CAM_KEY") != 0) {
+            continue;
+        }
+
+        double val[11];
+        for (int n = 0; n < 11; n++) {
+            val[n] = atof(tokens[i][n + 1].c_str());
+        }
+
+        Camera camera;
+        m4d::vec3 pos(val[1], val[2], val[3]);
+        m4d::vec3 poi(val[4], val[5], val[6]);
+        camera.setPosRFrame(pos, poi - pos, m4d::vec3(val[7], val[8], val[9]));
+        camera.setPOI(poi);
+        camera.setFovY(val[10]);
+        if (!addKey(camera, val[0])) {
+            fprintf(stderr, "Skip camera key at time %f in %s!\n", val[0], filename.c_str());
+        }
+    }
+    return true;
+}
+
+bool CameraPath::save(std::string filename) const
+{
+    FILE* fptr = nullptr;
+#ifdef _WIN32
+    fopen_s(&fptr, filename.c_str(), "w");
+#else
+    fptr = fopen(filename.c_str(), "w");
+#endif
+
+    if (fptr == nullptr) {
+        fprintf(stderr, "Cannot open %s for camera path output!\n", filename.c_str());
+        return false;
+    }
+
+    fprintf(fptr, "# ----------------------------------------------------------\n");
+    fprintf(fptr, "# Camera path : %s\n", filename.c_str());
+    fprintf(fptr, "#   CAM_KEY  time  pos(3)  poi(3)  vup(3)  fovy\n");
+    fprintf(fptr, "# ----------------------------------------------------------\n");
+    for (size_t i = 0; i < mKeys.size(); i++) {
+        struct_cam_key key = mKeys[i];
+        fprintf(fptr, "CAM_KEY %10.4f  %16.12f %16.12f %16.12f  %16.12f %16.12f %16.12f  %12.9f %12.9f %12.9f  %f\n",
+            key.time, key.pos[0], key.pos[1], key.pos[2], key.poi[0], key.poi[1], key.poi[2], key.vup[0], key.vup[1],
+            key.vup[2], key.fovy);
+    }
+    fclose(fptr);
+    return true;
+}
+
+m4d::vec3 CameraPath::tangent(int i, bool poi) const
+{
+    // Finite differences over the neighbouring keyframes; one-sided at the ends of the path.
+    int n = static_cast<int>(mKeys.size());
+    int i0 = (i > 0 ? i - 1 : i);
+    int i1 = (i < n - 1 ? i + 1 : i);
+    if (i0 == i1) {
+        return m4d::vec3();
+    }
+
+    struct_cam_key k0 = mKeys[static_cast<size_t>(i0)];
+    struct_cam_key k1 = mKeys[static_cast<size_t>(i1)];
+    m4d::vec3 dp = (poi ? k1.poi - k0.poi : k1.pos - k0.pos);
+    return dp * (1.0 / (k1.time - k0.time));
+}
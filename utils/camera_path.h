@@ -0,0 +1,93 @@
+/**
+ * @file    camera_path.h
+ * @author  Thomas Mueller
+ *
+ * @brief  Camera keyframes and their interpolation.
+ *
+ * A keyframe holds the eye position, the point of interest, the vertical
+ * up vector, and the field of view at a given time. Eye position and point
+ * of interest follow a cubic Hermite spline with finite-difference
+ * tangents, the camera orientation is interpolated by spherical linear
+ * interpolation of quaternions. The path is evaluated for a time in
+ * seconds, so interactive preview and offline rendering at any frame rate
+ * show the same framing.
+ *
+ * This file is part of GeodesicView.
+ */
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <string>
+#include <vector>
+
+#include <gdefs.h>
+#include <utils/camera.h>
+
+#include <m4dGlobalDefs.h>
+
+typedef struct _struct_cam_key {
+    double time; //!< seconds since start of the path
+    m4d::vec3 pos;
+    m4d::vec3 poi;
+    m4d::vec3 vup;
+    double fovy;
+} struct_cam_key;
+
+/**
+ * @brief The CameraPath class
+ */
+class CameraPath
+{
+public:
+    CameraPath();
+    ~CameraPath();
+
+public:
+    /**
+     * @brief Append the current camera as keyframe.
+     * @param camera  Camera.
+     * @param time    Time of the keyframe; has to be later than the last keyframe.
+     * @return false if the time is not later than the last keyframe.
+     */
+    bool addKey(Camera& camera, double time);
+
+    void clear();
+
+    int numKeys() const;
+
+    /**
+     * @brief Time of the last keyframe.
+     */
+    double duration() const;
+
+    /**
+     * @brief Set camera to the interpolated keyframes.
+     * @param t       Time in seconds; clamped to the path.
+     * @param camera  Camera.
+     * @return false if there are no keyframes.
+     */
+    bool evaluate(double t, Camera& camera) const;
+
+    /**
+     * @brief Load keyframes, one per line: time, pos, poi, vup, fovy.
+     * @param filename  Name of path file.
+     * @return true if file could be read.
+     */
+    bool load(std::string filename);
+
+    /**
+     * @brief Save keyframes.
+     * @param filename  Name of path file.
+     * @return true if file could be written.
+     */
+    bool save(std::string filename) const;
+
+protected:
+    m4d::vec3 tangent(int i, bool poi) const;
+
+private:
+    std::vector<struct_cam_key> mKeys;
+    std::vector<Quaternion> mRots; //!< orientation per keyframe, sign-aligned to its predecessor
+};
+
+#endif // CAMERA_PATH_H
@@ -0,0 +1,354 @@
+/**
+ * @file    effpot_curve.cpp
+ * @author  Thomas Mueller
+ *
+ * This file is part of GeodesicView.
+ */
+#include "effpot_curve.h"
+#include "utilities.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+EffPotCurve::EffPotCurve()
+{
+    mReceiver = nullptr;
+    mRevision = 0;
+    mHaveRevision = false;
+    mCoveredMin = 0.0;
+    mCoveredMax = 0.0;
+    mVBO = nullptr;
+    mNeedUpload = false;
+
+    mCancel = false;
+    mRunning = false;
+    mResultReady = false;
+
+    mSource = nullptr;
+    mMetric = nullptr;
+    mType = m4d::enum_geodesic_lightlike;
+    mJobMin = mJobMax = 0.0;
+    mJobSamples = 0;
+}
+
+EffPotCurve::~EffPotCurve()
+{
+    // The owner has to release the GL buffer with its context current.
+    stopJob();
+    delete mMetric;
+}
+
+void EffPotCurve::setReceiver(QObject* receiver)
+{
+    mReceiver = receiver;
+}
+
+void EffPotCurve::update(unsigned int revision, m4d::Metric* metric, const m4d::vec4& pos, const m4d::vec4& cdir,
+    m4d::enum_geodesic_type type, double xMin, double xMax)
+{
+    double width = xMax - xMin;
+    if (metric == nullptr || !(width > 0.0)) {
+        return;
+    }
+
+    // Metric parameters, initial position, direction, and type only change
+    // together with a new trajectory, hence the revision identifies the curve.
+    // The worker samples a private copy of the metric, which the GUI thread
+    // may change at any time.
+    if (!mHaveRevision || revision != mRevision || metric != mSource) {
+        clear();
+        mRevision = revision;
+        mHaveRevision = true;
+        mSource = metric;
+        mMetric = copyMetric(metric);
+        mPos = pos;
+        mDir = cdir;
+        mType = type;
+
+        if (mMetric != nullptr) {
+            double margin = DEF_EFFPOT_MARGIN * width;
+            startJob(xMin - margin, xMax + margin,
+                static_cast<int>(DEF_EFFPOT_NUM_SAMPLES * (1.0 + 2.0 * DEF_EFFPOT_MARGIN)));
+        }
+        return;
+    }
+    if (mMetric == nullptr) {
+        return;
+    }
+
+    if (mRunning) {
+        return;
+    }
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+    // Merged only after the join, so that no new job can discard a finished result.
+    mergeResult();
+
+    // Newly exposed ranges are sampled first; after zooming in, the visible
+    // range is resampled where the grid is much coarser than the view needs.
+    double margin = DEF_EFFPOT_MARGIN * width;
+    double spacing = width / DEF_EFFPOT_NUM_SAMPLES;
+    if (xMin < mCoveredMin) {
+        double x0 = xMin - margin;
+        startJob(x0, mCoveredMin, std::max(2, static_cast<int>(DEF_EFFPOT_NUM_SAMPLES * (mCoveredMin - x0) / width)));
+    }
+    else if (xMax > mCoveredMax) {
+        double x1 = xMax + margin;
+        startJob(mCoveredMax, x1, std::max(2, static_cast<int>(DEF_EFFPOT_NUM_SAMPLES * (x1 - mCoveredMax) / width)));
+    }
+    else if (getSpacing(xMin, xMax) > DEF_EFFPOT_RESAMPLE * spacing) {
+        startJob(xMin - margin, xMax + margin,
+            static_cast<int>(DEF_EFFPOT_NUM_SAMPLES * (1.0 + 2.0 * DEF_EFFPOT_MARGIN)));
+    }
+}
+
+void EffPotCurve::draw()
+{
+    if (mVerts.empty()) {
+        return;
+    }
+
+    if (mNeedUpload) {
+        if (mVBO == nullptr) {
+            mVBO = new QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+            mVBO->setUsagePattern(QOpenGLBuffer::StaticDraw);
+            if (!mVBO->create()) {
+                delete mVBO;
+                mVBO = nullptr;
+            }
+        }
+        if (mVBO != nullptr) {
+            mVBO->bind();
+            mVBO->allocate(mVerts.data(), static_cast<int>(mVerts.size() * sizeof(GLfloat)));
+            mVBO->release();
+        }
+        mNeedUpload = false;
+    }
+
+    if (mVBO != nullptr) {
+        mVBO->bind();
+        glVertexPointer(2, GL_FLOAT, 0, nullptr);
+    }
+    else {
+        glVertexPointer(2, GL_FLOAT, 0, mVerts.data());
+    }
+    glEnableClientState(GL_VERTEX_ARRAY);
+    for (size_t i = 0; i < mSegFirst.size(); i++) {
+        glDrawArrays(GL_LINE_STRIP, mSegFirst[i], mSegCount[i]);
+    }
+    glDisableClientState(GL_VERTEX_ARRAY);
+    if (mVBO != nullptr) {
+        mVBO->release();
+    }
+}
+
+void EffPotCurve::getVerts(std::vector<GLfloat>& verts) const
+{
+    verts.clear();
+    for (size_t i = 0; i < mSegFirst.size(); i++) {
+        if (i > 0) {
+            verts.push_back(std::numeric_limits<GLfloat>::quiet_NaN());
+            verts.push_back(std::numeric_limits<GLfloat>::quiet_NaN());
+        }
+        const GLfloat* v = mVerts.data() + 2 * static_cast<size_t>(mSegFirst[i]);
+        verts.insert(verts.end(), v, v + 2 * static_cast<size_t>(mSegCount[i]));
+    }
+}
+
+void EffPotCurve::clear()
+{
+    stopJob();
+    delete mMetric;
+    mMetric = nullptr;
+    mSource = nullptr;
+    mSamples.clear();
+    mVerts.clear();
+    mSegFirst.clear();
+    mSegCount.clear();
+    mHaveRevision = false;
+    mCoveredMin = 0.0;
+    mCoveredMax = 0.0;
+    mNeedUpload = false;
+}
+
+void EffPotCurve::releaseBuffer()
+{
+    if (mVBO != nullptr) {
+        mVBO->destroy();
+        delete mVBO;
+        mVBO = nullptr;
+    }
+}
+
+void EffPotCurve::startJob(double x0, double x1, int numSamples)
+{
+    mJobMin = x0;
+    mJobMax = x1;
+    mJobSamples = numSamples;
+    mCancel = false;
+    mRunning = true;
+    mResultReady = false;
+    mThread = std::thread(&EffPotCurve::run, this);
+}
+
+void EffPotCurve::stopJob()
+{
+    mCancel = true;
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+    mRunning = false;
+    mResultReady = false;
+    mResult.clear();
+}
+
+void EffPotCurve::mergeResult()
+{
+    std::vector<struct_effpot_sample> result;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mResultReady) {
+            return;
+        }
+        result.swap(mResult);
+        mResultReady = false;
+    }
+
+    if (mSamples.empty()) {
+        mCoveredMin = mJobMin;
+        mCoveredMax = mJobMax;
+    }
+    else {
+        mCoveredMin = std::min(mCoveredMin, mJobMin);
+        mCoveredMax = std::max(mCoveredMax, mJobMax);
+    }
+
+    // Replace existing samples in the job range by the new ones.
+    double x0 = mJobMin;
+    double x1 = mJobMax;
+    mSamples.erase(std::remove_if(mSamples.begin(), mSamples.end(),
+                       [x0, x1](const struct_effpot_sample& s) { return (s.x >= x0 && s.x <= x1); }),
+        mSamples.end());
+    std::vector<struct_effpot_sample>::iterator pos = std::lower_bound(mSamples.begin(), mSamples.end(), x0,
+        [](const struct_effpot_sample& s, double x) { return s.x < x; });
+    mSamples.insert(pos, result.begin(), result.end());
+
+    // Invalid samples split the curve into separate line strips.
+    mVerts.clear();
+    mSegFirst.clear();
+    mSegCount.clear();
+    GLint numVerts = 0;
+    bool inSegment = false;
+    for (size_t i = 0; i < mSamples.size(); i++) {
+        if (!mSamples[i].valid) {
+            inSegment = false;
+            continue;
+        }
+        if (!inSegment) {
+            mSegFirst.push_back(numVerts);
+            mSegCount.push_back(0);
+            inSegment = true;
+        }
+        mVerts.push_back(static_cast<GLfloat>(mSamples[i].x));
+        mVerts.push_back(static_cast<GLfloat>(mSamples[i].val));
+        mSegCount.back()++;
+        numVerts++;
+    }
+    mNeedUpload = true;
+}
+
+void EffPotCurve::run()
+{
+    std::vector<struct_effpot_sample> samples;
+    sampleRange(mJobMin, mJobMax, mJobSamples, samples);
+    if (mCancel) {
+        mRunning = false;
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mResult.swap(samples);
+        mResultReady = true;
+    }
+    mRunning = false;
+
+    if (mReceiver != nullptr) {
+        QMetaObject::invokeMethod(mReceiver, "update", Qt::QueuedConnection);
+    }
+}
+
+void EffPotCurve::sampleRange(double x0, double x1, int numSamples, std::vector<struct_effpot_sample>& samples)
+{
+    int num = std::max(2, numSamples);
+    double dx = (x1 - x0) / num;
+
+    struct_effpot_sample prev = evaluate(x0);
+    samples.push_back(prev);
+    for (int i = 1; i <= num; i++) {
+        if (mCancel) {
+            return;
+        }
+        struct_effpot_sample curr = evaluate(i < num ? x0 + i * dx : x1);
+        refine(prev, curr, 0, samples);
+        samples.push_back(curr);
+        prev = curr;
+    }
+
+    for (size_t i = 0; i < samples.size(); i++) {
+        samples[i].spacing = dx;
+    }
+}
+
+double EffPotCurve::getSpacing(double xMin, double xMax)
+{
+    double spacing = 0.0;
+    std::vector<struct_effpot_sample>::const_iterator it = std::lower_bound(mSamples.begin(), mSamples.end(), xMin,
+        [](const struct_effpot_sample& s, double x) { return s.x < x; });
+    for (; it != mSamples.end() && it->x <= xMax; ++it) {
+        spacing = std::max(spacing, it->spacing);
+    }
+    return spacing;
+}
+
+void EffPotCurve::refine(const struct_effpot_sample& s0, const struct_effpot_sample& s1, int depth,
+    std::vector<struct_effpot_sample>& samples)
+{
+    if (depth >= DEF_EFFPOT_MAX_DEPTH) {
+        return;
+    }
+
+    struct_effpot_sample sm = evaluate(0.5 * (s0.x + s1.x));
+
+    bool split = false;
+    if (s0.valid != sm.valid || sm.valid != s1.valid) {
+        // locate border of the domain, e.g. a horizon
+        split = true;
+    }
+    else if (sm.valid) {
+        double vmin = std::min(s0.val, s1.val);
+        double vmax = std::max(s0.val, s1.val);
+        double scale = std::max(std::max(fabs(s0.val), fabs(s1.val)), fabs(sm.val));
+        double dev = fabs(sm.val - 0.5 * (s0.val + s1.val));
+        // extremum (e.g. photon orbit) or curvature
+        split = (sm.val < vmin || sm.val > vmax || dev > DEF_EFFPOT_TOLERANCE * scale);
+    }
+
+    if (split) {
+        refine(s0, sm, depth + 1, samples);
+        samples.push_back(sm);
+        refine(sm, s1, depth + 1, samples);
+    }
+}
+
+EffPotCurve::struct_effpot_sample EffPotCurve::evaluate(double x)
+{
+    struct_effpot_sample s;
+    s.x = x;
+    s.val = 0.0;
+    s.spacing = 0.0;
+    s.valid = mMetric->effPotentialValue(mPos, mDir, mType, x, s.val) && std::isfinite(s.val);
+    return s;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file    effpot_curve.h
+ * @author  Thomas Mueller
+ *
+ * @brief  Adaptively sampled effective potential curve.
+ *
+ * The effective potential of the current geodesic is sampled once per
+ * trajectory revision in a worker thread. Samples are refined near extrema
+ * (e.g. the photon orbit) and where the curve deviates from a straight line.
+ * Panning or zooming out only samples the newly exposed x ranges; zooming in
+ * resamples the visible range once its grid is too coarse for the view. The
+ * worker evaluates a private copy of the metric.
+ *
+ * This file is part of GeodesicView.
+ */
+#ifndef EFFPOT_CURVE_H
+#define EFFPOT_CURVE_H
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <QObject>
+#include <QOpenGLBuffer>
+
+#include <gdefs.h>
+#include <m4dGlobalDefs.h>
+#include <metric/m4dMetric.h>
+
+/**
+ * @brief The EffPotCurve class
+ */
+class EffPotCurve
+{
+public:
+    EffPotCurve();
+    ~EffPotCurve();
+
+public:
+    /**
+     * @brief Set object that is asked to repaint when new samples are available.
+     * @param receiver  Pointer to widget.
+     */
+    void setReceiver(QObject* receiver);
+
+    /**
+     * @brief Make sure that the curve covers the visible x range.
+     *   Finished samples are merged, and a new job is started for missing
+     *   ranges. The curve is resampled if the revision changed.
+     * @param revision  Trajectory revision.
+     * @param metric    Pointer to current metric.
+     * @param pos       Initial position.
+     * @param cdir      Initial coordinate direction.
+     * @param type      Geodesic type.
+     * @param xMin      Left border of the visible range.
+     * @param xMax      Right border of the visible range.
+     */
+    void update(unsigned int revision, m4d::Metric* metric, const m4d::vec4& pos, const m4d::vec4& cdir,
+        m4d::enum_geodesic_type type, double xMin, double xMax);
+
+    /**
+     * @brief Draw curve as line strips. Needs a current context.
+     */
+    void draw();
+
+    /**
+     * @brief Copy the curve, e.g. for export.
+     * @param verts  Reference to vertex list; a NaN vertex separates line strips.
+     */
+    void getVerts(std::vector<GLfloat>& verts) const;
+
+    /**
+     * @brief Stop worker and drop all samples.
+     */
+    void clear();
+
+    /**
+     * @brief Destroy GL buffer. Needs a current context.
+     */
+    void releaseBuffer();
+
+protected:
+    typedef struct _struct_effpot_sample {
+        double x;
+        double val;
+        bool valid;
+        double spacing; //!< grid spacing of the job that produced the sample
+    } struct_effpot_sample;
+
+    void startJob(double x0, double x1, int numSamples);
+    void stopJob();
+    void mergeResult();
+    void run();
+
+    void sampleRange(double x0, double x1, int numSamples, std::vector<struct_effpot_sample>& samples);
+    void refine(const struct_effpot_sample& s0, const struct_effpot_sample& s1, int depth,
+        std::vector<struct_effpot_sample>& samples);
+    struct_effpot_sample evaluate(double x);
+    double getSpacing(double xMin, double xMax);
+
+private:
+    QObject* mReceiver;
+
+    // ---- samples owned by the GUI thread ----
+    std::vector<struct_effpot_sample> mSamples;
+    unsigned int mRevision;
+    bool mHaveRevision;
+    double mCoveredMin;
+    double mCoveredMax;
+
+    std::vector<GLfloat> mVerts;
+    std::vector<GLint> mSegFirst;
+    std::vector<GLsizei> mSegCount;
+    QOpenGLBuffer* mVBO;
+    bool mNeedUpload;
+
+    // ---- worker ----
+    std::thread mThread;
+    std::mutex mMutex;
+    std::atomic<bool> mCancel;
+    std::atomic<bool> mRunning;
+    bool mResultReady;
+    std::vector<struct_effpot_sample> mResult;
+
+    m4d::Metric* mSource; //!< metric of the GUI, only used to detect a change
+    m4d::Metric* mMetric; //!< private copy evaluated by the worker
+    m4d::vec4 mPos;
+    m4d::vec4 mDir;
+    m4d::enum_geodesic_type mType;
+    double mJobMin;
+    double mJobMax;
+    int mJobSamples;
+};
+
+#endif // EFFPOT_CURVE_H
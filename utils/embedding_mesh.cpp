@@ -0,0 +1,252 @@
+/**
+ * @file    embedding_mesh.cpp
+ * @author  Thomas Mueller
+ *
+ * This file is part of GeodesicView.
+ */
+#include "embedding_mesh.h"
+#include "utilities.h"
+
+#include <cstdio>
+
+#include <extra/m4dObject.h>
+
+extern m4d::Object mObject;
+
+EmbeddingMesh::EmbeddingMesh(size_t maxBytes)
+{
+    mReceiver = nullptr;
+    mMaxBytes = maxBytes;
+    mUsedBytes = 0;
+
+    mHaveWanted = false;
+    mPendingMetric = nullptr;
+    mRunning = false;
+    mJobMetric = nullptr;
+}
+
+EmbeddingMesh::~EmbeddingMesh()
+{
+    stopJob();
+    if (mPendingMetric != nullptr) {
+        delete mPendingMetric;
+        mPendingMetric = nullptr;
+    }
+}
+
+void EmbeddingMesh::setReceiver(QObject* receiver)
+{
+    mReceiver = receiver;
+}
+
+void EmbeddingMesh::request(m4d::Metric* metric)
+{
+    if (metric == nullptr) {
+        clear();
+        return;
+    }
+
+    struct_emb_key key = makeKey(metric);
+    if (mPendingMetric != nullptr) {
+        delete mPendingMetric;
+        mPendingMetric = nullptr;
+    }
+    mWantedKey = key;
+    mHaveWanted = true;
+    poll();
+
+    std::shared_ptr<const struct_emb_mesh> mesh = find(key);
+    if (mesh != nullptr) {
+        mCurrent = mesh;
+        return;
+    }
+    if (mRunning && isSameKey(key, mJobKey)) {
+        return;
+    }
+
+    // The worker operates on its own metric instance and never touches the current one.
+    m4d::Metric* copy = copyMetric(metric);
+    if (copy == nullptr) {
+        return;
+    }
+
+    if (mRunning) {
+        mPendingMetric = copy;
+        mPendingKey = key;
+    }
+    else {
+        startJob(copy, key);
+    }
+}
+
+void EmbeddingMesh::poll()
+{
+    // The worker stores its result before it clears the running flag.
+    if (mRunning) {
+        return;
+    }
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+
+    std::shared_ptr<struct_emb_mesh> result;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        result.swap(mResult);
+    }
+    if (result != nullptr) {
+        insert(result);
+        if (mHaveWanted && isSameKey(result->key, mWantedKey)) {
+            mCurrent = result;
+        }
+    }
+
+    if (mPendingMetric != nullptr) {
+        m4d::Metric* metric = mPendingMetric;
+        mPendingMetric = nullptr;
+        startJob(metric, mPendingKey);
+    }
+}
+
+std::shared_ptr<const struct_emb_mesh> EmbeddingMesh::getMesh()
+{
+    return mCurrent;
+}
+
+void EmbeddingMesh::clear()
+{
+    if (mPendingMetric != nullptr) {
+        delete mPendingMetric;
+        mPendingMetric = nullptr;
+    }
+    stopJob();
+    mCurrent.reset();
+    mHaveWanted = false;
+}
+
+void EmbeddingMesh::setMaxBytes(size_t maxBytes)
+{
+    mMaxBytes = maxBytes;
+}
+
+struct_emb_key EmbeddingMesh::makeKey(m4d::Metric* metric)
+{
+    struct_emb_key key;
+    key.metricName = std::string(metric->getMetricName());
+
+    std::vector<std::string> names;
+    metric->getParamNames(names);
+    for (size_t i = 0; i < names.size(); i++) {
+        double value = 0.0;
+        metric->getParam(names[i].c_str(), value);
+        key.metricParams.push_back(value);
+    }
+
+    names.clear();
+    metric->getEmbeddingNames(names);
+    for (size_t i = 0; i < names.size(); i++) {
+        double value = 0.0;
+        metric->getEmbeddingParam(names[i].c_str(), value);
+        key.embParams.push_back(value);
+    }
+
+    // Meshes of copies made under other units must not be reused.
+    key.units = { mObject.speed_of_light, mObject.grav_constant, mObject.dielectric_perm };
+    return key;
+}
+
+bool EmbeddingMesh::isSameKey(const struct_emb_key& k1, const struct_emb_key& k2)
+{
+    return (k1.metricName == k2.metricName && k1.metricParams == k2.metricParams && k1.embParams == k2.embParams
+        && k1.units == k2.units);
+}
+
+std::shared_ptr<const struct_emb_mesh> EmbeddingMesh::find(const struct_emb_key& key)
+{
+    std::list<std::shared_ptr<const struct_emb_mesh>>::iterator itr = mCache.begin();
+    while (itr != mCache.end()) {
+        if (isSameKey((*itr)->key, key)) {
+            mCache.splice(mCache.begin(), mCache, itr);
+            return mCache.front();
+        }
+        ++itr;
+    }
+    return nullptr;
+}
+
+void EmbeddingMesh::insert(std::shared_ptr<const struct_emb_mesh> mesh)
+{
+    mCache.push_front(mesh);
+    mUsedBytes += meshBytes(*mesh);
+
+    // The current mesh is always kept.
+    while (mUsedBytes > mMaxBytes && mCache.size() > 1) {
+        mUsedBytes -= meshBytes(*mCache.back());
+        mCache.pop_back();
+    }
+}
+
+size_t EmbeddingMesh::meshBytes(const struct_emb_mesh& mesh)
+{
+    return mesh.verts.size() * sizeof(GLfloat) + mesh.indices.size() * sizeof(GLuint);
+}
+
+void EmbeddingMesh::startJob(m4d::Metric* metric, const struct_emb_key& key)
+{
+    mJobMetric = metric;
+    mJobKey = key;
+    mRunning = true;
+    mThread = std::thread(&EmbeddingMesh::run, this);
+}
+
+void EmbeddingMesh::stopJob()
+{
+    // Mesh generation cannot be interrupted; the result is simply dropped.
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+    mRunning = false;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mResult.reset();
+}
+
+void EmbeddingMesh::run()
+{
+    GLfloat* verts = nullptr;
+    unsigned int* indices = nullptr;
+    unsigned int numElems = 0;
+    unsigned int counter = 0;
+    unsigned int numVerts = mJobMetric->getEmbeddingVertices(verts, indices, numElems, counter);
+
+    std::shared_ptr<struct_emb_mesh> mesh = std::make_shared<struct_emb_mesh>();
+    mesh->key = mJobKey;
+    mesh->numStrips = 0;
+    mesh->stripLength = static_cast<GLsizei>(numElems * 2);
+
+    // The last strip is not drawn.
+    if (numVerts > 0 && counter > 1) {
+        mesh->verts.assign(verts, verts + numVerts * 3);
+        mesh->numStrips = static_cast<GLsizei>(counter - 1);
+        mesh->indices.reserve(static_cast<size_t>(mesh->numStrips) * (numElems * 2 + 1));
+        for (unsigned int i = 0; i + 1 < counter; i++) {
+            mesh->indices.insert(mesh->indices.end(), indices + i * numElems * 2, indices + (i + 1) * numElems * 2);
+            mesh->indices.push_back(DEF_EMB_RESTART_INDEX);
+        }
+    }
+
+    SafeDelete<GLfloat>(verts);
+    SafeDelete<unsigned int>(indices);
+    delete mJobMetric;
+    mJobMetric = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mResult = mesh;
+    }
+    mRunning = false;
+
+    if (mReceiver != nullptr) {
+        QMetaObject::invokeMethod(mReceiver, "update", Qt::QueuedConnection);
+    }
+}
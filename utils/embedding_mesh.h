@@ -0,0 +1,124 @@
+/**
+ * @file    embedding_mesh.h
+ * @author  Thomas Mueller
+ *
+ * @brief  Asynchronously generated and cached embedding diagram meshes.
+ *
+ * The mesh of an embedding diagram is generated in a worker thread from a
+ * private copy of the current metric. All quad strips share one vertex and
+ * one index array; consecutive strips are separated by a restart index.
+ * Finished meshes are kept, keyed by metric name, metric parameters, and
+ * embedding parameters, so that an earlier parameter set is shown at once.
+ *
+ * This file is part of GeodesicView.
+ */
+#ifndef EMBEDDING_MESH_H
+#define EMBEDDING_MESH_H
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <QObject>
+#include <QOpenGLBuffer>
+
+#include <gdefs.h>
+#include <m4dGlobalDefs.h>
+#include <metric/m4dMetric.h>
+
+typedef struct _struct_emb_key {
+    std::string metricName;
+    std::vector<double> metricParams;
+    std::vector<double> embParams;
+    std::vector<double> units; //!< speed of light, gravitational constant, dielectric permittivity
+} struct_emb_key;
+
+typedef struct _struct_emb_mesh {
+    struct_emb_key key;
+    std::vector<GLfloat> verts; //!< xyz per vertex
+    std::vector<GLuint> indices; //!< strips separated by DEF_EMB_RESTART_INDEX
+    GLsizei numStrips;
+    GLsizei stripLength; //!< number of indices per strip without restart index
+} struct_emb_mesh;
+
+/**
+ * @brief The EmbeddingMesh class
+ */
+class EmbeddingMesh
+{
+public:
+    EmbeddingMesh(size_t maxBytes = DEF_EMB_CACHE_MAX_BYTES);
+    ~EmbeddingMesh();
+
+public:
+    /**
+     * @brief Set object that is asked to repaint when a mesh is finished.
+     * @param receiver  Pointer to widget.
+     */
+    void setReceiver(QObject* receiver);
+
+    /**
+     * @brief Request the mesh of the current metric state.
+     *   A cached mesh becomes current immediately, otherwise it is generated
+     *   in the background. The previous mesh stays current until then.
+     * @param metric  Pointer to current metric.
+     */
+    void request(m4d::Metric* metric);
+
+    /**
+     * @brief Take over a finished mesh and start a pending request.
+     */
+    void poll();
+
+    /**
+     * @brief Get current mesh.
+     * @return pointer to mesh or nullptr if there is none.
+     */
+    std::shared_ptr<const struct_emb_mesh> getMesh();
+
+    /**
+     * @brief Drop the current mesh and any pending request. The cache is kept.
+     */
+    void clear();
+
+    void setMaxBytes(size_t maxBytes);
+
+protected:
+    struct_emb_key makeKey(m4d::Metric* metric);
+    bool isSameKey(const struct_emb_key& k1, const struct_emb_key& k2);
+    std::shared_ptr<const struct_emb_mesh> find(const struct_emb_key& key);
+    void insert(std::shared_ptr<const struct_emb_mesh> mesh);
+    size_t meshBytes(const struct_emb_mesh& mesh);
+
+    void startJob(m4d::Metric* metric, const struct_emb_key& key);
+    void stopJob();
+    void run();
+
+private:
+    QObject* mReceiver;
+
+    std::shared_ptr<const struct_emb_mesh> mCurrent;
+    std::list<std::shared_ptr<const struct_emb_mesh>> mCache;
+    size_t mMaxBytes;
+    size_t mUsedBytes;
+    struct_emb_key mWantedKey;
+    bool mHaveWanted;
+
+    // ---- pending request, started when the worker is idle ----
+    m4d::Metric* mPendingMetric;
+    struct_emb_key mPendingKey;
+
+    // ---- worker ----
+    std::thread mThread;
+    std::mutex mMutex;
+    std::atomic<bool> mRunning;
+    m4d::Metric* mJobMetric;
+    struct_emb_key mJobKey;
+    std::shared_ptr<struct_emb_mesh> mResult;
+};
+
+#endif // EMBEDDING_MESH_H
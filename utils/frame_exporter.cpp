@@ -0,0 +1,263 @@
+/**
+ * @file    frame_exporter.cpp
+ * @author  Thomas Mueller
+ *
+ * This file is part of GeodesicView.
+ */
+#include "frame_exporter.h"
+#include "png_stream_writer.h"
+
+#include <algorithm>
+#include <csignal>
+#include <cstring>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+FrameExporter::FrameExporter(int width, int height)
+{
+    mWidth = width;
+    mHeight = height;
+    mFrameBytes = static_cast<size_t>(width) * static_cast<size_t>(height) * 3;
+    mPipe = nullptr;
+#ifndef _WIN32
+    mHaveOldPipeAction = false;
+#endif
+    mNumRead = 0;
+    mDone = false;
+    mFailed = false;
+    mNumWritten = 0;
+}
+
+FrameExporter::~FrameExporter()
+{
+    if (mThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mDone = true;
+        }
+        mCond.notify_all();
+        mThread.join();
+    }
+    closePipe();
+}
+
+bool FrameExporter::openImages(QString basename)
+{
+    mBasename = basename;
+    mThread = std::thread(&FrameExporter::run, this);
+    return true;
+}
+
+bool FrameExporter::openPipe(QString command, int fps)
+{
+    // Named placeholders leave printf-like patterns of the command, e.g. img_%03d.png, untouched.
+    QString cmd = command;
+    cmd.replace("{width}", QString::number(mWidth));
+    cmd.replace("{height}", QString::number(mHeight));
+    cmd.replace("{fps}", QString::number(fps));
+
+#ifndef _WIN32
+    // A command that exits early must not take the application down with it.
+    // The previous handler is restored when the pipe is closed.
+    struct sigaction ignore;
+    memset(&ignore, 0, sizeof(ignore));
+    ignore.sa_handler = SIG_IGN;
+    sigemptyset(&ignore.sa_mask);
+    mHaveOldPipeAction = (sigaction(SIGPIPE, &ignore, &mOldPipeAction) == 0);
+    mPipe = popen(cmd.toLocal8Bit().constData(), "w");
+#else
+    mPipe = popen(cmd.toLocal8Bit().constData(), "wb");
+#endif
+    if (mPipe == nullptr) {
+        fprintf(stderr, "Cannot start %s!\n", cmd.toLocal8Bit().constData());
+        closePipe();
+        return false;
+    }
+    mThread = std::thread(&FrameExporter::run, this);
+    return true;
+}
+
+void FrameExporter::begin()
+{
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    // Without pixel-pack buffers, frames are read synchronously.
+    mPBOs.clear();
+    for (int i = 0; i < DEF_ANIM_EXPORT_PBO_RING; i++) {
+        QOpenGLBuffer pbo(QOpenGLBuffer::PixelPackBuffer);
+        if (!pbo.create()) {
+            fprintf(stderr, "Cannot create pixel-pack buffers! Reading frames synchronously.\n");
+            for (size_t k = 0; k < mPBOs.size(); k++) {
+                mPBOs[k].destroy();
+            }
+            mPBOs.clear();
+            break;
+        }
+        pbo.setUsagePattern(QOpenGLBuffer::StreamRead);
+        pbo.bind();
+        pbo.allocate(static_cast<int>(mFrameBytes));
+        pbo.release();
+        mPBOs.push_back(pbo);
+    }
+    mNumRead = 0;
+}
+
+bool FrameExporter::readFrame()
+{
+    if (mPBOs.empty()) {
+        std::vector<unsigned char> pixels(mFrameBytes);
+        glReadPixels(0, 0, mWidth, mHeight, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+        mNumRead++;
+        return push(pixels);
+    }
+
+    // The buffer of the frame read one ring length ago is reused; its transfer has finished by now.
+    int ringSize = static_cast<int>(mPBOs.size());
+    if (mNumRead >= ringSize) {
+        collect(mNumRead - ringSize);
+    }
+
+    QOpenGLBuffer& pbo = mPBOs[static_cast<size_t>(mNumRead % ringSize)];
+    pbo.bind();
+    glReadPixels(0, 0, mWidth, mHeight, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+    pbo.release();
+    mNumRead++;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    return !mFailed;
+}
+
+bool FrameExporter::end()
+{
+    int ringSize = static_cast<int>(mPBOs.size());
+    for (int frame = std::max(0, mNumRead - ringSize); frame < mNumRead && ringSize > 0; frame++) {
+        collect(frame);
+    }
+    for (size_t i = 0; i < mPBOs.size(); i++) {
+        mPBOs[i].destroy();
+    }
+    mPBOs.clear();
+
+    if (mThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mDone = true;
+        }
+        mCond.notify_all();
+        mThread.join();
+    }
+
+    if (!closePipe()) {
+        mFailed = true;
+    }
+    return (!mFailed && mNumWritten == mNumRead);
+}
+
+bool FrameExporter::closePipe()
+{
+    bool ok = true;
+    if (mPipe != nullptr) {
+        ok = (pclose(mPipe) == 0);
+        mPipe = nullptr;
+    }
+#ifndef _WIN32
+    if (mHaveOldPipeAction) {
+        sigaction(SIGPIPE, &mOldPipeAction, nullptr);
+        mHaveOldPipeAction = false;
+    }
+#endif
+    return ok;
+}
+
+void FrameExporter::collect(int frame)
+{
+    QOpenGLBuffer& pbo = mPBOs[static_cast<size_t>(frame % static_cast<int>(mPBOs.size()))];
+    pbo.bind();
+    const unsigned char* data = static_cast<const unsigned char*>(pbo.map(QOpenGLBuffer::ReadOnly));
+    if (data != nullptr) {
+        std::vector<unsigned char> pixels(data, data + mFrameBytes);
+        pbo.unmap();
+        push(pixels);
+    }
+    else {
+        fprintf(stderr, "Cannot map pixel-pack buffer of frame %d!\n", frame);
+        std::lock_guard<std::mutex> lock(mMutex);
+        mFailed = true;
+    }
+    pbo.release();
+}
+
+bool FrameExporter::push(std::vector<unsigned char>& pixels)
+{
+    // Rendering waits for the encoder when it falls behind, which bounds the memory.
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCond.wait(lock, [this] { return mFailed || mQueue.size() < DEF_ANIM_EXPORT_QUEUE; });
+    if (mFailed) {
+        return false;
+    }
+    mQueue.push_back(std::vector<unsigned char>());
+    mQueue.back().swap(pixels);
+    mCond.notify_all();
+    return true;
+}
+
+void FrameExporter::run()
+{
+    int frame = 0;
+    while (true) {
+        std::vector<unsigned char> pixels;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCond.wait(lock, [this] { return mDone || !mQueue.empty(); });
+            if (mQueue.empty()) {
+                return;
+            }
+            pixels.swap(mQueue.front());
+            mQueue.pop_front();
+            mCond.notify_all();
+        }
+
+        bool ok = writeFrame(pixels, frame++);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!ok) {
+            mFailed = true;
+            mQueue.clear();
+            mCond.notify_all();
+            return;
+        }
+        mNumWritten++;
+    }
+}
+
+bool FrameExporter::writeFrame(const std::vector<unsigned char>& pixels, int frame)
+{
+    size_t rowBytes = static_cast<size_t>(mWidth) * 3;
+    if (mPipe != nullptr) {
+        for (int r = mHeight - 1; r >= 0; r--) {
+            if (fwrite(pixels.data() + static_cast<size_t>(r) * rowBytes, 1, rowBytes, mPipe) != rowBytes) {
+                fprintf(stderr, "Cannot write frame %d to pipe!\n", frame);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    QString filename = QString("%1_%2.png").arg(mBasename).arg(frame, 5, 10, QChar('0'));
+    PngStreamWriter writer;
+    if (!writer.open(filename, mWidth, mHeight)) {
+        return false;
+    }
+    bool ok = true;
+    for (int r = mHeight - 1; r >= 0 && ok; r--) {
+        ok = writer.writeRow(pixels.data() + static_cast<size_t>(r) * rowBytes);
+    }
+    if (!writer.close() || !ok) {
+        fprintf(stderr, "Cannot write image %s!\n", filename.toLocal8Bit().constData());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,119 @@
+/**
+ * @file    frame_exporter.h
+ * @author  Thomas Mueller
+ *
+ * @brief  Readback and encoding of offscreen animation frames.
+ *
+ * Frames are read from the bound framebuffer into a ring of pixel-pack
+ * buffers. A buffer is only mapped when the ring wraps around, so the
+ * transfer of a frame overlaps with rendering the following ones. Mapped
+ * frames are handed to a background thread which writes numbered PNG
+ * images or streams raw rgb24 video to the standard input of a command.
+ *
+ * This file is part of GeodesicView.
+ */
+#ifndef FRAME_EXPORTER_H
+#define FRAME_EXPORTER_H
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <signal.h>
+#endif
+
+#include <QOpenGLBuffer>
+#include <QString>
+
+#include <gdefs.h>
+
+typedef struct _struct_anim_export {
+    QString filename; //!< base name of the numbered png images
+    QString command; //!< if not empty, raw rgb24 frames are piped to this command
+    int numFrames;
+    int fps;
+    bool rotate; //!< apply the animation rotation rates per frame
+    bool local; //!< rotate about the camera axes
+    bool cameraPath; //!< follow the camera path at frame / fps seconds
+    int firstPoints; //!< number of shown points in the first frame, or -1 to keep
+    int lastPoints; //!< number of shown points in the last frame
+} struct_anim_export;
+
+/**
+ * @brief The FrameExporter class
+ */
+class FrameExporter
+{
+public:
+    FrameExporter(int width, int height);
+    ~FrameExporter();
+
+public:
+    /**
+     * @brief Write frames as basename_00000.png, basename_00001.png, ...
+     * @param basename  File name without number and suffix.
+     */
+    bool openImages(QString basename);
+
+    /**
+     * @brief Pipe raw rgb24 frames, top row first, to a command.
+     *   The placeholders {width}, {height}, and {fps} are replaced by width, height, and frame rate.
+     * @param command  Command line, e.g. an ffmpeg call reading from stdin.
+     * @param fps      Frame rate.
+     */
+    bool openPipe(QString command, int fps);
+
+    /**
+     * @brief Create pixel-pack buffers. Needs a current context.
+     */
+    void begin();
+
+    /**
+     * @brief Read the bound framebuffer. Needs a current context.
+     * @return false if encoding failed.
+     */
+    bool readFrame();
+
+    /**
+     * @brief Hand remaining frames to the encoder and wait for it.
+     *   Needs a current context.
+     * @return true if all frames were written.
+     */
+    bool end();
+
+protected:
+    void collect(int frame);
+    bool push(std::vector<unsigned char>& pixels);
+    void run();
+    bool writeFrame(const std::vector<unsigned char>& pixels, int frame);
+    bool closePipe();
+
+private:
+    int mWidth;
+    int mHeight;
+    size_t mFrameBytes;
+
+    QString mBasename;
+    FILE* mPipe;
+#ifndef _WIN32
+    struct sigaction mOldPipeAction; //!< SIGPIPE handler before the pipe was opened
+    bool mHaveOldPipeAction;
+#endif
+
+    std::vector<QOpenGLBuffer> mPBOs;
+    int mNumRead;
+
+    std::thread mThread;
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    std::deque<std::vector<unsigned char> > mQueue; //!< bottom row first, as read by OpenGL
+    bool mDone;
+    bool mFailed;
+    int mNumWritten;
+};
+
+#endif // FRAME_EXPORTER_H
@@ -0,0 +1,282 @@
+/**
+ * @file    geodesic_colormap.cpp
+ * @author  Thomas Mueller
+ *
+ * This file is part of GeodesicView.
+ */
+#include "geodesic_colormap.h"
+#include "math/TransCoordinates.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+// Control points of the colormaps, equally spaced over [0,1].
+const GLfloat cmapRainbow[] = { 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f, 0.0f,
+    0.0f };
+const GLfloat cmapViridis[] = { 0.267f, 0.005f, 0.329f, 0.254f, 0.265f, 0.530f, 0.164f, 0.471f, 0.558f, 0.135f,
+    0.659f, 0.518f, 0.478f, 0.821f, 0.318f, 0.993f, 0.906f, 0.144f };
+const GLfloat cmapCoolWarm[] = { 0.230f, 0.299f, 0.754f, 0.865f, 0.865f, 0.865f, 0.706f, 0.016f, 0.150f };
+const GLfloat cmapGray[] = { 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f };
+
+const GLfloat* cmapPoints[GEOD_COLORMAP_NUM] = { cmapRainbow, cmapViridis, cmapCoolWarm, cmapGray };
+const int cmapNumPoints[GEOD_COLORMAP_NUM] = { 5, 6, 3, 2 };
+
+double getProduct(m4d::Metric* metric, m4d::vec4 u, m4d::vec4 v)
+{
+    double sum = 0.0;
+    for (int mu = 0; mu < 4; mu++) {
+        for (int nu = 0; nu < 4; nu++) {
+            sum += metric->getMetricCoeff(mu, nu) * u.x(mu) * v.x(nu);
+        }
+    }
+    return sum;
+}
+
+} // namespace
+
+GeodesicColormap::GeodesicColormap()
+{
+    mNumPoints = 0;
+    for (int c = 0; c < GEOD_SCALAR_NUM_CHANNELS; c++) {
+        mMin[c] = 0.0;
+        mMax[c] = 1.0;
+    }
+    mHaveRevision = false;
+    mRevision = 0;
+    mNeedUpload = false;
+    for (int i = 0; i < GEOD_COLORMAP_NUM; i++) {
+        mTex[i] = 0;
+    }
+}
+
+GeodesicColormap::~GeodesicColormap()
+{
+    // The owner has to release the GL resources with its context current.
+}
+
+void GeodesicColormap::setTrajectory(m4d::Object* obj, unsigned int revision)
+{
+    if (mHaveRevision && revision == mRevision) {
+        return;
+    }
+    mHaveRevision = true;
+    mRevision = revision;
+
+    computeChannels(obj);
+    mNeedUpload = true;
+}
+
+void GeodesicColormap::clear()
+{
+    mData.clear();
+    mNumPoints = 0;
+    mHaveRevision = false;
+    mNeedUpload = false;
+}
+
+void GeodesicColormap::getRange(enum_geod_scalar scalar, double& min, double& max)
+{
+    int c = static_cast<int>(scalar) - 1;
+    if (c < 0 || c >= GEOD_SCALAR_NUM_CHANNELS || mNumPoints == 0) {
+        min = 0.0;
+        max = 1.0;
+        return;
+    }
+    min = mMin[c];
+    max = mMax[c];
+}
+
+bool GeodesicColormap::bind(
+    QOpenGLShaderProgram* prog, int location, enum_geod_scalar scalar, enum_colormap cmap, int numVerts)
+{
+    int c = static_cast<int>(scalar) - 1;
+    int t = static_cast<int>(cmap);
+    if (c < 0 || c >= GEOD_SCALAR_NUM_CHANNELS || t < 0 || t >= GEOD_COLORMAP_NUM || mNumPoints == 0) {
+        return false;
+    }
+    // Reading past the channel would take values of the next one or leave the buffer.
+    if (numVerts > mNumPoints) {
+        return false;
+    }
+    if (mNeedUpload && !upload()) {
+        return false;
+    }
+    if (mTex[0] == 0 && !createTextures()) {
+        return false;
+    }
+
+    mVBO.bind();
+    prog->setAttributeBuffer(location, GL_FLOAT, static_cast<int>(sizeof(GLfloat) * c * mNumPoints), 1);
+    prog->enableAttributeArray(location);
+    mVBO.release();
+
+    glBindTexture(GL_TEXTURE_1D, mTex[t]);
+    prog->setUniformValue("colormap", 0);
+    return true;
+}
+
+void GeodesicColormap::unbind(QOpenGLShaderProgram* prog, int location)
+{
+    prog->disableAttributeArray(location);
+    glBindTexture(GL_TEXTURE_1D, 0);
+}
+
+void GeodesicColormap::release()
+{
+    mVBO.destroy();
+    for (int i = 0; i < GEOD_COLORMAP_NUM; i++) {
+        if (mTex[i] != 0) {
+            glDeleteTextures(1, &mTex[i]);
+            mTex[i] = 0;
+        }
+    }
+    mNeedUpload = !mData.empty();
+}
+
+void GeodesicColormap::computeChannels(m4d::Object* obj)
+{
+    // Every channel covers all drawn points; channels that need a direction are zero where there is none.
+    mNumPoints = static_cast<int>(obj->points.size());
+    mData.assign(static_cast<size_t>(GEOD_SCALAR_NUM_CHANNELS * mNumPoints), 0.0f);
+    if (mNumPoints == 0 || obj->currMetric == nullptr) {
+        mNumPoints = 0;
+        return;
+    }
+
+    // Runs on the GUI thread; workers only sample their own copies, so the current metric with the
+    // units of the user is evaluated directly.
+    m4d::Metric* metric = obj->currMetric;
+
+    size_t n = static_cast<size_t>(mNumPoints);
+    size_t numDirs = std::min(n, obj->dirs.size());
+    GLfloat* lambda = mData.data();
+    GLfloat* time = lambda + n;
+    GLfloat* constraint = time + n;
+    GLfloat* stepsize = constraint + n;
+    GLfloat* radius = stepsize + n;
+    GLfloat* freqshift = radius + n;
+
+    // The constraint error is the drift of g(u,u) from its initial value; the frequency
+    // is measured by static observers, relative to the one at the starting point.
+    m4d::vec4 et(1.0, 0.0, 0.0, 0.0);
+    double norm0 = 0.0;
+    double freq0 = 0.0;
+    double freq = 1.0;
+    m4d::vec4 tp, d;
+    for (size_t i = 0; i < n; i++) {
+        double lam = (i < obj->lambda.size() ? obj->lambda[i] : static_cast<double>(i));
+        lambda[i] = static_cast<GLfloat>(lam);
+        time[i] = static_cast<GLfloat>(obj->points[i].x(0));
+
+        double pos[4] = { obj->points[i].x(0), obj->points[i].x(1), obj->points[i].x(2), obj->points[i].x(3) };
+        metric->calculateMetric(pos);
+        if (i >= numDirs) {
+            m4d::TransCoordinates::toCartesianCoord(metric->getCoordType(), obj->points[i], m4d::vec4(), tp, d);
+            radius[i] = static_cast<GLfloat>(sqrt(tp[1] * tp[1] + tp[2] * tp[2] + tp[3] * tp[3]));
+            continue;
+        }
+
+        double norm = getProduct(metric, obj->dirs[i], obj->dirs[i]);
+        if (i == 0) {
+            norm0 = norm;
+        }
+        constraint[i] = static_cast<GLfloat>(fabs(norm - norm0));
+
+        double gtt = getProduct(metric, et, et);
+        if (gtt < 0.0) {
+            double energy = -getProduct(metric, et, obj->dirs[i]) / sqrt(-gtt);
+            if (freq0 == 0.0) {
+                freq0 = energy;
+            }
+            if (freq0 != 0.0) {
+                freq = energy / freq0;
+            }
+        }
+        freqshift[i] = static_cast<GLfloat>(freq);
+
+        m4d::TransCoordinates::toCartesianCoord(metric->getCoordType(), obj->points[i], obj->dirs[i], tp, d);
+        radius[i] = static_cast<GLfloat>(sqrt(tp[1] * tp[1] + tp[2] * tp[2] + tp[3] * tp[3]));
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        size_t i0 = (i > 0 ? i - 1 : 0);
+        size_t i1 = (i > 0 ? i : std::min(n - 1, static_cast<size_t>(1)));
+        stepsize[i] = std::fabs(lambda[i1] - lambda[i0]);
+    }
+
+    for (int c = 0; c < GEOD_SCALAR_NUM_CHANNELS; c++) {
+        const GLfloat* data = mData.data() + static_cast<size_t>(c) * n;
+        bool needsDir = (data == constraint || data == freqshift);
+        size_t num = (needsDir ? numDirs : n);
+        double min = 0.0;
+        double max = 0.0;
+        bool first = true;
+        for (size_t i = 0; i < num; i++) {
+            if (!std::isfinite(data[i])) {
+                continue;
+            }
+            min = (first ? data[i] : std::min(min, static_cast<double>(data[i])));
+            max = (first ? data[i] : std::max(max, static_cast<double>(data[i])));
+            first = false;
+        }
+        if (max <= min) {
+            min -= 0.5;
+            max += 0.5;
+        }
+        mMin[c] = min;
+        mMax[c] = max;
+    }
+}
+
+bool GeodesicColormap::upload()
+{
+    if (!mVBO.isCreated()) {
+        mVBO.setUsagePattern(QOpenGLBuffer::StaticDraw);
+        if (!mVBO.create()) {
+            fprintf(stderr, "Cannot create buffer for geodesic scalars!\n");
+            return false;
+        }
+    }
+    mVBO.bind();
+    mVBO.allocate(mData.data(), static_cast<int>(mData.size() * sizeof(GLfloat)));
+    mVBO.release();
+    mNeedUpload = false;
+    return true;
+}
+
+bool GeodesicColormap::createTextures()
+{
+    glGenTextures(GEOD_COLORMAP_NUM, mTex);
+    if (mTex[0] == 0) {
+        fprintf(stderr, "Cannot create colormap textures!\n");
+        return false;
+    }
+
+    GLubyte texels[DEF_GEOD_COLORMAP_SIZE * 3];
+    for (int m = 0; m < GEOD_COLORMAP_NUM; m++) {
+        const GLfloat* pts = cmapPoints[m];
+        int numSegs = cmapNumPoints[m] - 1;
+        for (int i = 0; i < DEF_GEOD_COLORMAP_SIZE; i++) {
+            double x = numSegs * i / static_cast<double>(DEF_GEOD_COLORMAP_SIZE - 1);
+            int s = std::min(static_cast<int>(x), numSegs - 1);
+            double f = x - s;
+            for (int k = 0; k < 3; k++) {
+                double val = (1.0 - f) * pts[3 * s + k] + f * pts[3 * (s + 1) + k];
+                texels[3 * i + k] = static_cast<GLubyte>(255.0 * val + 0.5);
+            }
+        }
+
+        glBindTexture(GL_TEXTURE_1D, mTex[m]);
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB, DEF_GEOD_COLORMAP_SIZE, 0, GL_RGB, GL_UNSIGNED_BYTE, texels);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_1D, 0);
+    return true;
+}
@@ -0,0 +1,104 @@
+/**
+ * @file    geodesic_colormap.h
+ * @author  Thomas Mueller
+ *
+ * @brief  Colormapping of the geodesic by per-point scalars.
+ *
+ * All scalar channels of a trajectory (affine parameter, coordinate time,
+ * constraint error, step size, radius, and frequency shift) are computed
+ * once per trajectory revision and uploaded into a single GL buffer, one
+ * channel after the other. Selecting a channel only changes the offset of
+ * the scalar attribute; the colormaps are small 1D textures. Thus, switching
+ * scalar, range, or colormap needs neither a CPU rebuild nor an upload.
+ *
+ * This file is part of GeodesicView.
+ */
+#ifndef GEODESIC_COLORMAP_H
+#define GEODESIC_COLORMAP_H
+
+#include <vector>
+
+#include <QOpenGLBuffer>
+#include <QOpenGLShaderProgram>
+
+#include <gdefs.h>
+
+#include <extra/m4dObject.h>
+#include <m4dGlobalDefs.h>
+
+#define GEOD_SCALAR_NUM_CHANNELS 6
+#define GEOD_COLORMAP_NUM 4
+
+/**
+ * @brief The GeodesicColormap class
+ */
+class GeodesicColormap
+{
+public:
+    GeodesicColormap();
+    ~GeodesicColormap();
+
+public:
+    /**
+     * @brief Compute the scalar channels of the current trajectory.
+     *   A revision that was already computed is ignored.
+     * @param obj       Pointer to object holding the trajectory.
+     * @param revision  Trajectory revision.
+     */
+    void setTrajectory(m4d::Object* obj, unsigned int revision);
+
+    void clear();
+
+    /**
+     * @brief Range of a scalar channel over the whole trajectory.
+     * @param scalar  Scalar channel.
+     * @param min     Reference to minimum.
+     * @param max     Reference to maximum.
+     */
+    void getRange(enum_geod_scalar scalar, double& min, double& max);
+
+    /**
+     * @brief Bind scalar channel as vertex attribute and colormap as 1D texture
+     *   of unit 0. Needs a current context.
+     * @param prog      Bound shader program.
+     * @param location  Location of the scalar attribute.
+     * @param scalar    Scalar channel.
+     * @param cmap      Colormap.
+     * @param numVerts  Number of vertices that will be drawn.
+     * @return false if there is nothing to map or less than numVerts values per channel;
+     *   the geodesic keeps its single color then.
+     */
+    bool bind(QOpenGLShaderProgram* prog, int location, enum_geod_scalar scalar, enum_colormap cmap, int numVerts);
+
+    /**
+     * @brief Undo bind(). Needs a current context.
+     * @param prog      Bound shader program.
+     * @param location  Location of the scalar attribute.
+     */
+    void unbind(QOpenGLShaderProgram* prog, int location);
+
+    /**
+     * @brief Destroy GL resources. Needs a current context.
+     */
+    void release();
+
+protected:
+    void computeChannels(m4d::Object* obj);
+    bool upload();
+    bool createTextures();
+
+private:
+    std::vector<GLfloat> mData; //!< channel after channel, mNumPoints values each
+    int mNumPoints; //!< number of trajectory points, also without direction
+    double mMin[GEOD_SCALAR_NUM_CHANNELS];
+    double mMax[GEOD_SCALAR_NUM_CHANNELS];
+
+    bool mHaveRevision;
+    unsigned int mRevision;
+    bool mNeedUpload;
+
+    QOpenGLBuffer mVBO;
+    GLuint mTex[GEOD_COLORMAP_NUM];
+};
+
+#endif // GEODESIC_COLORMAP_H
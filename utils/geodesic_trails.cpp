@@ -0,0 +1,244 @@
+/**
+ * @file    geodesic_trails.cpp
+ * @author  Thomas Mueller
+ *
+ * This file is part of GeodesicView.
+ */
+#include "geodesic_trails.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+GeodesicTrails::GeodesicTrails(int numComps)
+{
+    mNumComps = numComps;
+    mMaxTrails = DEF_TRAILS_NUM;
+    mMaxBytes = DEF_TRAILS_MAX_BYTES;
+
+    mVBO = nullptr;
+    mCapacity = 0;
+    mWritePos = 0;
+    mRampTex = 0;
+
+    mSeq = 0;
+    mHaveKey = false;
+    mRevision = 0;
+    mDrawType = m4d::enum_draw_pseudocart;
+    mParam = 0.0;
+}
+
+GeodesicTrails::~GeodesicTrails()
+{
+    // The owner has to release the GL resources with its context current.
+}
+
+void GeodesicTrails::setMaxTrails(int num)
+{
+    mMaxTrails = std::max(0, num);
+    while (static_cast<int>(mTrails.size()) > mMaxTrails + 1) {
+        mTrails.pop_front();
+    }
+}
+
+void GeodesicTrails::setMaxBytes(size_t maxBytes)
+{
+    mMaxBytes = maxBytes;
+}
+
+void GeodesicTrails::push(
+    unsigned int revision, m4d::enum_draw_type dtype, double param, const GLfloat* verts, size_t numVerts)
+{
+    if (!mHaveKey || dtype != mDrawType || param != mParam) {
+        clear();
+        mHaveKey = true;
+        mDrawType = dtype;
+        mParam = param;
+    }
+    else if (revision == mRevision) {
+        return;
+    }
+    mRevision = revision;
+
+    if (verts == nullptr || numVerts == 0) {
+        return;
+    }
+
+    int stride = mNumComps + 1;
+    if (mVBO != nullptr && mCapacity != mMaxBytes / (stride * sizeof(GLfloat))) {
+        // memory budget changed
+        mVBO->destroy();
+        delete mVBO;
+        mVBO = nullptr;
+        mTrails.clear();
+    }
+    if (mVBO == nullptr && !createBuffer()) {
+        return;
+    }
+    if (numVerts > mCapacity) {
+        return;
+    }
+
+    if (static_cast<size_t>(mWritePos) + numVerts > mCapacity) {
+        mWritePos = 0;
+    }
+    GLint first = mWritePos;
+    GLint last = first + static_cast<GLint>(numVerts);
+
+    // Evict trails that would be overwritten, and the oldest ones beyond the limit.
+    mTrails.erase(std::remove_if(mTrails.begin(), mTrails.end(),
+                      [first, last](const struct_trail& t) { return (t.first < last && t.first + t.count > first); }),
+        mTrails.end());
+    while (static_cast<int>(mTrails.size()) > mMaxTrails) {
+        mTrails.pop_front();
+    }
+
+    mSeq++;
+    std::vector<GLfloat> data(numVerts * static_cast<size_t>(stride));
+    GLfloat* dptr = data.data();
+    for (size_t i = 0; i < numVerts; i++) {
+        for (int c = 0; c < mNumComps; c++) {
+            *(dptr++) = verts[i * static_cast<size_t>(mNumComps) + static_cast<size_t>(c)];
+        }
+        *(dptr++) = static_cast<GLfloat>(mSeq);
+    }
+
+    mVBO->bind();
+    mVBO->write(static_cast<int>(first * stride * static_cast<int>(sizeof(GLfloat))), data.data(),
+        static_cast<int>(data.size() * sizeof(GLfloat)));
+    mVBO->release();
+
+    struct_trail trail;
+    trail.first = first;
+    trail.count = static_cast<GLsizei>(numVerts);
+    trail.seq = mSeq;
+    mTrails.push_back(trail);
+    mWritePos = last;
+}
+
+void GeodesicTrails::draw(const QColor& col)
+{
+    // The most recent entry is the current geodesic which is drawn separately.
+    if (mVBO == nullptr || mTrails.size() < 2) {
+        return;
+    }
+    if (mRampTex == 0 && !createRamp()) {
+        return;
+    }
+
+    std::vector<GLint> firsts;
+    std::vector<GLsizei> counts;
+    for (size_t i = 0; i + 1 < mTrails.size(); i++) {
+        firsts.push_back(mTrails[i].first);
+        counts.push_back(mTrails[i].count);
+    }
+
+    // Map sequence numbers onto the alpha ramp: the oldest possible trail is
+    // almost transparent, the most recent one is almost opaque.
+    double numSteps = static_cast<double>(mMaxTrails + 1);
+    double seqOffset = static_cast<double>(mTrails.back().seq) - numSteps;
+
+    glPushAttrib(GL_ENABLE_BIT | GL_TEXTURE_BIT | GL_COLOR_BUFFER_BIT);
+    glMatrixMode(GL_TEXTURE);
+    glPushMatrix();
+    glLoadIdentity();
+    glScaled(1.0 / numSteps, 1.0, 1.0);
+    glTranslated(-seqOffset, 0.0, 0.0);
+    glMatrixMode(GL_MODELVIEW);
+
+    glEnable(GL_TEXTURE_1D);
+    glBindTexture(GL_TEXTURE_1D, mRampTex);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glColor3f(static_cast<float>(col.redF()), static_cast<float>(col.greenF()), static_cast<float>(col.blueF()));
+
+    GLsizei stride = static_cast<GLsizei>((mNumComps + 1) * sizeof(GLfloat));
+    mVBO->bind();
+    glVertexPointer(mNumComps, GL_FLOAT, stride, nullptr);
+    glTexCoordPointer(1, GL_FLOAT, stride, reinterpret_cast<const void*>(mNumComps * sizeof(GLfloat)));
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+#ifdef GL_GLEXT_PROTOTYPES
+    glMultiDrawArrays(GL_LINE_STRIP, firsts.data(), counts.data(), static_cast<GLsizei>(firsts.size()));
+#else
+    for (size_t i = 0; i < firsts.size(); i++) {
+        glDrawArrays(GL_LINE_STRIP, firsts[i], counts[i]);
+    }
+#endif // GL_GLEXT_PROTOTYPES
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    mVBO->release();
+
+    glBindTexture(GL_TEXTURE_1D, 0);
+    glMatrixMode(GL_TEXTURE);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopAttrib();
+}
+
+void GeodesicTrails::clear()
+{
+    mTrails.clear();
+    mWritePos = 0;
+    mHaveKey = false;
+}
+
+void GeodesicTrails::releaseBuffer()
+{
+    if (mVBO != nullptr) {
+        mVBO->destroy();
+        delete mVBO;
+        mVBO = nullptr;
+    }
+    if (mRampTex != 0) {
+        glDeleteTextures(1, &mRampTex);
+        mRampTex = 0;
+    }
+    mTrails.clear();
+    mCapacity = 0;
+    mWritePos = 0;
+}
+
+bool GeodesicTrails::createBuffer()
+{
+    mCapacity = mMaxBytes / ((mNumComps + 1) * sizeof(GLfloat));
+    mWritePos = 0;
+
+    mVBO = new QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+    mVBO->setUsagePattern(QOpenGLBuffer::DynamicDraw);
+    if (!mVBO->create()) {
+        fprintf(stderr, "Cannot create vertex buffer for geodesic trails!\n");
+        delete mVBO;
+        mVBO = nullptr;
+        mCapacity = 0;
+        return false;
+    }
+    mVBO->bind();
+    mVBO->allocate(static_cast<int>(mCapacity * (mNumComps + 1) * sizeof(GLfloat)));
+    mVBO->release();
+    return true;
+}
+
+bool GeodesicTrails::createRamp()
+{
+    GLubyte ramp[DEF_TRAILS_RAMP_SIZE * 4];
+    for (int i = 0; i < DEF_TRAILS_RAMP_SIZE; i++) {
+        double t = i / static_cast<double>(DEF_TRAILS_RAMP_SIZE - 1);
+        double alpha = DEF_TRAILS_MIN_ALPHA + (DEF_TRAILS_MAX_ALPHA - DEF_TRAILS_MIN_ALPHA) * t;
+        ramp[4 * i + 0] = ramp[4 * i + 1] = ramp[4 * i + 2] = 255;
+        ramp[4 * i + 3] = static_cast<GLubyte>(255.0 * alpha);
+    }
+
+    glGenTextures(1, &mRampTex);
+    if (mRampTex == 0) {
+        return false;
+    }
+    glBindTexture(GL_TEXTURE_1D, mRampTex);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA, DEF_TRAILS_RAMP_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, ramp);
+    glBindTexture(GL_TEXTURE_1D, 0);
+    return true;
+}
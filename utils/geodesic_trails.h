@@ -0,0 +1,105 @@
+/**
+ * @file    geodesic_trails.h
+ * @author  Thomas Mueller
+ *
+ * @brief  Trails of previously computed geodesics.
+ *
+ * The projected vertices of the last trajectories are kept in a single GL
+ * ring buffer and are never touched again after upload. Each vertex carries
+ * the sequence number of its trajectory which is mapped to a fading alpha
+ * value via a 1D texture. Thus, all trails are drawn with one multi-draw call.
+ *
+ * This file is part of GeodesicView.
+ */
+#ifndef GEODESIC_TRAILS_H
+#define GEODESIC_TRAILS_H
+
+#include <deque>
+
+#include <QColor>
+#include <QOpenGLBuffer>
+
+#include <gdefs.h>
+#include <m4dGlobalDefs.h>
+
+/**
+ * @brief The GeodesicTrails class
+ */
+class GeodesicTrails
+{
+public:
+    /**
+     * @param numComps  Number of components per vertex (2 or 3).
+     */
+    GeodesicTrails(int numComps);
+    ~GeodesicTrails();
+
+public:
+    /**
+     * @brief Set number of trails shown besides the current geodesic.
+     * @param num  Number of trails.
+     */
+    void setMaxTrails(int num);
+
+    /**
+     * @brief Set GPU memory budget. A changed budget reallocates the buffer
+     *   and drops the stored trails on the next push.
+     * @param maxBytes  Budget in bytes.
+     */
+    void setMaxBytes(size_t maxBytes);
+
+    /**
+     * @brief Append the current trajectory. Needs a current context.
+     *   Trails of other projections are dropped. A revision that was
+     *   already appended is ignored.
+     * @param revision  Trajectory revision.
+     * @param dtype     Draw type.
+     * @param param     Additional parameter the projection depends on.
+     * @param verts     Pointer to projected vertices.
+     * @param numVerts  Number of vertices.
+     */
+    void push(unsigned int revision, m4d::enum_draw_type dtype, double param, const GLfloat* verts, size_t numVerts);
+
+    /**
+     * @brief Draw all trails except the current one. Needs a current context.
+     * @param col  Color of the most recent trail.
+     */
+    void draw(const QColor& col);
+
+    void clear();
+
+    /**
+     * @brief Destroy GL resources. Needs a current context.
+     */
+    void releaseBuffer();
+
+protected:
+    typedef struct _struct_trail {
+        GLint first;
+        GLsizei count;
+        unsigned int seq;
+    } struct_trail;
+
+    bool createBuffer();
+    bool createRamp();
+
+private:
+    int mNumComps;
+    int mMaxTrails;
+    size_t mMaxBytes;
+
+    QOpenGLBuffer* mVBO;
+    size_t mCapacity; //!< capacity in vertices
+    GLint mWritePos;
+    GLuint mRampTex;
+
+    std::deque<struct_trail> mTrails;
+    unsigned int mSeq;
+
+    bool mHaveKey;
+    unsigned int mRevision;
+    m4d::enum_draw_type mDrawType;
+    double mParam;
+};
+
+#endif // GEODESIC_TRAILS_H
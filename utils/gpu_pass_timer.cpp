@@ -0,0 +1,250 @@
+/**
+ * @file    gpu_pass_timer.cpp
+ * @author  Thomas Mueller
+ *
+ * This file is part of GeodesicView.
+ */
+#include "gpu_pass_timer.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QPainter>
+
+GpuPassTimer::GpuPassTimer(const QStringList& passNames)
+{
+    mPassNames = passNames;
+    mEnabled = false;
+    mSupported = true;
+    mCreated = false;
+
+    mMonitor[0] = mMonitor[1] = nullptr;
+    mNumSamples[0] = mNumSamples[1] = 0;
+    mCurr = 0;
+    mActive = false;
+
+    mOpen.assign(static_cast<size_t>(passNames.size()), -1);
+    mSmoothed.assign(static_cast<size_t>(passNames.size()), 0.0);
+    mFrameCount = 0;
+}
+
+GpuPassTimer::~GpuPassTimer()
+{
+    // The owner has to release the queries with its context current.
+}
+
+void GpuPassTimer::setEnabled(bool enable)
+{
+    mEnabled = enable;
+}
+
+bool GpuPassTimer::isEnabled()
+{
+    return mEnabled;
+}
+
+void GpuPassTimer::beginFrame()
+{
+    mActive = false;
+    if (!mEnabled || !mSupported) {
+        return;
+    }
+    if (!mCreated && !create()) {
+        return;
+    }
+
+    // This query set holds the frame before last; skip the frame if the GPU has not finished it yet.
+    if (mNumSamples[mCurr] > 0) {
+        if (!mMonitor[mCurr]->isResultAvailable()) {
+            return;
+        }
+        collect(mCurr);
+    }
+
+    // The other query set holds the previous frame which is read back once available.
+    int prev = 1 - mCurr;
+    if (mNumSamples[prev] > 0 && mMonitor[prev]->isResultAvailable()) {
+        collect(prev);
+    }
+
+    std::fill(mOpen.begin(), mOpen.end(), -1);
+    mActive = true;
+}
+
+void GpuPassTimer::endFrame()
+{
+    if (mActive) {
+        mCurr = 1 - mCurr;
+    }
+    mActive = false;
+}
+
+void GpuPassTimer::begin(int pass)
+{
+    if (!mActive || pass < 0 || pass >= mPassNames.size() || mNumSamples[mCurr] + 2 > DEF_PASS_TIMER_MAX_SAMPLES) {
+        return;
+    }
+    mOpen[static_cast<size_t>(pass)] = mMonitor[mCurr]->recordSample();
+    mNumSamples[mCurr]++;
+}
+
+void GpuPassTimer::end(int pass)
+{
+    if (!mActive || pass < 0 || pass >= mPassNames.size() || mOpen[static_cast<size_t>(pass)] < 0) {
+        return;
+    }
+
+    struct_pass_record rec;
+    rec.pass = pass;
+    rec.first = mOpen[static_cast<size_t>(pass)];
+    rec.last = mMonitor[mCurr]->recordSample();
+    mNumSamples[mCurr]++;
+    mRecords[mCurr].push_back(rec);
+    mOpen[static_cast<size_t>(pass)] = -1;
+}
+
+void GpuPassTimer::drawOverlay(QOpenGLWidget* widget, const QColor& col, int left)
+{
+    if (!mEnabled) {
+        return;
+    }
+
+    QStringList lines;
+    if (!mSupported) {
+        lines << "GPU timer queries not supported";
+    }
+    else {
+        double total = 0.0;
+        for (int i = 0; i < mPassNames.size(); i++) {
+            lines << QString("%1 %2 ms").arg(mPassNames[i], -10).arg(mSmoothed[static_cast<size_t>(i)], 7, 'f', 3);
+            total += mSmoothed[static_cast<size_t>(i)];
+        }
+        lines << QString("%1 %2 ms").arg("total", -10).arg(total, 7, 'f', 3);
+    }
+
+    // QPainter changes the GL state that the fixed-function passes rely on.
+    glPushAttrib(GL_ALL_ATTRIB_BITS);
+    glPushClientAttrib(GL_CLIENT_ALL_ATTRIB_BITS);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    {
+        QPainter painter(widget);
+        QFont font("Monospace", 9);
+        font.setStyleHint(QFont::TypeWriter);
+        painter.setFont(font);
+        painter.setPen(col);
+        int lineHeight = painter.fontMetrics().height();
+        for (int i = 0; i < lines.size(); i++) {
+            painter.drawText(left + 6, 4 + (i + 1) * lineHeight, lines[i]);
+        }
+    }
+    QOpenGLFunctions* f = QOpenGLContext::currentContext()->functions();
+    f->glUseProgram(0);
+    f->glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopMatrix();
+    glPopClientAttrib();
+    glPopAttrib();
+}
+
+bool GpuPassTimer::saveLog(QString filename)
+{
+    FILE* fptr = fopen(filename.toLocal8Bit().constData(), "w");
+    if (fptr == nullptr) {
+        fprintf(stderr, "Cannot open file %s for output!\n", filename.toLocal8Bit().constData());
+        return false;
+    }
+
+    fprintf(fptr, "# GPU time per pass in milliseconds\n# frame");
+    for (int i = 0; i < mPassNames.size(); i++) {
+        fprintf(fptr, " %s", mPassNames[i].toLocal8Bit().constData());
+    }
+    fprintf(fptr, " total\n");
+
+    for (size_t f = 0; f < mLog.size(); f++) {
+        const std::vector<double>& row = mLog[f];
+        double total = 0.0;
+        fprintf(fptr, "%8lu", static_cast<unsigned long>(row[0]));
+        for (size_t i = 1; i < row.size(); i++) {
+            fprintf(fptr, " %10.4f", row[i]);
+            total += row[i];
+        }
+        fprintf(fptr, " %10.4f\n", total);
+    }
+    fclose(fptr);
+    return true;
+}
+
+void GpuPassTimer::clearLog()
+{
+    mLog.clear();
+}
+
+void GpuPassTimer::release()
+{
+    for (int i = 0; i < 2; i++) {
+        if (mMonitor[i] != nullptr) {
+            mMonitor[i]->destroy();
+            delete mMonitor[i];
+            mMonitor[i] = nullptr;
+        }
+        mRecords[i].clear();
+        mNumSamples[i] = 0;
+    }
+    mCreated = false;
+    mActive = false;
+}
+
+bool GpuPassTimer::create()
+{
+    for (int i = 0; i < 2; i++) {
+        mMonitor[i] = new QOpenGLTimeMonitor();
+        mMonitor[i]->setSampleCount(DEF_PASS_TIMER_MAX_SAMPLES);
+        if (!mMonitor[i]->create()) {
+            fprintf(stderr, "Cannot create GPU timer queries!\n");
+            release();
+            mSupported = false;
+            return false;
+        }
+        mRecords[i].clear();
+        mNumSamples[i] = 0;
+    }
+    mCurr = 0;
+    mCreated = true;
+    return true;
+}
+
+void GpuPassTimer::collect(int set)
+{
+    QVector<GLuint64> samples = mMonitor[set]->waitForSamples();
+
+    // Passes that are entered several times per frame, e.g. per stereo eye, are summed up.
+    std::vector<double> row(static_cast<size_t>(mPassNames.size()) + 1, 0.0);
+    row[0] = static_cast<double>(mFrameCount++);
+    for (size_t i = 0; i < mRecords[set].size(); i++) {
+        const struct_pass_record& rec = mRecords[set][i];
+        if (rec.first >= 0 && rec.first < samples.size() && rec.last < samples.size()
+            && samples[rec.last] >= samples[rec.first]) {
+            row[static_cast<size_t>(rec.pass) + 1] += (samples[rec.last] - samples[rec.first]) * 1e-6;
+        }
+    }
+
+    for (size_t i = 0; i < mSmoothed.size(); i++) {
+        mSmoothed[i] += DEF_PASS_TIMER_SMOOTHING * (row[i + 1] - mSmoothed[i]);
+    }
+
+    mLog.push_back(row);
+    while (mLog.size() > DEF_PASS_TIMER_LOG_FRAMES) {
+        mLog.pop_front();
+    }
+
+    mMonitor[set]->reset();
+    mRecords[set].clear();
+    mNumSamples[set] = 0;
+}
@@ -0,0 +1,104 @@
+/**
+ * @file    gpu_pass_timer.h
+ * @author  Thomas Mueller
+ *
+ * @brief  GPU time measurement of the render passes of a view.
+ *
+ * Each pass is enclosed by two timestamp queries. Two query sets are used
+ * alternately, and the results of a frame are only read back when the GPU
+ * has finished it, so the measurement never stalls the pipeline. Frames
+ * whose predecessor is still pending are not measured.
+ *
+ * This file is part of GeodesicView.
+ */
+#ifndef GPU_PASS_TIMER_H
+#define GPU_PASS_TIMER_H
+
+#include <deque>
+#include <vector>
+
+#include <QColor>
+#include <QOpenGLTimeMonitor>
+#include <QOpenGLWidget>
+#include <QString>
+#include <QStringList>
+
+#include <gdefs.h>
+
+/**
+ * @brief The GpuPassTimer class
+ */
+class GpuPassTimer
+{
+public:
+    /**
+     * @param passNames  Names of the passes; the pass index refers to this list.
+     */
+    GpuPassTimer(const QStringList& passNames);
+    ~GpuPassTimer();
+
+public:
+    void setEnabled(bool enable);
+    bool isEnabled();
+
+    /**
+     * @brief Start frame and collect results of the previous frame of this query set.
+     *   Needs a current context.
+     */
+    void beginFrame();
+    void endFrame();
+
+    void begin(int pass);
+    void end(int pass);
+
+    /**
+     * @brief Draw smoothed pass times into the upper left corner of the widget.
+     *   Has to be called at the end of paintGL.
+     * @param widget  Widget to paint on.
+     * @param col     Text color.
+     * @param left    Left margin in pixels.
+     */
+    void drawOverlay(QOpenGLWidget* widget, const QColor& col, int left = 0);
+
+    /**
+     * @brief Save logged frames as text table, one frame per row in milliseconds.
+     * @param filename  Name of log file.
+     * @return true if file could be written.
+     */
+    bool saveLog(QString filename);
+    void clearLog();
+
+    /**
+     * @brief Destroy queries. Needs a current context.
+     */
+    void release();
+
+protected:
+    typedef struct _struct_pass_record {
+        int pass;
+        int first; //!< sample index of begin
+        int last; //!< sample index of end
+    } struct_pass_record;
+
+    bool create();
+    void collect(int set);
+
+private:
+    QStringList mPassNames;
+    bool mEnabled;
+    bool mSupported;
+    bool mCreated;
+
+    QOpenGLTimeMonitor* mMonitor[2];
+    std::vector<struct_pass_record> mRecords[2];
+    std::vector<int> mOpen; //!< sample index of begin per pass, or -1
+    int mNumSamples[2];
+    int mCurr;
+    bool mActive;
+
+    std::vector<double> mSmoothed; //!< milliseconds per pass
+    std::deque<std::vector<double> > mLog;
+    unsigned long mFrameCount;
+};
+
+#endif // GPU_PASS_TIMER_H
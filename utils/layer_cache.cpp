@@ -0,0 +1,115 @@
+/**
+ * @file    layer_cache.cpp
+ * @author  Thomas Mueller
+ *
+ * This file is part of GeodesicView.
+ */
+#include "layer_cache.h"
+
+#include <cstdio>
+
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+
+LayerCache::LayerCache(bool withDepth)
+{
+    mWithDepth = withDepth;
+    mSupported = true;
+    mFBO = nullptr;
+    mTargetFBO = 0;
+}
+
+LayerCache::~LayerCache()
+{
+    // The owner has to release the framebuffer with its context current.
+}
+
+enum_layer_cache LayerCache::check(const std::vector<double>& key, int width, int height)
+{
+    if (!mSupported || width <= 0 || height <= 0) {
+        return enum_layer_cache_direct;
+    }
+
+    // The static layer changes from frame to frame: caching would only cost an extra copy.
+    // Keys may contain addresses that are reused later, hence any change invalidates the cache.
+    if (key != mLastKey) {
+        mLastKey = key;
+        mCachedKey.clear();
+        return enum_layer_cache_direct;
+    }
+
+    QSize size(width, height);
+    if (mFBO != nullptr && mFBO->size() == size && key == mCachedKey) {
+        return enum_layer_cache_hit;
+    }
+
+    if (mFBO == nullptr || mFBO->size() != size) {
+        delete mFBO;
+        mFBO = new QOpenGLFramebufferObject(size,
+            mWithDepth ? QOpenGLFramebufferObject::CombinedDepthStencil : QOpenGLFramebufferObject::NoAttachment);
+        if (!mFBO->isValid()) {
+            fprintf(stderr, "Cannot create framebuffer for layer cache!\n");
+            release();
+            mSupported = false;
+            return enum_layer_cache_direct;
+        }
+    }
+    mCachedKey = key;
+    return enum_layer_cache_build;
+}
+
+void LayerCache::begin()
+{
+    GLint target = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &target);
+    mTargetFBO = static_cast<GLuint>(target);
+    mFBO->bind();
+}
+
+void LayerCache::end()
+{
+    QOpenGLContext::currentContext()->functions()->glBindFramebuffer(GL_FRAMEBUFFER, mTargetFBO);
+}
+
+bool LayerCache::blit()
+{
+    if (mFBO == nullptr) {
+        return false;
+    }
+
+    QOpenGLExtraFunctions* f = QOpenGLContext::currentContext()->extraFunctions();
+    GLint target = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &target);
+
+    // Depth is only copied between identical formats; a mismatch shows up as error.
+    for (int i = 0; i < 8 && f->glGetError() != GL_NO_ERROR; i++) {
+    }
+
+    int width = mFBO->width();
+    int height = mFBO->height();
+    f->glBindFramebuffer(GL_READ_FRAMEBUFFER, mFBO->handle());
+    f->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, static_cast<GLuint>(target));
+    f->glBlitFramebuffer(0, 0, width, height, 0, 0, width, height,
+        GL_COLOR_BUFFER_BIT | (mWithDepth ? GL_DEPTH_BUFFER_BIT : 0), GL_NEAREST);
+    f->glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(target));
+
+    if (f->glGetError() != GL_NO_ERROR) {
+        fprintf(stderr, "Cannot copy layer cache! Drawing all layers directly.\n");
+        release();
+        mSupported = false;
+        return false;
+    }
+    return true;
+}
+
+void LayerCache::invalidate()
+{
+    mCachedKey.clear();
+}
+
+void LayerCache::release()
+{
+    delete mFBO;
+    mFBO = nullptr;
+    mCachedKey.clear();
+}
@@ -0,0 +1,83 @@
+/**
+ * @file    layer_cache.h
+ * @author  Thomas Mueller
+ *
+ * @brief  Offscreen copy of the static layer of a view.
+ *
+ * A view describes everything its static layer depends on by a key. As
+ * long as the key does not change, the layer is rendered once into a
+ * framebuffer object and afterwards only copied into the frame, so that
+ * only the dynamic layer, e.g. the geodesic, has to be drawn again. While
+ * the key changes from frame to frame, e.g. during a camera drag, caching
+ * would only cost an extra copy and the view draws everything directly.
+ *
+ * This file is part of GeodesicView.
+ */
+#ifndef LAYER_CACHE_H
+#define LAYER_CACHE_H
+
+#include <vector>
+
+#include <QOpenGLFramebufferObject>
+
+#include <gdefs.h>
+
+enum enum_layer_cache {
+    enum_layer_cache_direct = 0, //!< draw all layers into the frame
+    enum_layer_cache_build, //!< draw static layer into the cache, then copy
+    enum_layer_cache_hit //!< copy static layer from the cache
+};
+
+/**
+ * @brief The LayerCache class
+ */
+class LayerCache
+{
+public:
+    /**
+     * @param withDepth  Cache depth buffer as well, e.g. for a 3d scene.
+     */
+    LayerCache(bool withDepth);
+    ~LayerCache();
+
+public:
+    /**
+     * @brief Compare key of static layer with previous frames. Needs a current context.
+     * @param key     Everything the static layer depends on.
+     * @param width   Width of the frame in pixels.
+     * @param height  Height of the frame in pixels.
+     * @return How to draw the static layer.
+     */
+    enum_layer_cache check(const std::vector<double>& key, int width, int height);
+
+    /**
+     * @brief Redirect rendering into the cache.
+     */
+    void begin();
+    void end();
+
+    /**
+     * @brief Copy cache into the framebuffer that is currently bound.
+     * @return false if copying is not supported; the cache is disabled then.
+     */
+    bool blit();
+
+    void invalidate();
+
+    /**
+     * @brief Destroy framebuffer. Needs a current context.
+     */
+    void release();
+
+private:
+    bool mWithDepth;
+    bool mSupported;
+
+    QOpenGLFramebufferObject* mFBO;
+    GLuint mTargetFBO; //!< framebuffer bound before begin()
+
+    std::vector<double> mLastKey; //!< key of the previous frame
+    std::vector<double> mCachedKey; //!< key of the cache content
+};
+
+#endif // LAYER_CACHE_H
@@ -0,0 +1,413 @@
+/**
+ * @file    object_meshes.cpp
+ * @author  Thomas Mueller
+ *
+ * This file is part of GeodesicView.
+ */
+#include "object_meshes.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include <QMatrix4x4>
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+
+// model matrix (16), color (4), radii and height (4)
+static const int OBJ_INSTANCE_NUM_COMPS = 24;
+
+// attribute locations; the model matrix occupies four of them
+static const int OBJ_ATTRIB_SHAPE = 0;
+static const int OBJ_ATTRIB_MODEL = 1;
+static const int OBJ_ATTRIB_COLOR = 5;
+static const int OBJ_ATTRIB_RADII = 6;
+
+ObjectMeshes::ObjectMeshes()
+{
+    mSupported = false;
+    mShader = nullptr;
+    mRevision = 0;
+    mHaveRevision = false;
+}
+
+ObjectMeshes::~ObjectMeshes()
+{
+    // The owner has to release the buffers with its context current.
+}
+
+bool ObjectMeshes::init()
+{
+    QOpenGLContext* ctx = QOpenGLContext::currentContext();
+    mSupported = (ctx != nullptr && QOpenGLShaderProgram::hasOpenGLShaderPrograms(ctx)
+        && ctx->format().version() >= qMakePair(3, 3));
+    if (!mSupported) {
+        return false;
+    }
+
+    mShader = new QOpenGLShaderProgram();
+    mShader->addShaderFromSourceCode(QOpenGLShader::Vertex, getVertexShaderCode());
+    mShader->addShaderFromSourceCode(QOpenGLShader::Fragment, getFragmentShaderCode());
+    mShader->bindAttributeLocation("shape", OBJ_ATTRIB_SHAPE);
+    mShader->bindAttributeLocation("model", OBJ_ATTRIB_MODEL);
+    mShader->bindAttributeLocation("color", OBJ_ATTRIB_COLOR);
+    mShader->bindAttributeLocation("radii", OBJ_ATTRIB_RADII);
+    if (!mShader->link()) {
+        fprintf(stderr, "Cannot link object shader! Drawing objects one by one.\n");
+        delete mShader;
+        mShader = nullptr;
+        mSupported = false;
+    }
+    return mSupported;
+}
+
+bool ObjectMeshes::isSupported()
+{
+    return mSupported;
+}
+
+bool ObjectMeshes::isInstanced(enum_object_type type)
+{
+    return (type == enum_object_sphere3d || type == enum_object_cylinder3d || type == enum_object_disk3d);
+}
+
+bool ObjectMeshes::draw(const std::vector<MyObject*>& objects, unsigned int revision, bool stereo, double fogDensity)
+{
+    if (!mSupported) {
+        return false;
+    }
+
+    if (!mHaveRevision || revision != mRevision) {
+        update(objects);
+        mRevision = revision;
+        mHaveRevision = true;
+    }
+    if (mGroups.empty()) {
+        return true;
+    }
+
+    QOpenGLExtraFunctions* f = QOpenGLContext::currentContext()->extraFunctions();
+    mShader->bind();
+    mShader->setUniformValue("useWhite", static_cast<int>(stereo));
+    mShader->setUniformValue("useFog", static_cast<int>(fogDensity > 0.0));
+    mShader->setUniformValue("fogFactor", static_cast<float>(-fogDensity * fogDensity * 1.442695));
+
+    const int stride = static_cast<int>(sizeof(GLfloat)) * OBJ_INSTANCE_NUM_COMPS;
+    for (size_t g = 0; g < mGroups.size(); g++) {
+        struct_obj_group& group = mGroups[g];
+        struct_obj_mesh& mesh = mMeshes[group.meshKey];
+        mShader->setUniformValue("shapeType", static_cast<int>(group.type));
+
+        mesh.vbo.bind();
+        mShader->setAttributeBuffer(OBJ_ATTRIB_SHAPE, GL_FLOAT, 0, 3);
+        mShader->enableAttributeArray(OBJ_ATTRIB_SHAPE);
+
+        group.vbo.bind();
+        for (int i = 0; i < 4; i++) {
+            mShader->setAttributeBuffer(
+                OBJ_ATTRIB_MODEL + i, GL_FLOAT, static_cast<int>(sizeof(GLfloat)) * 4 * i, 4, stride);
+        }
+        mShader->setAttributeBuffer(OBJ_ATTRIB_COLOR, GL_FLOAT, static_cast<int>(sizeof(GLfloat)) * 16, 4, stride);
+        mShader->setAttributeBuffer(OBJ_ATTRIB_RADII, GL_FLOAT, static_cast<int>(sizeof(GLfloat)) * 20, 4, stride);
+        for (int loc = OBJ_ATTRIB_MODEL; loc <= OBJ_ATTRIB_RADII; loc++) {
+            mShader->enableAttributeArray(loc);
+            f->glVertexAttribDivisor(static_cast<GLuint>(loc), 1);
+        }
+
+        mesh.ibo.bind();
+        f->glDrawElementsInstanced(GL_TRIANGLES, mesh.numIndices, GL_UNSIGNED_INT, nullptr, group.count);
+        mesh.ibo.release();
+
+        // Other passes use the same attribute locations without instancing.
+        for (int loc = OBJ_ATTRIB_SHAPE; loc <= OBJ_ATTRIB_RADII; loc++) {
+            f->glVertexAttribDivisor(static_cast<GLuint>(loc), 0);
+            mShader->disableAttributeArray(loc);
+        }
+        group.vbo.release();
+    }
+    mShader->release();
+    return true;
+}
+
+void ObjectMeshes::release()
+{
+    clearGroups();
+    for (std::map<unsigned long, struct_obj_mesh>::iterator it = mMeshes.begin(); it != mMeshes.end(); ++it) {
+        it->second.vbo.destroy();
+        it->second.ibo.destroy();
+    }
+    mMeshes.clear();
+
+    delete mShader;
+    mShader = nullptr;
+    mSupported = false;
+    mHaveRevision = false;
+}
+
+void ObjectMeshes::update(const std::vector<MyObject*>& objects)
+{
+    clearGroups();
+
+    // One group per type and tessellation, in order of first appearance.
+    std::map<unsigned long, size_t> groupIndex;
+    for (size_t i = 0; i < objects.size(); i++) {
+        MyObject* obj = objects[i];
+        enum_object_type type = obj->getObjectType();
+        if (!isInstanced(type)) {
+            continue;
+        }
+
+        double slices, stacks;
+        obj->getValue((type == enum_object_sphere3d ? 4 : 8), slices);
+        obj->getValue((type == enum_object_sphere3d ? 5 : 9), stacks);
+        int numSlices = std::min(std::max(static_cast<int>(slices), 3), DEF_OBJECT_MESH_MAX_RES);
+        int numStacks = std::min(std::max(static_cast<int>(stacks), 1), DEF_OBJECT_MESH_MAX_RES);
+        unsigned long key = getMeshKey(type, numSlices, numStacks);
+
+        if (groupIndex.find(key) == groupIndex.end()) {
+            if (getMesh(type, numSlices, numStacks) == nullptr) {
+                continue;
+            }
+            struct_obj_group group;
+            group.type = type;
+            group.meshKey = key;
+            group.count = 0;
+            groupIndex[key] = mGroups.size();
+            mGroups.push_back(group);
+        }
+
+        struct_obj_group& group = mGroups[groupIndex[key]];
+        if (appendInstance(obj, group.instances)) {
+            group.count++;
+        }
+    }
+
+    for (size_t g = 0; g < mGroups.size(); g++) {
+        struct_obj_group& group = mGroups[g];
+        group.vbo = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+        group.vbo.create();
+        group.vbo.setUsagePattern(QOpenGLBuffer::StaticDraw);
+        group.vbo.bind();
+        group.vbo.allocate(group.instances.data(), static_cast<int>(sizeof(GLfloat) * group.instances.size()));
+        group.vbo.release();
+        group.instances.clear();
+    }
+}
+
+void ObjectMeshes::clearGroups()
+{
+    for (size_t g = 0; g < mGroups.size(); g++) {
+        mGroups[g].vbo.destroy();
+    }
+    mGroups.clear();
+}
+
+unsigned long ObjectMeshes::getMeshKey(enum_object_type type, int slices, int stacks)
+{
+    // slices and stacks are limited to DEF_OBJECT_MESH_MAX_RES < 1024
+    return (static_cast<unsigned long>(type) << 20) | (static_cast<unsigned long>(slices) << 10)
+        | static_cast<unsigned long>(stacks);
+}
+
+ObjectMeshes::struct_obj_mesh* ObjectMeshes::getMesh(enum_object_type type, int slices, int stacks)
+{
+    unsigned long key = getMeshKey(type, slices, stacks);
+    std::map<unsigned long, struct_obj_mesh>::iterator it = mMeshes.find(key);
+    if (it != mMeshes.end()) {
+        return &it->second;
+    }
+
+    // Sphere: unit position which is also the normal.
+    // Cylinder and disk: (cos(phi), sin(phi), t) with t running from base to top, or from inner to outer radius.
+    std::vector<GLfloat> verts;
+    verts.reserve(static_cast<size_t>(3 * (slices + 1) * (stacks + 1)));
+    for (int i = 0; i <= stacks; i++) {
+        double t = i / static_cast<double>(stacks);
+        for (int j = 0; j <= slices; j++) {
+            double phi = 2.0 * PI * j / static_cast<double>(slices);
+            if (type == enum_object_sphere3d) {
+                double theta = PI * t;
+                verts.push_back(static_cast<GLfloat>(sin(theta) * cos(phi)));
+                verts.push_back(static_cast<GLfloat>(sin(theta) * sin(phi)));
+                verts.push_back(static_cast<GLfloat>(cos(theta)));
+            }
+            else {
+                verts.push_back(static_cast<GLfloat>(cos(phi)));
+                verts.push_back(static_cast<GLfloat>(sin(phi)));
+                verts.push_back(static_cast<GLfloat>(t));
+            }
+        }
+    }
+
+    std::vector<GLuint> indices;
+    indices.reserve(static_cast<size_t>(6 * slices * stacks));
+    for (int i = 0; i < stacks; i++) {
+        for (int j = 0; j < slices; j++) {
+            GLuint v0 = static_cast<GLuint>(i * (slices + 1) + j);
+            GLuint v1 = v0 + static_cast<GLuint>(slices + 1);
+            indices.push_back(v0);
+            indices.push_back(v0 + 1);
+            indices.push_back(v1);
+            indices.push_back(v0 + 1);
+            indices.push_back(v1 + 1);
+            indices.push_back(v1);
+        }
+    }
+
+    struct_obj_mesh mesh;
+    mesh.vbo = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+    mesh.ibo = QOpenGLBuffer(QOpenGLBuffer::IndexBuffer);
+    if (!mesh.vbo.create() || !mesh.ibo.create()) {
+        fprintf(stderr, "Cannot create object mesh buffers!\n");
+        mesh.vbo.destroy();
+        return nullptr;
+    }
+    mesh.vbo.bind();
+    mesh.vbo.allocate(verts.data(), static_cast<int>(sizeof(GLfloat) * verts.size()));
+    mesh.vbo.release();
+    mesh.ibo.bind();
+    mesh.ibo.allocate(indices.data(), static_cast<int>(sizeof(GLuint) * indices.size()));
+    mesh.ibo.release();
+    mesh.numIndices = static_cast<GLsizei>(indices.size());
+
+    mMeshes[key] = mesh;
+    return &mMeshes[key];
+}
+
+bool ObjectMeshes::appendInstance(MyObject* obj, std::vector<GLfloat>& instances)
+{
+    double val[10];
+    for (int i = 0; i < 10; i++) {
+        obj->getValue(i, val[i]);
+    }
+
+    // Same placement as MyObject::drawObject.
+    QMatrix4x4 model;
+    model.translate(static_cast<float>(val[0]), static_cast<float>(val[1]), static_cast<float>(val[2]));
+    GLfloat radii[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    enum_object_type type = obj->getObjectType();
+    if (type == enum_object_sphere3d) {
+        radii[0] = static_cast<GLfloat>(val[3]);
+    }
+    else {
+        m4d::vec3 dir;
+        if (type == enum_object_cylinder3d) {
+            dir = m4d::vec3(val[3] - val[0], val[4] - val[1], val[5] - val[2]);
+        }
+        else {
+            dir = m4d::vec3(val[3], val[4], val[5]);
+        }
+        if (dir.isZero()) {
+            return false;
+        }
+        double height = dir.getNorm();
+        dir.normalize();
+
+        m4d::vec3 zup(0.0, 0.0, 1.0);
+        m4d::vec3 right = (zup ^ dir);
+        if (!right.isZero()) {
+            right.normalize();
+            model.rotate(static_cast<float>(acos(zup | dir) * RAD_TO_DEG), static_cast<float>(right[0]),
+                static_cast<float>(right[1]), static_cast<float>(right[2]));
+        }
+
+        radii[0] = static_cast<GLfloat>(val[6]);
+        radii[1] = static_cast<GLfloat>(val[7]);
+        radii[2] = static_cast<GLfloat>(height);
+    }
+
+    float col[4];
+    obj->getColor(col[0], col[1], col[2], col[3]);
+
+    instances.insert(instances.end(), model.constData(), model.constData() + 16);
+    instances.insert(instances.end(), col, col + 4);
+    instances.insert(instances.end(), radii, radii + 4);
+    return true;
+}
+
+QString ObjectMeshes::getVertexShaderCode()
+{
+    QString vert;
+    vert += "#version 150 compatibility\n";
+    vert += "in vec3 shape;\n";
+    vert += "in mat4 model;\n";
+    vert += "in vec4 color;\n";
+    vert += "in vec4 radii;\n";
+    vert += "uniform int useWhite;\n";
+    vert += "uniform int useFog;\n";
+    vert += "uniform int shapeType;\n";
+    vert += "out vec4 frontCol;\n";
+    vert += "out vec4 backCol;\n";
+
+    // GL_LIGHT0 with the object color as diffuse material, two-sided, no local viewer
+    vert += "vec4 lit(vec3 n, vec3 L, vec4 diffuse)\n";
+    vert += "{\n";
+    vert += "   float nl  = max(dot(n,L),0.0);\n";
+    vert += "   vec4  col = gl_FrontLightModelProduct.sceneColor + gl_FrontLightProduct[0].ambient\n";
+    vert += "             + nl * diffuse * gl_LightSource[0].diffuse;\n";
+    vert += "   if (nl > 0.0)\n";
+    vert += "   {\n";
+    vert += "     float nh = max(dot(n,normalize(L + vec3(0.0,0.0,1.0))),0.0);\n";
+    vert += "     col += pow(nh,gl_FrontMaterial.shininess) * gl_FrontLightProduct[0].specular;\n";
+    vert += "   }\n";
+    vert += "   return vec4(col.rgb,diffuse.a);\n";
+    vert += "}\n";
+
+    vert += "void main()\n";
+    vert += "{\n";
+    vert += "   vec3 pos, nrm;\n";
+    vert += "   if (shapeType==" + QString::number(enum_object_sphere3d) + ")\n";
+    vert += "   {\n";
+    vert += "     pos = radii.x * shape;\n";
+    vert += "     nrm = shape;\n";
+    vert += "   }\n";
+    vert += "   else if (shapeType==" + QString::number(enum_object_cylinder3d) + ")\n";
+    vert += "   {\n";
+    vert += "     float r = mix(radii.x,radii.y,shape.z);\n";
+    vert += "     pos = vec3(r*shape.xy, radii.z*shape.z);\n";
+    vert += "     nrm = vec3(shape.xy, (radii.x-radii.y)/radii.z);\n";
+    vert += "   }\n";
+    vert += "   else\n";
+    vert += "   {\n";
+    vert += "     float r = mix(radii.x,radii.y,shape.z);\n";
+    vert += "     pos = vec3(r*shape.xy, 0.0);\n";
+    vert += "     nrm = vec3(0.0,0.0,1.0);\n";
+    vert += "   }\n";
+
+    vert += "   vec4 ePos   = gl_ModelViewMatrix * (model * vec4(pos,1.0));\n";
+    vert += "   gl_Position = gl_ProjectionMatrix * ePos;\n";
+    vert += "   vec3 n = normalize(gl_NormalMatrix * (mat3(model) * nrm));\n";
+    vert += "   vec3 L = normalize(gl_LightSource[0].position.xyz - ePos.xyz * gl_LightSource[0].position.w);\n";
+    vert += "   vec4 diffuse = (useWhite==1 ? vec4(1.0) : color);\n";
+    vert += "   frontCol = lit(n,L,diffuse);\n";
+    vert += "   backCol  = lit(-n,L,diffuse);\n";
+
+    vert += "   if (useFog==1)\n";
+    vert += "     gl_FogFragCoord = length(ePos.xyz);\n";
+    vert += "}\n";
+    return vert;
+}
+
+QString ObjectMeshes::getFragmentShaderCode()
+{
+    QString frag;
+    frag += "#version 150 compatibility\n";
+    frag += "uniform int   useFog;\n";
+    frag += "uniform float fogFactor;\n";
+    frag += "in vec4 frontCol;\n";
+    frag += "in vec4 backCol;\n";
+    frag += "void main()\n";
+    frag += "{\n";
+    frag += "vec4 col = (gl_FrontFacing ? frontCol : backCol);\n";
+
+    frag += "if (useFog==1)\n";
+    frag += "{\n";
+    frag += "  float fog = exp2( gl_FogFragCoord*gl_FogFragCoord*fogFactor );\n";
+    frag += "  fog = clamp(fog,0.0,1.0);\n";
+    frag += "  col = mix(vec4(0.0,0.0,0.0,1.0),col,fog);\n";
+    frag += "}\n";
+    frag += "gl_FragColor = col;\n";
+    frag += "}\n";
+    return frag;
+}
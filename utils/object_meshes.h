@@ -0,0 +1,102 @@
+/**
+ * @file    object_meshes.h
+ * @author  Thomas Mueller
+ *
+ * @brief  Instanced drawing of the quadric scene objects.
+ *
+ * Spheres, cylinders, and disks are tessellated once per slices/stacks
+ * combination into a shared mesh of unit shape coordinates. All objects
+ * of the same type and tessellation are drawn with a single instanced
+ * call; the instance attributes carry the transformation, the color, and
+ * the radii from which the vertex shader builds the actual shape. The
+ * shader reproduces the fixed-function lighting of the 3d view.
+ *
+ * This file is part of GeodesicView.
+ */
+#ifndef OBJECT_MESHES_H
+#define OBJECT_MESHES_H
+
+#include <map>
+#include <vector>
+
+#include <QOpenGLBuffer>
+#include <QOpenGLShaderProgram>
+
+#include <gdefs.h>
+#include <utils/myobject.h>
+
+/**
+ * @brief The ObjectMeshes class
+ */
+class ObjectMeshes
+{
+public:
+    ObjectMeshes();
+    ~ObjectMeshes();
+
+public:
+    /**
+     * @brief Compile shader. Needs a current context.
+     * @return true if instanced drawing is supported.
+     */
+    bool init();
+
+    bool isSupported();
+
+    /**
+     * @brief Objects of this type are drawn by ObjectMeshes.
+     * @param type  Object type.
+     */
+    static bool isInstanced(enum_object_type type);
+
+    /**
+     * @brief Draw all instanced objects. Needs a current context.
+     *   Instance buffers are rebuilt when the revision changed.
+     * @param objects     List of objects; other types are skipped.
+     * @param revision    Revision of the object list.
+     * @param stereo      Draw white objects for anaglyph stereo.
+     * @param fogDensity  Density of the fog, or zero if fog is off.
+     * @return false if not supported; objects have to be drawn by MyObject then.
+     */
+    bool draw(const std::vector<MyObject*>& objects, unsigned int revision, bool stereo, double fogDensity);
+
+    /**
+     * @brief Destroy GL resources. Needs a current context.
+     */
+    void release();
+
+protected:
+    typedef struct _struct_obj_mesh {
+        QOpenGLBuffer vbo; //!< unit shape coordinates
+        QOpenGLBuffer ibo;
+        GLsizei numIndices;
+    } struct_obj_mesh;
+
+    typedef struct _struct_obj_group {
+        enum_object_type type;
+        unsigned long meshKey;
+        std::vector<GLfloat> instances; //!< model matrix, color, and radii per instance
+        QOpenGLBuffer vbo;
+        GLsizei count;
+    } struct_obj_group;
+
+    void update(const std::vector<MyObject*>& objects);
+    void clearGroups();
+    static unsigned long getMeshKey(enum_object_type type, int slices, int stacks);
+    struct_obj_mesh* getMesh(enum_object_type type, int slices, int stacks);
+    bool appendInstance(MyObject* obj, std::vector<GLfloat>& instances);
+
+    QString getVertexShaderCode();
+    QString getFragmentShaderCode();
+
+private:
+    bool mSupported;
+    QOpenGLShaderProgram* mShader;
+
+    std::map<unsigned long, struct_obj_mesh> mMeshes;
+    std::vector<struct_obj_group> mGroups;
+    unsigned int mRevision;
+    bool mHaveRevision;
+};
+
+#endif // OBJECT_MESHES_H
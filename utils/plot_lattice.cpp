@@ -0,0 +1,163 @@
+/**
+ * @file    plot_lattice.cpp
+ * @author  Thomas Mueller
+ *
+ * This file is part of GeodesicView.
+ */
+#include "plot_lattice.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+PlotLattice::PlotLattice()
+    : mVBO(QOpenGLBuffer::VertexBuffer)
+{
+    mNeedUpload = false;
+    mValid = false;
+    mStep[0] = mStep[1] = 0.0;
+    for (int i = 0; i < 4; i++) {
+        mRange[i] = 0;
+    }
+    for (int i = 0; i < enum_lattice_part_num; i++) {
+        mFirst[i] = 0;
+        mCount[i] = 0;
+    }
+}
+
+PlotLattice::~PlotLattice()
+{
+    // The owner has to release the GL buffer with its context current.
+}
+
+void PlotLattice::update(double xMin, double xMax, double yMin, double yMax, double xStep, double yStep)
+{
+    if (!(xStep > 0.0) || !(yStep > 0.0) || !std::isfinite(xMin) || !std::isfinite(xMax) || !std::isfinite(yMin)
+        || !std::isfinite(yMax)) {
+        return;
+    }
+
+    // Visible lattice indices as in OpenGL2dModel::setLattice.
+    int xs = static_cast<int>(floor(xMin / xStep)) + 1;
+    int xe = static_cast<int>(floor(xMax / xStep)) + 1;
+    int ys = static_cast<int>(floor(yMin / yStep)) + 1;
+    int ye = static_cast<int>(floor(yMax / yStep)) + 1;
+
+    if (mValid && xStep == mStep[0] && yStep == mStep[1] && xs >= mRange[0] && xe - 1 <= mRange[1]
+        && ys >= mRange[2] && ye - 1 <= mRange[3]) {
+        return;
+    }
+
+    int nx = std::max(xe - xs, 1);
+    int ny = std::max(ye - ys, 1);
+    mStep[0] = xStep;
+    mStep[1] = yStep;
+    mRange[0] = xs - nx;
+    mRange[1] = xe - 1 + nx;
+    mRange[2] = ys - ny;
+    mRange[3] = ye - 1 + ny;
+    build();
+    mValid = true;
+}
+
+void PlotLattice::drawLattice()
+{
+    draw(enum_lattice_part_lattice);
+}
+
+void PlotLattice::drawOrigin()
+{
+    draw(enum_lattice_part_origin);
+}
+
+void PlotLattice::drawXTicks()
+{
+    draw(enum_lattice_part_xticks);
+}
+
+void PlotLattice::drawYTicks()
+{
+    draw(enum_lattice_part_yticks);
+}
+
+void PlotLattice::release()
+{
+    mVBO.destroy();
+    mNeedUpload = !mData.empty();
+}
+
+void PlotLattice::build()
+{
+    // Lines along one axis span the covered range of the other axis plus one step.
+    GLfloat x0 = static_cast<GLfloat>((mRange[0] - 1) * mStep[0]);
+    GLfloat x1 = static_cast<GLfloat>((mRange[1] + 1) * mStep[0]);
+    GLfloat y0 = static_cast<GLfloat>((mRange[2] - 1) * mStep[1]);
+    GLfloat y1 = static_cast<GLfloat>((mRange[3] + 1) * mStep[1]);
+
+    mData.clear();
+    mFirst[enum_lattice_part_lattice] = 0;
+    for (int x = mRange[0]; x <= mRange[1]; x++) {
+        GLfloat xv = static_cast<GLfloat>(x * mStep[0]);
+        mData.insert(mData.end(), { xv, y0, xv, y1 });
+    }
+    for (int y = mRange[2]; y <= mRange[3]; y++) {
+        GLfloat yv = static_cast<GLfloat>(y * mStep[1]);
+        mData.insert(mData.end(), { x0, yv, x1, yv });
+    }
+
+    mFirst[enum_lattice_part_origin] = static_cast<GLint>(mData.size() / 2);
+    mData.insert(mData.end(), { 0.0f, y0, 0.0f, y1, x0, 0.0f, x1, 0.0f });
+
+    mFirst[enum_lattice_part_xticks] = static_cast<GLint>(mData.size() / 2);
+    for (int x = mRange[0]; x <= mRange[1]; x++) {
+        GLfloat xv = static_cast<GLfloat>(x * mStep[0]);
+        mData.insert(mData.end(), { xv, 0.6f, xv, 1.0f });
+    }
+
+    mFirst[enum_lattice_part_yticks] = static_cast<GLint>(mData.size() / 2);
+    for (int y = mRange[2]; y <= mRange[3]; y++) {
+        GLfloat yv = static_cast<GLfloat>(y * mStep[1]);
+        mData.insert(mData.end(), { 0.6f, yv, 1.0f, yv });
+    }
+
+    GLint numVerts = static_cast<GLint>(mData.size() / 2);
+    for (int i = 0; i < enum_lattice_part_num; i++) {
+        GLint next = (i + 1 < enum_lattice_part_num ? mFirst[i + 1] : numVerts);
+        mCount[i] = next - mFirst[i];
+    }
+    mNeedUpload = true;
+}
+
+void PlotLattice::draw(enum_lattice_part part)
+{
+    if (!mValid || mCount[part] == 0) {
+        return;
+    }
+
+    if (!mVBO.isCreated()) {
+        mVBO.setUsagePattern(QOpenGLBuffer::StaticDraw);
+        if (!mVBO.create()) {
+            fprintf(stderr, "Cannot create buffer for lattice!\n");
+        }
+    }
+
+    // Without buffer the lines are taken from client memory.
+    bool useVBO = mVBO.isCreated();
+    if (useVBO) {
+        mVBO.bind();
+        if (mNeedUpload) {
+            mVBO.allocate(mData.data(), static_cast<int>(mData.size() * sizeof(GLfloat)));
+            mNeedUpload = false;
+        }
+        glVertexPointer(2, GL_FLOAT, 0, nullptr);
+    }
+    else {
+        glVertexPointer(2, GL_FLOAT, 0, mData.data());
+    }
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glDrawArrays(GL_LINES, mFirst[part], mCount[part]);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    if (useVBO) {
+        mVBO.release();
+    }
+}
@@ -0,0 +1,92 @@
+/**
+ * @file    plot_lattice.h
+ * @author  Thomas Mueller
+ *
+ * @brief  Lattice, origin cross, and ticks of the 2D view in one GL buffer.
+ *
+ * All lines are generated into a single vertex buffer in plot coordinates.
+ * The buffer covers the visible lattice plus one view extent on each side,
+ * so panning and zooming only change the projection; the buffer is rebuilt
+ * when the step sizes change or the view leaves the covered range.
+ *
+ * This file is part of GeodesicView.
+ */
+#ifndef PLOT_LATTICE_H
+#define PLOT_LATTICE_H
+
+#include <vector>
+
+#include <QOpenGLBuffer>
+
+/**
+ * @brief The PlotLattice class
+ */
+class PlotLattice
+{
+public:
+    PlotLattice();
+    ~PlotLattice();
+
+public:
+    /**
+     * @brief Make sure the buffer covers the view. Needs a current context.
+     * @param xMin   Minimum abscissa of the view.
+     * @param xMax   Maximum abscissa of the view.
+     * @param yMin   Minimum ordinate of the view.
+     * @param yMax   Maximum ordinate of the view.
+     * @param xStep  Lattice step of the abscissa.
+     * @param yStep  Lattice step of the ordinate.
+     */
+    void update(double xMin, double xMax, double yMin, double yMax, double xStep, double yStep);
+
+    /**
+     * @brief Draw lattice lines in plot coordinates.
+     */
+    void drawLattice();
+
+    /**
+     * @brief Draw origin cross in plot coordinates.
+     */
+    void drawOrigin();
+
+    /**
+     * @brief Draw ticks of the abscissa; the ordinate runs over [0,1].
+     */
+    void drawXTicks();
+
+    /**
+     * @brief Draw ticks of the ordinate; the abscissa runs over [0,1].
+     */
+    void drawYTicks();
+
+    /**
+     * @brief Destroy GL buffer. Needs a current context.
+     */
+    void release();
+
+protected:
+    enum enum_lattice_part {
+        enum_lattice_part_lattice = 0,
+        enum_lattice_part_origin,
+        enum_lattice_part_xticks,
+        enum_lattice_part_yticks,
+        enum_lattice_part_num
+    };
+
+    void build();
+    void draw(enum_lattice_part part);
+
+private:
+    std::vector<GLfloat> mData;
+    QOpenGLBuffer mVBO;
+    bool mNeedUpload;
+
+    bool mValid;
+    double mStep[2];
+    int mRange[4]; //!< covered lattice indices: first and last abscissa, first and last ordinate
+
+    GLint mFirst[enum_lattice_part_num];
+    GLsizei mCount[enum_lattice_part_num];
+};
+
+#endif // PLOT_LATTICE_H
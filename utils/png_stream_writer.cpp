@@ -0,0 +1,139 @@
+/**
+ * @file    png_stream_writer.cpp
+ * @author  Thomas Mueller
+ *
+ * This file is part of GeodesicView.
+ */
+#include "png_stream_writer.h"
+
+#include <cstring>
+
+#ifdef HAVE_LIBPNG
+#include <png.h>
+#endif
+
+PngStreamWriter::PngStreamWriter()
+{
+    mWidth = mHeight = 0;
+    mNumRows = 0;
+    mFailed = false;
+#ifdef HAVE_LIBPNG
+    mFile = nullptr;
+    mPng = nullptr;
+    mInfo = nullptr;
+#endif
+}
+
+PngStreamWriter::~PngStreamWriter()
+{
+    close();
+}
+
+bool PngStreamWriter::open(QString filename, int width, int height)
+{
+    close();
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+
+    mWidth = width;
+    mHeight = height;
+    mNumRows = 0;
+    mFailed = false;
+    mFilename = filename;
+
+#ifdef HAVE_LIBPNG
+    mFile = fopen(filename.toLocal8Bit().constData(), "wb");
+    if (mFile == nullptr) {
+        fprintf(stderr, "Cannot open file %s for writing!\n", filename.toLocal8Bit().constData());
+        return false;
+    }
+
+    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    png_infop info = (png != nullptr ? png_create_info_struct(png) : nullptr);
+    mPng = png;
+    mInfo = info;
+    if (info == nullptr || setjmp(png_jmpbuf(png))) {
+        fprintf(stderr, "Cannot initialize png writer!\n");
+        mFailed = true;
+        close();
+        return false;
+    }
+
+    png_init_io(png, mFile);
+    png_set_IHDR(png, info, static_cast<png_uint_32>(width), static_cast<png_uint_32>(height), 8, PNG_COLOR_TYPE_RGB,
+        PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    png_write_info(png, info);
+#else
+    mImage = QImage(width, height, QImage::Format_RGB888);
+    if (mImage.isNull()) {
+        fprintf(stderr, "Cannot allocate image of size %d x %d!\n", width, height);
+        return false;
+    }
+#endif
+    return true;
+}
+
+bool PngStreamWriter::writeRow(const unsigned char* rgb)
+{
+    if (mFailed || mNumRows >= mHeight) {
+        return false;
+    }
+
+#ifdef HAVE_LIBPNG
+    png_structp png = static_cast<png_structp>(mPng);
+    if (png == nullptr) {
+        return false;
+    }
+    if (setjmp(png_jmpbuf(png))) {
+        fprintf(stderr, "Cannot write png row!\n");
+        mFailed = true;
+        return false;
+    }
+    png_write_row(png, const_cast<png_bytep>(rgb));
+#else
+    if (mImage.isNull()) {
+        return false;
+    }
+    memcpy(mImage.scanLine(mNumRows), rgb, static_cast<size_t>(mWidth * 3));
+#endif
+    mNumRows++;
+    return true;
+}
+
+bool PngStreamWriter::close()
+{
+    bool ok = (!mFailed && mNumRows == mHeight && mHeight > 0);
+
+#ifdef HAVE_LIBPNG
+    png_structp png = static_cast<png_structp>(mPng);
+    png_infop info = static_cast<png_infop>(mInfo);
+    if (png != nullptr) {
+        if (ok) {
+            if (setjmp(png_jmpbuf(png))) {
+                mFailed = true;
+            }
+            else {
+                png_write_end(png, nullptr);
+            }
+        }
+        png_destroy_write_struct(&png, (info != nullptr ? &info : nullptr));
+    }
+    mPng = nullptr;
+    mInfo = nullptr;
+    if (mFile != nullptr) {
+        fclose(mFile);
+        mFile = nullptr;
+    }
+    ok = (ok && !mFailed);
+#else
+    if (ok) {
+        ok = mImage.save(mFilename);
+    }
+    mImage = QImage();
+#endif
+
+    mWidth = mHeight = 0;
+    mNumRows = 0;
+    return ok;
+}
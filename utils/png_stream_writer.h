@@ -0,0 +1,70 @@
+/**
+ * @file    png_stream_writer.h
+ * @author  Thomas Mueller
+ *
+ * @brief  Row-wise PNG writer for large images.
+ *
+ * Rows are passed from top to bottom and are handed to libpng at once, so
+ * the image never has to be kept in memory as a whole. Without libpng
+ * (HAVE_LIBPNG not defined), the rows are collected in a QImage which is
+ * written when the writer is closed.
+ *
+ * This file is part of GeodesicView.
+ */
+#ifndef PNG_STREAM_WRITER_H
+#define PNG_STREAM_WRITER_H
+
+#include <cstdio>
+
+#include <QImage>
+#include <QString>
+
+/**
+ * @brief The PngStreamWriter class
+ */
+class PngStreamWriter
+{
+public:
+    PngStreamWriter();
+    ~PngStreamWriter();
+
+public:
+    /**
+     * @brief Open file and write header.
+     * @param filename  Name of png file.
+     * @param width     Image width.
+     * @param height    Image height.
+     * @return true if file could be opened.
+     */
+    bool open(QString filename, int width, int height);
+
+    /**
+     * @brief Append one row.
+     * @param rgb  Pointer to 3*width bytes.
+     * @return false if the row could not be written.
+     */
+    bool writeRow(const unsigned char* rgb);
+
+    /**
+     * @brief Finish image and close file.
+     * @return true if all rows were written.
+     */
+    bool close();
+
+private:
+    int mWidth;
+    int mHeight;
+    int mNumRows;
+    bool mFailed;
+    QString mFilename;
+
+#ifdef HAVE_LIBPNG
+    FILE* mFile;
+    void* mPng; //!< png_structp
+    void* mInfo; //!< png_infop
+#else
+    QImage mImage;
+#endif
+};
+
+#endif // PNG_STREAM_WRITER_H
@@ -0,0 +1,115 @@
+/**
+ * @file    point_index.cpp
+ * @author  Thomas Mueller
+ *
+ * This file is part of GeodesicView.
+ */
+#include "point_index.h"
+
+#include <algorithm>
+#include <cmath>
+
+PointIndex::PointIndex()
+{
+    mVerts = nullptr;
+    mStride = 2;
+    mOff[0] = 0;
+    mOff[1] = 1;
+    mQuery[0] = mQuery[1] = 0.0;
+    mWeight[0] = mWeight[1] = 1.0;
+    mMaxIndex = 0;
+    mBestDist2 = 0.0;
+    mBest = -1;
+}
+
+PointIndex::~PointIndex()
+{
+}
+
+void PointIndex::build(const GLfloat* verts, size_t num, int stride, int xOff, int yOff)
+{
+    mVerts = verts;
+    mStride = stride;
+    mOff[0] = xOff;
+    mOff[1] = yOff;
+    mIdx.clear();
+    mIdx.reserve(num);
+    for (size_t i = 0; i < num; i++) {
+        const GLfloat* v = verts + static_cast<size_t>(stride) * i;
+        if (std::isfinite(v[xOff]) && std::isfinite(v[yOff])) {
+            mIdx.push_back(static_cast<unsigned int>(i));
+        }
+    }
+    build(0, mIdx.size(), 0);
+}
+
+void PointIndex::clear()
+{
+    mVerts = nullptr;
+    mIdx.clear();
+}
+
+int PointIndex::nearest(double x, double y, double wx, double wy, double maxDist, size_t maxIndex)
+{
+    if (mVerts == nullptr || mIdx.empty()) {
+        return -1;
+    }
+
+    mQuery[0] = x;
+    mQuery[1] = y;
+    mWeight[0] = wx;
+    mWeight[1] = wy;
+    mMaxIndex = maxIndex;
+    mBestDist2 = maxDist * maxDist;
+    mBest = -1;
+    search(0, mIdx.size(), 0);
+    return mBest;
+}
+
+void PointIndex::build(size_t begin, size_t end, int axis)
+{
+    if (end - begin < 2) {
+        return;
+    }
+
+    size_t mid = begin + (end - begin) / 2;
+    const GLfloat* verts = mVerts + mOff[axis];
+    size_t stride = static_cast<size_t>(mStride);
+    std::nth_element(mIdx.begin() + begin, mIdx.begin() + mid, mIdx.begin() + end,
+        [verts, stride](unsigned int a, unsigned int b) { return verts[stride * a] < verts[stride * b]; });
+    build(begin, mid, 1 - axis);
+    build(mid + 1, end, 1 - axis);
+}
+
+void PointIndex::search(size_t begin, size_t end, int axis)
+{
+    if (begin >= end) {
+        return;
+    }
+
+    size_t mid = begin + (end - begin) / 2;
+    unsigned int idx = mIdx[mid];
+    const GLfloat* v = mVerts + static_cast<size_t>(mStride) * idx;
+    double dx = (v[mOff[0]] - mQuery[0]) * mWeight[0];
+    double dy = (v[mOff[1]] - mQuery[1]) * mWeight[1];
+    double dist2 = dx * dx + dy * dy;
+    if (idx < mMaxIndex && dist2 < mBestDist2) {
+        mBestDist2 = dist2;
+        mBest = static_cast<int>(idx);
+    }
+
+    // Descend into the half holding the query first; the other half only if the splitting line is close enough.
+    double delta = (axis == 0 ? dx : dy);
+    if (delta > 0.0) {
+        search(begin, mid, 1 - axis);
+        if (delta * delta < mBestDist2) {
+            search(mid + 1, end, 1 - axis);
+        }
+    }
+    else {
+        search(mid + 1, end, 1 - axis);
+        if (delta * delta < mBestDist2) {
+            search(begin, mid, 1 - axis);
+        }
+    }
+}
@@ -0,0 +1,74 @@
+/**
+ * @file    point_index.h
+ * @author  Thomas Mueller
+ *
+ * @brief  Spatial index for picking projected vertices.
+ *
+ * A balanced 2d-tree over the vertices of a 2D projection, stored
+ * implicitly as a permutation of the vertex indices. It is built once per
+ * projection in O(N log N); a nearest-vertex query then costs O(log N) on
+ * average. Distances are weighted per axis, so a pick radius can be given
+ * in pixels of a view with different scaling of abscissa and ordinate.
+ *
+ * This file is part of GeodesicView.
+ */
+#ifndef POINT_INDEX_H
+#define POINT_INDEX_H
+
+#include <vector>
+
+#include <QOpenGLFunctions>
+
+/**
+ * @brief The PointIndex class
+ */
+class PointIndex
+{
+public:
+    PointIndex();
+    ~PointIndex();
+
+public:
+    /**
+     * @brief Build tree.
+     * @param verts   Pointer to vertices; has to stay valid while the tree is used.
+     * @param num     Number of vertices.
+     * @param stride  Number of floats per vertex.
+     * @param xOff    Offset of abscissa within a vertex.
+     * @param yOff    Offset of ordinate within a vertex.
+     */
+    void build(const GLfloat* verts, size_t num, int stride = 2, int xOff = 0, int yOff = 1);
+
+    void clear();
+
+    /**
+     * @brief Find nearest vertex.
+     * @param x         Abscissa of query position.
+     * @param y         Ordinate of query position.
+     * @param wx        Weight of abscissa, e.g. pixels per unit.
+     * @param wy        Weight of ordinate.
+     * @param maxDist   Maximum weighted distance.
+     * @param maxIndex  Only vertices with smaller index are taken into account.
+     * @return index of nearest vertex, or -1 if there is none within maxDist.
+     */
+    int nearest(double x, double y, double wx, double wy, double maxDist, size_t maxIndex);
+
+protected:
+    void build(size_t begin, size_t end, int axis);
+    void search(size_t begin, size_t end, int axis);
+
+private:
+    const GLfloat* mVerts;
+    int mStride;
+    int mOff[2];
+    std::vector<unsigned int> mIdx; //!< node of a subrange is its median element
+
+    // state of the current query
+    double mQuery[2];
+    double mWeight[2];
+    size_t mMaxIndex;
+    double mBestDist2;
+    int mBest;
+};
+
+#endif // POINT_INDEX_H
@@ -0,0 +1,183 @@
+/**
+ * @file    projection_cache.cpp
+ * @author  Thomas Mueller
+ *
+ * This file is part of GeodesicView.
+ */
+#include "projection_cache.h"
+#include "utilities.h"
+
+#include <algorithm>
+
+ProjectionCache::ProjectionCache(size_t maxBytes)
+{
+    mMaxBytes = maxBytes;
+    mUsedBytes = 0;
+    mRevision = 0;
+    mNumUsers = 0;
+}
+
+ProjectionCache::~ProjectionCache()
+{
+    // The last view has to release the buffers with its context current.
+    clear();
+    releaseBuffers();
+}
+
+void ProjectionCache::attach()
+{
+    mNumUsers++;
+}
+
+int ProjectionCache::detach()
+{
+    mNumUsers = std::max(0, mNumUsers - 1);
+    return mNumUsers;
+}
+
+GLfloat* ProjectionCache::find(
+    unsigned int revision, m4d::enum_draw_type dtype, double param, int dim, size_t& numFloats)
+{
+    std::list<struct_proj_entry>::iterator itr = mEntries.begin();
+    while (itr != mEntries.end()) {
+        if (itr->revision == revision && itr->dtype == dtype && itr->param == param && itr->dim == dim) {
+            mEntries.splice(mEntries.begin(), mEntries, itr);
+            itr->numPins++;
+            numFloats = itr->numFloats;
+            return itr->verts;
+        }
+        ++itr;
+    }
+    return nullptr;
+}
+
+GLfloat* ProjectionCache::insert(
+    unsigned int revision, m4d::enum_draw_type dtype, double param, int dim, size_t numFloats)
+{
+    mRevision = revision;
+    std::list<struct_proj_entry>::iterator itr = mEntries.begin();
+    while (itr != mEntries.end()) {
+        std::list<struct_proj_entry>::iterator curr = itr++;
+        bool sameKey = (curr->dtype == dtype && curr->param == param && curr->dim == dim);
+        if (curr->numPins == 0 && (curr->revision != revision || sameKey)) {
+            evict(curr);
+        }
+    }
+
+    struct_proj_entry entry;
+    entry.revision = revision;
+    entry.dtype = dtype;
+    entry.param = param;
+    entry.dim = dim;
+    entry.verts = new GLfloat[std::max(numFloats, static_cast<size_t>(1))];
+    entry.numFloats = numFloats;
+    entry.vbo = nullptr;
+    entry.numPins = 1;
+    mEntries.push_front(entry);
+    mUsedBytes += numFloats * sizeof(GLfloat);
+
+    shrink();
+    return entry.verts;
+}
+
+void ProjectionCache::unpin(GLfloat* verts)
+{
+    if (verts == nullptr) {
+        return;
+    }
+
+    std::list<struct_proj_entry>::iterator itr = mEntries.begin();
+    while (itr != mEntries.end()) {
+        if (itr->verts == verts) {
+            itr->numPins = std::max(0, itr->numPins - 1);
+            // A view still showing an outdated trajectory kept it alive until now.
+            if (itr->numPins == 0 && itr->revision != mRevision) {
+                evict(itr);
+            }
+            else {
+                shrink();
+            }
+            return;
+        }
+        ++itr;
+    }
+}
+
+QOpenGLBuffer* ProjectionCache::getBuffer(GLfloat* verts)
+{
+    std::list<struct_proj_entry>::iterator itr = mEntries.begin();
+    while (itr != mEntries.end() && itr->verts != verts) {
+        ++itr;
+    }
+    if (itr == mEntries.end()) {
+        return nullptr;
+    }
+
+    struct_proj_entry& entry = *itr;
+    if (entry.vbo == nullptr) {
+        entry.vbo = new QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+        entry.vbo->setUsagePattern(QOpenGLBuffer::StaticDraw);
+        if (!entry.vbo->create()) {
+            delete entry.vbo;
+            entry.vbo = nullptr;
+            return nullptr;
+        }
+        entry.vbo->bind();
+        entry.vbo->allocate(entry.verts, static_cast<int>(entry.numFloats * sizeof(GLfloat)));
+        entry.vbo->release();
+        mUsedBytes += entry.numFloats * sizeof(GLfloat);
+        shrink();
+    }
+    return entry.vbo;
+}
+
+void ProjectionCache::releaseBuffers()
+{
+    for (size_t i = 0; i < mReleased.size(); i++) {
+        mReleased[i]->destroy();
+        delete mReleased[i];
+    }
+    mReleased.clear();
+}
+
+void ProjectionCache::clear()
+{
+    while (!mEntries.empty()) {
+        evict(mEntries.begin());
+    }
+}
+
+void ProjectionCache::setMaxBytes(size_t maxBytes)
+{
+    mMaxBytes = maxBytes;
+    shrink();
+}
+
+size_t ProjectionCache::getUsedBytes()
+{
+    return mUsedBytes;
+}
+
+void ProjectionCache::evict(std::list<struct_proj_entry>::iterator itr)
+{
+    mUsedBytes -= itr->numFloats * sizeof(GLfloat);
+    SafeDelete<GLfloat>(itr->verts);
+    if (itr->vbo != nullptr) {
+        mUsedBytes -= itr->numFloats * sizeof(GLfloat);
+        mReleased.push_back(itr->vbo);
+    }
+    mEntries.erase(itr);
+}
+
+void ProjectionCache::shrink()
+{
+    // Pinned entries are displayed by some view and are always kept.
+    std::list<struct_proj_entry>::iterator itr = mEntries.end();
+    while (mUsedBytes > mMaxBytes && itr != mEntries.begin()) {
+        std::list<struct_proj_entry>::iterator curr = --itr;
+        if (curr->numPins == 0) {
+            ++itr;
+            evict(curr);
+        }
+    }
+}
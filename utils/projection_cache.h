@@ -0,0 +1,125 @@
+/**
+ * @file    projection_cache.h
+ * @author  Thomas Mueller
+ *
+ * @brief  Cache for projected geodesic vertices.
+ *
+ * Each entry holds the vertices of one projection (draw type, parameter,
+ * and number of components) of the current trajectory, together with a
+ * lazily created GL buffer. Entries are tagged with the trajectory revision;
+ * entries of older revisions are dropped and the remaining ones are evicted
+ * in least-recently-used order when the memory budget is exceeded.
+ *
+ * One cache is shared by all views. Its GL buffers live in the shared
+ * context group, so a projection is computed and uploaded once per
+ * trajectory revision however many views show it. Every view pins the
+ * entry it displays; pinned entries are never evicted.
+ *
+ * This file is part of GeodesicView.
+ */
+#ifndef PROJECTION_CACHE_H
+#define PROJECTION_CACHE_H
+
+#include <list>
+#include <vector>
+
+#include <QOpenGLBuffer>
+
+#include <gdefs.h>
+#include <m4dGlobalDefs.h>
+
+/**
+ * @brief The ProjectionCache class
+ */
+class ProjectionCache
+{
+public:
+    ProjectionCache(size_t maxBytes = DEF_PROJECTION_CACHE_MAX_BYTES);
+    ~ProjectionCache();
+
+public:
+    /**
+     * @brief Register a view using the cache.
+     */
+    void attach();
+
+    /**
+     * @brief Unregister a view.
+     * @return number of views still using the cache.
+     */
+    int detach();
+
+    /**
+     * @brief Find projection, pin it, and mark it as most recently used.
+     * @param revision  Trajectory revision.
+     * @param dtype     Draw type.
+     * @param param     Additional parameter the projection depends on.
+     * @param dim       Number of components per vertex.
+     * @param numFloats Reference to number of floats stored.
+     * @return pointer to vertices or nullptr if not cached.
+     */
+    GLfloat* find(unsigned int revision, m4d::enum_draw_type dtype, double param, int dim, size_t& numFloats);
+
+    /**
+     * @brief Allocate a new pinned projection entry.
+     *   Unpinned entries of other revisions are dropped and least recently
+     *   used unpinned entries are evicted until the budget is met.
+     * @param revision  Trajectory revision.
+     * @param dtype     Draw type.
+     * @param param     Additional parameter the projection depends on.
+     * @param dim       Number of components per vertex.
+     * @param numFloats Number of floats to allocate.
+     * @return pointer to uninitialized vertex storage.
+     */
+    GLfloat* insert(unsigned int revision, m4d::enum_draw_type dtype, double param, int dim, size_t numFloats);
+
+    /**
+     * @brief Unpin the entry of a view that displays something else now.
+     * @param verts  Vertices returned by find() or insert(); nullptr is ignored.
+     */
+    void unpin(GLfloat* verts);
+
+    /**
+     * @brief Get GL buffer of an entry.
+     *   The buffer is created and filled on first request. Needs a current context.
+     * @param verts  Vertices returned by find() or insert().
+     * @return pointer to buffer or nullptr if there is no such entry.
+     */
+    QOpenGLBuffer* getBuffer(GLfloat* verts);
+
+    /**
+     * @brief Destroy GL buffers of evicted entries. Needs a current context.
+     */
+    void releaseBuffers();
+
+    void clear();
+
+    void setMaxBytes(size_t maxBytes);
+    size_t getUsedBytes();
+
+protected:
+    typedef struct _struct_proj_entry {
+        unsigned int revision;
+        m4d::enum_draw_type dtype;
+        double param;
+        int dim;
+        GLfloat* verts;
+        size_t numFloats;
+        QOpenGLBuffer* vbo;
+        int numPins;
+    } struct_proj_entry;
+
+    void evict(std::list<struct_proj_entry>::iterator itr);
+    void shrink();
+
+private:
+    std::list<struct_proj_entry> mEntries;
+    std::vector<QOpenGLBuffer*> mReleased;
+    unsigned int mRevision; //!< revision of the latest insert
+    int mNumUsers;
+
+    size_t mMaxBytes;
+    size_t mUsedBytes;
+};
+
+#endif // PROJECTION_CACHE_H
@@ -129,6 +129,59 @@ void Quaternion::setRot(double angle, m4d::vec3 v)
     xk = sa * vn[2];
 }
 
+void Quaternion::setCamFrame(m4d::vec3 right, m4d::vec3 vup, m4d::vec3 dir)
+{
+    // Columns of the rotation matrix are right, vup, and -dir.
+    double m00 = right[0], m01 = vup[0], m02 = -dir[0];
+    double m10 = right[1], m11 = vup[1], m12 = -dir[1];
+    double m20 = right[2], m21 = vup[2], m22 = -dir[2];
+
+    double trace = m00 + m11 + m22;
+    if (trace > 0.0) {
+        double s = 0.5 / sqrt(trace + 1.0);
+        set(0.25 / s, (m21 - m12) * s, (m02 - m20) * s, (m10 - m01) * s);
+    }
+    else if (m00 > m11 && m00 > m22) {
+        double s = 2.0 * sqrt(1.0 + m00 - m11 - m22);
+        set((m21 - m12) / s, 0.25 * s, (m01 + m10) / s, (m02 + m20) / s);
+    }
+    else if (m11 > m22) {
+        double s = 2.0 * sqrt(1.0 + m11 - m00 - m22);
+        set((m02 - m20) / s, (m01 + m10) / s, 0.25 * s, (m12 + m21) / s);
+    }
+    else {
+        double s = 2.0 * sqrt(1.0 + m22 - m00 - m11);
+        set((m10 - m01) / s, (m02 + m20) / s, (m12 + m21) / s, 0.25 * s);
+    }
+}
+
+Quaternion Quaternion::slerp(const Quaternion& q1, const Quaternion& q2, double t)
+{
+    double cosom = q1.r() * q2.r() + q1.i() * q2.i() + q1.j() * q2.j() + q1.k() * q2.k();
+    Quaternion q3 = q2;
+    if (cosom < 0.0) {
+        cosom = -cosom;
+        q3 = q2 * (-1.0);
+    }
+
+    // Nearly parallel rotations are interpolated linearly to avoid dividing by sin(0).
+    double s1 = 1.0 - t;
+    double s2 = t;
+    if (cosom < 1.0 - 1e-6) {
+        double omega = acos(cosom);
+        double sinom = sin(omega);
+        s1 = sin((1.0 - t) * omega) / sinom;
+        s2 = sin(t * omega) / sinom;
+    }
+
+    Quaternion q = q1 * s1 + q3 * s2;
+    double len = q.length();
+    if (len < QUATERNION_EPS) {
+        return q1;
+    }
+    return q * (1.0 / len);
+}
+
 Quaternion Quaternion::conj() const
 {
     return Quaternion(xr, -xi, -xj, -xk);
@@ -81,6 +81,25 @@ public:
      */
     void setRot(double angle, m4d::vec3 v);
 
+    /*! Set rotation quaternion from an orthonormal camera frame.
+     *   This is the inverse of calcMat() followed by getCamRight(), getCamVup(), and -getCamDir().
+     *
+     *   \param  right :  right vector.
+     *   \param  vup   :  vertical up vector.
+     *   \param  dir   :  viewing direction.
+     */
+    void setCamFrame(m4d::vec3 right, m4d::vec3 vup, m4d::vec3 dir);
+
+    /*! Spherical linear interpolation between two rotation quaternions.
+     *   The shorter of the two arcs is taken.
+     *
+     *   \param  q1 :  rotation at t=0.
+     *   \param  q2 :  rotation at t=1.
+     *   \param  t  :  interpolation parameter.
+     *   \return Quaternion : normalized rotation quaternion.
+     */
+    static Quaternion slerp(const Quaternion& q1, const Quaternion& q2, double t);
+
     double r() const { return xr; }
     double i() const { return xi; }
     double j() const { return xj; }
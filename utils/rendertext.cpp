@@ -7,6 +7,7 @@
 #include "utils/rendertext.h"
 #include "utils/mathutils.h"
 #include <QMatrix4x4>
+#include <QVector>
 #include <stdint.h>
 
 #ifdef HAVE_FREETYPE
@@ -21,30 +22,139 @@ typedef struct char_info_t {
     float bitmap_height;
     float bitmap_left;
     float bitmap_top;
-    float tx; //!< x offset of glyph in texture coordinates
+    float tx; //!< x offset of glyph in the atlas in pixels
+    float ty; //!< y offset of glyph in the atlas in pixels
 } char_info;
 
-typedef struct font_atlas_t {
-    GLuint texID; //!< texture id
-    float width; //!< width of texture
-    float height; //!< height of texture
-    char_info c[128]; //!< character information
-} font_atlas;
-
 class RenderTextPimpl
 {
 public:
     RenderTextPimpl();
+    ~RenderTextPimpl();
+
+    /**
+     * @brief Glyph of a code point; rasterized into the atlas on first use.
+     */
+    const char_info& getGlyph(unsigned int code);
 
     FT_Library ft_;
     FT_Face face_;
     FT_GlyphSlot g_;
-    font_atlas atlas_;
+
+    GLuint texID_;
+    int width_; //!< width of atlas in pixels
+    int height_; //!< height of atlas in pixels
+    std::vector<uint8_t> pixels_;
+    bool dirty_; //!< glyphs were added since the last upload
+    bool resized_; //!< atlas has grown since the last upload
+
+protected:
+    bool place(int w, int h, int& x, int& y);
+
+private:
+    std::map<unsigned int, char_info> glyphs_;
+
+    // glyphs are packed in rows from top to bottom
+    int penX_;
+    int penY_;
+    int rowHeight_;
 };
 
 RenderTextPimpl::RenderTextPimpl()
 {
-    atlas_.texID = 0;
+    ft_ = nullptr;
+    face_ = nullptr;
+    g_ = nullptr;
+    texID_ = 0;
+    width_ = RENDERTEXT_ATLAS_WIDTH;
+    height_ = RENDERTEXT_ATLAS_MIN_HEIGHT;
+    pixels_.assign(static_cast<size_t>(width_ * height_), 0);
+    dirty_ = true;
+    resized_ = true;
+    penX_ = 0;
+    penY_ = 0;
+    rowHeight_ = 0;
+}
+
+RenderTextPimpl::~RenderTextPimpl()
+{
+    if (face_ != nullptr) {
+        FT_Done_Face(face_);
+    }
+    if (ft_ != nullptr) {
+        FT_Done_FreeType(ft_);
+    }
+}
+
+const char_info& RenderTextPimpl::getGlyph(unsigned int code)
+{
+    std::map<unsigned int, char_info>::iterator itr = glyphs_.find(code);
+    if (itr != glyphs_.end()) {
+        return itr->second;
+    }
+
+    // A glyph that cannot be loaded is kept empty, so it is not tried again.
+    char_info& ci = glyphs_[code];
+    memset(&ci, 0, sizeof(char_info));
+    if (FT_Load_Char(face_, code, FT_LOAD_RENDER)) {
+        fprintf(stderr, "@ %s (%d): Loading character U+%04X failed.\n", __FILE__, __LINE__, code);
+        return ci;
+    }
+
+    ci.adv_x = static_cast<float>(g_->advance.x >> 6);
+    ci.adv_y = static_cast<float>(g_->advance.y >> 6);
+    ci.bitmap_left = static_cast<float>(g_->bitmap_left);
+    ci.bitmap_top = static_cast<float>(g_->bitmap_top);
+
+    int w = static_cast<int>(g_->bitmap.width);
+    int h = static_cast<int>(g_->bitmap.rows);
+    int x, y;
+    if (w == 0 || h == 0) {
+        return ci;
+    }
+    if (!place(w, h, x, y)) {
+        fprintf(stderr, "@ %s (%d): Glyph atlas is full, U+%04X is not shown.\n", __FILE__, __LINE__, code);
+        return ci;
+    }
+
+    for (int row = 0; row < h; row++) {
+        memcpy(&pixels_[static_cast<size_t>((y + row) * width_ + x)], g_->bitmap.buffer + row * g_->bitmap.pitch,
+            static_cast<size_t>(w));
+    }
+    ci.bitmap_width = static_cast<float>(w);
+    ci.bitmap_height = static_cast<float>(h);
+    ci.tx = static_cast<float>(x);
+    ci.ty = static_cast<float>(y);
+    dirty_ = true;
+    return ci;
+}
+
+bool RenderTextPimpl::place(int w, int h, int& x, int& y)
+{
+    if (w > width_) {
+        return false;
+    }
+    if (penX_ + w > width_) {
+        penX_ = 0;
+        penY_ += rowHeight_ + 1;
+        rowHeight_ = 0;
+    }
+
+    // Rows are stored top to bottom, so the atlas grows without moving any glyph.
+    while (penY_ + h > height_) {
+        if (2 * height_ > RENDERTEXT_ATLAS_MAX_HEIGHT) {
+            return false;
+        }
+        height_ *= 2;
+        pixels_.resize(static_cast<size_t>(width_ * height_), 0);
+        resized_ = true;
+    }
+
+    x = penX_;
+    y = penY_;
+    penX_ += w + 1;
+    rowHeight_ = std::max(rowHeight_, h);
+    return true;
 }
 
 RenderText::RenderText(const char* fontFilename, unsigned int size)
@@ -53,6 +163,7 @@ RenderText::RenderText(const char* fontFilename, unsigned int size)
     fontSize_ = size;
     color_ = Qt::white;
     shader = nullptr;
+    labelShader = nullptr;
 
     rtp = new RenderTextPimpl();
     initialized_ = init();
@@ -69,6 +180,7 @@ RenderText::RenderText(const char* fontFilename, unsigned int size, float* rgba)
     color_.setBlueF(static_cast<qreal>(rgba[2]));
     color_.setAlphaF(static_cast<qreal>(rgba[3]));
     shader = nullptr;
+    labelShader = nullptr;
 
     rtp = new RenderTextPimpl();
     initialized_ = init();
@@ -85,6 +197,7 @@ RenderText::RenderText(const char* fontFilename, unsigned int size, float r, flo
     color_.setBlueF(static_cast<qreal>(b));
     color_.setAlphaF(static_cast<qreal>(a));
     shader = nullptr;
+    labelShader = nullptr;
 
     rtp = new RenderTextPimpl();
     initialized_ = init();
@@ -103,19 +216,10 @@ unsigned int RenderText::GetFontSize()
 
 float RenderText::GetTextWidth(const char* text)
 {
-    float sx = 1.0f;
-
-    const uint8_t* p;
-    float width = 0.0;
-    const char* t = text;
-    for (p = reinterpret_cast<const uint8_t*>(t); *p; p++) {
-        float w = rtp->atlas_.c[*p].adv_x * sx;
-        if (w < 1e-10f)
-            continue;
-
-        width += w;
+    if (!initialized_) {
+        return 0.0f;
     }
-    return width;
+    return getLayout(text).width;
 }
 
 void RenderText::SetColor(float r, float g, float b, float a)
@@ -182,7 +286,105 @@ void RenderText::render(const char* text, float posx, float posy, float sx, floa
         return;
     }
 
-    if (shader == nullptr) {
+    const Layout& layout = getLayout(text);
+    std::vector<Coord> coords(layout.quads.size());
+    for (size_t i = 0; i < layout.quads.size(); i++) {
+        const Coord& q = layout.quads[i];
+        coords[i] = Coord(q.x * sx, q.y * sy, q.z, q.w);
+    }
+    draw(coords.data(), static_cast<int>(coords.size()), posx, posy);
+}
+
+void RenderText::BeginBatch()
+{
+    batch_.clear();
+}
+
+void RenderText::AddToBatch(const int px, const int py, const char* text, int align)
+{
+    if (!initialized_) {
+        return;
+    }
+
+    const Layout& layout = getLayout(text);
+    float x = static_cast<float>(px);
+    float y = static_cast<float>(py);
+
+    if (align & ALIGN_RIGHT) {
+        x -= layout.width;
+    }
+    else if (align & ALIGN_HCENTER) {
+        x -= 0.5f * layout.width;
+    }
+
+    if (align & ALIGN_TOP) {
+        y -= fontSize_;
+    }
+    else if (align & ALIGN_VCENTER) {
+        y -= 0.5f * fontSize_;
+    }
+
+    // Whole pixels keep the glyphs sharp.
+    x = floorf(x + 0.5f);
+    y = floorf(y + 0.5f);
+    for (size_t i = 0; i < layout.quads.size(); i++) {
+        const Coord& q = layout.quads[i];
+        batch_.push_back(Coord(q.x + x, q.y + y, q.z, q.w));
+    }
+}
+
+void RenderText::DrawBatch()
+{
+    if (!initialized_ || batch_.empty()) {
+        return;
+    }
+    draw(batch_.data(), static_cast<int>(batch_.size()), 0.0f, 0.0f);
+}
+
+const RenderText::Layout& RenderText::getLayout(const char* text)
+{
+    std::map<std::string, Layout>::iterator itr = layouts_.find(text);
+    if (itr != layouts_.end()) {
+        return itr->second;
+    }
+    if (layouts_.size() >= RENDERTEXT_MAX_LAYOUTS) {
+        layouts_.clear();
+    }
+
+    // Text is UTF-8; every code point gets its glyph from the atlas.
+    Layout& layout = layouts_[text];
+    QVector<uint> codes = QString::fromUtf8(text).toUcs4();
+    float x = 0.0f;
+    float y = 0.0f;
+    for (int i = 0; i < codes.size(); i++) {
+        const char_info& ci = rtp->getGlyph(codes[i]);
+        float x2 = x + ci.bitmap_left;
+        float y2 = y + ci.bitmap_top;
+        float w = ci.bitmap_width;
+        float h = ci.bitmap_height;
+        float tx2 = ci.tx + ci.bitmap_width;
+        float ty2 = ci.ty + ci.bitmap_height;
+
+        x += ci.adv_x;
+        y += ci.adv_y;
+        if (w == 0.0f || h == 0.0f) {
+            continue;
+        }
+
+        layout.quads.push_back(Coord(x2, y2, ci.tx, ci.ty));
+        layout.quads.push_back(Coord(x2 + w, y2, tx2, ci.ty));
+        layout.quads.push_back(Coord(x2, y2 - h, ci.tx, ty2));
+        layout.quads.push_back(Coord(x2 + w, y2, tx2, ci.ty));
+        layout.quads.push_back(Coord(x2, y2 - h, ci.tx, ty2));
+        layout.quads.push_back(Coord(x2 + w, y2 - h, tx2, ty2));
+    }
+    layout.width = x;
+    return layout;
+}
+
+void RenderText::draw(const Coord* coords, int num, float posx, float posy)
+{
+    if (shader == nullptr || num == 0) {
         return;
     }
 
@@ -209,54 +411,27 @@ void RenderText::render(const char* text, float posx, float posy, float sx, floa
     // rotAngle in degree !!
     viewMX.rotate(rotAngle, 0.0f, 0.0f, 1.0f);
 
-    float x = 0.0f;
-    float y = 0.0f;
-
-    Coord* coords_ = new Coord[6 * strlen(text)];
-
-    const uint8_t* p;
-    const char* t = text;
-    int c = 0;
-    for (p = reinterpret_cast<const uint8_t*>(t); *p; p++) {
-        float x2 = x + rtp->atlas_.c[*p].bitmap_left * sx;
-        float y2 = -y - rtp->atlas_.c[*p].bitmap_top * sy;
-        float w = rtp->atlas_.c[*p].bitmap_width * sx;
-        float h = rtp->atlas_.c[*p].bitmap_height * sy;
-
-        x += rtp->atlas_.c[*p].adv_x * sx;
-        y += rtp->atlas_.c[*p].adv_y * sy;
-
-        // if (!w || !h)    continue;
-
-        coords_[c++] = Coord(x2, -y2, rtp->atlas_.c[*p].tx, 0);
-        coords_[c++] = Coord(x2 + w, -y2, rtp->atlas_.c[*p].tx + rtp->atlas_.c[*p].bitmap_width / rtp->atlas_.width, 0);
-        coords_[c++] = Coord(x2, -y2 - h, rtp->atlas_.c[*p].tx, rtp->atlas_.c[*p].bitmap_height / rtp->atlas_.height);
-        coords_[c++] = Coord(x2 + w, -y2, rtp->atlas_.c[*p].tx + rtp->atlas_.c[*p].bitmap_width / rtp->atlas_.width, 0);
-        coords_[c++] = Coord(x2, -y2 - h, rtp->atlas_.c[*p].tx, rtp->atlas_.c[*p].bitmap_height / rtp->atlas_.height);
-        coords_[c++] = Coord(x2 + w, -y2 - h, rtp->atlas_.c[*p].tx + rtp->atlas_.c[*p].bitmap_width / rtp->atlas_.width,
-            rtp->atlas_.c[*p].bitmap_height / rtp->atlas_.height);
-    }
-
     shader->bind();
 
     //glActiveTexture(GL_TEXTURE0);
     glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, rtp->atlas_.texID);
+    bindAtlas();
 
     shader->setUniformValue("tex", 0);
+    shader->setUniformValue("atlasSize", static_cast<float>(rtp->width_), static_cast<float>(rtp->height_));
     shader->setUniformValue("color", color_);
     shader->setUniformValue("projMX", projMX);
     shader->setUniformValue("viewMX", viewMX);
 
     vbo.create();
     vbo.bind();
-    vbo.allocate(&coords_[0], 4 * c * static_cast<int>(sizeof(float)));
+    vbo.allocate(coords, 4 * num * static_cast<int>(sizeof(float)));
 
     va.bind();
     shader->enableAttributeArray(0);
     shader->setAttributeBuffer(0, GL_FLOAT, 0, 4);
 
-    glDrawArrays(GL_TRIANGLES, 0, c);
+    glDrawArrays(GL_TRIANGLES, 0, num);
     vbo.release();
     va.release();
 
@@ -274,6 +449,108 @@ void RenderText::render(const char* text, float posx, float posy, float sx, floa
     }
 }
 
+void RenderText::BeginLabels(int set)
+{
+    Labels& labels = labels_[set];
+    labels.data.clear();
+    labels.needUpload = true;
+}
+
+void RenderText::AddLabel(int set, float x, float y, float z, const char* text, const QColor& col, float scale,
+    int align)
+{
+    if (!initialized_) {
+        return;
+    }
+
+    const Layout& layout = getLayout(text);
+    float dx = 0.0f;
+    float dy = 0.0f;
+    if (align & ALIGN_RIGHT) {
+        dx = -layout.width * scale;
+    }
+    else if (align & ALIGN_HCENTER) {
+        dx = -0.5f * layout.width * scale;
+    }
+
+    if (align & ALIGN_TOP) {
+        dy = -static_cast<float>(fontSize_) * scale;
+    }
+    else if (align & ALIGN_VCENTER) {
+        dy = -0.5f * fontSize_ * scale;
+    }
+
+    // Every vertex carries its anchor; the shader adds the glyph offset in pixels after projection.
+    Labels& labels = labels_[set];
+    for (size_t i = 0; i < layout.quads.size(); i++) {
+        const Coord& q = layout.quads[i];
+        float v[RENDERTEXT_LABEL_FLOATS] = { x, y, z, q.x * scale + dx, q.y * scale + dy, q.z, q.w,
+            static_cast<float>(col.redF()), static_cast<float>(col.greenF()), static_cast<float>(col.blueF()),
+            static_cast<float>(col.alphaF()) };
+        labels.data.insert(labels.data.end(), v, v + RENDERTEXT_LABEL_FLOATS);
+    }
+    labels.needUpload = true;
+}
+
+void RenderText::DrawLabels(int set, const QMatrix4x4& mvp)
+{
+    std::map<int, Labels>::iterator itr = labels_.find(set);
+    if (!initialized_ || labelShader == nullptr || itr == labels_.end() || itr->second.data.empty()) {
+        return;
+    }
+    Labels& labels = itr->second;
+
+    if (!labels.vbo.isCreated()) {
+        labels.vbo.setUsagePattern(QOpenGLBuffer::StaticDraw);
+        if (!labels.vbo.create()) {
+            fprintf(stderr, "Cannot create buffer for labels!\n");
+            return;
+        }
+    }
+    labels.vbo.bind();
+    if (labels.needUpload) {
+        labels.vbo.allocate(labels.data.data(), static_cast<int>(labels.data.size() * sizeof(float)));
+        labels.needUpload = false;
+    }
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    // Labels are hidden behind the scene, but do not hide each other.
+    glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glEnable(GL_DEPTH_TEST);
+    glDepthMask(GL_FALSE);
+
+    labelShader->bind();
+    glEnable(GL_TEXTURE_2D);
+    bindAtlas();
+    labelShader->setUniformValue("tex", 0);
+    labelShader->setUniformValue("atlasSize", static_cast<float>(rtp->width_), static_cast<float>(rtp->height_));
+    labelShader->setUniformValue("winSize", static_cast<float>(viewport[2]), static_cast<float>(viewport[3]));
+    labelShader->setUniformValue("mvpMX", mvp);
+
+    va.bind();
+    int stride = RENDERTEXT_LABEL_FLOATS * static_cast<int>(sizeof(float));
+    labelShader->setAttributeBuffer(0, GL_FLOAT, 0, 3, stride);
+    labelShader->setAttributeBuffer(1, GL_FLOAT, 3 * static_cast<int>(sizeof(float)), 4, stride);
+    labelShader->setAttributeBuffer(2, GL_FLOAT, 7 * static_cast<int>(sizeof(float)), 4, stride);
+    for (int i = 0; i < 3; i++) {
+        labelShader->enableAttributeArray(i);
+    }
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(labels.data.size() / RENDERTEXT_LABEL_FLOATS));
+    for (int i = 0; i < 3; i++) {
+        labelShader->disableAttributeArray(i);
+    }
+    va.release();
+    labels.vbo.release();
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    labelShader->release();
+    glPopAttrib();
+}
+
 void RenderText::printf(float x, float y, const char* fmt, ...)
 {
     va_list ap;
@@ -387,73 +664,25 @@ bool RenderText::init()
     FT_Set_Pixel_Sizes(rtp->face_, 0, fontSize_);
     rtp->g_ = rtp->face_->glyph;
 
-    int minw = 0;
-    int minh = 0;
-    memset(rtp->atlas_.c, 0, sizeof(rtp->atlas_.c));
-
-    for (int i = 32; i < 128; i++) {
-        if (FT_Load_Char(rtp->face_, i, FT_LOAD_RENDER)) {
-            char msg[1024];
-#ifdef _WIN32
-            sprintf_s(msg, "Loading character %c failed.", i);
-#else
-            sprintf(msg, "Loading character %c failed.", i);
-#endif
-            fprintf(stderr, "@ %s (%d): %s\n", __FILE__, __LINE__, msg);
-            continue;
-        }
-        minw += rtp->g_->bitmap.width + 1;
-        minh = std::max(minh, static_cast<int>(rtp->g_->bitmap.rows));
+    // Printable ASCII is ready from the start; any other glyph is added when first used.
+    for (unsigned int i = 32; i < 127; i++) {
+        rtp->getGlyph(i);
     }
 
-    rtp->atlas_.width = static_cast<float>(minw);
-    rtp->atlas_.height = static_cast<float>(minh);
-
-    glGenTextures(1, &rtp->atlas_.texID);
-
-    glBindTexture(GL_TEXTURE_2D, rtp->atlas_.texID);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // CLAMP_TO_BORDER?
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, minw, minh, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-    int offset = 0;
-    for (int i = 32; i < 128; i++) {
-        if (FT_Load_Char(rtp->face_, i, FT_LOAD_RENDER)) {
-            char msg[256];
-#ifdef _WIN32
-            sprintf_s(msg, "Loading character %c failed.", i);
-#else
-            sprintf(msg, "Loading character %c failed.", i);
-#endif
-            fprintf(stderr, "@ %s (%d): %s\n", __FILE__, __LINE__, msg);
-            continue;
-        }
-        glTexSubImage2D(GL_TEXTURE_2D, 0, offset, 0, rtp->g_->bitmap.width, rtp->g_->bitmap.rows, GL_RED,
-            GL_UNSIGNED_BYTE, rtp->g_->bitmap.buffer);
-
-        rtp->atlas_.c[i].adv_x = static_cast<float>(rtp->g_->advance.x >> 6);
-        rtp->atlas_.c[i].adv_y = static_cast<float>(rtp->g_->advance.y >> 6);
-        rtp->atlas_.c[i].bitmap_width = static_cast<float>(rtp->g_->bitmap.width);
-        rtp->atlas_.c[i].bitmap_height = static_cast<float>(rtp->g_->bitmap.rows);
-        rtp->atlas_.c[i].bitmap_left = static_cast<float>(rtp->g_->bitmap_left);
-        rtp->atlas_.c[i].bitmap_top = static_cast<float>(rtp->g_->bitmap_top);
-        rtp->atlas_.c[i].tx = offset / rtp->atlas_.width;
-        offset += rtp->g_->bitmap.width + 1;
-    }
-
-    // glGenerateMipmap(GL_TEXTURE_2D);
-    fprintf(stderr, "Generated a %d x %d (%d kb) texture atlas\n", minw, minh, minw * minh / 1024);
-
     shader = new QOpenGLShaderProgram();
     shader->addShaderFromSourceCode(QOpenGLShader::Vertex, getVertexShaderCode());
     shader->addShaderFromSourceCode(QOpenGLShader::Fragment, getFragmentShaderCode());
     shader->link();
     std::cerr << shader->log().toStdString() << std::endl;
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    labelShader = new QOpenGLShaderProgram();
+    labelShader->addShaderFromSourceCode(QOpenGLShader::Vertex, getLabelVertexShaderCode());
+    labelShader->addShaderFromSourceCode(QOpenGLShader::Fragment, getLabelFragmentShaderCode());
+    if (!labelShader->link()) {
+        fprintf(stderr, "Cannot link label shader!\n");
+        delete labelShader;
+        labelShader = nullptr;
+    }
 
     vbo.create();
     vbo.bind();
@@ -465,17 +694,62 @@ bool RenderText::init()
 
 void RenderText::clear()
 {
-    if (rtp != nullptr && rtp->atlas_.texID > 0) {
-        glDeleteTextures(1, &rtp->atlas_.texID);
+    if (rtp != nullptr && rtp->texID_ > 0) {
+        glDeleteTextures(1, &rtp->texID_);
     }
 
     if (rtp != nullptr) {
-        delete[] rtp;
+        delete rtp;
         rtp = nullptr;
     }
 
     vbo.destroy();
     va.destroy();
+    layouts_.clear();
+    batch_.clear();
+
+    std::map<int, Labels>::iterator itr = labels_.begin();
+    while (itr != labels_.end()) {
+        itr->second.vbo.destroy();
+        ++itr;
+    }
+    labels_.clear();
+
+    delete shader;
+    shader = nullptr;
+    delete labelShader;
+    labelShader = nullptr;
+}
+
+void RenderText::bindAtlas()
+{
+    if (rtp->texID_ == 0) {
+        glGenTextures(1, &rtp->texID_);
+        glBindTexture(GL_TEXTURE_2D, rtp->texID_);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        rtp->resized_ = true;
+    }
+    else {
+        glBindTexture(GL_TEXTURE_2D, rtp->texID_);
+    }
+
+    // Texture coordinates are given in pixels, so neither layouts nor labels change when the atlas grows.
+    if (rtp->resized_ || rtp->dirty_) {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        if (rtp->resized_) {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, rtp->width_, rtp->height_, 0, GL_RED, GL_UNSIGNED_BYTE,
+                rtp->pixels_.data());
+        }
+        else {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, rtp->width_, rtp->height_, GL_RED, GL_UNSIGNED_BYTE,
+                rtp->pixels_.data());
+        }
+        rtp->resized_ = false;
+        rtp->dirty_ = false;
+    }
 }
 
 QString RenderText::getVertexShaderCode()
@@ -484,11 +758,12 @@ QString RenderText::getVertexShaderCode()
     vert += "#version 330\n\n";
     vert += "uniform mat4 projMX;\n";
     vert += "uniform mat4 viewMX;\n";
+    vert += "uniform vec2 atlasSize;\n";
     vert += "layout(location = 0) in  vec4 coord;\n";
     vert += "out vec2 texpos;\n";
     vert += "void main(void) {\n";
     vert += "    gl_Position = projMX * viewMX * vec4(coord.xy, 0, 1);\n";
-    vert += "    texpos = coord.zw;\n";
+    vert += "    texpos = coord.zw / atlasSize;\n";
     vert += "}\n";
     return vert;
 }
@@ -508,4 +783,40 @@ QString RenderText::getFragmentShaderCode()
     return frag;
 }
 
+QString RenderText::getLabelVertexShaderCode()
+{
+    QString vert;
+    vert += "#version 330\n\n";
+    vert += "uniform mat4 mvpMX;\n";
+    vert += "uniform vec2 winSize;\n";
+    vert += "uniform vec2 atlasSize;\n";
+    vert += "layout(location = 0) in  vec3 anchor;\n";
+    vert += "layout(location = 1) in  vec4 coord;\n";
+    vert += "layout(location = 2) in  vec4 color;\n";
+    vert += "out vec2 texpos;\n";
+    vert += "out vec4 labelColor;\n";
+    vert += "void main(void) {\n";
+    vert += "    vec4 pos = mvpMX * vec4(anchor, 1);\n";
+    vert += "    pos.xy += 2.0 * coord.xy / winSize * pos.w;\n";
+    vert += "    gl_Position = pos;\n";
+    vert += "    texpos = coord.zw / atlasSize;\n";
+    vert += "    labelColor = color;\n";
+    vert += "}\n";
+    return vert;
+}
+
+QString RenderText::getLabelFragmentShaderCode()
+{
+    QString frag;
+    frag += "#version 330\n\n";
+    frag += "uniform sampler2D tex;\n";
+    frag += "in vec2 texpos;\n";
+    frag += "in vec4 labelColor;\n";
+    frag += "layout(location = 0) out vec4 out_frag_color;\n";
+    frag += "void main(void) {\n";
+    frag += "  out_frag_color = vec4(1, 1, 1, texture(tex, texpos).r) * labelColor;\n";
+    frag += "}\n";
+    return frag;
+}
+
 #endif // HAVE_FREETYPE
@@ -4,6 +4,10 @@
  *
  * @brief  Render text in OpenGL.
  *
+ * Glyphs of any code point of UTF-8 text are rasterized into an atlas the
+ * first time they are used; the atlas grows as needed. Laid-out strings are
+ * cached, so batched text and labels only copy their glyph quads.
+ *
  * This file is part of GeodesicView.
  */
 #ifndef RENDER_TEXT_H
@@ -11,8 +15,12 @@
 
 #include <cstring>
 #include <iostream>
+#include <map>
+#include <string>
+#include <vector>
 
 #include <QColor>
+#include <QMatrix4x4>
 #include <QOpenGLBuffer>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLVertexArrayObject>
@@ -31,6 +39,17 @@
 #define ALIGN_BOTTOM 0x0040
 #define ALIGN_VCENTER 0x0080
 
+// Number of laid out strings kept for batched printing
+#define RENDERTEXT_MAX_LAYOUTS 1024
+
+// Glyph atlas: fixed width, initial and maximum height in pixels
+#define RENDERTEXT_ATLAS_WIDTH 512
+#define RENDERTEXT_ATLAS_MIN_HEIGHT 64
+#define RENDERTEXT_ATLAS_MAX_HEIGHT 4096
+
+// Floats per label vertex: anchor, pixel offset, atlas position, color
+#define RENDERTEXT_LABEL_FLOATS 11
+
 class RenderTextPimpl;
 
 class RenderText
@@ -88,6 +107,54 @@ public:
 
     void Print(const int px, const int py, int align, const char* fmt, ...);
 
+    /**
+     * @brief Start collecting text for one batched draw call.
+     */
+    void BeginBatch();
+
+    /**
+     * @brief Add text at position (px,py) to the batch.
+     *   The glyph quads of a string are laid out once and reused. Rotation is ignored.
+     * @param px    Horizontal pixel coordinate from left.
+     * @param py    Vertical pixel coordinate from bottom.
+     * @param text
+     * @param align
+     */
+    void AddToBatch(const int px, const int py, const char* text, int align = ALIGN_LEFT);
+
+    /**
+     * @brief Draw all text of the batch with one call.
+     */
+    void DrawBatch();
+
+    /**
+     * @brief Remove all labels of a set.
+     *   A set keeps its labels on the GPU until it is cleared again.
+     * @param set   Id of label set.
+     */
+    void BeginLabels(int set);
+
+    /**
+     * @brief Add text anchored at a 3D point; it always faces the viewer and keeps its size in pixels.
+     * @param set    Id of label set.
+     * @param x      Anchor position.
+     * @param y
+     * @param z
+     * @param text   UTF-8 text.
+     * @param col    Text color.
+     * @param scale  Size relative to the font size.
+     * @param align  Alignment relative to the anchor.
+     */
+    void AddLabel(int set, float x, float y, float z, const char* text, const QColor& col, float scale = 1.0f,
+        int align = ALIGN_LEFT);
+
+    /**
+     * @brief Draw all labels of a set with one call into the current viewport.
+     * @param set  Id of label set.
+     * @param mvp  Projection times modelview matrix.
+     */
+    void DrawLabels(int set, const QMatrix4x4& mvp);
+
     /**
      * @brief Set rotation angle.
      * @param angle [degree]
@@ -107,6 +174,8 @@ protected:
 
     QString getVertexShaderCode();
     QString getFragmentShaderCode();
+    QString getLabelVertexShaderCode();
+    QString getLabelFragmentShaderCode();
 
     typedef struct Coord_t {
         float x;
@@ -123,6 +192,22 @@ protected:
         }
     } Coord;
 
+    typedef struct Layout_t {
+        std::vector<Coord> quads; //!< glyph quads relative to the pen position
+        float width;
+    } Layout;
+
+    typedef struct Labels_t {
+        std::vector<float> data;
+        QOpenGLBuffer vbo;
+        bool needUpload;
+        Labels_t() { this->needUpload = false; }
+    } Labels;
+
+    const Layout& getLayout(const char* text);
+    void draw(const Coord* coords, int num, float posx, float posy);
+    void bindAtlas();
+
 private:
     std::string fontFilename_;
     unsigned int fontSize_;
@@ -136,9 +221,14 @@ private:
 
     QColor color_;
 
+    std::map<std::string, Layout> layouts_;
+    std::vector<Coord> batch_;
+    std::map<int, Labels> labels_;
+
     QOpenGLBuffer vbo;
     QOpenGLVertexArrayObject va;
     QOpenGLShaderProgram* shader;
+    QOpenGLShaderProgram* labelShader;
 };
 
 #endif // HAVE_FREETYPE
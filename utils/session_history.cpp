@@ -0,0 +1,283 @@
+/**
+ * @file    session_history.cpp
+ * @author  Thomas Mueller
+ *
+ * This file is part of GeodesicView.
+ */
+#include "session_history.h"
+
+#include <algorithm>
+
+#include <metric/m4dMetric.h>
+
+extern m4d::Object mObject;
+
+void storeSessionState(struct_session_state& state, struct_params* par, m4d::enum_break_condition breakCond)
+{
+    state.metricName = std::string();
+    state.metricParams.clear();
+    if (mObject.currMetric != nullptr) {
+        state.metricName = std::string(mObject.currMetric->getMetricName());
+
+        std::vector<std::string> paramNames;
+        mObject.currMetric->getParamNames(paramNames);
+        for (size_t i = 0; i < paramNames.size(); i++) {
+            double value = 0.0;
+            mObject.currMetric->getParam(paramNames[i].c_str(), value);
+            state.metricParams.push_back(value);
+        }
+    }
+
+    state.geodSolverType = mObject.geodSolverType;
+    state.maxNumPoints = mObject.maxNumPoints;
+    state.stepsize = mObject.stepsize;
+    state.epsAbs = mObject.epsAbs;
+    state.epsRel = mObject.epsRel;
+    state.stepsizeControlled = mObject.stepsizeControlled;
+
+    state.type = mObject.type;
+    state.startPos = mObject.startPos;
+    state.startDir = mObject.startDir;
+    state.coordDir = mObject.coordDir;
+    state.ksi = mObject.ksi;
+    state.chi = mObject.chi;
+    state.vel = mObject.vel;
+    state.timeDirection = mObject.timeDirection;
+    state.tetradType = mObject.tetradType;
+    for (int i = 0; i < 4; i++) {
+        state.base[i] = mObject.base[i];
+    }
+    state.boost_ksi = mObject.boost_ksi;
+    state.boost_chi = mObject.boost_chi;
+    state.boost_beta = mObject.boost_beta;
+
+    state.speed_of_light = mObject.speed_of_light;
+    state.grav_constant = mObject.grav_constant;
+    state.dielectric_perm = mObject.dielectric_perm;
+
+    if (par != nullptr) {
+        state.params = *par;
+    }
+
+    state.hasTrajectory = true;
+    state.breakCond = breakCond;
+    state.points = mObject.points;
+    state.dirs = mObject.dirs;
+    state.lambda = mObject.lambda;
+    state.sachs1 = mObject.sachs1;
+    state.sachs2 = mObject.sachs2;
+    state.jacobi = mObject.jacobi;
+    state.maxJacobi = mObject.maxJacobi;
+}
+
+void restoreSessionState(const struct_session_state& state)
+{
+    if (mObject.currMetric != nullptr) {
+        std::vector<std::string> paramNames;
+        mObject.currMetric->getParamNames(paramNames);
+        for (size_t i = 0; i < paramNames.size() && i < state.metricParams.size(); i++) {
+            mObject.currMetric->setParam(paramNames[i].c_str(), state.metricParams[i]);
+        }
+
+        std::map<std::string, double>::const_iterator itr = state.params.opengl_emb_params.begin();
+        while (itr != state.params.opengl_emb_params.end()) {
+            mObject.currMetric->setEmbeddingParam(itr->first.c_str(), itr->second);
+            ++itr;
+        }
+    }
+
+    mObject.geodSolverType = state.geodSolverType;
+    mObject.maxNumPoints = state.maxNumPoints;
+    mObject.stepsize = state.stepsize;
+    mObject.epsAbs = state.epsAbs;
+    mObject.epsRel = state.epsRel;
+    mObject.stepsizeControlled = state.stepsizeControlled;
+
+    mObject.type = state.type;
+    mObject.startPos = state.startPos;
+    mObject.startDir = state.startDir;
+    mObject.coordDir = state.coordDir;
+    mObject.ksi = state.ksi;
+    mObject.chi = state.chi;
+    mObject.vel = state.vel;
+    mObject.timeDirection = state.timeDirection;
+    mObject.tetradType = state.tetradType;
+    for (int i = 0; i < 4; i++) {
+        mObject.base[i] = state.base[i];
+    }
+    mObject.boost_ksi = state.boost_ksi;
+    mObject.boost_chi = state.boost_chi;
+    mObject.boost_beta = state.boost_beta;
+
+    mObject.speed_of_light = state.speed_of_light;
+    mObject.grav_constant = state.grav_constant;
+    mObject.dielectric_perm = state.dielectric_perm;
+}
+
+bool restoreSessionTrajectory(const struct_session_state& state)
+{
+    if (!state.hasTrajectory) {
+        return false;
+    }
+
+    mObject.points = state.points;
+    mObject.dirs = state.dirs;
+    mObject.lambda = state.lambda;
+    mObject.sachs1 = state.sachs1;
+    mObject.sachs2 = state.sachs2;
+    mObject.jacobi = state.jacobi;
+    mObject.maxJacobi = state.maxJacobi;
+    return true;
+}
+
+SessionHistory::SessionHistory(size_t maxStates, size_t maxTrajectories, size_t maxBytes)
+{
+    mCurrent = -1;
+    mMaxStates = std::max(static_cast<size_t>(1), maxStates);
+    mMaxTrajectories = maxTrajectories;
+    mMaxBytes = maxBytes;
+}
+
+SessionHistory::~SessionHistory()
+{
+    clear();
+}
+
+void SessionHistory::push(const struct_session_state& state)
+{
+    if (mCurrent >= 0 && isSamePhysics(mStates[static_cast<size_t>(mCurrent)], state)) {
+        mStates[static_cast<size_t>(mCurrent)] = state;
+        enforceBudget();
+        return;
+    }
+
+    // discard redo branch
+    while (static_cast<int>(mStates.size()) > mCurrent + 1) {
+        mStates.pop_back();
+    }
+
+    mStates.push_back(state);
+    while (mStates.size() > mMaxStates) {
+        mStates.pop_front();
+    }
+    mCurrent = static_cast<int>(mStates.size()) - 1;
+    enforceBudget();
+}
+
+bool SessionHistory::canUndo()
+{
+    return (mCurrent > 0);
+}
+
+bool SessionHistory::canRedo()
+{
+    return (mCurrent >= 0 && mCurrent + 1 < static_cast<int>(mStates.size()));
+}
+
+const struct_session_state* SessionHistory::undo()
+{
+    if (!canUndo()) {
+        return nullptr;
+    }
+    mCurrent--;
+    return &mStates[static_cast<size_t>(mCurrent)];
+}
+
+const struct_session_state* SessionHistory::redo()
+{
+    if (!canRedo()) {
+        return nullptr;
+    }
+    mCurrent++;
+    return &mStates[static_cast<size_t>(mCurrent)];
+}
+
+void SessionHistory::clear()
+{
+    mStates.clear();
+    mCurrent = -1;
+}
+
+bool SessionHistory::isSamePhysics(const struct_session_state& s1, const struct_session_state& s2)
+{
+    if (s1.metricName != s2.metricName || s1.metricParams != s2.metricParams) {
+        return false;
+    }
+
+    if (s1.geodSolverType != s2.geodSolverType || s1.maxNumPoints != s2.maxNumPoints || s1.stepsize != s2.stepsize
+        || s1.epsAbs != s2.epsAbs || s1.epsRel != s2.epsRel || s1.stepsizeControlled != s2.stepsizeControlled) {
+        return false;
+    }
+
+    if (s1.type != s2.type || s1.ksi != s2.ksi || s1.chi != s2.chi || s1.vel != s2.vel
+        || s1.timeDirection != s2.timeDirection || s1.tetradType != s2.tetradType) {
+        return false;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        if (s1.startPos.x(i) != s2.startPos.x(i)) {
+            return false;
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        if (s1.startDir.x(i) != s2.startDir.x(i)) {
+            return false;
+        }
+    }
+
+    return (s1.boost_ksi == s2.boost_ksi && s1.boost_chi == s2.boost_chi && s1.boost_beta == s2.boost_beta
+        && s1.speed_of_light == s2.speed_of_light && s1.grav_constant == s2.grav_constant
+        && s1.dielectric_perm == s2.dielectric_perm);
+}
+
+size_t SessionHistory::trajectoryBytes(const struct_session_state& state)
+{
+    if (!state.hasTrajectory) {
+        return 0;
+    }
+
+    return state.points.size() * sizeof(state.points[0]) + state.dirs.size() * sizeof(state.dirs[0])
+        + state.lambda.size() * sizeof(state.lambda[0]) + state.sachs1.size() * sizeof(state.sachs1[0])
+        + state.sachs2.size() * sizeof(state.sachs2[0]) + state.jacobi.size() * sizeof(state.jacobi[0]);
+}
+
+void SessionHistory::dropTrajectory(struct_session_state& state)
+{
+    state.hasTrajectory = false;
+    decltype(state.points)().swap(state.points);
+    decltype(state.dirs)().swap(state.dirs);
+    decltype(state.lambda)().swap(state.lambda);
+    decltype(state.sachs1)().swap(state.sachs1);
+    decltype(state.sachs2)().swap(state.sachs2);
+    decltype(state.jacobi)().swap(state.jacobi);
+}
+
+void SessionHistory::enforceBudget()
+{
+    // Keep trajectories of the states closest to the current one, the current state first.
+    size_t numKept = 0;
+    size_t bytes = 0;
+    int numStates = static_cast<int>(mStates.size());
+    for (int d = 0; d < numStates; d++) {
+        for (int sign = -1; sign <= 1; sign += 2) {
+            int idx = mCurrent + sign * d;
+            if (idx < 0 || idx >= numStates || (d == 0 && sign > 0)) {
+                continue;
+            }
+
+            struct_session_state& state = mStates[static_cast<size_t>(idx)];
+            if (!state.hasTrajectory) {
+                continue;
+            }
+
+            size_t b = trajectoryBytes(state);
+            if (d > 0 && (numKept >= mMaxTrajectories || bytes + b > mMaxBytes)) {
+                dropTrajectory(state);
+            }
+            else {
+                numKept++;
+                bytes += b;
+            }
+        }
+    }
+}
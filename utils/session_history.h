@@ -0,0 +1,143 @@
+/**
+ * @file    session_history.h
+ * @author  Thomas Mueller
+ *
+ * @brief  Undo/redo history of session states.
+ *
+ * A session state holds the metric with its parameters, the integrator
+ * settings, the local tetrad with its boost, the initial direction, and
+ * the view parameters. The most recent states additionally keep their
+ * integrated trajectory so that undo and redo need no recomputation.
+ *
+ * This file is part of GeodesicView.
+ */
+#ifndef SESSION_HISTORY_H
+#define SESSION_HISTORY_H
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <gdefs.h>
+
+#include <extra/m4dObject.h>
+#include <m4dGlobalDefs.h>
+
+// The member types mirror those of m4d::Object.
+typedef struct _struct_session_state {
+    std::string metricName;
+    std::vector<double> metricParams;
+
+    decltype(m4d::Object::geodSolverType) geodSolverType;
+    decltype(m4d::Object::maxNumPoints) maxNumPoints;
+    decltype(m4d::Object::stepsize) stepsize;
+    decltype(m4d::Object::epsAbs) epsAbs;
+    decltype(m4d::Object::epsRel) epsRel;
+    decltype(m4d::Object::stepsizeControlled) stepsizeControlled;
+
+    decltype(m4d::Object::type) type;
+    decltype(m4d::Object::startPos) startPos;
+    decltype(m4d::Object::startDir) startDir;
+    decltype(m4d::Object::coordDir) coordDir;
+    decltype(m4d::Object::ksi) ksi;
+    decltype(m4d::Object::chi) chi;
+    decltype(m4d::Object::vel) vel;
+    decltype(m4d::Object::timeDirection) timeDirection;
+    decltype(m4d::Object::tetradType) tetradType;
+    m4d::vec4 base[4];
+    decltype(m4d::Object::boost_ksi) boost_ksi;
+    decltype(m4d::Object::boost_chi) boost_chi;
+    decltype(m4d::Object::boost_beta) boost_beta;
+
+    decltype(m4d::Object::speed_of_light) speed_of_light;
+    decltype(m4d::Object::grav_constant) grav_constant;
+    decltype(m4d::Object::dielectric_perm) dielectric_perm;
+
+    struct_params params;
+
+    // integrated trajectory
+    bool hasTrajectory;
+    m4d::enum_break_condition breakCond;
+    decltype(m4d::Object::points) points;
+    decltype(m4d::Object::dirs) dirs;
+    decltype(m4d::Object::lambda) lambda;
+    decltype(m4d::Object::sachs1) sachs1;
+    decltype(m4d::Object::sachs2) sachs2;
+    decltype(m4d::Object::jacobi) jacobi;
+    decltype(m4d::Object::maxJacobi) maxJacobi;
+} struct_session_state;
+
+/**
+ * @brief Store the current session state.
+ * @param state    Reference to state.
+ * @param par      Pointer to view parameters.
+ * @param breakCond  Break condition of the current trajectory.
+ */
+void storeSessionState(struct_session_state& state, struct_params* par, m4d::enum_break_condition breakCond);
+
+/**
+ * @brief Copy the physical part of a session state back to the object.
+ *   The metric has to be set already; view parameters and trajectory are not touched.
+ * @param state  Reference to state.
+ */
+void restoreSessionState(const struct_session_state& state);
+
+/**
+ * @brief Copy the stored trajectory back to the object.
+ * @param state  Reference to state.
+ * @return true : state holds a trajectory.
+ */
+bool restoreSessionTrajectory(const struct_session_state& state);
+
+/**
+ * @brief The SessionHistory class
+ */
+class SessionHistory
+{
+public:
+    SessionHistory(size_t maxStates = DEF_HISTORY_MAX_STATES, size_t maxTrajectories = DEF_HISTORY_NUM_TRAJECTORIES,
+        size_t maxBytes = DEF_HISTORY_MAX_BYTES);
+    ~SessionHistory();
+
+public:
+    /**
+     * @brief Push a new state.
+     *   All states after the current one are discarded. If the physical part of the
+     *   state equals the current one, only the current state is replaced.
+     * @param state  Reference to state.
+     */
+    void push(const struct_session_state& state);
+
+    bool canUndo();
+    bool canRedo();
+
+    /**
+     * @brief Step back in history.
+     * @return pointer to previous state or nullptr.
+     */
+    const struct_session_state* undo();
+
+    /**
+     * @brief Step forward in history.
+     * @return pointer to next state or nullptr.
+     */
+    const struct_session_state* redo();
+
+    void clear();
+
+protected:
+    bool isSamePhysics(const struct_session_state& s1, const struct_session_state& s2);
+    size_t trajectoryBytes(const struct_session_state& state);
+    void dropTrajectory(struct_session_state& state);
+    void enforceBudget();
+
+private:
+    std::deque<struct_session_state> mStates;
+    int mCurrent;
+
+    size_t mMaxStates;
+    size_t mMaxTrajectories;
+    size_t mMaxBytes;
+};
+
+#endif // SESSION_HISTORY_H
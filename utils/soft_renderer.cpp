@@ -0,0 +1,921 @@
+/**
+ * @file    soft_renderer.cpp
+ * @author  Thomas Mueller
+ *
+ * This file is part of GeodesicView.
+ */
+#include "soft_renderer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+
+#ifdef __APPLE__
+#include <OpenGL/glu.h>
+#else
+#include <GL/glu.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define SOFT_AXES_SIZE 100
+#define SOFT_AXES_SLICES 32
+#define SOFT_AMBIENT 0.05f
+
+SoftRenderer::SoftRenderer()
+{
+    mWidth = mHeight = 0;
+    mDepthTest = true;
+    mViewport[0] = mViewport[1] = mViewport[2] = mViewport[3] = 0;
+}
+
+SoftRenderer::~SoftRenderer()
+{
+}
+
+bool SoftRenderer::render(struct_soft_job& job)
+{
+    job.ok = false;
+    if (job.width <= 0 || job.height <= 0) {
+        fprintf(stderr, "Image size is null!\n");
+        return false;
+    }
+
+    if (job.view == enum_soft_view_3d) {
+        render3d(job);
+    }
+    else {
+        render2d(job);
+    }
+
+    job.ok = mImage.save(job.filename);
+    if (!job.ok) {
+        fprintf(stderr, "Cannot write image %s!\n", job.filename.toLocal8Bit().constData());
+    }
+    return job.ok;
+}
+
+void SoftRenderer::render3d(const struct_soft_job& job)
+{
+    const struct_params& par = job.params;
+    resize(job.width, job.height);
+    clear(par.opengl_bg_color);
+    mDepthTest = true;
+
+    // Same frustum as Camera::perspective() and Camera::orthographic().
+    QVector3D pos(static_cast<float>(par.opengl_eye_pos[0]), static_cast<float>(par.opengl_eye_pos[1]),
+        static_cast<float>(par.opengl_eye_pos[2]));
+    QVector3D poi(static_cast<float>(par.opengl_eye_poi[0]), static_cast<float>(par.opengl_eye_poi[1]),
+        static_cast<float>(par.opengl_eye_poi[2]));
+    QVector3D vup(static_cast<float>(par.opengl_eye_vup[0]), static_cast<float>(par.opengl_eye_vup[1]),
+        static_cast<float>(par.opengl_eye_vup[2]));
+
+    float aspect = job.width / static_cast<float>(job.height);
+    float zNear = 0.01f;
+    float zFar = 10000.0f;
+
+    QMatrix4x4 proj;
+    if (par.opengl_projection == enum_proj_orthographic) {
+        float size = (pos - poi).length() * static_cast<float>(tan(0.5 * par.opengl_fov * DEG_TO_RAD));
+        proj.ortho(-size * aspect, size * aspect, -size, size, zNear, zFar);
+    }
+    else {
+        proj.perspective(static_cast<float>(par.opengl_fov), aspect, zNear, zFar);
+    }
+
+    QMatrix4x4 mv;
+    mv.lookAt(pos, poi, vup);
+    mv.scale(static_cast<float>(par.opengl_scale_x), static_cast<float>(par.opengl_scale_y),
+        static_cast<float>(par.opengl_scale_z));
+
+    setViewport(0, 0, job.width, job.height);
+    setMatrices(proj, mv);
+
+    if (job.embMesh != nullptr && job.embMesh->numStrips > 0) {
+        drawEmbedding(*job.embMesh, par.opengl_emb_color);
+    }
+
+    drawGeodesic(job, 3, par.opengl_line_color, par.opengl_line_width);
+
+    for (size_t i = 0; i < job.objects.size(); i++) {
+        if (job.objects[i].dim == enum_object_dim_3d) {
+            drawObject3d(job.objects[i], job.wiredObjs);
+        }
+    }
+
+    drawAxes(job);
+}
+
+void SoftRenderer::render2d(const struct_soft_job& job)
+{
+    const struct_params& par = job.params;
+    resize(job.width, job.height);
+    clear(Qt::black);
+    mDepthTest = false;
+
+    int left = DEF_DRAW2D_LEFT_BORDER;
+    int bottom = DEF_DRAW2D_BOTTOM_BORDER;
+    int plotWidth = std::max(1, job.width - left);
+    int plotHeight = std::max(1, job.height - bottom);
+
+    double range[4];
+    double step[2];
+    getPlotFrame(job, range, step);
+    double xMin = range[0];
+    double xMax = range[1];
+    double yMin = range[2];
+    double yMax = range[3];
+
+    int xStart = static_cast<int>(floor(xMin / step[0])) + 1;
+    int xEnd = static_cast<int>(floor(xMax / step[0])) + 1;
+    int yStart = static_cast<int>(floor(yMin / step[1])) + 1;
+    int yEnd = static_cast<int>(floor(yMax / step[1])) + 1;
+
+    QMatrix4x4 ident;
+    QMatrix4x4 proj;
+    QRgb white = qRgb(255, 255, 255);
+
+    // ticks
+    proj.ortho(static_cast<float>(xMin), static_cast<float>(xMax), 0.0f, 1.0f, -1.0f, 1.0f);
+    setViewport(left, 0, plotWidth, bottom);
+    setMatrices(proj, ident);
+    for (int x = xStart; x < xEnd; x++) {
+        float xp = static_cast<float>(x * step[0]);
+        drawLine(QVector3D(xp, 0.6f, 0.0f), QVector3D(xp, 1.0f, 0.0f), white, 1);
+    }
+
+    proj.setToIdentity();
+    proj.ortho(0.0f, 1.0f, static_cast<float>(yMin), static_cast<float>(yMax), -1.0f, 1.0f);
+    setViewport(0, bottom, left, plotHeight);
+    setMatrices(proj, ident);
+    for (int y = yStart; y < yEnd; y++) {
+        float yp = static_cast<float>(y * step[1]);
+        drawLine(QVector3D(0.6f, yp, 0.0f), QVector3D(1.0f, yp, 0.0f), white, 1);
+    }
+
+    // background
+    proj.setToIdentity();
+    proj.ortho(static_cast<float>(xMin), static_cast<float>(xMax), static_cast<float>(yMin),
+        static_cast<float>(yMax), -1.0f, 1.0f);
+    setViewport(left, bottom, plotWidth, plotHeight);
+    setMatrices(proj, ident);
+
+    QVector3D c0(static_cast<float>(xMin), static_cast<float>(yMin), 0.0f);
+    QVector3D c1(static_cast<float>(xMax), static_cast<float>(yMin), 0.0f);
+    QVector3D c2(static_cast<float>(xMax), static_cast<float>(yMax), 0.0f);
+    QVector3D c3(static_cast<float>(xMin), static_cast<float>(yMax), 0.0f);
+    drawTriangle(c0, c1, c2, par.draw2d_bg_color.rgb());
+    drawTriangle(c0, c2, c3, par.draw2d_bg_color.rgb());
+
+    // lattice
+    QRgb gridCol = par.draw2d_grid_color.rgb();
+    for (int x = xStart; x < xEnd; x++) {
+        float xp = static_cast<float>(x * step[0]);
+        drawLine(QVector3D(xp, c0.y(), 0.0f), QVector3D(xp, c2.y(), 0.0f), gridCol, 1, 0x1111);
+    }
+    for (int y = yStart; y < yEnd; y++) {
+        float yp = static_cast<float>(y * step[1]);
+        drawLine(QVector3D(c0.x(), yp, 0.0f), QVector3D(c2.x(), yp, 0.0f), gridCol, 1, 0x1111);
+    }
+    drawLine(QVector3D(0.0f, c0.y(), 0.0f), QVector3D(0.0f, c2.y(), 0.0f), gridCol, 1);
+    drawLine(QVector3D(c0.x(), 0.0f, 0.0f), QVector3D(c2.x(), 0.0f, 0.0f), gridCol, 1);
+
+    for (size_t i = 0; i < job.objects.size(); i++) {
+        if (job.objects[i].dim == enum_object_dim_2d) {
+            drawObject2d(job.objects[i]);
+        }
+    }
+
+    drawGeodesic(job, 2, par.draw2d_line_color, par.draw2d_line_width);
+
+    // effective potential and total energy as in OpenGL2dModel::paintGL_dynamic()
+    const std::vector<GLfloat>& pot = job.effPot;
+    for (size_t i = 0; i + 3 < pot.size(); i += 2) {
+        if (std::isfinite(pot[i + 1]) && std::isfinite(pot[i + 3])) {
+            drawLine(QVector3D(pot[i], pot[i + 1], 0.0f), QVector3D(pot[i + 2], pot[i + 3], 0.0f), qRgb(255, 0, 0), 1);
+        }
+    }
+    if (std::isfinite(job.effPotEnergy)) {
+        float k = static_cast<float>(job.effPotEnergy);
+        drawLine(QVector3D(c0.x(), k, 0.0f), QVector3D(c2.x(), k, 0.0f), qRgb(0, 0, 255), 1);
+    }
+}
+
+void SoftRenderer::getPlotFrame(const struct_soft_job& job, double* range, double* step)
+{
+    const struct_params& par = job.params;
+    int plotWidth = std::max(1, job.width - DEF_DRAW2D_LEFT_BORDER);
+    int plotHeight = std::max(1, job.height - DEF_DRAW2D_BOTTOM_BORDER);
+
+    // Keep the ordinate range and adapt the abscissa to the aspect ratio, as OpenGL2dModel::resizeGL() does.
+    double yMin = par.draw2d_yMin;
+    double yMax = par.draw2d_yMax;
+    double xCenter = 0.5 * (par.draw2d_xMin + par.draw2d_xMax);
+    double aspect = plotWidth / static_cast<double>(plotHeight);
+    double xMin = xCenter - 0.5 * (yMax - yMin) * aspect;
+    double xMax = xCenter + 0.5 * (yMax - yMin) * aspect;
+
+    // Lattice as in OpenGL2dModel::getTightLattice() followed by setLattice().
+    std::vector<double> steps;
+    for (int i = 0; i < dbl_draw2d_steps.size(); i++) {
+        steps.push_back(dbl_draw2d_steps[i].toDouble());
+    }
+    if (steps.empty()) {
+        steps.push_back(1.0);
+    }
+
+    double extent[2] = { xMax - xMin, yMax - yMin };
+    int numPix[2] = { plotWidth, plotHeight };
+    int numSteps[2] = { DEF_DRAW2D_X_STEP, DEF_DRAW2D_Y_STEP };
+    for (int k = 0; k < 2; k++) {
+        double pStep = extent[k] / static_cast<double>(numSteps[k]);
+        int idx = 0;
+        double minDist = 1e32;
+        for (int i = 0; i < static_cast<int>(steps.size()); i++) {
+            if (fabs(pStep - steps[static_cast<size_t>(i)]) < minDist) {
+                minDist = fabs(pStep - steps[static_cast<size_t>(i)]);
+                idx = i;
+            }
+        }
+
+        int pixStep = static_cast<int>(floor(steps[static_cast<size_t>(idx)] / (extent[k] / numPix[k])));
+        if (pixStep > 139) {
+            idx = std::max(idx - 1, 0);
+        }
+        else if (pixStep < 51) {
+            idx = std::min(idx + 1, static_cast<int>(steps.size()) - 1);
+        }
+        step[k] = steps[static_cast<size_t>(idx)];
+    }
+
+    range[0] = xMin;
+    range[1] = xMax;
+    range[2] = yMin;
+    range[3] = yMax;
+}
+
+QImage SoftRenderer::getImage()
+{
+    return mImage;
+}
+
+bool SoftRenderer::renderJobs(std::vector<struct_soft_job>& jobs, int numThreads)
+{
+    if (jobs.empty()) {
+        return true;
+    }
+    if (numThreads <= 0) {
+        numThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    numThreads = std::min(numThreads, static_cast<int>(jobs.size()));
+
+    // Each worker owns its renderer and fetches the next job.
+    std::atomic<size_t> next(0);
+    auto worker = [&jobs, &next]() {
+        SoftRenderer renderer;
+        size_t idx;
+        while ((idx = next++) < jobs.size()) {
+            renderer.render(jobs[idx]);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < numThreads; i++) {
+        threads.push_back(std::thread(worker));
+    }
+    worker();
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < jobs.size(); i++) {
+        ok = (ok && jobs[i].ok);
+    }
+    return ok;
+}
+
+void SoftRenderer::resize(int width, int height)
+{
+    if (width != mWidth || height != mHeight) {
+        mWidth = width;
+        mHeight = height;
+        mImage = QImage(width, height, QImage::Format_RGB32);
+        mDepth.resize(static_cast<size_t>(width) * static_cast<size_t>(height));
+    }
+    setViewport(0, 0, width, height);
+    mLocal.setToIdentity();
+}
+
+void SoftRenderer::clear(const QColor& col)
+{
+    mImage.fill(col.rgb());
+    clearDepth();
+}
+
+void SoftRenderer::clearDepth()
+{
+    std::fill(mDepth.begin(), mDepth.end(), 1.0f);
+}
+
+void SoftRenderer::setViewport(int x, int y, int width, int height)
+{
+    mViewport[0] = x;
+    mViewport[1] = y;
+    mViewport[2] = width;
+    mViewport[3] = height;
+}
+
+void SoftRenderer::setMatrices(const QMatrix4x4& proj, const QMatrix4x4& modelview)
+{
+    mProj = proj;
+    mModelView = modelview;
+    mLocal.setToIdentity();
+    mMVP = mProj * mModelView;
+}
+
+/**
+ * @brief Clip segment against the near plane z = -w.
+ * @return false if the segment is completely behind.
+ */
+static bool clipNear(QVector4D& c0, QVector4D& c1)
+{
+    float d0 = c0.z() + c0.w();
+    float d1 = c1.z() + c1.w();
+    if (d0 < 0.0f && d1 < 0.0f) {
+        return false;
+    }
+    if (d0 < 0.0f) {
+        c0 = c0 + (c1 - c0) * (d0 / (d0 - d1));
+    }
+    else if (d1 < 0.0f) {
+        c1 = c1 + (c0 - c1) * (d1 / (d1 - d0));
+    }
+    return true;
+}
+
+bool SoftRenderer::toWindow(const QVector4D& clip, QVector3D& win)
+{
+    if (clip.w() <= 0.0f) {
+        return false;
+    }
+    float iw = 1.0f / clip.w();
+    win.setX(mViewport[0] + 0.5f * (clip.x() * iw + 1.0f) * mViewport[2]);
+    win.setY(mViewport[1] + 0.5f * (clip.y() * iw + 1.0f) * mViewport[3]);
+    win.setZ(0.5f * (clip.z() * iw + 1.0f));
+    return true;
+}
+
+void SoftRenderer::drawLine(const QVector3D& p0, const QVector3D& p1, QRgb col, int width, ushort stipple)
+{
+    QMatrix4x4 mvp = mMVP * mLocal;
+    QVector4D c0 = mvp * QVector4D(p0, 1.0f);
+    QVector4D c1 = mvp * QVector4D(p1, 1.0f);
+    QVector3D w0, w1;
+    if (!clipNear(c0, c1) || !toWindow(c0, w0) || !toWindow(c1, w1)) {
+        return;
+    }
+
+    // Liang-Barsky against the viewport extended by the line width.
+    float ext = 0.5f * width + 1.0f;
+    float xmin = mViewport[0] - ext;
+    float xmax = mViewport[0] + mViewport[2] + ext;
+    float ymin = mViewport[1] - ext;
+    float ymax = mViewport[1] + mViewport[3] + ext;
+    QVector3D d = w1 - w0;
+    float t0 = 0.0f, t1 = 1.0f;
+    float p[4] = { -d.x(), d.x(), -d.y(), d.y() };
+    float q[4] = { w0.x() - xmin, xmax - w0.x(), w0.y() - ymin, ymax - w0.y() };
+    for (int k = 0; k < 4; k++) {
+        if (p[k] == 0.0f) {
+            if (q[k] < 0.0f) {
+                return;
+            }
+            continue;
+        }
+        float t = q[k] / p[k];
+        if (p[k] < 0.0f) {
+            t0 = std::max(t0, t);
+        }
+        else {
+            t1 = std::min(t1, t);
+        }
+    }
+    if (t0 > t1) {
+        return;
+    }
+
+    QVector3D a = w0 + d * t0;
+    QVector3D b = w0 + d * t1;
+    QVector3D ab = b - a;
+    bool xMajor = (fabs(ab.x()) >= fabs(ab.y()));
+    int numSteps = static_cast<int>(ceil(std::max(fabs(ab.x()), fabs(ab.y()))));
+    int w = std::max(1, width);
+    int offset = (w - 1) / 2;
+
+    for (int i = 0; i <= numSteps; i++) {
+        if (((stipple >> (i & 15)) & 1) == 0) {
+            continue;
+        }
+        float t = (numSteps > 0 ? i / static_cast<float>(numSteps) : 0.0f);
+        QVector3D pt = a + ab * t;
+        int px = static_cast<int>(floor(pt.x()));
+        int py = static_cast<int>(floor(pt.y()));
+        for (int k = 0; k < w; k++) {
+            if (xMajor) {
+                plotSpan(px, px, py + k - offset, pt.z(), col);
+            }
+            else {
+                plotSpan(px + k - offset, px + k - offset, py, pt.z(), col);
+            }
+        }
+    }
+}
+
+void SoftRenderer::drawPoint(const QVector3D& p, QRgb col, int size)
+{
+    QVector4D c = mMVP * mLocal * QVector4D(p, 1.0f);
+    QVector3D win;
+    if (c.z() + c.w() < 0.0f || !toWindow(c, win)) {
+        return;
+    }
+    int s = std::max(1, size);
+    int x0 = static_cast<int>(floor(win.x() - 0.5f * s + 0.5f));
+    int y0 = static_cast<int>(floor(win.y() - 0.5f * s + 0.5f));
+    for (int y = y0; y < y0 + s; y++) {
+        plotSpan(x0, x0 + s - 1, y, win.z(), col);
+    }
+}
+
+void SoftRenderer::drawTriangle(const QVector3D& p0, const QVector3D& p1, const QVector3D& p2, QRgb col)
+{
+    QMatrix4x4 mvp = mMVP * mLocal;
+    QVector4D in[3] = { mvp * QVector4D(p0, 1.0f), mvp * QVector4D(p1, 1.0f), mvp * QVector4D(p2, 1.0f) };
+
+    // Sutherland-Hodgman against the near plane yields at most four vertices.
+    QVector4D poly[4];
+    int num = 0;
+    for (int i = 0; i < 3; i++) {
+        const QVector4D& a = in[i];
+        const QVector4D& b = in[(i + 1) % 3];
+        float da = a.z() + a.w();
+        float db = b.z() + b.w();
+        if (da >= 0.0f) {
+            poly[num++] = a;
+        }
+        if ((da >= 0.0f) != (db >= 0.0f)) {
+            poly[num++] = a + (b - a) * (da / (da - db));
+        }
+    }
+
+    QVector3D win[4];
+    for (int i = 0; i < num; i++) {
+        if (!toWindow(poly[i], win[i])) {
+            return;
+        }
+    }
+
+    int vx0 = mViewport[0];
+    int vy0 = mViewport[1];
+    int vx1 = std::min(mViewport[0] + mViewport[2], mWidth) - 1;
+    int vy1 = std::min(mViewport[1] + mViewport[3], mHeight) - 1;
+
+    for (int t = 1; t + 1 < num; t++) {
+        const QVector3D& a = win[0];
+        const QVector3D& b = win[t];
+        const QVector3D& c = win[t + 1];
+        float area = (b.x() - a.x()) * (c.y() - a.y()) - (b.y() - a.y()) * (c.x() - a.x());
+        if (fabs(area) < 1e-12f) {
+            continue;
+        }
+
+        int xmin = std::max(vx0, static_cast<int>(floor(std::min(a.x(), std::min(b.x(), c.x())))));
+        int xmax = std::min(vx1, static_cast<int>(ceil(std::max(a.x(), std::max(b.x(), c.x())))));
+        int ymin = std::max(vy0, static_cast<int>(floor(std::min(a.y(), std::min(b.y(), c.y())))));
+        int ymax = std::min(vy1, static_cast<int>(ceil(std::max(a.y(), std::max(b.y(), c.y())))));
+
+        for (int y = ymin; y <= ymax; y++) {
+            float py = y + 0.5f;
+            for (int x = xmin; x <= xmax; x++) {
+                float px = x + 0.5f;
+                float w0 = ((b.x() - px) * (c.y() - py) - (b.y() - py) * (c.x() - px)) / area;
+                float w1 = ((c.x() - px) * (a.y() - py) - (c.y() - py) * (a.x() - px)) / area;
+                float w2 = 1.0f - w0 - w1;
+                if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) {
+                    continue;
+                }
+                plotSpan(x, x, y, w0 * a.z() + w1 * b.z() + w2 * c.z(), col);
+            }
+        }
+    }
+}
+
+void SoftRenderer::drawShadedTriangle(const QVector3D& p0, const QVector3D& p1, const QVector3D& p2, const float* col)
+{
+    // Two-sided diffuse lighting with the light source at the eye.
+    QMatrix4x4 mv = mModelView * mLocal;
+    QVector3D e0 = mv.map(p0);
+    QVector3D n = QVector3D::crossProduct(mv.map(p1) - e0, mv.map(p2) - e0);
+    float diff = 1.0f;
+    if (n.lengthSquared() > 0.0f && e0.lengthSquared() > 0.0f) {
+        diff = fabs(QVector3D::dotProduct(n.normalized(), e0.normalized()));
+    }
+    float f = std::min(1.0f, SOFT_AMBIENT + diff);
+    drawTriangle(p0, p1, p2,
+        qRgb(static_cast<int>(255.0f * f * col[0]), static_cast<int>(255.0f * f * col[1]),
+            static_cast<int>(255.0f * f * col[2])));
+}
+
+void SoftRenderer::drawQuad(const QVector3D& p0, const QVector3D& p1, const QVector3D& p2, const QVector3D& p3,
+    const float* col, bool wired)
+{
+    if (wired) {
+        QRgb rgb = qRgb(static_cast<int>(255.0f * col[0]), static_cast<int>(255.0f * col[1]),
+            static_cast<int>(255.0f * col[2]));
+        drawLine(p0, p1, rgb, 1);
+        drawLine(p1, p2, rgb, 1);
+        drawLine(p2, p3, rgb, 1);
+        drawLine(p3, p0, rgb, 1);
+        return;
+    }
+    drawShadedTriangle(p0, p1, p2, col);
+    drawShadedTriangle(p0, p2, p3, col);
+}
+
+void SoftRenderer::drawGeodesic(const struct_soft_job& job, int numComps, const QColor& col, int width)
+{
+    size_t numVerts = job.verts.size() / static_cast<size_t>(numComps);
+    const GLfloat* v = job.verts.data();
+    QRgb rgb = col.rgb();
+
+    for (size_t i = 0; i < numVerts; i++) {
+        QVector3D p(v[0], v[1], (numComps > 2 ? v[2] : 0.0f));
+        if (job.style == enum_draw_points) {
+            drawPoint(p, rgb, width);
+        }
+        else if (i + 1 < numVerts) {
+            const GLfloat* u = v + numComps;
+            drawLine(p, QVector3D(u[0], u[1], (numComps > 2 ? u[2] : 0.0f)), rgb, width);
+        }
+        v += numComps;
+    }
+}
+
+void SoftRenderer::drawEmbedding(const struct_emb_mesh& mesh, const QColor& col)
+{
+    // Outlines of the quad strips, as with polygon mode GL_LINE.
+    QRgb rgb = col.rgb();
+    const GLfloat* v = mesh.verts.data();
+    for (GLsizei s = 0; s < mesh.numStrips; s++) {
+        const GLuint* idx = mesh.indices.data() + static_cast<size_t>(s * (mesh.stripLength + 1));
+        for (GLsizei i = 0; i + 1 < mesh.stripLength; i += 2) {
+            QVector3D a(v[3 * idx[i]], v[3 * idx[i] + 1], v[3 * idx[i] + 2]);
+            QVector3D b(v[3 * idx[i + 1]], v[3 * idx[i + 1] + 1], v[3 * idx[i + 1] + 2]);
+            drawLine(a, b, rgb, 1);
+            if (i + 3 < mesh.stripLength) {
+                QVector3D c(v[3 * idx[i + 2]], v[3 * idx[i + 2] + 1], v[3 * idx[i + 2] + 2]);
+                QVector3D d(v[3 * idx[i + 3]], v[3 * idx[i + 3] + 1], v[3 * idx[i + 3] + 2]);
+                drawLine(a, c, rgb, 1);
+                drawLine(b, d, rgb, 1);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Rotation that maps the z-axis onto 'dir', as used by MyObject for disks and cylinders.
+ */
+static void alignToZ(QMatrix4x4& mat, const QVector3D& dir)
+{
+    QVector3D zup(0.0f, 0.0f, 1.0f);
+    QVector3D right = QVector3D::crossProduct(zup, dir);
+    if (right.lengthSquared() > 0.0f) {
+        float angle = static_cast<float>(acos(std::max(-1.0f, std::min(1.0f, QVector3D::dotProduct(zup, dir))))
+            * RAD_TO_DEG);
+        mat.rotate(angle, right.normalized());
+    }
+}
+
+void SoftRenderer::drawObject3d(const struct_obj& obj, bool wired)
+{
+    const double* val = obj.val;
+    const float* col = obj.color;
+    QRgb rgb = qRgb(static_cast<int>(255.0f * col[0]), static_cast<int>(255.0f * col[1]),
+        static_cast<int>(255.0f * col[2]));
+    bool quadWired = (wired || obj.style == GLU_LINE);
+    mLocal.setToIdentity();
+
+    switch (obj.type) {
+        default:
+            break;
+        case enum_object_sphere3d: {
+            mLocal.translate(static_cast<float>(val[0]), static_cast<float>(val[1]), static_cast<float>(val[2]));
+            int slices = std::max(3, static_cast<int>(val[4]));
+            int stacks = std::max(2, static_cast<int>(val[5]));
+            float r = static_cast<float>(val[3]);
+            for (int i = 0; i < stacks; i++) {
+                double rho[2] = { M_PI * i / stacks, M_PI * (i + 1) / stacks };
+                for (int j = 0; j < slices; j++) {
+                    double theta[2] = { 2.0 * M_PI * j / slices, 2.0 * M_PI * (j + 1) / slices };
+                    QVector3D p[4];
+                    for (int k = 0; k < 4; k++) {
+                        double rh = rho[(k == 1 || k == 2) ? 1 : 0];
+                        double th = theta[(k >= 2) ? 1 : 0];
+                        p[k] = r
+                            * QVector3D(static_cast<float>(sin(rh) * cos(th)), static_cast<float>(sin(rh) * sin(th)),
+                                static_cast<float>(cos(rh)));
+                    }
+                    drawQuad(p[0], p[1], p[2], p[3], col, quadWired);
+                }
+            }
+            break;
+        }
+        case enum_object_box3d: {
+            QVector3D c(static_cast<float>(val[0]), static_cast<float>(val[1]), static_cast<float>(val[2]));
+            QVector3D h(static_cast<float>(0.5 * val[3]), static_cast<float>(0.5 * val[4]),
+                static_cast<float>(0.5 * val[5]));
+            const float sx[4] = { -1.0f, 1.0f, 1.0f, -1.0f };
+            const float sy[4] = { -1.0f, -1.0f, 1.0f, 1.0f };
+            QVector3D p[8];
+            for (int k = 0; k < 8; k++) {
+                p[k] = c + QVector3D(sx[k % 4] * h.x(), sy[k % 4] * h.y(), (k < 4 ? -h.z() : h.z()));
+            }
+            int width = static_cast<int>(val[6]);
+            for (int k = 0; k < 4; k++) {
+                drawLine(p[k], p[(k + 1) % 4], rgb, width);
+                drawLine(p[k + 4], p[(k + 1) % 4 + 4], rgb, width);
+                drawLine(p[k], p[k + 4], rgb, width);
+            }
+            break;
+        }
+        case enum_object_line3d: {
+            drawLine(QVector3D(static_cast<float>(val[0]), static_cast<float>(val[1]), static_cast<float>(val[2])),
+                QVector3D(static_cast<float>(val[3]), static_cast<float>(val[4]), static_cast<float>(val[5])), rgb,
+                static_cast<int>(val[6]));
+            break;
+        }
+        case enum_object_plane3d: {
+            QVector3D a(static_cast<float>(val[0]), static_cast<float>(val[1]), static_cast<float>(val[2]));
+            QVector3D b(static_cast<float>(val[3]), static_cast<float>(val[4]), static_cast<float>(val[5]));
+            QVector3D d(static_cast<float>(val[6]), static_cast<float>(val[7]), static_cast<float>(val[8]));
+            if (obj.lighted || wired) {
+                drawQuad(a, b, b + d - a, d, col, wired);
+            }
+            else {
+                drawTriangle(a, b, b + d - a, rgb);
+                drawTriangle(a, b + d - a, d, rgb);
+            }
+            break;
+        }
+        case enum_object_disk3d: {
+            QVector3D dir(static_cast<float>(val[3]), static_cast<float>(val[4]), static_cast<float>(val[5]));
+            if (dir.isNull()) {
+                break;
+            }
+            mLocal.translate(static_cast<float>(val[0]), static_cast<float>(val[1]), static_cast<float>(val[2]));
+            alignToZ(mLocal, dir.normalized());
+            int slices = std::max(3, static_cast<int>(val[8]));
+            int loops = std::max(1, static_cast<int>(val[9]));
+            for (int i = 0; i < loops; i++) {
+                double r[2] = { val[6] + (val[7] - val[6]) * i / loops, val[6] + (val[7] - val[6]) * (i + 1) / loops };
+                for (int j = 0; j < slices; j++) {
+                    double phi[2] = { 2.0 * M_PI * j / slices, 2.0 * M_PI * (j + 1) / slices };
+                    QVector3D p[4];
+                    for (int k = 0; k < 4; k++) {
+                        double rk = r[(k == 1 || k == 2) ? 1 : 0];
+                        double pk = phi[(k >= 2) ? 1 : 0];
+                        p[k] = QVector3D(static_cast<float>(rk * cos(pk)), static_cast<float>(rk * sin(pk)), 0.0f);
+                    }
+                    drawQuad(p[0], p[1], p[2], p[3], col, quadWired);
+                }
+            }
+            break;
+        }
+        case enum_object_cylinder3d: {
+            QVector3D dir(static_cast<float>(val[3] - val[0]), static_cast<float>(val[4] - val[1]),
+                static_cast<float>(val[5] - val[2]));
+            if (dir.isNull()) {
+                break;
+            }
+            double height = dir.length();
+            mLocal.translate(static_cast<float>(val[0]), static_cast<float>(val[1]), static_cast<float>(val[2]));
+            alignToZ(mLocal, dir.normalized());
+            int slices = std::max(3, static_cast<int>(val[8]));
+            int stacks = std::max(1, static_cast<int>(val[9]));
+            for (int i = 0; i < stacks; i++) {
+                double z[2] = { height * i / stacks, height * (i + 1) / stacks };
+                double r[2]
+                    = { val[6] + (val[7] - val[6]) * i / stacks, val[6] + (val[7] - val[6]) * (i + 1) / stacks };
+                for (int j = 0; j < slices; j++) {
+                    double phi[2] = { 2.0 * M_PI * j / slices, 2.0 * M_PI * (j + 1) / slices };
+                    QVector3D p[4];
+                    for (int k = 0; k < 4; k++) {
+                        int s = ((k == 1 || k == 2) ? 1 : 0);
+                        double pk = phi[(k >= 2) ? 1 : 0];
+                        p[k] = QVector3D(static_cast<float>(r[s] * cos(pk)), static_cast<float>(r[s] * sin(pk)),
+                            static_cast<float>(z[s]));
+                    }
+                    drawQuad(p[0], p[1], p[2], p[3], col, quadWired);
+                }
+            }
+            break;
+        }
+        case enum_object_torus3d: {
+            mLocal.translate(static_cast<float>(val[0]), static_cast<float>(val[1]), static_cast<float>(val[2]));
+            mLocal.rotate(static_cast<float>(val[4]), 0.0f, 0.0f, 1.0f);
+            mLocal.rotate(static_cast<float>(-val[3]), 1.0f, 0.0f, 0.0f);
+            double alphaStep = 2.0 * M_PI / std::max(3.0, val[8]);
+            double betaStep = 2.0 * M_PI / std::max(3.0, val[9]);
+            double maxPhi = val[7] * DEG_TO_RAD;
+            for (double alpha = 0.0; alpha < maxPhi; alpha += alphaStep) {
+                for (double beta = 0.0; beta < 2.0 * M_PI; beta += betaStep) {
+                    QVector3D p[4];
+                    for (int k = 0; k < 4; k++) {
+                        double a = alpha + ((k == 1 || k == 2) ? alphaStep : 0.0);
+                        double b = beta + ((k >= 2) ? betaStep : 0.0);
+                        p[k] = QVector3D(static_cast<float>((val[5] + val[6] * cos(b)) * cos(a)),
+                            static_cast<float>((val[5] + val[6] * cos(b)) * sin(a)),
+                            static_cast<float>(val[6] * sin(b)));
+                    }
+                    drawQuad(p[0], p[1], p[2], p[3], col, wired);
+                }
+            }
+            break;
+        }
+        case enum_object_tube3d: {
+            QVector3D base(static_cast<float>(val[0]), static_cast<float>(val[1]), static_cast<float>(val[2]));
+            QVector3D e1(static_cast<float>(val[3]), static_cast<float>(val[4]), static_cast<float>(val[5]));
+            QVector3D e2(static_cast<float>(val[6]), static_cast<float>(val[7]), static_cast<float>(val[8]));
+            QVector3D e3(static_cast<float>(val[9]), static_cast<float>(val[10]), static_cast<float>(val[11]));
+            int slices = std::max(3, static_cast<int>(val[12]));
+            int stacks = std::max(1, static_cast<int>(val[13]));
+            for (int i = 0; i < stacks; i++) {
+                float l[2] = { i / static_cast<float>(stacks), (i + 1) / static_cast<float>(stacks) };
+                for (int j = 0; j < slices; j++) {
+                    double phi[2] = { 2.0 * M_PI * j / slices, 2.0 * M_PI * (j + 1) / slices };
+                    QVector3D p[4];
+                    for (int k = 0; k < 4; k++) {
+                        double pk = phi[(k >= 2) ? 1 : 0];
+                        p[k] = base + e1 * static_cast<float>(cos(pk)) + e2 * static_cast<float>(sin(pk))
+                            + e3 * l[(k == 1 || k == 2) ? 1 : 0];
+                    }
+                    drawQuad(p[0], p[1], p[2], p[3], col, wired);
+                }
+            }
+            break;
+        }
+    }
+    mLocal.setToIdentity();
+}
+
+void SoftRenderer::drawObject2d(const struct_obj& obj)
+{
+    const double* val = obj.val;
+    QRgb rgb = qRgb(static_cast<int>(255.0f * obj.color[0]), static_cast<int>(255.0f * obj.color[1]),
+        static_cast<int>(255.0f * obj.color[2]));
+
+    switch (obj.type) {
+        default:
+            break;
+        case enum_object_sphere2d:
+        case enum_object_disk2d: {
+            bool filled = (obj.type == enum_object_disk2d);
+            double numPoints = val[3];
+            if (numPoints < 3.0) {
+                break;
+            }
+            QVector3D c(static_cast<float>(val[0]), static_cast<float>(val[1]), 0.0f);
+            float r = static_cast<float>(val[2]);
+            int n = static_cast<int>(ceil(numPoints));
+            for (int i = 0; i < n; i++) {
+                double a0 = 2.0 * M_PI * i / numPoints;
+                double a1 = std::min(2.0 * M_PI, 2.0 * M_PI * (i + 1) / numPoints);
+                QVector3D p0 = c + r * QVector3D(static_cast<float>(cos(a0)), static_cast<float>(sin(a0)), 0.0f);
+                QVector3D p1 = c + r * QVector3D(static_cast<float>(cos(a1)), static_cast<float>(sin(a1)), 0.0f);
+                if (filled) {
+                    drawTriangle(c, p0, p1, rgb);
+                }
+                else {
+                    drawLine(p0, p1, rgb, static_cast<int>(val[4]));
+                }
+            }
+            break;
+        }
+        case enum_object_box2d: {
+            float hx = static_cast<float>(0.5 * val[2]);
+            float hy = static_cast<float>(0.5 * val[3]);
+            QVector3D c(static_cast<float>(val[0]), static_cast<float>(val[1]), 0.0f);
+            QVector3D p[4] = { c + QVector3D(-hx, -hy, 0.0f), c + QVector3D(hx, -hy, 0.0f),
+                c + QVector3D(hx, hy, 0.0f), c + QVector3D(-hx, hy, 0.0f) };
+            for (int k = 0; k < 4; k++) {
+                drawLine(p[k], p[(k + 1) % 4], rgb, static_cast<int>(val[4]));
+            }
+            break;
+        }
+        case enum_object_line2d: {
+            drawLine(QVector3D(static_cast<float>(val[0]), static_cast<float>(val[1]), 0.0f),
+                QVector3D(static_cast<float>(val[2]), static_cast<float>(val[3]), 0.0f), rgb,
+                static_cast<int>(val[4]));
+            break;
+        }
+        case enum_object_quad2d: {
+            QVector3D p[4];
+            for (int k = 0; k < 4; k++) {
+                p[k] = QVector3D(static_cast<float>(val[2 * k]), static_cast<float>(val[2 * k + 1]), 0.0f);
+            }
+            if (val[8] > 0.0) {
+                for (int k = 0; k < 4; k++) {
+                    drawLine(p[k], p[(k + 1) % 4], rgb, static_cast<int>(val[8]));
+                }
+            }
+            else {
+                drawTriangle(p[0], p[1], p[2], rgb);
+                drawTriangle(p[0], p[2], p[3], rgb);
+            }
+            break;
+        }
+    }
+}
+
+void SoftRenderer::drawAxes(const struct_soft_job& job)
+{
+    // Same inset as OpenGL3dModel::paintGL_axes(): camera at distance 37 looking at the origin.
+    const struct_params& par = job.params;
+    QVector3D pos(static_cast<float>(par.opengl_eye_pos[0]), static_cast<float>(par.opengl_eye_pos[1]),
+        static_cast<float>(par.opengl_eye_pos[2]));
+    QVector3D vup(static_cast<float>(par.opengl_eye_vup[0]), static_cast<float>(par.opengl_eye_vup[1]),
+        static_cast<float>(par.opengl_eye_vup[2]));
+    if (pos.isNull()) {
+        return;
+    }
+
+    QMatrix4x4 proj;
+    proj.perspective(5.0f, 1.0f, 0.01f, 10000.0f);
+    QMatrix4x4 mv;
+    mv.lookAt(pos.normalized() * 37.0f, QVector3D(0.0f, 0.0f, 0.0f), vup);
+
+    setViewport(0, 0, SOFT_AXES_SIZE, SOFT_AXES_SIZE);
+    clearDepth();
+    mDepthTest = true;
+
+    // Arrow along the z-axis: shaft, bottom disk, cone, and cone disk.
+    const double mantles[2][4] = { { 0.0625, 0.0625, 0.0, 0.75 }, { 0.125, 0.0, 0.75, 1.0 } };
+    const float colors[3][3] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } };
+
+    for (int axis = 0; axis < 3; axis++) {
+        QMatrix4x4 amv = mv;
+        if (axis == 0) {
+            amv.rotate(90.0f, 0.0f, 1.0f, 0.0f);
+        }
+        else if (axis == 1) {
+            amv.rotate(-90.0f, 1.0f, 0.0f, 0.0f);
+        }
+        setMatrices(proj, amv);
+
+        for (int i = 0; i < SOFT_AXES_SLICES; i++) {
+            double phi[2] = { 2.0 * M_PI * i / SOFT_AXES_SLICES, 2.0 * M_PI * (i + 1) / SOFT_AXES_SLICES };
+            QVector3D dir[2];
+            for (int k = 0; k < 2; k++) {
+                dir[k] = QVector3D(static_cast<float>(cos(phi[k])), static_cast<float>(sin(phi[k])), 0.0f);
+            }
+            for (int m = 0; m < 2; m++) {
+                float r0 = static_cast<float>(mantles[m][0]);
+                float r1 = static_cast<float>(mantles[m][1]);
+                QVector3D z0(0.0f, 0.0f, static_cast<float>(mantles[m][2]));
+                QVector3D z1(0.0f, 0.0f, static_cast<float>(mantles[m][3]));
+                drawQuad(z0 + r0 * dir[0], z0 + r0 * dir[1], z1 + r1 * dir[1], z1 + r1 * dir[0], colors[axis], false);
+                drawShadedTriangle(z0, z0 + r0 * dir[1], z0 + r0 * dir[0], colors[axis]);
+            }
+        }
+    }
+    setViewport(0, 0, mWidth, mHeight);
+}
+
+void SoftRenderer::plotSpan(int x0, int x1, int y, float z, QRgb col)
+{
+    // Window coordinates have their origin in the lower left corner.
+    int vx0 = std::max(0, mViewport[0]);
+    int vx1 = std::min(mWidth, mViewport[0] + mViewport[2]) - 1;
+    if (y < std::max(0, mViewport[1]) || y >= std::min(mHeight, mViewport[1] + mViewport[3])) {
+        return;
+    }
+    x0 = std::max(x0, vx0);
+    x1 = std::min(x1, vx1);
+
+    int row = mHeight - 1 - y;
+    QRgb* line = reinterpret_cast<QRgb*>(mImage.scanLine(row));
+    float* depth = mDepth.data() + static_cast<size_t>(row) * static_cast<size_t>(mWidth);
+    for (int x = x0; x <= x1; x++) {
+        if (mDepthTest) {
+            if (z >= depth[x]) {
+                continue;
+            }
+            depth[x] = z;
+        }
+        line[x] = col;
+    }
+}
@@ -0,0 +1,124 @@
+/**
+ * @file    soft_renderer.h
+ * @author  Thomas Mueller
+ *
+ * @brief  CPU rasterizer for the 2d and 3d views.
+ *
+ * Reproduces the framing of OpenGL3dModel and OpenGL2dModel without an
+ * OpenGL context: geodesic, embedding wireframe, coordinate axes, and
+ * objects are rasterized with a depth buffer into a QImage. A job carries
+ * copies of everything it needs, so independent images can be rendered
+ * in parallel with one renderer per thread.
+ *
+ * This file is part of GeodesicView.
+ */
+#ifndef SOFT_RENDERER_H
+#define SOFT_RENDERER_H
+
+#include <memory>
+#include <vector>
+
+#include <QColor>
+#include <QImage>
+#include <QMatrix4x4>
+#include <QString>
+#include <QVector3D>
+#include <QVector4D>
+
+#include <gdefs.h>
+#include <utils/embedding_mesh.h>
+
+enum enum_soft_view { enum_soft_view_2d = 0, enum_soft_view_3d };
+
+typedef struct _struct_soft_job {
+    enum_soft_view view;
+    QString filename;
+    int width;
+    int height;
+    struct_params params; //!< camera, scaling, ranges, and colors
+    enum_draw_style style;
+    std::vector<GLfloat> verts; //!< projected geodesic, 2 or 3 components per vertex
+    std::shared_ptr<const struct_emb_mesh> embMesh;
+    std::vector<struct_obj> objects; //!< only objects of matching dimension are drawn
+    std::vector<GLfloat> effPot; //!< effective potential of the 2d view, a NaN vertex separates line strips
+    double effPotEnergy; //!< total energy line of the effective potential, NaN if not shown
+    bool wiredObjs;
+    bool ok;
+} struct_soft_job;
+
+/**
+ * @brief The SoftRenderer class
+ */
+class SoftRenderer
+{
+public:
+    SoftRenderer();
+    ~SoftRenderer();
+
+public:
+    /**
+     * @brief Render job and save image to job.filename.
+     * @param job  Job description; job.ok is set.
+     * @return true if image was written.
+     */
+    bool render(struct_soft_job& job);
+
+    void render3d(const struct_soft_job& job);
+    void render2d(const struct_soft_job& job);
+
+    QImage getImage();
+
+    /**
+     * @brief Visible range and lattice steps of a 2d job, as OpenGL2dModel determines them.
+     * @param job    Job description.
+     * @param range  Pointer to xMin, xMax, yMin, yMax.
+     * @param step   Pointer to lattice steps of abscissa and ordinate.
+     */
+    static void getPlotFrame(const struct_soft_job& job, double* range, double* step);
+
+    /**
+     * @brief Render jobs in parallel.
+     * @param jobs        List of jobs.
+     * @param numThreads  Number of threads; zero uses all cores.
+     * @return true if all images were written.
+     */
+    static bool renderJobs(std::vector<struct_soft_job>& jobs, int numThreads = 0);
+
+protected:
+    void resize(int width, int height);
+    void clear(const QColor& col);
+    void clearDepth();
+    void setViewport(int x, int y, int width, int height);
+    void setMatrices(const QMatrix4x4& proj, const QMatrix4x4& modelview);
+
+    void drawLine(const QVector3D& p0, const QVector3D& p1, QRgb col, int width, ushort stipple = 0xffff);
+    void drawPoint(const QVector3D& p, QRgb col, int size);
+    void drawTriangle(const QVector3D& p0, const QVector3D& p1, const QVector3D& p2, QRgb col);
+    void drawShadedTriangle(const QVector3D& p0, const QVector3D& p1, const QVector3D& p2, const float* col);
+    void drawQuad(const QVector3D& p0, const QVector3D& p1, const QVector3D& p2, const QVector3D& p3,
+        const float* col, bool wired);
+
+    void drawGeodesic(const struct_soft_job& job, int numComps, const QColor& col, int width);
+    void drawEmbedding(const struct_emb_mesh& mesh, const QColor& col);
+    void drawObject3d(const struct_obj& obj, bool wired);
+    void drawObject2d(const struct_obj& obj);
+    void drawAxes(const struct_soft_job& job);
+
+    void plotSpan(int x0, int x1, int y, float z, QRgb col);
+    bool toWindow(const QVector4D& clip, QVector3D& win);
+
+private:
+    int mWidth;
+    int mHeight;
+    QImage mImage;
+    std::vector<float> mDepth;
+    bool mDepthTest;
+
+    int mViewport[4];
+    QMatrix4x4 mProj;
+    QMatrix4x4 mModelView;
+    QMatrix4x4 mMVP;
+    QMatrix4x4 mLocal; //!< object transformation in front of the modelview
+};
+
+#endif // SOFT_RENDERER_H
@@ -14,6 +14,10 @@
 #include <mach-o/dyld.h>
 #endif
 
+#include <extra/m4dObject.h>
+
+extern m4d::Object mObject;
+
 bool CopyString(const char* src, char*& dest)
 {
     if (src == nullptr) {
@@ -502,6 +506,15 @@ void setStandardParams(struct_params* par)
     par->opengl_line_width = DEF_OPENGL_LINE_WIDTH;
     par->opengl_bg_color = QColor(DEF_OPENGL_BG_COLOR);
     par->opengl_line_smooth = 0;
+    par->opengl_line_mode = enum_line_mode_gl;
+    par->opengl_tube_radius = DEF_OPENGL_TUBE_RADIUS;
+    par->opengl_cmap_scalar = enum_geod_scalar_none;
+    par->opengl_cmap_type = enum_colormap_rainbow;
+    par->opengl_cmap_auto = 1;
+    par->opengl_cmap_min = 0.0;
+    par->opengl_cmap_max = 1.0;
+    par->opengl_img_width = 0;
+    par->opengl_img_height = 0;
 
     par->opengl_leg1_col1 = QColor(DEF_OPENGL_LEG1_COL1);
     par->opengl_leg1_col2 = QColor(DEF_OPENGL_LEG1_COL2);
@@ -532,6 +545,10 @@ void setStandardParams(struct_params* par)
     par->draw2d_representation = static_cast<m4d::enum_draw_type>(0);
     par->draw2d_abscissa = 0;
     par->draw2d_ordinate = 0;
+
+    par->trails_use = 0;
+    par->trails_num = DEF_TRAILS_NUM;
+    par->trails_max_mbytes = DEF_TRAILS_MAX_BYTES / (1024 * 1024);
 }
 
 bool loadParamFile(const std::string& filename, struct_params* par)
@@ -599,6 +616,23 @@ bool loadParamFile(const std::string& filename, struct_params* par)
         else if (baseString.compare("OGL_LINE_SMOOTH") == 0 && tokens[i].size() > 1) {
             par->opengl_line_smooth = atoi(tokens[i][1].c_str());
         }
+        else if (baseString.compare("OGL_LINE_MODE") == 0 && tokens[i].size() > 1) {
+            par->opengl_line_mode = atoi(tokens[i][1].c_str());
+        }
+        else if (baseString.compare("OGL_TUBE_RADIUS") == 0 && tokens[i].size() > 1) {
+            par->opengl_tube_radius = atof(tokens[i][1].c_str());
+        }
+        else if (baseString.compare("OGL_CMAP") == 0 && tokens[i].size() > 5) {
+            par->opengl_cmap_scalar = atoi(tokens[i][1].c_str());
+            par->opengl_cmap_type = atoi(tokens[i][2].c_str());
+            par->opengl_cmap_auto = atoi(tokens[i][3].c_str());
+            par->opengl_cmap_min = atof(tokens[i][4].c_str());
+            par->opengl_cmap_max = atof(tokens[i][5].c_str());
+        }
+        else if (baseString.compare("OGL_IMG_SIZE") == 0 && tokens[i].size() > 2) {
+            par->opengl_img_width = atoi(tokens[i][1].c_str());
+            par->opengl_img_height = atoi(tokens[i][2].c_str());
+        }
         else if (baseString.compare("OGL_BG_COLOR") == 0 && tokens[i].size() > 3) {
             par->opengl_bg_color
                 = QColor(atoi(tokens[i][1].c_str()), atoi(tokens[i][2].c_str()), atoi(tokens[i][3].c_str()));
@@ -722,6 +756,15 @@ bool loadParamFile(const std::string& filename, struct_params* par)
         else if (baseString.compare("DRAW2D_ORDINATE") == 0 && tokens[i].size() > 1) {
             par->draw2d_ordinate = atoi(tokens[i][1].c_str());
         }
+        else if (baseString.compare("TRAILS_USE") == 0 && tokens[i].size() > 1) {
+            par->trails_use = atoi(tokens[i][1].c_str());
+        }
+        else if (baseString.compare("TRAILS_NUM") == 0 && tokens[i].size() > 1) {
+            par->trails_num = atoi(tokens[i][1].c_str());
+        }
+        else if (baseString.compare("TRAILS_MAX_MBYTES") == 0 && tokens[i].size() > 1) {
+            par->trails_max_mbytes = atoi(tokens[i][1].c_str());
+        }
     }
     return true;
 }
@@ -764,6 +807,11 @@ bool saveParamFile(const std::string& filename, struct_params* par)
         par->opengl_line_color.blue());
     fprintf(fptr, "OGL_LINE_WIDTH       %d\n", par->opengl_line_width);
     fprintf(fptr, "OGL_LINE_SMOOTH      %d\n", par->opengl_line_smooth);
+    fprintf(fptr, "OGL_LINE_MODE        %d\n", par->opengl_line_mode);
+    fprintf(fptr, "OGL_TUBE_RADIUS      %f\n", par->opengl_tube_radius);
+    fprintf(fptr, "OGL_CMAP             %d %d %d %g %g\n", par->opengl_cmap_scalar, par->opengl_cmap_type,
+        par->opengl_cmap_auto, par->opengl_cmap_min, par->opengl_cmap_max);
+    fprintf(fptr, "OGL_IMG_SIZE         %d %d\n", par->opengl_img_width, par->opengl_img_height);
     fprintf(fptr, "OGL_BG_COLOR         %3d %3d %3d\n", par->opengl_bg_color.red(), par->opengl_bg_color.green(),
         par->opengl_bg_color.blue());
 
@@ -822,10 +870,48 @@ bool saveParamFile(const std::string& filename, struct_params* par)
     fprintf(fptr, "DRAW2D_REPRESENTATION  %d\n", static_cast<int>(par->draw2d_representation));
     fprintf(fptr, "DRAW2D_ABSCISSA        %d\n", par->draw2d_abscissa);
     fprintf(fptr, "DRAW2D_ORDINATE        %d\n", par->draw2d_ordinate);
+    fprintf(fptr, "# -----\n");
+    fprintf(fptr, "TRAILS_USE             %d\n", par->trails_use);
+    fprintf(fptr, "TRAILS_NUM             %d\n", par->trails_num);
+    fprintf(fptr, "TRAILS_MAX_MBYTES      %d\n", par->trails_max_mbytes);
     fclose(fptr);
     return true;
 }
 
+m4d::Metric* copyMetric(m4d::Metric* metric)
+{
+    int index = mObject.metricDB.getMetricNr(metric->getMetricName());
+    if (index < 0) {
+        return nullptr;
+    }
+
+    m4d::Metric* copy = mObject.metricDB.getMetric(static_cast<m4d::MetricList::enum_metric>(index));
+    if (copy == nullptr) {
+        fprintf(stderr, "Cannot create copy of metric!\n");
+        return nullptr;
+    }
+
+    std::vector<std::string> names;
+    metric->getParamNames(names);
+    for (size_t i = 0; i < names.size(); i++) {
+        double value = 0.0;
+        metric->getParam(names[i].c_str(), value);
+        copy->setParam(names[i].c_str(), value);
+    }
+
+    names.clear();
+    metric->getEmbeddingNames(names);
+    for (size_t i = 0; i < names.size(); i++) {
+        double value = 0.0;
+        metric->getEmbeddingParam(names[i].c_str(), value);
+        copy->setEmbeddingParam(names[i].c_str(), value);
+    }
+
+    // The units are only kept by the current metric and the object.
+    copy->setUnits(mObject.speed_of_light, mObject.grav_constant, mObject.dielectric_perm);
+    return copy;
+}
+
 #ifdef HAVE_LUA
 int setGVObject(lua_State*)
 {
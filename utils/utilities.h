@@ -17,6 +17,8 @@
 
 #include "myobject.h"
 
+#include <metric/m4dMetric.h>
+
 #ifdef HAVE_LUA
 #include "lua/m4dlua.h"
 #include "lua/m4dlua_utils.h"
@@ -67,6 +69,17 @@ bool loadParamFile(const std::string& filename, struct_params* par);
  */
 bool saveParamFile(const std::string& filename, struct_params* par);
 
+/**
+ * @brief Create a new metric of the same type with the same parameters and units.
+ *
+ *  Worker threads evaluate the copy, so the GUI thread can change
+ *  or integrate with the original at any time.
+ *
+ * @param metric  Pointer to metric.
+ * @return pointer to copy that has to be deleted by the caller, or nullptr.
+ */
+m4d::Metric* copyMetric(m4d::Metric* metric);
+
 /**
  * @brief Safely delete 1D arrays generated with 'new'.
  *
@@ -0,0 +1,698 @@
+/**
+ * @file    vector_exporter.cpp
+ * @author  Thomas Mueller
+ *
+ * This file is part of GeodesicView.
+ */
+#include "vector_exporter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <unordered_set>
+
+VectorExporter::VectorExporter()
+{
+    mFormat = enum_vector_format_svg;
+    mNumBytes = 0;
+    mFailed = false;
+    mWidth = mHeight = 0;
+    mFilled = false;
+    mShapeVerts = 0;
+    mStreamStart = 0;
+    mTrans[0] = mTrans[2] = 0.0;
+    mTrans[1] = mTrans[3] = 1.0;
+    for (int i = 0; i < 4; i++) {
+        mClip[i] = 0.0;
+    }
+    mTolerance = DEF_VECTOR_EXPORT_TOLERANCE;
+    mHavePrev = false;
+    mInPath = false;
+    mHaveWedge = false;
+    mWedgeDir = 0.0;
+    mWedge[0] = mWedge[1] = 0.0;
+    mReach = 0.0;
+    mLastRel = 0.0;
+    mNumIn = mNumOut = 0;
+}
+
+VectorExporter::~VectorExporter()
+{
+    if (mFile.isOpen()) {
+        mFile.close();
+    }
+}
+
+bool VectorExporter::save(QString filename, const struct_soft_job& job, double tolerance)
+{
+    if (job.view != enum_soft_view_2d) {
+        fprintf(stderr, "Vector export is only available for the 2D view!\n");
+        return false;
+    }
+    if (job.width <= 0 || job.height <= 0) {
+        fprintf(stderr, "Image size is null!\n");
+        return false;
+    }
+
+    const struct_params& par = job.params;
+    mTolerance = std::max(tolerance, 1e-3);
+    mNumIn = mNumOut = 0;
+
+    int left = DEF_DRAW2D_LEFT_BORDER;
+    int bottom = DEF_DRAW2D_BOTTOM_BORDER;
+    int plotWidth = std::max(1, job.width - left);
+    int plotHeight = std::max(1, job.height - bottom);
+
+    double range[4];
+    double step[2];
+    SoftRenderer::getPlotFrame(job, range, step);
+    mTrans[1] = plotWidth / (range[1] - range[0]);
+    mTrans[0] = left - range[0] * mTrans[1];
+    mTrans[3] = plotHeight / (range[3] - range[2]);
+    mTrans[2] = bottom - range[2] * mTrans[3];
+
+    // Polylines are clipped slightly outside of the plot area; the clip path cuts them exactly.
+    double margin = std::max(par.draw2d_line_width, 1) + 1.0;
+    mClip[0] = left - margin;
+    mClip[1] = job.width + margin;
+    mClip[2] = bottom - margin;
+    mClip[3] = job.height + margin;
+
+    if (!open(filename, job.width, job.height)) {
+        return false;
+    }
+
+    int xStart = static_cast<int>(floor(range[0] / step[0])) + 1;
+    int xEnd = static_cast<int>(floor(range[1] / step[0])) + 1;
+    int yStart = static_cast<int>(floor(range[2] / step[1])) + 1;
+    int yEnd = static_cast<int>(floor(range[3] / step[1])) + 1;
+
+    setFill(Qt::black);
+    fillRect(0.0, 0.0, job.width, job.height);
+
+    // ticks
+    setStroke(Qt::white, 1.0);
+    beginShape(false);
+    for (int x = xStart; x < xEnd; x++) {
+        double xp = toDevice(x * step[0], 0.0).x();
+        moveTo(QPointF(xp, 0.6 * bottom));
+        lineTo(QPointF(xp, bottom));
+    }
+    for (int y = yStart; y < yEnd; y++) {
+        double yp = toDevice(0.0, y * step[1]).y();
+        moveTo(QPointF(0.6 * left, yp));
+        lineTo(QPointF(left, yp));
+    }
+    endShape();
+
+    // tick labels with the same anchors as OpenGL2dModel::paintGL_static()
+    setFill(Qt::white);
+    for (int x = xStart; x < xEnd; x++) {
+        drawText(toDevice(x * step[0], 0.0).x(), 2.0, QString::number(x * step[0]), enum_text_align_hcenter);
+    }
+    for (int y = yStart; y < yEnd; y++) {
+        drawText(left - 3.0, toDevice(0.0, y * step[1]).y() + 2.0, QString::number(y * step[1]),
+            enum_text_align_right);
+    }
+
+    beginClip(left, bottom, plotWidth, plotHeight);
+
+    // background
+    setFill(par.draw2d_bg_color);
+    fillRect(left, bottom, plotWidth, plotHeight);
+
+    // lattice
+    QPointF c0 = toDevice(range[0], range[2]);
+    QPointF c1 = toDevice(range[1], range[3]);
+    setStroke(par.draw2d_grid_color, 1.0, true);
+    beginShape(false);
+    for (int x = xStart; x < xEnd; x++) {
+        double xp = toDevice(x * step[0], 0.0).x();
+        moveTo(QPointF(xp, c0.y()));
+        lineTo(QPointF(xp, c1.y()));
+    }
+    for (int y = yStart; y < yEnd; y++) {
+        double yp = toDevice(0.0, y * step[1]).y();
+        moveTo(QPointF(c0.x(), yp));
+        lineTo(QPointF(c1.x(), yp));
+    }
+    endShape();
+
+    // 'origin' cross
+    QPointF origin = toDevice(0.0, 0.0);
+    setStroke(par.draw2d_grid_color, 1.0);
+    beginShape(false);
+    moveTo(QPointF(origin.x(), c0.y()));
+    lineTo(QPointF(origin.x(), c1.y()));
+    moveTo(QPointF(c0.x(), origin.y()));
+    lineTo(QPointF(c1.x(), origin.y()));
+    endShape();
+
+    for (size_t i = 0; i < job.objects.size(); i++) {
+        if (job.objects[i].dim == enum_object_dim_2d) {
+            drawObject2d(job.objects[i]);
+        }
+    }
+
+    // geodesic
+    size_t numVerts = job.verts.size() / 2;
+    if (job.style == enum_draw_points) {
+        setFill(par.draw2d_line_color);
+        drawPoints(job.verts.data(), numVerts, std::max(par.draw2d_line_width, 1));
+    }
+    else {
+        setStroke(par.draw2d_line_color, std::max(par.draw2d_line_width, 1));
+        drawPolyline(job.verts.data(), numVerts);
+    }
+
+    // effective potential and total energy
+    setStroke(Qt::red, 1.0);
+    drawPolyline(job.effPot.data(), job.effPot.size() / 2);
+    if (std::isfinite(job.effPotEnergy)) {
+        setStroke(Qt::blue, 1.0);
+        addVertex(toDevice(range[0], job.effPotEnergy));
+        addVertex(toDevice(range[1], job.effPotEnergy));
+        endPolyline();
+    }
+
+    endClip();
+    return close();
+}
+
+size_t VectorExporter::getNumInputVerts()
+{
+    return mNumIn;
+}
+
+size_t VectorExporter::getNumOutputVerts()
+{
+    return mNumOut;
+}
+
+bool VectorExporter::open(QString filename, int width, int height)
+{
+    if (filename.endsWith(DEF_SVG_FILE_ENDING, Qt::CaseInsensitive)) {
+        mFormat = enum_vector_format_svg;
+    }
+    else if (filename.endsWith(DEF_PDF_FILE_ENDING, Qt::CaseInsensitive)) {
+        mFormat = enum_vector_format_pdf;
+    }
+    else {
+        fprintf(stderr, "Unknown vector format of file %s!\n", filename.toStdString().c_str());
+        return false;
+    }
+
+    mFile.setFileName(filename);
+    if (!mFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        fprintf(stderr, "Cannot open file %s!\n", filename.toStdString().c_str());
+        return false;
+    }
+
+    mWidth = width;
+    mHeight = height;
+    mNumBytes = 0;
+    mFailed = false;
+    mObjOffsets.clear();
+
+    QByteArray w = QByteArray::number(width);
+    QByteArray h = QByteArray::number(height);
+    if (mFormat == enum_vector_format_svg) {
+        write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+        write("<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\" width=\"" + w + "\" height=\"" + h
+            + "\" viewBox=\"0 0 " + w + " " + h + "\">\n");
+    }
+    else {
+        // One page whose content stream is written while the plot is traversed; its length follows as object 6.
+        write("%PDF-1.4\n%\xe2\xe3\xcf\xd3\n");
+        beginObject(1);
+        write("<< /Type /Catalog /Pages 2 0 R >>\nendobj\n");
+        beginObject(2);
+        write("<< /Type /Pages /Kids [3 0 R] /Count 1 >>\nendobj\n");
+        beginObject(3);
+        write("<< /Type /Page /Parent 2 0 R /MediaBox [0 0 " + w + " " + h
+            + "] /Resources << /Font << /F1 4 0 R >> >> /Contents 5 0 R >>\nendobj\n");
+        beginObject(4);
+        write("<< /Type /Font /Subtype /Type1 /BaseFont /Courier >>\nendobj\n");
+        beginObject(5);
+        write("<< /Length 6 0 R >>\nstream\n");
+        mStreamStart = mNumBytes;
+    }
+    return !mFailed;
+}
+
+bool VectorExporter::close()
+{
+    if (mFormat == enum_vector_format_svg) {
+        write("</svg>\n");
+    }
+    else {
+        qint64 length = mNumBytes - mStreamStart;
+        write("\nendstream\nendobj\n");
+        beginObject(6);
+        write(QByteArray::number(length) + "\nendobj\n");
+
+        qint64 xref = mNumBytes;
+        write("xref\n0 " + QByteArray::number(static_cast<int>(mObjOffsets.size()) + 1) + "\n");
+        write("0000000000 65535 f \n");
+        for (size_t i = 0; i < mObjOffsets.size(); i++) {
+            write(QByteArray::number(mObjOffsets[i]).rightJustified(10, '0') + " 00000 n \n");
+        }
+        write("trailer\n<< /Size " + QByteArray::number(static_cast<int>(mObjOffsets.size()) + 1)
+            + " /Root 1 0 R >>\nstartxref\n" + QByteArray::number(xref) + "\n%%EOF\n");
+    }
+    mFile.close();
+
+    if (mFailed) {
+        fprintf(stderr, "Cannot write file %s!\n", mFile.fileName().toStdString().c_str());
+    }
+    return !mFailed;
+}
+
+void VectorExporter::write(const QByteArray& data)
+{
+    if (mFile.write(data) != data.size()) {
+        mFailed = true;
+    }
+    mNumBytes += data.size();
+}
+
+void VectorExporter::beginObject(int num)
+{
+    // Objects are numbered consecutively from 1.
+    mObjOffsets.resize(static_cast<size_t>(num));
+    mObjOffsets[static_cast<size_t>(num - 1)] = mNumBytes;
+    write(QByteArray::number(num) + " 0 obj\n");
+}
+
+QByteArray VectorExporter::toCoords(const QPointF& p)
+{
+    // Device space has its origin in the lower left corner like the pdf page; svg counts from the top.
+    double y = (mFormat == enum_vector_format_svg ? mHeight - p.y() : p.y());
+    QByteArray coords[2] = { QByteArray::number(p.x(), 'f', 2), QByteArray::number(y, 'f', 2) };
+    for (int i = 0; i < 2; i++) {
+        while (coords[i].endsWith('0')) {
+            coords[i].chop(1);
+        }
+        if (coords[i].endsWith('.')) {
+            coords[i].chop(1);
+        }
+        if (coords[i] == "-0") {
+            coords[i] = "0";
+        }
+    }
+    return coords[0] + " " + coords[1];
+}
+
+void VectorExporter::setStroke(const QColor& col, double width, bool dashed)
+{
+    if (mFormat == enum_vector_format_svg) {
+        mStrokeAttr = "stroke=\"" + col.name().toLatin1() + "\" stroke-width=\"" + QByteArray::number(width) + "\"";
+        if (dashed) {
+            // glLineStipple(1, 0x1111): one pixel on, three pixels off
+            mStrokeAttr += " stroke-dasharray=\"1 3\"";
+        }
+    }
+    else {
+        write(QByteArray::number(col.redF(), 'f', 3) + " " + QByteArray::number(col.greenF(), 'f', 3) + " "
+            + QByteArray::number(col.blueF(), 'f', 3) + " RG " + QByteArray::number(width) + " w "
+            + (dashed ? "[1 3] 0 d\n" : "[] 0 d\n"));
+    }
+}
+
+void VectorExporter::setFill(const QColor& col)
+{
+    if (mFormat == enum_vector_format_svg) {
+        mFillAttr = "fill=\"" + col.name().toLatin1() + "\"";
+    }
+    else {
+        write(QByteArray::number(col.redF(), 'f', 3) + " " + QByteArray::number(col.greenF(), 'f', 3) + " "
+            + QByteArray::number(col.blueF(), 'f', 3) + " rg\n");
+    }
+}
+
+void VectorExporter::beginClip(double x, double y, double w, double h)
+{
+    if (mFormat == enum_vector_format_svg) {
+        QByteArray ul = toCoords(QPointF(x, y + h));
+        ul.replace(' ', "\" y=\"");
+        write("<clipPath id=\"plot\"><rect x=\"" + ul + "\" width=\"" + QByteArray::number(w) + "\" height=\""
+            + QByteArray::number(h) + "\"/></clipPath>\n<g clip-path=\"url(#plot)\">\n");
+    }
+    else {
+        write("q " + toCoords(QPointF(x, y)) + " " + QByteArray::number(w) + " " + QByteArray::number(h)
+            + " re W n\n");
+    }
+}
+
+void VectorExporter::endClip()
+{
+    write(mFormat == enum_vector_format_svg ? "</g>\n" : "Q\n");
+}
+
+void VectorExporter::beginShape(bool filled)
+{
+    mFilled = filled;
+    mShapeVerts = 0;
+    if (mFormat == enum_vector_format_svg) {
+        QByteArray attr = (filled ? mFillAttr : QByteArray("fill=\"none\" ") + mStrokeAttr);
+        write("<path " + attr + " d=\"");
+    }
+}
+
+void VectorExporter::moveTo(const QPointF& p)
+{
+    if (mFormat == enum_vector_format_svg) {
+        write((mShapeVerts > 0 ? "\nM" : "M") + toCoords(p));
+    }
+    else {
+        write(toCoords(p) + " m\n");
+    }
+    mShapeVerts = 1;
+}
+
+void VectorExporter::lineTo(const QPointF& p)
+{
+    if (mFormat == enum_vector_format_svg) {
+        // Coordinate pairs following an 'L' continue the line; a line break now and then keeps the file readable.
+        if (mShapeVerts == 1) {
+            write("L" + toCoords(p));
+        }
+        else {
+            write((mShapeVerts % 8 == 0 ? "\n" : " ") + toCoords(p));
+        }
+    }
+    else {
+        write(toCoords(p) + " l\n");
+    }
+    mShapeVerts++;
+}
+
+void VectorExporter::closeSubpath()
+{
+    write(mFormat == enum_vector_format_svg ? "z" : "h\n");
+}
+
+void VectorExporter::endShape()
+{
+    if (mFormat == enum_vector_format_svg) {
+        write("\"/>\n");
+    }
+    else {
+        write(mFilled ? "f\n" : "S\n");
+    }
+}
+
+void VectorExporter::fillRect(double x, double y, double w, double h)
+{
+    beginShape(true);
+    moveTo(QPointF(x, y));
+    lineTo(QPointF(x + w, y));
+    lineTo(QPointF(x + w, y + h));
+    lineTo(QPointF(x, y + h));
+    closeSubpath();
+    endShape();
+}
+
+void VectorExporter::drawText(double x, double y, const QString& text, enum_text_align align)
+{
+    if (mFormat == enum_vector_format_svg) {
+        static const char* anchors[3] = { "start", "middle", "end" };
+        QByteArray pos = toCoords(QPointF(x, y));
+        pos.replace(' ', "\" y=\"");
+        write("<text x=\"" + pos + "\" font-family=\"monospace\" font-size=\""
+            + QByteArray::number(DEF_VECTOR_EXPORT_FONT_SIZE) + "\" text-anchor=\"" + anchors[align] + "\" "
+            + mFillAttr + ">" + text.toHtmlEscaped().toUtf8() + "</text>\n");
+    }
+    else {
+        // Courier has a fixed advance of 0.6 em like the monospaced font of the 2d view.
+        double width = 0.6 * DEF_VECTOR_EXPORT_FONT_SIZE * text.length();
+        if (align == enum_text_align_hcenter) {
+            x -= 0.5 * width;
+        }
+        else if (align == enum_text_align_right) {
+            x -= width;
+        }
+
+        QByteArray str = text.toLatin1();
+        str.replace('\\', "\\\\").replace('(', "\\(").replace(')', "\\)");
+        write("BT /F1 " + QByteArray::number(DEF_VECTOR_EXPORT_FONT_SIZE) + " Tf " + toCoords(QPointF(x, y)) + " Td ("
+            + str + ") Tj ET\n");
+    }
+}
+
+QPointF VectorExporter::toDevice(double x, double y)
+{
+    return QPointF(mTrans[0] + mTrans[1] * x, mTrans[2] + mTrans[3] * y);
+}
+
+void VectorExporter::drawPolyline(const GLfloat* verts, size_t num)
+{
+    for (size_t i = 0; i < num; i++) {
+        addVertex(toDevice(verts[2 * i], verts[2 * i + 1]));
+    }
+    endPolyline();
+}
+
+void VectorExporter::drawPoints(const GLfloat* verts, size_t num, double size)
+{
+    // At most one point per cell of the marker size, but not finer than the tolerance; together with the
+    // clipping, the number of squares is bounded by the plot area in markers.
+    double cell = std::max(size, mTolerance);
+    std::unordered_set<quint64> cells;
+    bool inShape = false;
+    for (size_t i = 0; i < num; i++) {
+        QPointF p = toDevice(verts[2 * i], verts[2 * i + 1]);
+        mNumIn++;
+        if (!(p.x() >= mClip[0] && p.x() <= mClip[1] && p.y() >= mClip[2] && p.y() <= mClip[3])) {
+            continue;
+        }
+
+        qint64 cx = static_cast<qint64>(floor(p.x() / cell));
+        qint64 cy = static_cast<qint64>(floor(p.y() / cell));
+        if (!cells.insert((static_cast<quint64>(cx) << 32) ^ static_cast<quint32>(cy)).second) {
+            continue;
+        }
+
+        if (!inShape) {
+            beginShape(true);
+            inShape = true;
+        }
+        double h = 0.5 * size;
+        moveTo(QPointF(p.x() - h, p.y() - h));
+        lineTo(QPointF(p.x() + h, p.y() - h));
+        lineTo(QPointF(p.x() + h, p.y() + h));
+        lineTo(QPointF(p.x() - h, p.y() + h));
+        closeSubpath();
+        mNumOut++;
+    }
+    if (inShape) {
+        endShape();
+    }
+}
+
+void VectorExporter::drawObject2d(const struct_obj& obj)
+{
+    const double* val = obj.val;
+    QColor col = QColor::fromRgbF(obj.color[0], obj.color[1], obj.color[2]);
+    std::vector<QPointF> pts;
+    bool filled = false;
+    double width = 1.0;
+
+    switch (obj.type) {
+        default:
+            return;
+        case enum_object_sphere2d:
+        case enum_object_disk2d: {
+            double numPoints = val[3];
+            if (numPoints < 3.0) {
+                return;
+            }
+            int n = static_cast<int>(ceil(numPoints));
+            for (int i = 0; i <= n; i++) {
+                double a = std::min(2.0 * M_PI, 2.0 * M_PI * i / numPoints);
+                pts.push_back(toDevice(val[0] + val[2] * cos(a), val[1] + val[2] * sin(a)));
+            }
+            filled = (obj.type == enum_object_disk2d);
+            width = val[4];
+            break;
+        }
+        case enum_object_box2d: {
+            double hx = 0.5 * val[2];
+            double hy = 0.5 * val[3];
+            pts.push_back(toDevice(val[0] - hx, val[1] - hy));
+            pts.push_back(toDevice(val[0] + hx, val[1] - hy));
+            pts.push_back(toDevice(val[0] + hx, val[1] + hy));
+            pts.push_back(toDevice(val[0] - hx, val[1] + hy));
+            pts.push_back(pts.front());
+            width = val[4];
+            break;
+        }
+        case enum_object_line2d: {
+            pts.push_back(toDevice(val[0], val[1]));
+            pts.push_back(toDevice(val[2], val[3]));
+            width = val[4];
+            break;
+        }
+        case enum_object_quad2d: {
+            for (int k = 0; k < 4; k++) {
+                pts.push_back(toDevice(val[2 * k], val[2 * k + 1]));
+            }
+            pts.push_back(pts.front());
+            filled = !(val[8] > 0.0);
+            width = val[8];
+            break;
+        }
+    }
+
+    if (filled) {
+        setFill(col);
+        beginShape(true);
+        moveTo(pts[0]);
+        for (size_t i = 1; i < pts.size(); i++) {
+            lineTo(pts[i]);
+        }
+        closeSubpath();
+        endShape();
+    }
+    else {
+        setStroke(col, std::max(width, 1.0));
+        for (size_t i = 0; i < pts.size(); i++) {
+            addVertex(pts[i]);
+        }
+        endPolyline();
+    }
+}
+
+void VectorExporter::addVertex(const QPointF& p)
+{
+    mNumIn++;
+    if (!std::isfinite(p.x()) || !std::isfinite(p.y())) {
+        endPolyline();
+        return;
+    }
+    if (!mHavePrev) {
+        mPrev = p;
+        mHavePrev = true;
+        return;
+    }
+
+    // Liang-Barsky clipping of the segment from the previous vertex to p.
+    double d[2] = { p.x() - mPrev.x(), p.y() - mPrev.y() };
+    double t0 = 0.0;
+    double t1 = 1.0;
+    double pk[4] = { -d[0], d[0], -d[1], d[1] };
+    double qk[4] = { mPrev.x() - mClip[0], mClip[1] - mPrev.x(), mPrev.y() - mClip[2], mClip[3] - mPrev.y() };
+    bool visible = true;
+    for (int k = 0; k < 4 && visible; k++) {
+        if (pk[k] == 0.0) {
+            visible = (qk[k] >= 0.0);
+        }
+        else if (pk[k] < 0.0) {
+            t0 = std::max(t0, qk[k] / pk[k]);
+        }
+        else {
+            t1 = std::min(t1, qk[k] / pk[k]);
+        }
+        visible = visible && (t0 <= t1);
+    }
+
+    if (!visible) {
+        endPath();
+    }
+    else {
+        if (!mInPath || t0 > 0.0) {
+            endPath();
+            beginPath(QPointF(mPrev.x() + t0 * d[0], mPrev.y() + t0 * d[1]));
+        }
+        extendPath(QPointF(mPrev.x() + t1 * d[0], mPrev.y() + t1 * d[1]));
+        if (t1 < 1.0) {
+            endPath();
+        }
+    }
+    mPrev = p;
+}
+
+void VectorExporter::endPolyline()
+{
+    endPath();
+    mHavePrev = false;
+}
+
+void VectorExporter::beginPath(const QPointF& p)
+{
+    beginShape(false);
+    moveTo(p);
+    mNumOut++;
+    mInPath = true;
+    mAnchor = mLast = p;
+    mHaveWedge = false;
+    mReach = 0.0;
+}
+
+void VectorExporter::extendPath(const QPointF& p)
+{
+    // The line from the anchor passes a vertex at distance d within the tolerance if its direction deviates by
+    // less than asin(tol/d). The intersection of these wedges holds all directions that are still admissible.
+    double dx = p.x() - mAnchor.x();
+    double dy = p.y() - mAnchor.y();
+    double dist = sqrt(dx * dx + dy * dy);
+    if (dist <= mTolerance) {
+        // Close to the anchor, the vertex lies within the tolerance of any segment that starts there.
+        if (!mHaveWedge) {
+            mLast = p;
+        }
+        return;
+    }
+
+    double dir = atan2(dy, dx);
+    double half = asin(mTolerance / dist);
+    if (!mHaveWedge) {
+        mWedgeDir = dir;
+        mWedge[0] = -half;
+        mWedge[1] = half;
+        mHaveWedge = true;
+        mReach = dist;
+        mLast = p;
+        mLastRel = 0.0;
+        return;
+    }
+
+    // The last vertex is always the farthest one, so every skipped vertex projects onto the written segment.
+    // A vertex that steps back by less than the tolerance is skipped as long as the last vertex stays admissible;
+    // one outside the wedge, or further back, ends the segment at the last vertex.
+    double rel = remainder(dir - mWedgeDir, 2.0 * M_PI);
+    bool inWedge = (rel >= mWedge[0] && rel <= mWedge[1]);
+    if (inWedge && dist < mReach && dist >= mReach - mTolerance && fabs(mLastRel - rel) <= half) {
+        mWedge[0] = std::max(mWedge[0], rel - half);
+        mWedge[1] = std::min(mWedge[1], rel + half);
+        return;
+    }
+    if (!inWedge || dist < mReach) {
+        lineTo(mLast);
+        mNumOut++;
+        mAnchor = mLast;
+        mHaveWedge = false;
+        mReach = 0.0;
+        extendPath(p);
+        return;
+    }
+
+    mWedge[0] = std::max(mWedge[0], rel - half);
+    mWedge[1] = std::min(mWedge[1], rel + half);
+    mReach = dist;
+    mLast = p;
+    mLastRel = rel;
+}
+
+void VectorExporter::endPath()
+{
+    if (!mInPath) {
+        return;
+    }
+    if (mLast != mAnchor || mShapeVerts == 1) {
+        lineTo(mLast);
+        mNumOut++;
+    }
+    endShape();
+    mInPath = false;
+}
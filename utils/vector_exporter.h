@@ -0,0 +1,139 @@
+/**
+ * @file    vector_exporter.h
+ * @author  Thomas Mueller
+ *
+ * @brief  SVG and PDF export of the 2d view.
+ *
+ * Ticks, tick labels, lattice, 2d objects, geodesic, and effective potential
+ * of a 2d soft job are written as vector graphics in the framing of the
+ * SoftRenderer. Polylines are streamed vertex by vertex through a clipper and
+ * a simplifier in device space: a vertex is only written when the segment from
+ * the last written vertex can no longer pass all skipped vertices within the
+ * tolerance. Points that fall into the cell of an already written point are
+ * dropped; a cell is as large as the point marker, at least the tolerance.
+ * Thus, the file size follows the visual complexity of the plot and not the
+ * number of vertices.
+ *
+ * This file is part of GeodesicView.
+ */
+#ifndef VECTOR_EXPORTER_H
+#define VECTOR_EXPORTER_H
+
+#include <vector>
+
+#include <QByteArray>
+#include <QColor>
+#include <QFile>
+#include <QPointF>
+#include <QString>
+
+#include <gdefs.h>
+#include <utils/soft_renderer.h>
+
+enum enum_vector_format { enum_vector_format_svg = 0, enum_vector_format_pdf };
+
+/**
+ * @brief The VectorExporter class
+ */
+class VectorExporter
+{
+public:
+    VectorExporter();
+    ~VectorExporter();
+
+public:
+    /**
+     * @brief Export 2d job. The format is taken from the file ending.
+     * @param filename   Name of svg or pdf file.
+     * @param job        Job description of the 2d view.
+     * @param tolerance  Maximum deviation of simplified polylines in pixels.
+     * @return true if file was written.
+     */
+    bool save(QString filename, const struct_soft_job& job, double tolerance = DEF_VECTOR_EXPORT_TOLERANCE);
+
+    /**
+     * @brief Number of vertices passed to the polylines and points of the last export.
+     */
+    size_t getNumInputVerts();
+
+    /**
+     * @brief Number of polyline and point vertices written by the last export.
+     */
+    size_t getNumOutputVerts();
+
+protected:
+    enum enum_text_align { enum_text_align_left = 0, enum_text_align_hcenter, enum_text_align_right };
+
+    // ---- document ----
+    bool open(QString filename, int width, int height);
+    bool close();
+    void write(const QByteArray& data);
+    void beginObject(int num);
+    QByteArray toCoords(const QPointF& p);
+
+    void setStroke(const QColor& col, double width, bool dashed = false);
+    void setFill(const QColor& col);
+    void beginClip(double x, double y, double w, double h);
+    void endClip();
+
+    void beginShape(bool filled);
+    void moveTo(const QPointF& p);
+    void lineTo(const QPointF& p);
+    void closeSubpath();
+    void endShape();
+
+    void fillRect(double x, double y, double w, double h);
+    void drawText(double x, double y, const QString& text, enum_text_align align);
+
+    // ---- plot ----
+    QPointF toDevice(double x, double y);
+    void drawPolyline(const GLfloat* verts, size_t num);
+    void drawPoints(const GLfloat* verts, size_t num, double size);
+    void drawObject2d(const struct_obj& obj);
+
+    // ---- polyline pipeline: clipping, then simplification ----
+    void addVertex(const QPointF& p);
+    void endPolyline();
+    void beginPath(const QPointF& p);
+    void extendPath(const QPointF& p);
+    void endPath();
+
+private:
+    enum_vector_format mFormat;
+    QFile mFile;
+    qint64 mNumBytes;
+    bool mFailed;
+    int mWidth;
+    int mHeight;
+
+    QByteArray mStrokeAttr; //!< svg attributes of the current stroke style
+    QByteArray mFillAttr; //!< svg attributes of the current fill color
+    bool mFilled;
+    int mShapeVerts;
+
+    std::vector<qint64> mObjOffsets; //!< byte offsets of the pdf objects
+    qint64 mStreamStart;
+
+    double mTrans[4]; //!< device x = trans[0] + trans[1] * x, device y = trans[2] + trans[3] * y
+    double mClip[4]; //!< device rect of the polylines: xMin, xMax, yMin, yMax
+    double mTolerance;
+
+    // clipper state
+    QPointF mPrev;
+    bool mHavePrev;
+
+    // simplifier state
+    bool mInPath;
+    QPointF mAnchor; //!< last written vertex
+    QPointF mLast; //!< last accepted vertex
+    bool mHaveWedge;
+    double mWedgeDir; //!< direction of the first vertex outside the tolerance
+    double mWedge[2]; //!< admissible directions relative to mWedgeDir
+    double mReach; //!< distance of the last accepted vertex from the anchor
+    double mLastRel; //!< direction of the last accepted vertex relative to mWedgeDir
+
+    size_t mNumIn;
+    size_t mNumOut;
+};
+
+#endif // VECTOR_EXPORTER_H
@@ -5,15 +5,40 @@
  * This file is part of GeodesicView.
  */
 #include <QColorDialog>
+#include <QFileDialog>
 #include <QGridLayout>
 #include <QGroupBox>
 #include <QHeaderView>
 #include <QTimer>
+#include <algorithm>
+#include <cmath>
 
 #include "draw_view.h"
 
 extern m4d::Object mObject;
 
+namespace {
+
+double getProduct(m4d::Metric* metric, m4d::vec4 u, m4d::vec4 v)
+{
+    double sum = 0.0;
+    for (int mu = 0; mu < 4; mu++) {
+        for (int nu = 0; nu < 4; nu++) {
+            sum += metric->getMetricCoeff(mu, nu) * u.x(mu) * v.x(nu);
+        }
+    }
+    return sum;
+}
+
+double getNorm(m4d::Metric* metric, m4d::vec4 pos, m4d::vec4 dir)
+{
+    double x[4] = { pos.x(0), pos.x(1), pos.x(2), pos.x(3) };
+    metric->calculateMetric(x);
+    return getProduct(metric, dir, dir);
+}
+
+} // namespace
+
 DrawView::DrawView(
     OpenGL3dModel* opengl, OpenGL2dModel* draw, OpenGLJacobiModel* oglJacobi, struct_params* par, QWidget* parent)
     : QGroupBox(parent)
@@ -49,6 +74,7 @@ void DrawView::resetAll()
     cob_drawtype->addItem(QString(m4d::stl_draw_type[m4d::enum_draw_coordinates]));
     cob_abscissa->setEnabled(false);
     cob_ordinate->setEnabled(false);
+    grb_draw2d_multiples->setEnabled(false);
 
     m2dFGcolor = mParams->draw2d_line_color;
     m2dBGcolor = mParams->draw2d_bg_color;
@@ -81,6 +107,20 @@ void DrawView::resetAll()
     mOpenGL->setColors(mFGcolor, mBGcolor);
 
     spb_linewidth->setValue(mParams->opengl_line_width);
+    cob_linemode->setCurrentIndex(mParams->opengl_line_mode);
+    dsb_tube_radius->setValue(mParams->opengl_tube_radius);
+    dsb_tube_radius->setEnabled(mParams->opengl_line_mode == enum_line_mode_tube);
+    adjustColormap();
+    chb_trails->setChecked(mParams->trails_use == 1);
+    // The budget is set silently first; the slot triggered by the number then reads both.
+    spb_trails_mbytes->blockSignals(true);
+    spb_trails_mbytes->setValue(mParams->trails_max_mbytes);
+    spb_trails_mbytes->blockSignals(false);
+    spb_trails_num->setValue(mParams->trails_num);
+    spb_trails_num->setEnabled(mParams->trails_use == 1);
+    spb_trails_mbytes->setEnabled(mParams->trails_use == 1);
+    spb_img_width->setValue(mParams->opengl_img_width);
+    spb_img_height->setValue(mParams->opengl_img_height);
 
     led_scale3d_x->setValueAndStep(mParams->opengl_scale_x, DEF_DRAW3D_SCALE_X_STEP);
     led_scale3d_y->setValueAndStep(mParams->opengl_scale_x, DEF_DRAW3D_SCALE_Y_STEP);
@@ -113,6 +153,7 @@ void DrawView::resetAll()
     for (int i = 0; i < lst_led_lastpoint_pos_value.size(); i++) {
         lst_led_lastpoint_pos_value[i]->setText(QString());
     }
+    showPickedPoint(-1);
 
     adjustEmbParams();
     pub_emb_color->setPalette(QPalette(mParams->opengl_emb_color));
@@ -181,10 +222,12 @@ void DrawView::updateParams()
     if (type == m4d::enum_draw_coordinates) {
         cob_abscissa->setEnabled(true);
         cob_ordinate->setEnabled(true);
+        grb_draw2d_multiples->setEnabled(true);
     }
     else {
         cob_abscissa->setEnabled(false);
         cob_ordinate->setEnabled(false);
+        grb_draw2d_multiples->setEnabled(false);
     }
 
     cob_projection->setCurrentIndex(mParams->opengl_projection);
@@ -216,6 +259,27 @@ void DrawView::updateParams()
     else {
         chb_linesmooth->setChecked(false);
     }
+    cob_linemode->setCurrentIndex(mParams->opengl_line_mode);
+    dsb_tube_radius->setValue(mParams->opengl_tube_radius);
+    dsb_tube_radius->setEnabled(mParams->opengl_line_mode == enum_line_mode_tube);
+    mOpenGL->setLineMode(mParams->opengl_line_mode, mParams->opengl_tube_radius);
+    mOpenGL->setColormap(mParams->opengl_cmap_scalar, mParams->opengl_cmap_type, mParams->opengl_cmap_auto == 1,
+        mParams->opengl_cmap_min, mParams->opengl_cmap_max);
+    adjustColormap();
+
+    /* --- trails --- */
+    chb_trails->setChecked(mParams->trails_use == 1);
+    // The budget is set silently first; the slot triggered by the number then reads both.
+    spb_trails_mbytes->blockSignals(true);
+    spb_trails_mbytes->setValue(mParams->trails_max_mbytes);
+    spb_trails_mbytes->blockSignals(false);
+    spb_trails_num->setValue(mParams->trails_num);
+    spb_trails_num->setEnabled(mParams->trails_use == 1);
+    spb_trails_mbytes->setEnabled(mParams->trails_use == 1);
+
+    /* --- image export --- */
+    spb_img_width->setValue(mParams->opengl_img_width);
+    spb_img_height->setValue(mParams->opengl_img_height);
 
     /* --- embedding --- */
     if (mParams->opengl_emb_params.size() > 0 && mObject.currMetric != nullptr) {
@@ -289,6 +353,7 @@ void DrawView::adjustCoordNames()
     cob_ordinate->clear();
     cob_abscissa->setEnabled(false);
     cob_ordinate->setEnabled(false);
+    grb_draw2d_multiples->setEnabled(false);
     mDraw->setAbsOrd(enum_draw_coord_x0, enum_draw_coord_x0);
 
     for (int i = 0; i < 4; i++) {
@@ -297,11 +362,13 @@ void DrawView::adjustCoordNames()
             cob_abscissa->addItem(coordNames[i].c_str());
             cob_ordinate->addItem(coordNames[i].c_str());
             lst_lab_lastpoint_coordname[i]->setText(coordNames[i].c_str());
+            lst_lab_pick_coordname[i]->setText(coordNames[i].c_str());
         }
         else {
             cob_abscissa->addItem(QString(ch));
             cob_ordinate->addItem(QString(ch));
             lst_lab_lastpoint_coordname[i]->setText(QString(ch));
+            lst_lab_pick_coordname[i]->setText(QString(ch));
         }
     }
     QChar lch = mGreekLetter.toChar("lambda");
@@ -319,9 +386,26 @@ void DrawView::adjustCoordNames()
         }
     }
 
+    // Default panels: x1 vs x0, x3 vs x1, and dx1 vs the affine parameter.
+    QStringList names = getCoordNames();
+    led_draw2d_multiples_pairs->setText(QString("%1 vs %2, %3 vs %4, %5 vs %6")
+                                            .arg(names[enum_draw_coord_x1], names[enum_draw_coord_x0],
+                                                names[enum_draw_coord_x3], names[enum_draw_coord_x1],
+                                                names[enum_draw_coord_dx1], names[enum_draw_lambda]));
+    slot_setMultiples();
+
     slot_adjustAPname();
 }
 
+QStringList DrawView::getCoordNames()
+{
+    QStringList names;
+    for (int i = 0; i < cob_abscissa->count(); i++) {
+        names << cob_abscissa->itemText(i);
+    }
+    return names;
+}
+
 void DrawView::adjustDrawTypes()
 {
     if (mObject.currMetric == nullptr) {
@@ -452,6 +536,70 @@ bool DrawView::isAnimated()
     return pub_anim_rotate->isChecked();
 }
 
+void DrawView::adjustCameraPath()
+{
+    lab_path_info->setText(
+        QString("%1 keys, %2 s").arg(mOpenGL->numCameraKeys()).arg(mOpenGL->getCameraPathDuration(), 0, 'f', 2));
+}
+
+void DrawView::adjustColormap()
+{
+    bool mapped = (mParams->opengl_cmap_scalar != enum_geod_scalar_none);
+    bool autoRange = (mParams->opengl_cmap_auto == 1);
+    cob_cmap_scalar->setCurrentIndex(mParams->opengl_cmap_scalar);
+    cob_cmap_type->setCurrentIndex(mParams->opengl_cmap_type);
+    chb_cmap_auto->blockSignals(true);
+    chb_cmap_auto->setChecked(autoRange);
+    chb_cmap_auto->blockSignals(false);
+    cob_cmap_type->setEnabled(mapped);
+    chb_cmap_auto->setEnabled(mapped);
+    led_cmap_min->setEnabled(mapped && !autoRange);
+    led_cmap_max->setEnabled(mapped && !autoRange);
+
+    double min = mParams->opengl_cmap_min;
+    double max = mParams->opengl_cmap_max;
+    if (autoRange) {
+        mOpenGL->getColormapRange(min, max);
+    }
+    led_cmap_min->setValue(min);
+    led_cmap_max->setValue(max);
+}
+
+void DrawView::showPickedPoint(int index)
+{
+    size_t num = std::min(mObject.points.size(), mObject.dirs.size());
+    if (index < 0 || static_cast<size_t>(index) >= num) {
+        led_pick_index->setText(QString());
+        led_pick_affineparam->setText(QString());
+        for (int i = 0; i < 4; i++) {
+            lst_led_pick_pos_value[i]->setText(QString());
+            lst_led_pick_dir_value[i]->setText(QString());
+        }
+        led_pick_constraint->setText(QString());
+        return;
+    }
+
+    size_t idx = static_cast<size_t>(index);
+    led_pick_index->setText(QString::number(index));
+    if (idx < mObject.lambda.size()) {
+        led_pick_affineparam->setText(QString::number(mObject.lambda[idx], 'f', DEF_PREC_POSITION));
+    }
+    for (int i = 0; i < 4; i++) {
+        lst_led_pick_pos_value[i]->setText(QString::number(mObject.points[idx][i], 'f', DEF_PREC_POSITION));
+        lst_led_pick_dir_value[i]->setText(QString::number(mObject.dirs[idx][i], 'f', DEF_PREC_VELOCITY));
+    }
+
+    // Drift of g(u,u) from its value at the starting point.
+    if (mObject.currMetric != nullptr) {
+        double norm0 = getNorm(mObject.currMetric, mObject.points[0], mObject.dirs[0]);
+        double norm = getNorm(mObject.currMetric, mObject.points[idx], mObject.dirs[idx]);
+        led_pick_constraint->setText(QString::number(fabs(norm - norm0), 'e', DEF_PREC_VELOCITY));
+    }
+    else {
+        led_pick_constraint->setText(QString());
+    }
+}
+
 void DrawView::setGeodLength(int num)
 {
     sli_anim_geodlength->setMaximum(num);
@@ -548,12 +696,14 @@ void DrawView::slot_setDrawType()
     if (type == m4d::enum_draw_coordinates) {
         cob_abscissa->setEnabled(true);
         cob_ordinate->setEnabled(true);
+        grb_draw2d_multiples->setEnabled(true);
     }
     else {
         cob_abscissa->setEnabled(false);
         cob_ordinate->setEnabled(false);
+        grb_draw2d_multiples->setEnabled(false);
     }
-    emit calcGeodesic();
+    emit projectGeodesic();
 }
 
 void DrawView::slot_setAbsOrd()
@@ -566,6 +716,51 @@ void DrawView::slot_setAbsOrd()
     mParams->draw2d_ordinate = ordinate;
 }
 
+void DrawView::slot_setMultiples()
+{
+    std::vector<struct_plot_panel> panels;
+    if (grb_draw2d_multiples->isChecked()) {
+        QStringList items = led_draw2d_multiples_pairs->text().split(",", QString::SkipEmptyParts);
+        for (int i = 0; i < items.size(); i++) {
+            QStringList ordAbs = items[i].split(" vs ", QString::SkipEmptyParts);
+            int ordIdx = (ordAbs.size() == 2 ? getCoordIndex(ordAbs[0].trimmed()) : -1);
+            int absIdx = (ordAbs.size() == 2 ? getCoordIndex(ordAbs[1].trimmed()) : -1);
+            if (ordIdx < 0 || absIdx < 0) {
+                fprintf(stderr, "Cannot read panel '%s'!\n", items[i].trimmed().toStdString().c_str());
+                continue;
+            }
+            struct_plot_panel panel;
+            panel.abscissa = static_cast<enum_draw_coord_num>(absIdx);
+            panel.ordinate = static_cast<enum_draw_coord_num>(ordIdx);
+            panel.title = items[i].trimmed();
+            panels.push_back(panel);
+        }
+    }
+    mDraw->setMultiples(spb_draw2d_multiples_rows->value(), spb_draw2d_multiples_cols->value(), panels);
+}
+
+int DrawView::getCoordIndex(QString name)
+{
+    QStringList names = getCoordNames();
+    int idx = names.indexOf(name);
+    if (idx >= 0) {
+        return idx;
+    }
+
+    // Greek coordinates can also be typed by name.
+    QChar ch = mGreekLetter.toChar(name);
+    if (ch != QChar()) {
+        return names.indexOf(QString(ch));
+    }
+    if (name.startsWith("d")) {
+        ch = mGreekLetter.toChar(name.mid(1));
+        if (ch != QChar()) {
+            return names.indexOf(QString("d") + QString(ch));
+        }
+    }
+    return -1;
+}
+
 void DrawView::slot_setScaling()
 {
     double xmin = led_draw2d_x_min->getValue();
@@ -750,7 +945,7 @@ void DrawView::slot_setDrawType3d()
         mOpenGL->clearEmbed();
     }
 
-    emit calcGeodesic();
+    emit projectGeodesic();
 }
 
 void DrawView::slot_setFGcolor()
@@ -814,6 +1009,51 @@ void DrawView::slot_setSmoothLine()
     // mDraw->setLineSmooth(mParams->opengl_line_smooth);
 }
 
+void DrawView::slot_setLineMode()
+{
+    mParams->opengl_line_mode = cob_linemode->currentIndex();
+    mParams->opengl_tube_radius = dsb_tube_radius->value();
+    dsb_tube_radius->setEnabled(mParams->opengl_line_mode == enum_line_mode_tube);
+    mOpenGL->setLineMode(mParams->opengl_line_mode, mParams->opengl_tube_radius);
+}
+
+void DrawView::slot_setColormap()
+{
+    mParams->opengl_cmap_scalar = cob_cmap_scalar->currentIndex();
+    mParams->opengl_cmap_type = cob_cmap_type->currentIndex();
+    mParams->opengl_cmap_auto = (chb_cmap_auto->isChecked() ? 1 : 0);
+    if (mParams->opengl_cmap_auto == 0) {
+        mParams->opengl_cmap_min = led_cmap_min->getValue();
+        mParams->opengl_cmap_max = led_cmap_max->getValue();
+    }
+    mOpenGL->setColormap(mParams->opengl_cmap_scalar, mParams->opengl_cmap_type, mParams->opengl_cmap_auto == 1,
+        mParams->opengl_cmap_min, mParams->opengl_cmap_max);
+    adjustColormap();
+}
+
+void DrawView::slot_setTrails()
+{
+    if (chb_trails->isChecked()) {
+        mParams->trails_use = 1;
+    }
+    else {
+        mParams->trails_use = 0;
+    }
+    mParams->trails_num = spb_trails_num->value();
+    mParams->trails_max_mbytes = spb_trails_mbytes->value();
+    spb_trails_num->setEnabled(mParams->trails_use == 1);
+    spb_trails_mbytes->setEnabled(mParams->trails_use == 1);
+
+    mOpenGL->setTrails(mParams->trails_use, mParams->trails_num, mParams->trails_max_mbytes);
+    mDraw->setTrails(mParams->trails_use, mParams->trails_num, mParams->trails_max_mbytes);
+}
+
+void DrawView::slot_setImageSize()
+{
+    mParams->opengl_img_width = spb_img_width->value();
+    mParams->opengl_img_height = spb_img_height->value();
+}
+
 void DrawView::slot_set3dScaling()
 {
     mParams->opengl_scale_x = led_scale3d_x->getValue();
@@ -914,6 +1154,7 @@ void DrawView::slot_setFogDensityStep()
 void DrawView::slot_anim_rot_startstop()
 {
     if (pub_anim_rotate->isChecked()) {
+        mAnimClock.start();
         tim_anim_rotate->start();
         pub_anim_rotate->setText("Stop");
     }
@@ -938,7 +1179,7 @@ void DrawView::slot_anim_rotate()
     else {
         mParams->opengl_anim_local = 0;
     }
-    mOpenGL->doAnimRotation(30.0, local);
+    mOpenGL->doAnimRotation(static_cast<double>(mAnimClock.restart()), local);
     /*
     m4d::vec3 pos = mOpenGL->getCameraPos();
     led_eye_x->setValue(pos[0]);
@@ -962,6 +1203,109 @@ void DrawView::slot_setAnimRotateParamsStep()
     led_anim_rotate_z->setStep(led_anim_rotate_z_step->getValue());
 }
 
+void DrawView::slot_anim_export()
+{
+    struct_anim_export job;
+    job.command = led_anim_export_pipe->text().trimmed();
+    if (job.command.isEmpty()) {
+        QString filename
+            = QFileDialog::getSaveFileName(this, tr("Export animation frames"), QString(), DEF_IMG_FILE_FILTER);
+        if (filename == QString()) {
+            return;
+        }
+        if (filename.endsWith(DEF_IMG_FILE_ENDING)) {
+            filename.remove(DEF_IMG_FILE_ENDING);
+        }
+        job.filename = filename;
+    }
+
+    job.numFrames = spb_anim_frames->value();
+    job.fps = spb_anim_fps->value();
+    job.rotate = chb_anim_export_rotate->isChecked();
+    job.local = chb_anim_localrot->isChecked();
+    job.firstPoints = (chb_anim_export_grow->isChecked() ? 0 : -1);
+    job.lastPoints = sli_anim_geodlength->maximum();
+    job.cameraPath = (chb_anim_export_path->isChecked() && mOpenGL->numCameraKeys() > 0);
+    if (job.cameraPath) {
+        job.numFrames = static_cast<int>(mOpenGL->getCameraPathDuration() * job.fps + 0.5) + 1;
+    }
+
+    pub_anim_rotate->setChecked(false);
+    pub_path_play->setChecked(false);
+    mOpenGL->exportAnimation(job);
+}
+
+void DrawView::slot_path_addKey()
+{
+    if (!mOpenGL->addCameraKey(dsb_path_dt->value())) {
+        fprintf(stderr, "Cannot add camera key!\n");
+    }
+    adjustCameraPath();
+}
+
+void DrawView::slot_path_clear()
+{
+    pub_path_play->setChecked(false);
+    mOpenGL->clearCameraPath();
+    adjustCameraPath();
+}
+
+void DrawView::slot_path_startstop()
+{
+    if (pub_path_play->isChecked() && mOpenGL->numCameraKeys() > 0) {
+        pub_anim_rotate->setChecked(false);
+        mOpenGL->setPathPreview(true);
+        mPathClock.start();
+        tim_anim_path->start();
+        pub_path_play->setText("Stop");
+    }
+    else {
+        tim_anim_path->stop();
+        mOpenGL->setPathPreview(false);
+        pub_path_play->setText("Play");
+        pub_path_play->setChecked(false);
+        slot_adjustCamera();
+    }
+}
+
+void DrawView::slot_path_play()
+{
+    // Wall-clock time keeps the playback speed independent of the frame rate.
+    double t = mPathClock.elapsed() * 1e-3;
+    mOpenGL->setCameraPathTime(t);
+    if (t >= mOpenGL->getCameraPathDuration()) {
+        pub_path_play->setChecked(false);
+    }
+}
+
+void DrawView::slot_path_load()
+{
+    QString filename
+        = QFileDialog::getOpenFileName(this, tr("Load camera path"), QString(), DEF_CAMPATH_FILE_ENDING_PATTERN);
+    if (filename == QString()) {
+        return;
+    }
+
+    pub_path_play->setChecked(false);
+    if (!mOpenGL->loadCameraPath(filename)) {
+        fprintf(stderr, "Cannot load camera path %s!\n", filename.toLocal8Bit().constData());
+    }
+    adjustCameraPath();
+}
+
+void DrawView::slot_path_save()
+{
+    QString filename
+        = QFileDialog::getSaveFileName(this, tr("Save camera path"), QString(), DEF_CAMPATH_FILE_ENDING_PATTERN);
+    if (filename == QString()) {
+        return;
+    }
+    if (!filename.endsWith(DEF_CAMPATH_FILE_ENDING)) {
+        filename.append(DEF_CAMPATH_FILE_ENDING);
+    }
+    mOpenGL->saveCameraPath(filename);
+}
+
 void DrawView::slot_embParamChanged()
 {
     QObject* obj = sender();
@@ -990,6 +1334,7 @@ void DrawView::slot_adjustAPname()
         chAffine = mGreekLetter.toChar("lambda");
     }
     lab_lastpoint_affineparam->setText(chAffine);
+    lab_pick_affineparam->setText(chAffine);
 }
 
 void DrawView::slot_showNumPoints(int num)
@@ -1007,6 +1352,7 @@ void DrawView::init()
     initGUI();
     initControl();
     initStatusTips();
+    adjustCameraPath();
 }
 
 void DrawView::initElements()
@@ -1018,6 +1364,7 @@ void DrawView::initElements()
     wgt_draw_3dstereo = new QWidget();
     wgt_draw_3danim = new QWidget();
     wgt_draw_3demb = new QWidget();
+    wgt_draw_pick = new QWidget();
 
     // ---------------------------------
     //    2-D
@@ -1080,6 +1427,22 @@ void DrawView::initElements()
     led_draw2d_currY = new QLineEdit();
     led_draw2d_currY->setReadOnly(true);
 
+    grb_draw2d_multiples = new QGroupBox("Small multiples");
+    grb_draw2d_multiples->setCheckable(true);
+    grb_draw2d_multiples->setChecked(false);
+    grb_draw2d_multiples->setEnabled(false);
+
+    lab_draw2d_multiples_grid = new QLabel("rows x cols");
+    spb_draw2d_multiples_rows = new QSpinBox();
+    spb_draw2d_multiples_rows->setRange(1, DEF_DRAW2D_MULTIPLES_MAX);
+    spb_draw2d_multiples_rows->setValue(1);
+    spb_draw2d_multiples_cols = new QSpinBox();
+    spb_draw2d_multiples_cols->setRange(1, DEF_DRAW2D_MULTIPLES_MAX);
+    spb_draw2d_multiples_cols->setValue(3);
+
+    lab_draw2d_multiples_pairs = new QLabel("panels");
+    led_draw2d_multiples_pairs = new QLineEdit();
+
     // ---------------------------------
     //    3-D
     // ---------------------------------
@@ -1123,9 +1486,51 @@ void DrawView::initElements()
 
     lab_linewidth = new QLabel("Line width");
     spb_linewidth = new QSpinBox();
-    spb_linewidth->setRange(1, 5);
+    spb_linewidth->setRange(1, DEF_OPENGL_MAX_LINE_WIDTH);
 
     chb_linesmooth = new QCheckBox("smooth");
+
+    cob_linemode = new QComboBox();
+    cob_linemode->addItems(stl_line_modes);
+    cob_linemode->setCurrentIndex(mParams->opengl_line_mode);
+    dsb_tube_radius = new QDoubleSpinBox();
+    dsb_tube_radius->setRange(0.001, 10.0);
+    dsb_tube_radius->setSingleStep(0.01);
+    dsb_tube_radius->setDecimals(3);
+    dsb_tube_radius->setValue(mParams->opengl_tube_radius);
+    dsb_tube_radius->setKeyboardTracking(false);
+
+    cob_cmap_scalar = new QComboBox();
+    cob_cmap_scalar->addItems(stl_geod_scalars);
+    cob_cmap_scalar->setCurrentIndex(mParams->opengl_cmap_scalar);
+    cob_cmap_type = new QComboBox();
+    cob_cmap_type->addItems(stl_colormaps);
+    cob_cmap_type->setCurrentIndex(mParams->opengl_cmap_type);
+    chb_cmap_auto = new QCheckBox("auto");
+    chb_cmap_auto->setChecked(mParams->opengl_cmap_auto == 1);
+    led_cmap_min = new DoubleEdit(DEF_PREC_COLORMAP, mParams->opengl_cmap_min, 0.1);
+    led_cmap_max = new DoubleEdit(DEF_PREC_COLORMAP, mParams->opengl_cmap_max, 0.1);
+
+    chb_trails = new QCheckBox("Trails");
+    spb_trails_num = new QSpinBox();
+    spb_trails_num->setRange(1, DEF_TRAILS_MAX_NUM);
+    spb_trails_num->setValue(mParams->trails_num);
+    spb_trails_num->setEnabled(false);
+    spb_trails_mbytes = new QSpinBox();
+    spb_trails_mbytes->setRange(1, DEF_TRAILS_MAX_MBYTES);
+    spb_trails_mbytes->setSuffix(" MB");
+    spb_trails_mbytes->setValue(mParams->trails_max_mbytes);
+    spb_trails_mbytes->setEnabled(false);
+
+    lab_imgsize = new QLabel("Image size");
+    spb_img_width = new QSpinBox();
+    spb_img_width->setRange(0, DEF_OPENGL_IMG_MAX_SIZE);
+    spb_img_width->setSpecialValueText("window");
+    spb_img_width->setValue(mParams->opengl_img_width);
+    spb_img_height = new QSpinBox();
+    spb_img_height->setRange(0, DEF_OPENGL_IMG_MAX_SIZE);
+    spb_img_height->setSpecialValueText("window");
+    spb_img_height->setValue(mParams->opengl_img_height);
     lab_drawtype3d = new QLabel("type");
     cob_drawtype3d = new QComboBox();
     cob_drawtype3d->setCurrentIndex(mParams->opengl_draw3d_type);
@@ -1238,6 +1643,38 @@ void DrawView::initElements()
     pub_anim_rotate = new QPushButton("Play");
     pub_anim_rotate->setCheckable(true);
 
+    spb_anim_frames = new QSpinBox();
+    spb_anim_frames->setRange(1, 100000);
+    spb_anim_frames->setValue(DEF_ANIM_EXPORT_FRAMES);
+    spb_anim_frames->setSuffix(" frames");
+    spb_anim_fps = new QSpinBox();
+    spb_anim_fps->setRange(1, 240);
+    spb_anim_fps->setValue(DEF_ANIM_EXPORT_FPS);
+    spb_anim_fps->setSuffix(" fps");
+    chb_anim_export_rotate = new QCheckBox("Rotate");
+    chb_anim_export_rotate->setChecked(true);
+    chb_anim_export_grow = new QCheckBox("Grow geodesic");
+    chb_anim_export_grow->setChecked(false);
+    chb_anim_export_path = new QCheckBox("Camera path");
+    chb_anim_export_path->setChecked(false);
+    led_anim_export_pipe = new QLineEdit();
+    led_anim_export_pipe->setPlaceholderText(
+        "ffmpeg -y -f rawvideo -pix_fmt rgb24 -s {width}x{height} -r {fps} -i - out.mp4");
+    pub_anim_export = new QPushButton("Export...");
+
+    dsb_path_dt = new QDoubleSpinBox();
+    dsb_path_dt->setRange(0.01, 600.0);
+    dsb_path_dt->setSingleStep(0.5);
+    dsb_path_dt->setValue(DEF_CAMPATH_KEY_DT);
+    dsb_path_dt->setSuffix(" s");
+    pub_path_add = new QPushButton("Add key");
+    pub_path_clear = new QPushButton("Clear");
+    pub_path_play = new QPushButton("Play");
+    pub_path_play->setCheckable(true);
+    pub_path_load = new QPushButton("Load...");
+    pub_path_save = new QPushButton("Save...");
+    lab_path_info = new QLabel();
+
     sli_anim_geodlength = new QSlider(Qt::Horizontal);
     sli_anim_geodlength->setRange(0, 0);
     lcd_anim_geodlength = new QLCDNumber();
@@ -1267,6 +1704,8 @@ void DrawView::initElements()
 
     tim_anim_rotate = new QTimer();
     tim_anim_rotate->setInterval(33);
+    tim_anim_path = new QTimer();
+    tim_anim_path->setInterval(DEF_CAMPATH_PLAY_INTERVAL);
 
     // ---------------------------------
     //    3-D  embedding
@@ -1291,6 +1730,43 @@ void DrawView::initElements()
     dsb_emb_offset->setDecimals(2);
     dsb_emb_offset->setValue(0.0);
     dsb_emb_offset->setKeyboardTracking(false);
+
+    // ---------------------------------
+    //    picked point
+    // ---------------------------------
+    lab_pick_index = new QLabel("#");
+    led_pick_index = new QLineEdit();
+    led_pick_index->setReadOnly(true);
+    led_pick_index->setAlignment(Qt::AlignRight);
+
+    lab_pick_affineparam = new QLabel(chAffine);
+    led_pick_affineparam = new QLineEdit();
+    led_pick_affineparam->setReadOnly(true);
+    led_pick_affineparam->setAlignment(Qt::AlignRight);
+
+    lab_pick_pos = new QLabel("position");
+    lab_pick_dir = new QLabel("direction");
+    for (int i = 0; i < 4; i++) {
+        QLabel* lab = new QLabel(coordnames[i]);
+        lab->setMaximumSize(12, 20);
+        lab->setMinimumSize(12, 20);
+        lst_lab_pick_coordname.push_back(lab);
+
+        QLineEdit* led_pos = new QLineEdit();
+        led_pos->setReadOnly(true);
+        led_pos->setAlignment(Qt::AlignRight);
+        lst_led_pick_pos_value.push_back(led_pos);
+
+        QLineEdit* led_dir = new QLineEdit();
+        led_dir->setReadOnly(true);
+        led_dir->setAlignment(Qt::AlignRight);
+        lst_led_pick_dir_value.push_back(led_dir);
+    }
+
+    lab_pick_constraint = new QLabel("constraint");
+    led_pick_constraint = new QLineEdit();
+    led_pick_constraint->setReadOnly(true);
+    led_pick_constraint->setAlignment(Qt::AlignRight);
 }
 
 void DrawView::initGUI()
@@ -1335,6 +1811,14 @@ void DrawView::initGUI()
     layout_2d_colors->setRowStretch(2, 10);
     grb_2d_colors->setLayout(layout_2d_colors);
 
+    QGridLayout* layout_2d_multiples = new QGridLayout();
+    layout_2d_multiples->addWidget(lab_draw2d_multiples_grid, 0, 0);
+    layout_2d_multiples->addWidget(spb_draw2d_multiples_rows, 0, 1);
+    layout_2d_multiples->addWidget(spb_draw2d_multiples_cols, 0, 2);
+    layout_2d_multiples->addWidget(lab_draw2d_multiples_pairs, 1, 0);
+    layout_2d_multiples->addWidget(led_draw2d_multiples_pairs, 1, 1, 1, 2);
+    grb_draw2d_multiples->setLayout(layout_2d_multiples);
+
     QHBoxLayout* layout_2d_proj = new QHBoxLayout();
     layout_2d_proj->addWidget(cob_drawtype, 0);
     layout_2d_proj->addWidget(lab_abscissa, 1);
@@ -1346,6 +1830,7 @@ void DrawView::initGUI()
     layout_2d->addLayout(layout_2d_proj);
     layout_2d->addWidget(grb_2d_scaling);
     layout_2d->addWidget(grb_2d_colors);
+    layout_2d->addWidget(grb_draw2d_multiples);
     wgt_draw_2d->setLayout(layout_2d);
 
     // ---------------------------------
@@ -1361,8 +1846,21 @@ void DrawView::initGUI()
     layout_3d_col->addWidget(chb_linesmooth, 1, 2);
     layout_3d_col->addWidget(lab_bgcolor, 2, 0);
     layout_3d_col->addWidget(pub_bgcolor, 2, 1);
+    layout_3d_col->addWidget(chb_trails, 3, 0);
+    layout_3d_col->addWidget(spb_trails_num, 3, 1);
+    layout_3d_col->addWidget(spb_trails_mbytes, 3, 2);
+    layout_3d_col->addWidget(cob_linemode, 4, 0);
+    layout_3d_col->addWidget(dsb_tube_radius, 4, 1);
+    layout_3d_col->addWidget(cob_cmap_scalar, 5, 0);
+    layout_3d_col->addWidget(cob_cmap_type, 5, 1);
+    layout_3d_col->addWidget(chb_cmap_auto, 5, 2);
+    layout_3d_col->addWidget(led_cmap_min, 6, 1);
+    layout_3d_col->addWidget(led_cmap_max, 6, 2);
+    layout_3d_col->addWidget(lab_imgsize, 7, 0);
+    layout_3d_col->addWidget(spb_img_width, 7, 1);
+    layout_3d_col->addWidget(spb_img_height, 7, 2);
     // layout_3d_bg->addSpacing(200);
-    layout_3d_col->setRowStretch(3, 10);
+    layout_3d_col->setRowStretch(8, 10);
     grb_3d_col->setLayout(layout_3d_col);
 
     QGroupBox* grb_3d_pos = new QGroupBox("Camera parameters");
@@ -1488,9 +1986,33 @@ void DrawView::initGUI()
     layout_geod_length->addLayout(layout_geod_last);
     grb_geod_length->setLayout(layout_geod_length);
 
+    QGroupBox* grb_anim_export = new QGroupBox("Export");
+    QGridLayout* layout_anim_export = new QGridLayout();
+    layout_anim_export->addWidget(spb_anim_frames, 0, 0);
+    layout_anim_export->addWidget(spb_anim_fps, 0, 1);
+    layout_anim_export->addWidget(chb_anim_export_rotate, 0, 2);
+    layout_anim_export->addWidget(chb_anim_export_grow, 0, 3);
+    layout_anim_export->addWidget(chb_anim_export_path, 0, 4);
+    layout_anim_export->addWidget(led_anim_export_pipe, 1, 0, 1, 4);
+    layout_anim_export->addWidget(pub_anim_export, 1, 4);
+    grb_anim_export->setLayout(layout_anim_export);
+
+    QGroupBox* grb_cam_path = new QGroupBox("Camera path");
+    QGridLayout* layout_cam_path = new QGridLayout();
+    layout_cam_path->addWidget(dsb_path_dt, 0, 0);
+    layout_cam_path->addWidget(pub_path_add, 0, 1);
+    layout_cam_path->addWidget(pub_path_clear, 0, 2);
+    layout_cam_path->addWidget(pub_path_play, 0, 3);
+    layout_cam_path->addWidget(lab_path_info, 1, 0, 1, 2);
+    layout_cam_path->addWidget(pub_path_load, 1, 2);
+    layout_cam_path->addWidget(pub_path_save, 1, 3);
+    grb_cam_path->setLayout(layout_cam_path);
+
     QVBoxLayout* layout_anim = new QVBoxLayout();
     layout_anim->addWidget(grb_rotate_anim);
     layout_anim->addWidget(grb_geod_length);
+    layout_anim->addWidget(grb_cam_path);
+    layout_anim->addWidget(grb_anim_export);
     wgt_draw_3danim->setLayout(layout_anim);
 
     // ---------------------------------
@@ -1509,6 +2031,26 @@ void DrawView::initGUI()
     layout_emb->addWidget(dsb_emb_offset, 1, 3);
     wgt_draw_3demb->setLayout(layout_emb);
 
+    // ---------------------------------
+    //    picked point
+    // ---------------------------------
+    QGridLayout* layout_pick = new QGridLayout();
+    layout_pick->addWidget(lab_pick_index, 0, 0);
+    layout_pick->addWidget(led_pick_index, 0, 1);
+    layout_pick->addWidget(lab_pick_affineparam, 0, 2);
+    layout_pick->addWidget(led_pick_affineparam, 0, 3);
+    layout_pick->addWidget(lab_pick_pos, 1, 1, Qt::AlignHCenter | Qt::AlignVCenter);
+    layout_pick->addWidget(lab_pick_dir, 1, 2, 1, 2, Qt::AlignHCenter | Qt::AlignVCenter);
+    for (int i = 0; i < 4; i++) {
+        layout_pick->addWidget(lst_lab_pick_coordname[i], i + 2, 0);
+        layout_pick->addWidget(lst_led_pick_pos_value[i], i + 2, 1);
+        layout_pick->addWidget(lst_led_pick_dir_value[i], i + 2, 2, 1, 2);
+    }
+    layout_pick->addWidget(lab_pick_constraint, 6, 0, 1, 2);
+    layout_pick->addWidget(led_pick_constraint, 6, 2, 1, 2);
+    layout_pick->setRowStretch(7, 1);
+    wgt_draw_pick->setLayout(layout_pick);
+
     // ---------------------------------
     //    set all tab widgets
     // --------------------------------- */
@@ -1518,6 +2060,7 @@ void DrawView::initGUI()
     tab_draw->addTab(wgt_draw_3danim, "3D anim");
     tab_draw->addTab(wgt_draw_3demb, "3D emb");
     tab_draw->addTab(wgt_draw_2d, "2D");
+    tab_draw->addTab(wgt_draw_pick, "Pick");
 
     this->setTitle("DrawHandling");
     QGridLayout* layout_draw = new QGridLayout();
@@ -1531,6 +2074,10 @@ void DrawView::initControl()
     connect(cob_drawtype3d, SIGNAL(activated(int)), this, SLOT(slot_setDrawType3d()));
     connect(cob_abscissa, SIGNAL(activated(int)), this, SLOT(slot_setAbsOrd()));
     connect(cob_ordinate, SIGNAL(activated(int)), this, SLOT(slot_setAbsOrd()));
+    connect(grb_draw2d_multiples, SIGNAL(toggled(bool)), this, SLOT(slot_setMultiples()));
+    connect(spb_draw2d_multiples_rows, SIGNAL(valueChanged(int)), this, SLOT(slot_setMultiples()));
+    connect(spb_draw2d_multiples_cols, SIGNAL(valueChanged(int)), this, SLOT(slot_setMultiples()));
+    connect(led_draw2d_multiples_pairs, SIGNAL(editingFinished()), this, SLOT(slot_setMultiples()));
 
     connect(led_draw2d_x_min, SIGNAL(editingFinished()), this, SLOT(slot_setScaling()));
     connect(led_draw2d_x_max, SIGNAL(editingFinished()), this, SLOT(slot_setScaling()));
@@ -1556,6 +2103,18 @@ void DrawView::initControl()
     connect(dsb_emb_offset, SIGNAL(valueChanged(double)), this, SLOT(slot_setEmbParams()));
     connect(spb_linewidth, SIGNAL(valueChanged(int)), this, SLOT(slot_setLineWidth()));
     connect(chb_linesmooth, SIGNAL(clicked()), this, SLOT(slot_setSmoothLine()));
+    connect(cob_linemode, SIGNAL(activated(int)), this, SLOT(slot_setLineMode()));
+    connect(dsb_tube_radius, SIGNAL(valueChanged(double)), this, SLOT(slot_setLineMode()));
+    connect(cob_cmap_scalar, SIGNAL(activated(int)), this, SLOT(slot_setColormap()));
+    connect(cob_cmap_type, SIGNAL(activated(int)), this, SLOT(slot_setColormap()));
+    connect(chb_cmap_auto, SIGNAL(toggled(bool)), this, SLOT(slot_setColormap()));
+    connect(led_cmap_min, SIGNAL(editingFinished()), this, SLOT(slot_setColormap()));
+    connect(led_cmap_max, SIGNAL(editingFinished()), this, SLOT(slot_setColormap()));
+    connect(chb_trails, SIGNAL(clicked()), this, SLOT(slot_setTrails()));
+    connect(spb_trails_num, SIGNAL(valueChanged(int)), this, SLOT(slot_setTrails()));
+    connect(spb_trails_mbytes, SIGNAL(valueChanged(int)), this, SLOT(slot_setTrails()));
+    connect(spb_img_width, SIGNAL(valueChanged(int)), this, SLOT(slot_setImageSize()));
+    connect(spb_img_height, SIGNAL(valueChanged(int)), this, SLOT(slot_setImageSize()));
 
     connect(led_scale3d_x, SIGNAL(editingFinished()), this, SLOT(slot_set3dScaling()));
     connect(led_scale3d_y, SIGNAL(editingFinished()), this, SLOT(slot_set3dScaling()));
@@ -1597,6 +2156,13 @@ void DrawView::initControl()
     connect(pub_anim_rotate, SIGNAL(toggled(bool)), this, SLOT(slot_anim_rot_startstop()));
     connect(tim_anim_rotate, SIGNAL(timeout()), this, SLOT(slot_anim_rotate()));
 
+    connect(pub_anim_export, SIGNAL(pressed()), this, SLOT(slot_anim_export()));
+    connect(pub_path_add, SIGNAL(pressed()), this, SLOT(slot_path_addKey()));
+    connect(pub_path_clear, SIGNAL(pressed()), this, SLOT(slot_path_clear()));
+    connect(pub_path_play, SIGNAL(toggled(bool)), this, SLOT(slot_path_startstop()));
+    connect(tim_anim_path, SIGNAL(timeout()), this, SLOT(slot_path_play()));
+    connect(pub_path_load, SIGNAL(pressed()), this, SLOT(slot_path_load()));
+    connect(pub_path_save, SIGNAL(pressed()), this, SLOT(slot_path_save()));
     connect(sli_anim_geodlength, SIGNAL(valueChanged(int)), lcd_anim_geodlength, SLOT(display(int)));
     connect(sli_anim_geodlength, SIGNAL(valueChanged(int)), this, SLOT(slot_showNumPoints(int)));
 }
@@ -1607,6 +2173,10 @@ void DrawView::initStatusTips()
     cob_drawtype->setStatusTip(tr("Set draw type for 2D view."));
     cob_abscissa->setStatusTip(tr("Select coordinate for abscissa."));
     cob_ordinate->setStatusTip(tr("Select coordinate for ordinate."));
+    grb_draw2d_multiples->setStatusTip(tr("Show a grid of coordinate plots, each fitted to its data."));
+    spb_draw2d_multiples_rows->setStatusTip(tr("Number of panel rows."));
+    spb_draw2d_multiples_cols->setStatusTip(tr("Number of panel columns."));
+    led_draw2d_multiples_pairs->setStatusTip(tr("Panels row by row as 'ordinate vs abscissa', separated by commas."));
 
     led_draw2d_x_min->setStatusTip(tr("Set minimum of 2D view for abscissa."));
     led_draw2d_x_max->setStatusTip(tr("Set maximum of 2D view for abscissa."));
@@ -1624,6 +2194,18 @@ void DrawView::initStatusTips()
     led_poi_x->setStatusTip(tr("Camera's point of interest."));
     led_poi_y->setStatusTip(tr("Camera's point of interest."));
     led_poi_z->setStatusTip(tr("Camera's point of interest."));
+    chb_trails->setStatusTip(tr("Keep previous geodesics as fading trails in 2D and 3D view."));
+    spb_trails_num->setStatusTip(tr("Number of trails."));
+    spb_trails_mbytes->setStatusTip(tr("GPU memory for the trails of each view."));
+    cob_linemode->setStatusTip(tr("Draw geodesic as GL lines, thick screen-space lines, or tubes."));
+    dsb_tube_radius->setStatusTip(tr("Radius of tubes."));
+    cob_cmap_scalar->setStatusTip(tr("Color geodesic by a scalar along the trajectory."));
+    cob_cmap_type->setStatusTip(tr("Colormap for the scalar."));
+    chb_cmap_auto->setStatusTip(tr("Map the range of the scalar over the whole trajectory."));
+    led_cmap_min->setStatusTip(tr("Scalar value at the lower end of the colormap."));
+    led_cmap_max->setStatusTip(tr("Scalar value at the upper end of the colormap."));
+    spb_img_width->setStatusTip(tr("Width of saved 3D images; large images are rendered in tiles."));
+    spb_img_height->setStatusTip(tr("Height of saved 3D images; large images are rendered in tiles."));
 
     led_scale3d_x->setStatusTip(tr("Scale factor for 3D view."));
     led_scale3d_x_step->setStatusTip(tr("Step size for scale factor."));
@@ -1648,6 +2230,22 @@ void DrawView::initStatusTips()
     led_anim_rotate_y_step->setStatusTip(tr("Step size for rotation around y axis."));
     led_anim_rotate_z->setStatusTip(tr("Velocity of rotation around z axis."));
     led_anim_rotate_z_step->setStatusTip(tr("Step size for rotation around z axis."));
+    spb_anim_frames->setStatusTip(tr("Number of exported animation frames."));
+    spb_anim_fps->setStatusTip(tr("Frame rate of exported animation; sets the rotation per frame."));
+    chb_anim_export_rotate->setStatusTip(tr("Rotate camera during exported animation."));
+    chb_anim_export_grow->setStatusTip(tr("Grow geodesic from the first to the last point during exported animation."));
+    led_anim_export_pipe->setStatusTip(
+        tr("Command reading raw rgb24 frames from stdin; {width}, {height}, {fps} are replaced. Empty: png images."));
+    chb_anim_export_path->setStatusTip(tr("Follow the camera path; the number of frames is given by its duration."));
+    dsb_path_dt->setStatusTip(tr("Time between the last and the added keyframe."));
+    pub_path_add->setStatusTip(tr("Append current camera as keyframe."));
+    pub_path_clear->setStatusTip(tr("Remove all keyframes."));
+    pub_path_play->setStatusTip(tr("Preview camera path in real time with plain lines."));
+    pub_path_load->setStatusTip(tr("Load camera path."));
+    pub_path_save->setStatusTip(tr("Save camera path."));
+    pub_anim_export->setStatusTip(tr("Render animation offscreen at the 3D image size and export its frames."));
     sli_anim_geodlength->setStatusTip(tr("Number of points to be shown."));
+    led_pick_index->setStatusTip(tr("Index of the point picked by Shift+click in a 3D or 2D view."));
+    led_pick_constraint->setStatusTip(tr("Constraint error |g(u,u) - g(u0,u0)| at the picked point."));
 #endif
 }
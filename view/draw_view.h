@@ -11,6 +11,7 @@
        <li>3D animations<br><img src="../pics/draw_3d_animate.png">
        <li>3D embeddings<br><img src="../pics/draw_3d_embed.png">
        <li>General 2D parameters<br><img src="../pics/draw_2d.png">
+       <li>Picked point of the geodesic (Shift+click in a view)
      </ul>
 
  * This file is part of GeodesicView.
@@ -22,6 +23,7 @@
 
 #include <QCheckBox>
 #include <QComboBox>
+#include <QElapsedTimer>
 #include <QGroupBox>
 #include <QLCDNumber>
 #include <QLabel>
@@ -59,6 +61,11 @@ public:
     void updateParams();
 
     void adjustCoordNames();
+
+    /**
+     * @brief Names of coordinates, affine parameter, and directions as listed for abscissa and ordinate.
+     */
+    QStringList getCoordNames();
     void adjustDrawTypes();
     void adjustEmbParams();
     void adjustLastPoint(unsigned int num = 0);
@@ -76,6 +83,22 @@ public:
 
     void setGeodLength(int num);
 
+    /**
+     * @brief Show number of keyframes and duration of the camera path.
+     */
+    void adjustCameraPath();
+
+    /**
+     * @brief Show colormap settings; the range is the one of the current trajectory in auto mode.
+     */
+    void adjustColormap();
+
+    /**
+     * @brief Show position, direction, affine parameter, and constraint error of a geodesic point.
+     * @param index  Point index, or -1 to clear the fields.
+     */
+    void showPickedPoint(int index);
+
 public slots:
     void setType(int num);
     void setPosition(double x, double y, double z);
@@ -91,6 +114,7 @@ public slots:
 protected slots:
     void slot_setDrawType();
     void slot_setAbsOrd();
+    void slot_setMultiples();
 
     void slot_setScaling();
     void slot_resetScaling();
@@ -118,6 +142,10 @@ protected slots:
     void slot_setEmbParams();
     void slot_setLineWidth();
     void slot_setSmoothLine();
+    void slot_setLineMode();
+    void slot_setColormap();
+    void slot_setTrails();
+    void slot_setImageSize();
 
     void slot_set3dScaling();
     void slot_set3dScalingStep();
@@ -136,6 +164,14 @@ protected slots:
     void slot_anim_rotate();
     void slot_setAnimRotateParams();
     void slot_setAnimRotateParamsStep();
+    void slot_anim_export();
+
+    void slot_path_addKey();
+    void slot_path_clear();
+    void slot_path_startstop();
+    void slot_path_play();
+    void slot_path_load();
+    void slot_path_save();
 
     void slot_embParamChanged();
 
@@ -144,6 +180,7 @@ protected slots:
 
 signals:
     void calcGeodesic();
+    void projectGeodesic();
     void colorChanged();
     void lastPointChanged(int num);
 
@@ -154,6 +191,13 @@ protected:
     void initControl();
     void initStatusTips();
 
+    /**
+     * @brief Index of a coordinate name as listed for abscissa and ordinate.
+     * @param name  Listed name, or name of a Greek letter, e.g. 'theta' or 'dtheta'.
+     * @return index, or -1 if there is no such coordinate.
+     */
+    int getCoordIndex(QString name);
+
 private:
     OpenGL3dModel* mOpenGL;
     OpenGL2dModel* mDraw;
@@ -167,6 +211,7 @@ private:
     QWidget* wgt_draw_3dstereo;
     QWidget* wgt_draw_3danim;
     QWidget* wgt_draw_3demb;
+    QWidget* wgt_draw_pick;
 
     // ----------------------
     //         2-D
@@ -204,6 +249,13 @@ private:
     QLineEdit* led_draw2d_currX;
     QLineEdit* led_draw2d_currY;
 
+    QGroupBox* grb_draw2d_multiples;
+    QLabel* lab_draw2d_multiples_grid;
+    QSpinBox* spb_draw2d_multiples_rows;
+    QSpinBox* spb_draw2d_multiples_cols;
+    QLabel* lab_draw2d_multiples_pairs;
+    QLineEdit* led_draw2d_multiples_pairs;
+
     // ----------------------
     //         3-D
     // ----------------------
@@ -216,6 +268,19 @@ private:
     QLabel* lab_linewidth;
     QSpinBox* spb_linewidth;
     QCheckBox* chb_linesmooth;
+    QComboBox* cob_linemode;
+    QDoubleSpinBox* dsb_tube_radius;
+    QComboBox* cob_cmap_scalar;
+    QComboBox* cob_cmap_type;
+    QCheckBox* chb_cmap_auto;
+    DoubleEdit* led_cmap_min;
+    DoubleEdit* led_cmap_max;
+    QCheckBox* chb_trails;
+    QSpinBox* spb_trails_num;
+    QSpinBox* spb_trails_mbytes;
+    QLabel* lab_imgsize;
+    QSpinBox* spb_img_width;
+    QSpinBox* spb_img_height;
     QLabel* lab_drawtype3d;
     QComboBox* cob_drawtype3d;
     QLabel* lab_eye_x;
@@ -285,6 +350,25 @@ private:
     DoubleEdit* led_anim_rotate_z_step;
     QPushButton* pub_anim_rotate;
     QTimer* tim_anim_rotate;
+    QElapsedTimer mAnimClock;
+
+    QDoubleSpinBox* dsb_path_dt;
+    QPushButton* pub_path_add;
+    QPushButton* pub_path_clear;
+    QPushButton* pub_path_play;
+    QPushButton* pub_path_load;
+    QPushButton* pub_path_save;
+    QLabel* lab_path_info;
+    QTimer* tim_anim_path;
+    QElapsedTimer mPathClock;
+
+    QSpinBox* spb_anim_frames;
+    QSpinBox* spb_anim_fps;
+    QCheckBox* chb_anim_export_rotate;
+    QCheckBox* chb_anim_export_grow;
+    QCheckBox* chb_anim_export_path;
+    QLineEdit* led_anim_export_pipe;
+    QPushButton* pub_anim_export;
 
     QSlider* sli_anim_geodlength;
     QLCDNumber* lcd_anim_geodlength;
@@ -302,6 +386,21 @@ private:
     QLabel* lab_emb_offset;
     QDoubleSpinBox* dsb_emb_offset;
 
+    // ----------------------
+    //      picked point
+    // ----------------------
+    QLabel* lab_pick_index;
+    QLineEdit* led_pick_index;
+    QLabel* lab_pick_affineparam;
+    QLineEdit* led_pick_affineparam;
+    QLabel* lab_pick_pos;
+    QLabel* lab_pick_dir;
+    QList<QLabel*> lst_lab_pick_coordname;
+    QList<QLineEdit*> lst_led_pick_pos_value;
+    QList<QLineEdit*> lst_led_pick_dir_value;
+    QLabel* lab_pick_constraint;
+    QLineEdit* led_pick_constraint;
+
     // ----------------------
     //    other things
     // ----------------------
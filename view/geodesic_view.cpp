@@ -13,6 +13,7 @@
 #include <QScrollArea>
 
 extern m4d::Object mObject;
+extern unsigned int mObjectRevision;
 
 #ifdef HAVE_LUA
 #include "lua/m4dlua_metric.h"
@@ -22,12 +23,24 @@ extern m4d::Object mObject;
 
 GeodesicView* GeodesicView::m_instance = nullptr;
 
+namespace {
+
+// Coordinate pairs of the additional plots until the user picks others.
+const enum_draw_coord_num plotAbscissa[] = { enum_draw_coord_x0, enum_draw_lambda };
+const enum_draw_coord_num plotOrdinate[] = { enum_draw_coord_x1, enum_draw_coord_dx1 };
+
+} // namespace
+
 GeodesicView::GeodesicView()
     : QMainWindow(nullptr)
 {    
     mPreviousFolder = QApplication::applicationDirPath();
 
     setStandardParams(&mParams);
+    mRestoringState = false;
+    mActionUndo = nullptr;
+    mActionRedo = nullptr;
+    mActionTiledViews = nullptr;
     init();
     // tab_draw->setCurrentIndex(1);
 }
@@ -212,6 +225,37 @@ void GeodesicView::slot_save_image_2d()
     tab_draw->setCurrentIndex(currIdx);
 }
 
+void GeodesicView::slot_save_vector_2d()
+{
+    QString filename
+        = QFileDialog::getSaveFileName(this, tr("Save 2D vector graphics"), mPreviousFolder, DEF_VEC_FILE_FILTER);
+
+    if (filename == QString()) {
+        return;
+    }
+
+    mPreviousFolder = QFileInfo(filename).absoluteDir().absolutePath();
+
+    if (!filename.endsWith(DEF_SVG_FILE_ENDING) && !filename.endsWith(DEF_PDF_FILE_ENDING)) {
+        filename.append(DEF_SVG_FILE_ENDING);
+    }
+
+    int currIdx = tab_draw->currentIndex();
+    tab_draw->setCurrentIndex(1);
+    struct_soft_job job;
+    draw2d->getSoftJob(job);
+    tab_draw->setCurrentIndex(currIdx);
+
+    VectorExporter exporter;
+    if (exporter.save(filename, job)) {
+        led_status->setText(
+            QString("%1 of %2 vertices exported").arg(exporter.getNumOutputVerts()).arg(exporter.getNumInputVerts()));
+    }
+    else {
+        led_status->setText("export 2D vector graphics failed");
+    }
+}
+
 void GeodesicView::slot_save_image_3d()
 {
     QString filename = QFileDialog::getSaveFileName(this, tr("Save 3D image"), mPreviousFolder, DEF_3D_FILE_FILTER);
@@ -269,6 +313,13 @@ void GeodesicView::slot_load_all()
 
         QString objFilename = basefilename + QString(DEF_OBJECT_FILE_ENDING);
         loadObjects(objFilename);
+
+        QString pathFilename = basefilename + QString(DEF_CAMPATH_FILE_ENDING);
+        opengl->clearCameraPath();
+        if (QFileInfo(pathFilename).exists()) {
+            opengl->loadCameraPath(pathFilename);
+        }
+        drw_view->adjustCameraPath();
         calculateGeodesic();
     }
 }
@@ -303,6 +354,7 @@ void GeodesicView::slot_write_prot()
     basefilename.remove(DEF_PROTOCOL_FILE_ENDING);
     basefilename.remove(DEF_VPARAMS_FILE_ENDING);
     basefilename.remove(DEF_OBJECT_FILE_ENDING);
+    basefilename.remove(DEF_CAMPATH_FILE_ENDING);
 
     // ---------------------------------
     //    save settings
@@ -320,6 +372,12 @@ void GeodesicView::slot_write_prot()
         QString filename = dirname + "/" + basefilename;
         filename.append(DEF_VPARAMS_FILE_ENDING);
         saveParamFile(filename.toStdString(), &mParams);
+
+        if (opengl->numCameraKeys() > 0) {
+            filename = dirname + "/" + basefilename;
+            filename.append(DEF_CAMPATH_FILE_ENDING);
+            opengl->saveCameraPath(filename);
+        }
     }
 
     // ---------------------------------
@@ -365,19 +423,41 @@ void GeodesicView::slot_write_prot()
     // ---------------------------------
     //    save images
     // ---------------------------------
+    // Each view is decided on its own. A view that was never shown gets its context when its tab is shown;
+    // only a view without OpenGL context, e.g. on compute nodes, is rendered on the CPU in parallel.
+    std::vector<struct_soft_job> softJobs;
+
     int currIdx = tab_draw->currentIndex();
     if (mProtDialog->doWrite3dImage()) {
         tab_draw->setCurrentIndex(0);
         QString filename = dirname + "/" + basefilename + DEF_3D_FILE_ENDING;
-        opengl->saveRGBimage(filename);
+        if (!opengl->isValid()) {
+            softJobs.push_back(struct_soft_job());
+            opengl->getSoftJob(softJobs.back());
+            softJobs.back().filename = filename;
+        }
+        else {
+            opengl->saveRGBimage(filename);
+        }
     }
     if (mProtDialog->doWrite2dImage()) {
         tab_draw->setCurrentIndex(1);
         QString filename = dirname + "/" + basefilename + DEF_2D_FILE_ENDING;
-        draw2d->saveRGBimage(filename);
+        if (!draw2d->isValid()) {
+            softJobs.push_back(struct_soft_job());
+            draw2d->getSoftJob(softJobs.back());
+            softJobs.back().filename = filename;
+        }
+        else {
+            draw2d->saveRGBimage(filename);
+        }
     }
     tab_draw->setCurrentIndex(currIdx);
 
+    if (!SoftRenderer::renderJobs(softJobs)) {
+        led_status->setText("write images failed");
+    }
+
     // ---------------------------------
     //  save report
     // ---------------------------------
@@ -411,21 +491,7 @@ void GeodesicView::slot_run_luaScript()
     }
 
     setSetting();
-
-    if (tab_draw->currentIndex() == 1) { // set points for 2D visualization...
-        int absIdx, ordIdx;
-        drw_view->getDrawAbsOrdIndex(absIdx, ordIdx);
-        draw2d->setPoints(mObject.currMetric->getCurrDrawType(drw_view->getDrawTypeName()));
-    }
-    else if (tab_draw->currentIndex() == 0) { // set sachs axes and points for 3D visualization...
-        if (mObject.type == m4d::enum_geodesic_lightlike_sachs) {
-            opengl->setSachsAxes(false);
-        }
-        else {
-            opengl->clearSachsAxes();
-        }
-        opengl->setPoints(mObject.currMetric->getCurrDrawType(drw_view->getDrawType3DName()));
-    }
+    projectGeodesic();
 }
 #endif // HAVE_LUA
 
@@ -460,6 +526,9 @@ void GeodesicView::reset()
     drw_view->resetAll();
 
     mObject.resetAll();
+
+    mHistory.clear();
+    updateHistoryActions();
 }
 
 void GeodesicView::slot_reset()
@@ -494,6 +563,37 @@ void GeodesicView::slot_about()
            "Details about the metrics can be found in the\n\"Catalogue of Spacetimes\", arXiv:0904.4184 [gr-qc]"));
 }
 
+void GeodesicView::slot_showDrawPage()
+{
+    bool tiled = (mActionTiledViews != nullptr && mActionTiledViews->isChecked());
+    wgt_opengl->setVisible(isDrawShown(0));
+    wgt_2d->setVisible(isDrawShown(1));
+    wgt_plots->setVisible(tiled);
+    tab_draw->setVisible(!tiled);
+}
+
+void GeodesicView::slot_setTiledViews()
+{
+    slot_showDrawPage();
+    projectGeodesic();
+}
+
+void GeodesicView::slot_setPlotAbsOrd()
+{
+    projectPlots();
+}
+
+void GeodesicView::slot_pickVertex(int idx)
+{
+    // A point picked in one view is marked in all of them.
+    drw_view->showPickedPoint(idx);
+    opengl->setPickedVertex(idx);
+    draw2d->setPickedVertex(idx);
+    for (int i = 0; i < DEF_TILED_NUM_PLOTS; i++) {
+        mPlots[i]->setPickedVertex(idx);
+    }
+}
+
 void GeodesicView::slot_changeDrawActive()
 {
     QObject* obj = sender();
@@ -666,6 +766,36 @@ void GeodesicView::slot_save_report()
     saveReport(filename);
 }
 
+void GeodesicView::slot_show_pass_times()
+{
+    bool show = mActionShowPassTimes->isChecked();
+    opengl->showPassTimes(show);
+    draw2d->showPassTimes(show);
+}
+
+void GeodesicView::slot_save_pass_times()
+{
+    QString filename
+        = QFileDialog::getSaveFileName(this, tr("Save render timings"), mPreviousFolder, tr("Text files (*.txt)"));
+
+    if (filename == QString()) {
+        return;
+    }
+
+    mPreviousFolder = QFileInfo(filename).absoluteDir().absolutePath();
+
+    // One log per view: name.3d.txt and name.2d.txt
+    if (filename.endsWith(".txt")) {
+        filename.chop(4);
+    }
+
+    bool ok = opengl->savePassTimes(filename + ".3d.txt");
+    ok &= draw2d->savePassTimes(filename + ".2d.txt");
+    if (!ok) {
+        led_status->setText("save render timings failed");
+    }
+}
+
 void GeodesicView::slot_setCurrentMetric()
 {
     int index = cob_metric->currentIndex();
@@ -855,6 +985,28 @@ void GeodesicView::slot_calcGeodesic()
     calculateGeodesic();
 }
 
+void GeodesicView::slot_projectGeodesic()
+{
+    projectGeodesic();
+}
+
+void GeodesicView::slot_undo()
+{
+    // A state that cannot be restored leaves the history where it was.
+    const struct_session_state* state = mHistory.undo();
+    if (state != nullptr && !restoreHistoryState(state)) {
+        mHistory.redo();
+    }
+}
+
+void GeodesicView::slot_redo()
+{
+    const struct_session_state* state = mHistory.redo();
+    if (state != nullptr && !restoreHistoryState(state)) {
+        mHistory.undo();
+    }
+}
+
 void GeodesicView::slot_setOpenGLcolors()
 {
     QColor bgcol, fgcol;
@@ -1100,6 +1252,10 @@ void GeodesicView::initActions()
     addAction(mActionSaveImage2D);
     connect(mActionSaveImage2D, SIGNAL(triggered()), this, SLOT(slot_save_image_2d()));
 
+    mActionSaveVector2D = new QAction(QIcon(":/save.png"), "Save &Vector 2D", this);
+    addAction(mActionSaveVector2D);
+    connect(mActionSaveVector2D, SIGNAL(triggered()), this, SLOT(slot_save_vector_2d()));
+
     mActionSaveImage3D = new QAction(QIcon(":/save.png"), "Save Image &3D", this);
     addAction(mActionSaveImage3D);
     connect(mActionSaveImage3D, SIGNAL(triggered()), this, SLOT(slot_save_image_3d()));
@@ -1121,6 +1277,21 @@ void GeodesicView::initActions()
     connect(mActionRunLuaScript, SIGNAL(triggered()), this, SLOT(slot_run_luaScript()));
 #endif // HAVE_LUA
 
+    /* ------------------
+     *  Edit actions
+     * ------------------ */
+    mActionUndo = new QAction("&Undo", this);
+    mActionUndo->setShortcut(Qt::CTRL | Qt::Key_Z);
+    mActionUndo->setEnabled(false);
+    addAction(mActionUndo);
+    connect(mActionUndo, SIGNAL(triggered()), this, SLOT(slot_undo()));
+
+    mActionRedo = new QAction("&Redo", this);
+    mActionRedo->setShortcut(Qt::CTRL | Qt::SHIFT | Qt::Key_Z);
+    mActionRedo->setEnabled(false);
+    addAction(mActionRedo);
+    connect(mActionRedo, SIGNAL(triggered()), this, SLOT(slot_redo()));
+
     /* ------------------
      *  Object actions
      * ------------------ */
@@ -1150,6 +1321,16 @@ void GeodesicView::initActions()
     mActionShowReport->setShortcut(Qt::CTRL | Qt::Key_R);
     addAction(mActionShowReport);
     connect(mActionShowReport, SIGNAL(triggered()), this, SLOT(slot_show_report()));
+
+    mActionShowPassTimes = new QAction(QIcon(":/display.png"), "Show render &timings", this);
+    mActionShowPassTimes->setShortcut(Qt::CTRL | Qt::Key_T);
+    mActionShowPassTimes->setCheckable(true);
+    addAction(mActionShowPassTimes);
+    connect(mActionShowPassTimes, SIGNAL(triggered()), this, SLOT(slot_show_pass_times()));
+
+    mActionSavePassTimes = new QAction(QIcon(":/save.png"), "Save render timings", this);
+    addAction(mActionSavePassTimes);
+    connect(mActionSavePassTimes, SIGNAL(triggered()), this, SLOT(slot_save_pass_times()));
     //
     // mActionSaveReport = new QAction(QIcon(":/save.png"), "&Save report", this);
     // addAction(mActionSaveReport);
@@ -1167,6 +1348,15 @@ void GeodesicView::initActions()
     addAction(mActionAbout);
     connect(mActionAbout, SIGNAL(triggered()), this, SLOT(slot_about()));
 
+    // ------------------
+    //   View actions
+    // ------------------
+    mActionTiledViews = new QAction("&Tiled views", this);
+    mActionTiledViews->setShortcut(tr("Ctrl+3"));
+    mActionTiledViews->setCheckable(true);
+    addAction(mActionTiledViews);
+    connect(mActionTiledViews, SIGNAL(triggered()), this, SLOT(slot_setTiledViews()));
+
     // ------------------
     //   other actions
     // ------------------
@@ -1229,6 +1419,7 @@ void GeodesicView::initMenus()
     mFileMenu->addAction(mActionLoadAll);
     mFileMenu->addSeparator();
     mFileMenu->addAction(mActionSaveImage2D);
+    mFileMenu->addAction(mActionSaveVector2D);
     mFileMenu->addAction(mActionSaveImage3D);
     mFileMenu->addAction(mActionWriteProtocoll);
 #ifdef HAVE_LUA
@@ -1238,6 +1429,15 @@ void GeodesicView::initMenus()
     mFileMenu->addSeparator();
     mFileMenu->addAction(mActionQuit);
 
+    // ---- Edit menu ----
+    mEditMenu = menuBar()->addMenu("&Edit");
+    mEditMenu->addAction(mActionUndo);
+    mEditMenu->addAction(mActionRedo);
+
+    // ---- View menu ----
+    mViewMenu = menuBar()->addMenu("&View");
+    mViewMenu->addAction(mActionTiledViews);
+
     // ---- Object menu ----
     mObjectMenu = menuBar()->addMenu("&Objects");
     mObjectMenu->addAction(mActionLoadObjectFile);
@@ -1255,6 +1455,8 @@ void GeodesicView::initMenus()
     // ---- Help menu ----
     mHelpMenu = menuBar()->addMenu("&Help");
     mHelpMenu->addAction(mActionShowReport);
+    mHelpMenu->addAction(mActionShowPassTimes);
+    mHelpMenu->addAction(mActionSavePassTimes);
     mHelpMenu->addSeparator();
     // mHelpMenu -> addAction(mActionDoc);
     mHelpMenu->addAction(mActionAbout);
@@ -1297,20 +1499,50 @@ void GeodesicView::initGUI()
     //   drawing
     // ---------------------------------
     opengl = new OpenGL3dModel(&mParams);
-    QFrame* wgt_opengl = new QFrame();
+    wgt_opengl = new QFrame();
     QGridLayout* layout_opengl = new QGridLayout();
     layout_opengl->addWidget(opengl, 0, 0);
     wgt_opengl->setLayout(layout_opengl);
 
     draw2d = new OpenGL2dModel(&mParams);
-    QFrame* wgt_2d = new QFrame();
+    wgt_2d = new QFrame();
     QGridLayout* layout_2d = new QGridLayout();
     layout_2d->addWidget(draw2d, 0, 0);
     wgt_2d->setLayout(layout_2d);
 
-    tab_draw = new QTabWidget();
-    tab_draw->addTab(wgt_opengl, tr("OpenGL 3D"));
-    tab_draw->addTab(wgt_2d, tr("Draw 2D"));
+    wgt_plots = new QFrame();
+    QGridLayout* layout_plots = new QGridLayout();
+    for (int i = 0; i < DEF_TILED_NUM_PLOTS; i++) {
+        mPlots[i] = new OpenGL2dModel(&mParams);
+        cob_plot_abscissa[i] = new QComboBox();
+        cob_plot_ordinate[i] = new QComboBox();
+        layout_plots->addWidget(new QLabel(tr("abscissa")), 2 * i, 0);
+        layout_plots->addWidget(cob_plot_abscissa[i], 2 * i, 1);
+        layout_plots->addWidget(new QLabel(tr("ordinate")), 2 * i, 2);
+        layout_plots->addWidget(cob_plot_ordinate[i], 2 * i, 3);
+        layout_plots->addWidget(mPlots[i], 2 * i + 1, 0, 1, 4);
+        layout_plots->setRowStretch(2 * i + 1, 10);
+    }
+    wgt_plots->setLayout(layout_plots);
+
+    // All views live in one splitter; in tab mode only the current one is visible.
+    spl_draw = new QSplitter(Qt::Horizontal);
+    spl_draw->addWidget(wgt_opengl);
+    spl_draw->addWidget(wgt_2d);
+    spl_draw->addWidget(wgt_plots);
+
+    tab_draw = new QTabBar();
+    tab_draw->addTab(tr("OpenGL 3D"));
+    tab_draw->addTab(tr("Draw 2D"));
+
+    wgt_draw = new QWidget();
+    QVBoxLayout* layout_draw = new QVBoxLayout();
+    layout_draw->setContentsMargins(0, 0, 0, 0);
+    layout_draw->addWidget(tab_draw);
+    layout_draw->addWidget(spl_draw, 1);
+    wgt_draw->setLayout(layout_draw);
+    wgt_2d->hide();
+    wgt_plots->hide();
 
     // ---------------------------------
     //    metric/integrator
@@ -1516,7 +1748,7 @@ void GeodesicView::initGUI()
     dw->setAllowedAreas(Qt::RightDockWidgetArea | Qt::LeftDockWidgetArea);
     dw->setWindowTitle("Parameters");
 
-    setCentralWidget(tab_draw);
+    setCentralWidget(wgt_draw);
     addDockWidget(Qt::RightDockWidgetArea, dw);
 
     // ---------------------------
@@ -1553,7 +1785,15 @@ void GeodesicView::initGUI()
 
 void GeodesicView::initControl()
 {
-    connect(tab_draw, SIGNAL(currentChanged(int)), this, SLOT(slot_calcGeodesic()));
+    connect(tab_draw, SIGNAL(currentChanged(int)), this, SLOT(slot_showDrawPage()));
+    connect(tab_draw, SIGNAL(currentChanged(int)), this, SLOT(slot_projectGeodesic()));
+    for (int i = 0; i < DEF_TILED_NUM_PLOTS; i++) {
+        connect(cob_plot_abscissa[i], SIGNAL(activated(int)), this, SLOT(slot_setPlotAbsOrd()));
+        connect(cob_plot_ordinate[i], SIGNAL(activated(int)), this, SLOT(slot_setPlotAbsOrd()));
+        connect(mPlots[i], SIGNAL(vertexPicked(int)), this, SLOT(slot_pickVertex(int)));
+    }
+    connect(opengl, SIGNAL(vertexPicked(int)), this, SLOT(slot_pickVertex(int)));
+    connect(draw2d, SIGNAL(vertexPicked(int)), this, SLOT(slot_pickVertex(int)));
 
     connect(cob_metric, SIGNAL(activated(int)), this, SLOT(slot_setCurrentMetric()));
     connect(cob_integrator, SIGNAL(activated(int)), this, SLOT(slot_setGeodSolver()));
@@ -1583,6 +1823,7 @@ void GeodesicView::initControl()
     connect(geo_view, SIGNAL(calcGeodesic()), this, SLOT(slot_calcGeodesic()));
     connect(geo_view, SIGNAL(changeGeodType()), drw_view, SLOT(slot_adjustAPname()));
     connect(drw_view, SIGNAL(calcGeodesic()), this, SLOT(slot_calcGeodesic()));
+    connect(drw_view, SIGNAL(projectGeodesic()), this, SLOT(slot_projectGeodesic()));
     connect(drw_view, SIGNAL(colorChanged()), this, SLOT(slot_setOpenGLcolors()));
     connect(drw_view, SIGNAL(lastPointChanged(int)), geo_view, SLOT(slot_showLastJacobi(int)));
 
@@ -1644,6 +1885,7 @@ bool GeodesicView::setMetricNamesAndCoords()
     /* --- set coordinate names --- */
     drw_view->adjustCoordNames();
     lct_view->adjustCoordNames();
+    adjustPlotCoordNames();
 
     /* --- set embedding to mParams --- */
     if (!mParams.opengl_emb_params.empty()) {
@@ -1781,6 +2023,11 @@ void GeodesicView::setUnits(const double sol, const double grav, const double di
 
 void GeodesicView::calculateGeodesic()
 {
+    // GUI updates while restoring a history state must not trigger an integration.
+    if (mRestoringState) {
+        return;
+    }
+
     if ((mObject.currMetric == nullptr) || (mObject.geodSolver == nullptr)) {
         return;
     }
@@ -1860,25 +2107,25 @@ void GeodesicView::calculateGeodesic()
 
     // ????? Welche der beiden oberen Methoden stimmt,  b[0]... oder mObject.base[0]... ??
 
+    mObjectRevision++;
+
+    struct_session_state state;
+    storeSessionState(state, &mParams, breakCond);
+    mHistory.push(state);
+    updateHistoryActions();
+
+    showGeodesic(breakCond);
+}
+
+void GeodesicView::showGeodesic(m4d::enum_break_condition breakCond)
+{
     led_status->setText(m4d::stl_break_condition[breakCond]);
 
     lcd_num_points->display(int(mObject.points.size()));
     drw_view->setGeodLength(int(mObject.points.size()));
+    slot_pickVertex(-1);
 
-    if (tab_draw->currentIndex() == 1) { // set points for 2D visualization...
-        int absIdx, ordIdx;
-        drw_view->getDrawAbsOrdIndex(absIdx, ordIdx);
-        draw2d->setPoints(mObject.currMetric->getCurrDrawType(drw_view->getDrawTypeName()));
-    }
-    else if (tab_draw->currentIndex() == 0) { // set sachs axes and points for 3D visualization...
-        if (mObject.type == m4d::enum_geodesic_lightlike_sachs) {
-            opengl->setSachsAxes(false);
-        }
-        else {
-            opengl->clearSachsAxes();
-        }
-        opengl->setPoints(mObject.currMetric->getCurrDrawType(drw_view->getDrawType3DName()));
-    }
+    projectGeodesic();
 #if 0
     for (int i = 0; i < mObject.points.size(); i++) {
         fprintf(stdout, "%5d %12.8f %12.8f %12.8f %12.8f %12.8f %12.8f %12.8e %12.8f\n", i, mObject.lambda[i], mObject.points[i].x(1), mObject.points[i].x(3), mObject.jacobi[i][0], mObject.jacobi[i][1], mObject.jacobi[i][2], mObject.jacobi[i][3], mObject.jacobi[i][4]);
@@ -1898,6 +2145,120 @@ void GeodesicView::calculateGeodesic()
 #endif
 }
 
+void GeodesicView::projectGeodesic()
+{
+    if (mObject.currMetric == nullptr) {
+        return;
+    }
+
+    // Every shown view takes its projection from the shared cache, so each is computed and uploaded once.
+    if (isDrawShown(1)) { // set points for 2D visualization...
+        draw2d->setPoints(mObject.currMetric->getCurrDrawType(drw_view->getDrawTypeName()));
+    }
+    if (isDrawShown(0)) { // set sachs axes and points for 3D visualization...
+        if (mObject.type == m4d::enum_geodesic_lightlike_sachs) {
+            opengl->setSachsAxes(false);
+        }
+        else {
+            opengl->clearSachsAxes();
+        }
+        opengl->setPoints(mObject.currMetric->getCurrDrawType(drw_view->getDrawType3DName()));
+        drw_view->adjustColormap();
+    }
+    projectPlots();
+}
+
+bool GeodesicView::isDrawShown(int idx)
+{
+    bool tiled = (mActionTiledViews != nullptr && mActionTiledViews->isChecked());
+    return (tiled || tab_draw->currentIndex() == idx);
+}
+
+void GeodesicView::projectPlots()
+{
+    if (mActionTiledViews == nullptr || !mActionTiledViews->isChecked() || mObject.currMetric == nullptr) {
+        return;
+    }
+
+    for (int i = 0; i < DEF_TILED_NUM_PLOTS; i++) {
+        mPlots[i]->updateParams();
+        mPlots[i]->setAbsOrd(static_cast<enum_draw_coord_num>(cob_plot_abscissa[i]->currentIndex()),
+            static_cast<enum_draw_coord_num>(cob_plot_ordinate[i]->currentIndex()));
+        mPlots[i]->setPoints(m4d::enum_draw_coordinates, false);
+        mPlots[i]->fitPoints(DEF_TILED_PLOT_MARGIN);
+    }
+}
+
+void GeodesicView::adjustPlotCoordNames()
+{
+    QStringList names = drw_view->getCoordNames();
+    for (int i = 0; i < DEF_TILED_NUM_PLOTS; i++) {
+        cob_plot_abscissa[i]->clear();
+        cob_plot_ordinate[i]->clear();
+        cob_plot_abscissa[i]->addItems(names);
+        cob_plot_ordinate[i]->addItems(names);
+        cob_plot_abscissa[i]->setCurrentIndex(plotAbscissa[i % 2]);
+        cob_plot_ordinate[i]->setCurrentIndex(plotOrdinate[i % 2]);
+    }
+}
+
+bool GeodesicView::restoreHistoryState(const struct_session_state* state)
+{
+    if (state == nullptr) {
+        return false;
+    }
+
+    // The metric is switched first; if that fails, the current session stays as it is.
+    if (mObject.currMetric == nullptr || state->metricName != std::string(mObject.currMetric->getMetricName())) {
+        int index = mObject.metricDB.getMetricNr(state->metricName.c_str());
+        if (index < 0 || index == static_cast<int>(m4d::MetricList::enum_metric_unknown)) {
+            fprintf(stderr, "Cannot restore metric %s!\n", state->metricName.c_str());
+            return false;
+        }
+        m4d::Metric* prevMetric = mObject.currMetric;
+        if (!setMetric(static_cast<m4d::MetricList::enum_metric>(index))) {
+            mObject.currMetric = prevMetric;
+            fprintf(stderr, "Cannot restore metric %s!\n", state->metricName.c_str());
+            return false;
+        }
+    }
+
+    mRestoringState = true;
+    restoreSessionState(*state);
+    mParams = state->params;
+    setSetting();
+
+    opengl->updateParams();
+    drw_view->updateParams();
+    geo_view->updateParams();
+    draw2d->updateParams();
+
+    if (mObject.currMetric->getCurrDrawType(drw_view->getDrawType3DName()) == m4d::enum_draw_embedding) {
+        opengl->genEmbed(mObject.currMetric);
+    }
+    mRestoringState = false;
+
+    if (restoreSessionTrajectory(*state)) {
+        mObjectRevision++;
+        showGeodesic(state->breakCond);
+    }
+    else {
+        calculateGeodesic();
+    }
+    updateHistoryActions();
+    return true;
+}
+
+void GeodesicView::updateHistoryActions()
+{
+    // The first geodesic may be integrated before the actions exist.
+    if (mActionUndo == nullptr || mActionRedo == nullptr) {
+        return;
+    }
+    mActionUndo->setEnabled(mHistory.canUndo());
+    mActionRedo->setEnabled(mHistory.canRedo());
+}
+
 void GeodesicView::calculateGeodesicData()
 {
     if ((mObject.currMetric != nullptr) && (mObject.geodSolver != nullptr)) {
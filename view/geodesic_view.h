@@ -14,7 +14,9 @@
 
 #include <QMainWindow>
 #include <QMenuBar>
+#include <QSplitter>
 #include <QStatusBar>
+#include <QTabBar>
 
 #ifdef HAVE_NETWORK
 #include <QTcpServer>
@@ -41,7 +43,9 @@
 #include <metric/m4dMetricDatabase.h>
 #include <motion/m4dMotionList.h>
 #include <utils/myobject.h>
+#include <utils/session_history.h>
 #include <utils/utilities.h>
+#include <utils/vector_exporter.h>
 
 #ifdef HAVE_LUA
 #include "lua/m4dlua.h"
@@ -74,6 +78,7 @@ public slots:
     void slot_reset_vparams();
 
     void slot_save_image_2d();
+    void slot_save_vector_2d();
     void slot_save_image_3d();
 
     void slot_load_all();
@@ -91,6 +96,10 @@ public slots:
     void slot_about();
 
     void slot_changeDrawActive();
+    void slot_showDrawPage();
+    void slot_setTiledViews();
+    void slot_setPlotAbsOrd();
+    void slot_pickVertex(int idx);
 
     void slot_animate();
 
@@ -103,6 +112,9 @@ public slots:
     void slot_show_report();
     void slot_save_report();
 
+    void slot_show_pass_times();
+    void slot_save_pass_times();
+
     void slot_setCurrentMetric();
     void slot_metricParamChanged();
     void slot_setGeodSolver();
@@ -123,6 +135,10 @@ public slots:
     void slot_setUnits();
 
     void slot_calcGeodesic();
+    void slot_projectGeodesic();
+
+    void slot_undo();
+    void slot_redo();
 
     void slot_setOpenGLcolors();
 
@@ -150,8 +166,24 @@ protected:
     void initStatusTips();
 
     void calculateGeodesic();
+    void projectGeodesic();
+
+    /**
+     * @brief Is the 3D (0) or 2D (1) view shown, either as current tab or tiled?
+     */
+    bool isDrawShown(int idx);
+
+    /**
+     * @brief Project geodesic into the additional coordinate plots of the tiled layout.
+     */
+    void projectPlots();
+    void adjustPlotCoordNames();
+    void showGeodesic(m4d::enum_break_condition breakCond);
     void calculateGeodesicData();
 
+    bool restoreHistoryState(const struct_session_state* state);
+    void updateHistoryActions();
+
     bool setMetric(m4d::MetricList::enum_metric metric);
     bool setMetricNamesAndCoords();
     bool setGeodSolver(m4d::enum_integrator type);
@@ -203,10 +235,18 @@ private:
     struct_params mParams;
     QString mPreviousFolder;
 
-    // Tab widget holding 2D and 3D rendering window
-    QTabWidget* tab_draw;
+    // Tab bar selecting the 2D or 3D rendering window; the tiled layout shows all of them side by side
+    QTabBar* tab_draw;
+    QSplitter* spl_draw;
+    QWidget* wgt_draw;
+    QWidget* wgt_opengl;
+    QWidget* wgt_2d;
+    QWidget* wgt_plots;
 
     OpenGL2dModel* draw2d;
+    OpenGL2dModel* mPlots[DEF_TILED_NUM_PLOTS];
+    QComboBox* cob_plot_abscissa[DEF_TILED_NUM_PLOTS];
+    QComboBox* cob_plot_ordinate[DEF_TILED_NUM_PLOTS];
     QAction* mActionMake3Dactive;
     QAction* mActionMake2Dactive;
 
@@ -258,6 +298,7 @@ private:
     QAction* mActionResetViewParams;
     QAction* mActionLoadAll;
     QAction* mActionSaveImage2D;
+    QAction* mActionSaveVector2D;
     QAction* mActionSaveImage3D;
     QAction* mActionWriteProtocoll;
     QAction* mActionQuit;
@@ -267,6 +308,15 @@ private:
     lua_State* mLuaState;
 #endif // HAVE_LUA
 
+    // ---- Edit menu ----
+    QMenu* mEditMenu;
+    QAction* mActionUndo;
+    QAction* mActionRedo;
+
+    // ---- View menu ----
+    QMenu* mViewMenu;
+    QAction* mActionTiledViews;
+
     // ---- Object menu ----
     QMenu* mObjectMenu;
     QAction* mActionLoadObjectFile;
@@ -278,6 +328,8 @@ private:
     QMenu* mReportMenu;
     QAction* mActionShowReport;
     QAction* mActionSaveReport;
+    QAction* mActionShowPassTimes;
+    QAction* mActionSavePassTimes;
 
     /* ---- Help menu ---- */
     QMenu* mHelpMenu;
@@ -316,6 +368,10 @@ private:
 
     GreekLetter mGreekLetter;
 
+    // ---- undo/redo ----
+    SessionHistory mHistory;
+    bool mRestoringState;
+
 #ifdef HAVE_NETWORK
     QTcpServer* mServer;
     QTcpSocket* mSocket;